@@ -42,9 +42,21 @@
  * in the hope that the final linked shader will be found in the cache.
  * If anything goes wrong (shader variant not found, backend cache item is
  * corrupt, etc) we will use a fallback path to compile and link the IR.
+ *
+ * With MESA_GLSL_CACHE_WARM_START, the keys of the programs used by the
+ * application are also stored in a per-application manifest in the cache,
+ * and the next run reads the programs listed there on a background thread
+ * at context creation, so that linking them doesn't have to wait for the
+ * disk.
  */
 
 #include "util/os_misc.h"
+#include "util/hash_table.h"
+#include "util/u_atomic.h"
+#include "util/u_debug.h"
+#include "util/u_process.h"
+#include "util/u_queue.h"
+#include "util/simple_mtx.h"
 
 #include "compiler/shader_info.h"
 #include "glsl_symbol_table.h"
@@ -75,6 +87,259 @@ compile_shaders(struct gl_context *ctx, struct gl_shader_program *prog) {
    }
 }
 
+/* Maximum number of programs listed in a warm start manifest. */
+#define WARM_START_MAX_PROGRAMS     1024
+/* Maximum number of bytes preloaded at context creation. */
+#define WARM_START_MAX_BYTES        (64 * 1024 * 1024)
+#define WARM_START_MANIFEST_VERSION 1
+
+DEBUG_GET_ONCE_BOOL_OPTION(glsl_cache_warm_start, "MESA_GLSL_CACHE_WARM_START",
+                           false)
+
+struct warm_start_program {
+   cache_key key;
+   void *data;   /* NULL for programs used by this context */
+   size_t size;
+};
+
+struct shader_cache_warm_start {
+   struct disk_cache *cache;
+   cache_key manifest_key;
+
+   struct util_queue queue;
+   struct util_queue_fence fence;
+   bool abort;
+
+   /* Keys read from the manifest, written by the preload job. */
+   cache_key *manifest;
+   unsigned manifest_count;
+
+   simple_mtx_t lock;
+   /* cache_key -> warm_start_program, for both preloaded programs and
+    * programs used by this context.
+    */
+   struct hash_table *programs;
+   /* Programs used by this context in the order of first use. */
+   cache_key *used;
+   unsigned used_count;
+};
+
+static uint32_t
+cache_key_hash(const void *key)
+{
+   return _mesa_hash_data(key, sizeof(cache_key));
+}
+
+static bool
+cache_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(cache_key)) == 0;
+}
+
+static void
+warm_start_preload(void *data, UNUSED void *gdata, UNUSED int thread_index)
+{
+   struct shader_cache_warm_start *ws = (struct shader_cache_warm_start *)data;
+   size_t manifest_size, total_size = 0;
+   uint32_t *manifest = (uint32_t *)
+      disk_cache_get(ws->cache, ws->manifest_key, &manifest_size);
+
+   if (!manifest)
+      return;
+
+   if (manifest_size < 2 * sizeof(uint32_t) ||
+       manifest[0] != WARM_START_MANIFEST_VERSION ||
+       manifest[1] > WARM_START_MAX_PROGRAMS ||
+       manifest_size != 2 * sizeof(uint32_t) + manifest[1] * sizeof(cache_key)) {
+      free(manifest);
+      return;
+   }
+
+   ws->manifest_count = manifest[1];
+   ws->manifest = (cache_key *)malloc(ws->manifest_count * sizeof(cache_key));
+   if (!ws->manifest) {
+      free(manifest);
+      return;
+   }
+   memcpy(ws->manifest, &manifest[2], ws->manifest_count * sizeof(cache_key));
+   free(manifest);
+
+   for (unsigned i = 0; i < ws->manifest_count; i++) {
+      if (p_atomic_read(&ws->abort) || total_size >= WARM_START_MAX_BYTES)
+         break;
+
+      size_t size;
+      void *blob = disk_cache_get(ws->cache, ws->manifest[i], &size);
+      if (!blob)
+         continue;
+
+      struct warm_start_program *p = (struct warm_start_program *)
+         calloc(1, sizeof(*p));
+      if (!p) {
+         free(blob);
+         break;
+      }
+      memcpy(p->key, ws->manifest[i], sizeof(cache_key));
+      p->data = blob;
+      p->size = size;
+
+      simple_mtx_lock(&ws->lock);
+      /* Skip programs that the context has already looked up. */
+      if (_mesa_hash_table_search(ws->programs, p->key)) {
+         free(blob);
+         free(p);
+      } else {
+         _mesa_hash_table_insert(ws->programs, p->key, p);
+         total_size += size;
+      }
+      simple_mtx_unlock(&ws->lock);
+   }
+}
+
+void
+shader_cache_warm_start_init(struct gl_context *ctx)
+{
+   if (!ctx->Cache || !debug_get_option_glsl_cache_warm_start())
+      return;
+
+   struct shader_cache_warm_start *ws = (struct shader_cache_warm_start *)
+      calloc(1, sizeof(*ws));
+   if (!ws)
+      return;
+
+   ws->cache = ctx->Cache;
+   ws->programs = _mesa_hash_table_create(NULL, cache_key_hash,
+                                          cache_key_equal);
+   ws->used = (cache_key *)malloc(WARM_START_MAX_PROGRAMS * sizeof(cache_key));
+   if (!ws->programs || !ws->used ||
+       !util_queue_init(&ws->queue, "glsl_cache", 1, 1,
+                        UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY, NULL)) {
+      _mesa_hash_table_destroy(ws->programs, NULL);
+      free(ws->used);
+      free(ws);
+      return;
+   }
+   simple_mtx_init(&ws->lock, mtx_plain);
+
+   char *name = ralloc_asprintf(NULL, "glsl warm start manifest: %s",
+                                util_get_process_name());
+   disk_cache_compute_key(ctx->Cache, name, strlen(name), ws->manifest_key);
+   ralloc_free(name);
+
+   util_queue_fence_init(&ws->fence);
+   util_queue_add_job(&ws->queue, ws, &ws->fence, warm_start_preload,
+                      NULL, 0);
+   ctx->ShaderCacheWarmStart = ws;
+}
+
+/**
+ * Write the manifest for the next run and free everything. Programs used
+ * by this context come first, followed by the rest of the old manifest.
+ */
+void
+shader_cache_warm_start_fini(struct gl_context *ctx)
+{
+   struct shader_cache_warm_start *ws = ctx->ShaderCacheWarmStart;
+   if (!ws)
+      return;
+
+   p_atomic_set(&ws->abort, true);
+   util_queue_fence_wait(&ws->fence);
+   util_queue_destroy(&ws->queue);
+   util_queue_fence_destroy(&ws->fence);
+
+   if (ws->used_count) {
+      struct blob manifest;
+      blob_init(&manifest);
+      blob_write_uint32(&manifest, WARM_START_MANIFEST_VERSION);
+      size_t count_offset = blob_reserve_uint32(&manifest);
+      uint32_t count = ws->used_count;
+
+      blob_write_bytes(&manifest, ws->used, ws->used_count * sizeof(cache_key));
+
+      for (unsigned i = 0; i < ws->manifest_count &&
+                           count < WARM_START_MAX_PROGRAMS; i++) {
+         struct hash_entry *entry =
+            _mesa_hash_table_search(ws->programs, ws->manifest[i]);
+
+         /* Skip programs already written as used. */
+         if (entry && !((struct warm_start_program *)entry->data)->data)
+            continue;
+
+         blob_write_bytes(&manifest, ws->manifest[i], sizeof(cache_key));
+         count++;
+      }
+      blob_overwrite_uint32(&manifest, count_offset, count);
+
+      if (!manifest.out_of_memory) {
+         disk_cache_put(ws->cache, ws->manifest_key, manifest.data,
+                        manifest.size, NULL);
+      }
+      blob_finish(&manifest);
+   }
+
+   hash_table_foreach(ws->programs, entry) {
+      struct warm_start_program *p = (struct warm_start_program *)entry->data;
+      free(p->data);
+      free(p);
+   }
+   _mesa_hash_table_destroy(ws->programs, NULL);
+   simple_mtx_destroy(&ws->lock);
+   free(ws->manifest);
+   free(ws->used);
+   free(ws);
+   ctx->ShaderCacheWarmStart = NULL;
+}
+
+/**
+ * Same as disk_cache_get, but it returns a preloaded program if there is
+ * one and records the key in the warm start manifest.
+ */
+static void *
+shader_cache_get_program(struct gl_context *ctx, const cache_key key,
+                         size_t *size)
+{
+   struct shader_cache_warm_start *ws = ctx->ShaderCacheWarmStart;
+   if (!ws)
+      return disk_cache_get(ctx->Cache, key, size);
+
+   void *data = NULL;
+   bool first_use = false;
+
+   simple_mtx_lock(&ws->lock);
+   struct hash_entry *entry = _mesa_hash_table_search(ws->programs, key);
+   if (entry) {
+      /* Take the preloaded program, and keep the entry to mark it used. */
+      struct warm_start_program *p = (struct warm_start_program *)entry->data;
+      if (p->data) {
+         data = p->data;
+         *size = p->size;
+         p->data = NULL;
+         first_use = true;
+      }
+   } else {
+      struct warm_start_program *p = (struct warm_start_program *)
+         calloc(1, sizeof(*p));
+      if (p) {
+         memcpy(p->key, key, sizeof(cache_key));
+         _mesa_hash_table_insert(ws->programs, p->key, p);
+         first_use = true;
+      }
+   }
+
+   if (first_use && ws->used_count < WARM_START_MAX_PROGRAMS)
+      memcpy(ws->used[ws->used_count++], key, sizeof(cache_key));
+   simple_mtx_unlock(&ws->lock);
+
+   if (data) {
+      if (ctx->_Shader->Flags & GLSL_CACHE_INFO)
+         fprintf(stderr, "using preloaded program from warm start cache\n");
+      return data;
+   }
+
+   return disk_cache_get(ctx->Cache, key, size);
+}
+
 static void
 create_binding_str(const char *key, unsigned value, void *closure)
 {
@@ -211,8 +476,8 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
    ralloc_free(buf);
 
    size_t size;
-   uint8_t *buffer = (uint8_t *) disk_cache_get(cache, prog->data->sha1,
-                                                &size);
+   uint8_t *buffer = (uint8_t *) shader_cache_get_program(ctx, prog->data->sha1,
+                                                          &size);
    if (buffer == NULL) {
       /* Cached program not found. We may have seen the individual shaders
        * before and skipped compiling but they may not have been used together
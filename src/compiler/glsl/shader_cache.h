@@ -26,6 +26,10 @@
 
 #include "util/disk_cache.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
 struct gl_shader_program;
 
@@ -37,4 +41,14 @@ bool
 shader_cache_read_program_metadata(struct gl_context *ctx,
                                    struct gl_shader_program *prog);
 
+void
+shader_cache_warm_start_init(struct gl_context *ctx);
+
+void
+shader_cache_warm_start_fini(struct gl_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* SHADER_CACHE_H */
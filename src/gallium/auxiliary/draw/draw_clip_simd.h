@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * SIMD kernels for the clip stage: plane distances of several vertices at
+ * once, and attribute interpolation for new vertices.
+ *
+ * The vector and the scalar versions must give bit-identical results, so
+ * that clipping doesn't depend on which path a vertex takes.  With
+ * -ffp-contract=fast (the GCC default) the compiler is free to fuse a
+ * multiply and an add into an FMA, in either version and differently in
+ * each, so when the target has FMA both versions spell out the fused
+ * operations themselves.  Without FMA there is nothing to contract.
+ */
+
+#ifndef DRAW_CLIP_SIMD_H
+#define DRAW_CLIP_SIMD_H
+
+#include <math.h>
+#include "util/detect_arch.h"
+#include "util/macros.h"
+
+#if DETECT_ARCH_SSE
+#include <xmmintrin.h>
+#if defined(__FMA__)
+#include <immintrin.h>
+#endif
+#elif DETECT_ARCH_AARCH64 || (DETECT_ARCH_ARM && defined(__ARM_NEON))
+#include <arm_neon.h>
+#define DRAW_CLIP_NEON 1
+#endif
+
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+#define DRAW_CLIP_FMA 1
+#endif
+
+
+/* a * b + c, fused iff DRAW_CLIP_FMA */
+static inline float
+draw_clip_madd(float a, float b, float c)
+{
+#ifdef DRAW_CLIP_FMA
+   return fmaf(a, b, c);
+#else
+   return a * b + c;
+#endif
+}
+
+
+static inline float
+draw_clip_dot4(const float *a, const float *b)
+{
+   float d = a[0] * b[0];
+   d = draw_clip_madd(a[1], b[1], d);
+   d = draw_clip_madd(a[2], b[2], d);
+   return draw_clip_madd(a[3], b[3], d);
+}
+
+
+/**
+ * dst = out + t * (in - out), one component at a time.
+ */
+static inline void
+draw_clip_lerp4_c(float dst[4], float t, const float in[4],
+                  const float out[4])
+{
+   dst[0] = draw_clip_madd(t, in[0] - out[0], out[0]);
+   dst[1] = draw_clip_madd(t, in[1] - out[1], out[1]);
+   dst[2] = draw_clip_madd(t, in[2] - out[2], out[2]);
+   dst[3] = draw_clip_madd(t, in[3] - out[3], out[3]);
+}
+
+
+#if DETECT_ARCH_SSE
+static inline __m128
+draw_clip_madd_ps(__m128 a, __m128 b, __m128 c)
+{
+#ifdef DRAW_CLIP_FMA
+   return _mm_fmadd_ps(a, b, c);
+#else
+   return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+#elif defined(DRAW_CLIP_NEON)
+static inline float32x4_t
+draw_clip_madd_f32(float32x4_t a, float32x4_t b, float32x4_t c)
+{
+#ifdef DRAW_CLIP_FMA
+   return vfmaq_f32(c, a, b);
+#else
+   return vaddq_f32(vmulq_f32(a, b), c);
+#endif
+}
+#endif
+
+
+/**
+ * dists[i] = dot(vecs[i], plane) for i < n.
+ * Vertices are transposed four at a time so each lane computes one
+ * distance.  A partial last group repeats its last vertex, so every
+ * distance comes out of the same vector code.
+ */
+static inline void
+draw_clip_dists(float *dists, const float *const *vecs, unsigned n,
+                const float plane[4])
+{
+#if DETECT_ARCH_SSE || defined(DRAW_CLIP_NEON)
+   for (unsigned i = 0; i < n; i += 4) {
+      const float *v0 = vecs[i];
+      const float *v1 = vecs[MIN2(i + 1, n - 1)];
+      const float *v2 = vecs[MIN2(i + 2, n - 1)];
+      const float *v3 = vecs[MIN2(i + 3, n - 1)];
+      float tail[4];
+      float *d = i + 4 <= n ? &dists[i] : tail;
+
+#if DETECT_ARCH_SSE
+      __m128 x = _mm_loadu_ps(v0);
+      __m128 y = _mm_loadu_ps(v1);
+      __m128 z = _mm_loadu_ps(v2);
+      __m128 w = _mm_loadu_ps(v3);
+      __m128 r;
+
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+
+      /* Same operations as draw_clip_dot4(). */
+      r = _mm_mul_ps(x, _mm_set1_ps(plane[0]));
+      r = draw_clip_madd_ps(y, _mm_set1_ps(plane[1]), r);
+      r = draw_clip_madd_ps(z, _mm_set1_ps(plane[2]), r);
+      r = draw_clip_madd_ps(w, _mm_set1_ps(plane[3]), r);
+      _mm_storeu_ps(d, r);
+#else
+      const float32x4x2_t t01 = vtrnq_f32(vld1q_f32(v0), vld1q_f32(v1));
+      const float32x4x2_t t23 = vtrnq_f32(vld1q_f32(v2), vld1q_f32(v3));
+      const float32x4_t x = vcombine_f32(vget_low_f32(t01.val[0]),
+                                         vget_low_f32(t23.val[0]));
+      const float32x4_t y = vcombine_f32(vget_low_f32(t01.val[1]),
+                                         vget_low_f32(t23.val[1]));
+      const float32x4_t z = vcombine_f32(vget_high_f32(t01.val[0]),
+                                         vget_high_f32(t23.val[0]));
+      const float32x4_t w = vcombine_f32(vget_high_f32(t01.val[1]),
+                                         vget_high_f32(t23.val[1]));
+      float32x4_t r;
+
+      /* Same operations as draw_clip_dot4(). */
+      r = vmulq_f32(x, vdupq_n_f32(plane[0]));
+      r = draw_clip_madd_f32(y, vdupq_n_f32(plane[1]), r);
+      r = draw_clip_madd_f32(z, vdupq_n_f32(plane[2]), r);
+      r = draw_clip_madd_f32(w, vdupq_n_f32(plane[3]), r);
+      vst1q_f32(d, r);
+#endif
+
+      if (d == tail) {
+         for (unsigned j = i; j < n; j++)
+            dists[j] = tail[j - i];
+      }
+   }
+#else
+   for (unsigned i = 0; i < n; i++)
+      dists[i] = draw_clip_dot4(vecs[i], plane);
+#endif
+}
+
+
+/**
+ * dst = out + t * (in - out)
+ */
+static inline void
+draw_clip_lerp4(float dst[4], float t, const float in[4], const float out[4])
+{
+#if DETECT_ARCH_SSE
+   const __m128 o = _mm_loadu_ps(out);
+   const __m128 d = _mm_sub_ps(_mm_loadu_ps(in), o);
+
+   _mm_storeu_ps(dst, draw_clip_madd_ps(_mm_set1_ps(t), d, o));
+#elif defined(DRAW_CLIP_NEON)
+   const float32x4_t o = vld1q_f32(out);
+   const float32x4_t d = vsubq_f32(vld1q_f32(in), o);
+
+   vst1q_f32(dst, draw_clip_madd_f32(vdupq_n_f32(t), d, o));
+#else
+   draw_clip_lerp4_c(dst, t, in, out);
+#endif
+}
+
+#endif /* DRAW_CLIP_SIMD_H */
@@ -33,6 +33,7 @@
 
 
 #include "util/u_bitcast.h"
+#include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 
@@ -42,6 +43,7 @@
 #include "draw_pipe.h"
 #include "draw_fs.h"
 #include "draw_gs.h"
+#include "draw_clip_simd.h"
 
 
 /** Set to 1 to enable printing of coords before/after clipping */
@@ -68,6 +70,9 @@ struct clip_stage {
    uint8_t perspect_attribs[PIPE_MAX_SHADER_OUTPUTS];
 
    float (*plane)[4];
+
+   /* Use the draw_clip_simd.h vector kernels (DRAW_CLIP_SIMD, default on) */
+   bool simd;
 };
 
 
@@ -95,21 +100,19 @@ draw_viewport_index(struct draw_context *draw,
 }
 
 
-#define LINTERP(T, OUT, IN) ((OUT) + (T) * ((IN) - (OUT)))
-
-
 /* All attributes are float[4], so this is easy:
  */
-static void
-interp_attr(float dst[4],
+static inline void
+interp_attr(const struct clip_stage *clip,
+            float dst[4],
             float t,
             const float in[4],
             const float out[4])
 {
-   dst[0] = LINTERP(t, out[0], in[0]);
-   dst[1] = LINTERP(t, out[1], in[1]);
-   dst[2] = LINTERP(t, out[2], in[2]);
-   dst[3] = LINTERP(t, out[3], in[3]);
+   if (clip->simd)
+      draw_clip_lerp4(dst, t, in, out);
+   else
+      draw_clip_lerp4_c(dst, t, in, out);
 }
 
 
@@ -151,11 +154,11 @@ interp(const struct clip_stage *clip,
    /* Interpolate the clip-space coords.
     */
    if (clip->cv_attr >= 0) {
-      interp_attr(dst->data[clip->cv_attr], t,
+      interp_attr(clip, dst->data[clip->cv_attr], t,
                   in->data[clip->cv_attr], out->data[clip->cv_attr]);
    }
    /* interpolate the clip-space position */
-   interp_attr(dst->clip_pos, t, in->clip_pos, out->clip_pos);
+   interp_attr(clip, dst->clip_pos, t, in->clip_pos, out->clip_pos);
 
    /* Do the projective divide and viewport transformation to get
     * new window coordinates:
@@ -177,7 +180,7 @@ interp(const struct clip_stage *clip,
    /* interp perspective attribs */
    for (unsigned j = 0; j < clip->num_perspect_attribs; j++) {
       const unsigned attr = clip->perspect_attribs[j];
-      interp_attr(dst->data[attr], t, in->data[attr], out->data[attr]);
+      interp_attr(clip, dst->data[attr], t, in->data[attr], out->data[attr]);
    }
 
    /**
@@ -204,7 +207,7 @@ interp(const struct clip_stage *clip,
       }
       for (unsigned j = 0; j < clip->num_linear_attribs; j++) {
          const unsigned attr = clip->linear_attribs[j];
-         interp_attr(dst->data[attr], t_nopersp, in->data[attr], out->data[attr]);
+         interp_attr(clip, dst->data[attr], t_nopersp, in->data[attr], out->data[attr]);
       }
    }
 }
@@ -295,7 +298,7 @@ emit_poly(struct draw_stage *stage,
 static inline float
 dot4(const float *a, const float *b)
 {
-   return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+   return draw_clip_dot4(a, b);
 }
 
 /*
@@ -338,6 +341,44 @@ getclipdist(const struct clip_stage *clipper,
 }
 
 
+/*
+ * Clip distances of the first \p n vertices of a polygon against one
+ * plane.  Plane dot products are done several vertices at a time.
+ * Returns false if any of them is inf or nan.
+ */
+static bool
+getclipdists(const struct clip_stage *clipper,
+             struct vertex_header *const *verts,
+             unsigned n,
+             int plane_idx,
+             float *dists)
+{
+   if (plane_idx >= 6 && clipper->have_clipdist) {
+      for (unsigned i = 0; i < n; i++)
+         dists[i] = getclipdist(clipper, verts[i], plane_idx);
+   } else {
+      const bool use_cv = plane_idx >= 6 && clipper->cv_attr >= 0;
+      const float *vecs[MAX_CLIPPED_VERTICES];
+
+      for (unsigned i = 0; i < n; i++)
+         vecs[i] = use_cv ? verts[i]->data[clipper->cv_attr] : verts[i]->clip_pos;
+
+      if (clipper->simd) {
+         draw_clip_dists(dists, vecs, n, clipper->plane[plane_idx]);
+      } else {
+         for (unsigned i = 0; i < n; i++)
+            dists[i] = dot4(vecs[i], clipper->plane[plane_idx]);
+      }
+   }
+
+   for (unsigned i = 0; i < n; i++) {
+      if (util_is_inf_or_nan(dists[i]))
+         return false;
+   }
+   return true;
+}
+
+
 /* Clip a triangle against the viewport and user clip planes.
  */
 static void
@@ -413,30 +454,29 @@ do_clip_tri(struct draw_stage *stage,
       const bool is_user_clip_plane = plane_idx >= 6;
       struct vertex_header *vert_prev = inlist[0];
       bool *edge_prev = &inEdges[0];
+      float dists[MAX_CLIPPED_VERTICES];
       float dp_prev;
       unsigned outcount = 0;
 
-      dp_prev = getclipdist(clipper, vert_prev, plane_idx);
       clipmask &= ~(1<<plane_idx);
 
-      if (util_is_inf_or_nan(dp_prev))
-         return; //discard nan
-
       assert(n < MAX_CLIPPED_VERTICES);
       if (n >= MAX_CLIPPED_VERTICES)
          return;
       inlist[n] = inlist[0]; /* prevent rotation of vertices */
       inEdges[n] = inEdges[0];
 
+      if (!getclipdists(clipper, inlist, n + 1, plane_idx, dists))
+         return; //discard nan
+
+      dp_prev = dists[0];
+
       for (unsigned i = 1; i <= n; i++) {
          struct vertex_header *vert = inlist[i];
          bool *edge = &inEdges[i];
          bool different_sign;
 
-         float dp = getclipdist(clipper, vert, plane_idx);
-
-         if (util_is_inf_or_nan(dp))
-            return; //discard nan
+         float dp = dists[i];
 
          if (dp_prev >= 0.0f) {
             assert(outcount < MAX_CLIPPED_VERTICES);
@@ -995,6 +1035,7 @@ draw_clip_stage(struct draw_context *draw)
    clipper->stage.destroy = clip_destroy;
 
    clipper->plane = draw->plane;
+   clipper->simd = debug_get_bool_option("DRAW_CLIP_SIMD", true);
 
    if (!draw_alloc_temp_verts(&clipper->stage, MAX_CLIPPED_VERTICES+1))
       goto fail;
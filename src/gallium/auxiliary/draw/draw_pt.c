@@ -157,9 +157,16 @@ draw_pt_arrays(struct draw_context *draw,
 
       draw->start_index = draw_info[i].start;
 
-      if (count >= first)
+      if (count >= first) {
+         if (middle->begin_draw)
+            middle->begin_draw(middle, count);
+
          frontend->run(frontend, draw_info[i].start, count);
 
+         if (middle->end_draw)
+            middle->end_draw(middle);
+      }
+
       if (num_draws > 1 && draw->pt.user.increment_draw_id)
          draw->pt.user.drawid++;
    }
@@ -124,6 +124,13 @@ struct draw_pt_middle_end {
 
    int (*get_max_vertex_count)(struct draw_pt_middle_end *);
 
+   /* Optional.  Bracket the runs of a single draw of \p count vertices.
+    * In between, the middle end may process runs asynchronously, as long
+    * as all of them have been emitted, in order, when end_draw returns.
+    */
+   void (*begin_draw)(struct draw_pt_middle_end *, unsigned count);
+   void (*end_draw)(struct draw_pt_middle_end *);
+
    void (*finish)(struct draw_pt_middle_end *);
    void (*destroy)(struct draw_pt_middle_end *);
 };
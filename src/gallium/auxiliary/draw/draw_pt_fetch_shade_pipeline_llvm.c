@@ -28,6 +28,7 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
+#include "util/u_queue.h"
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
 #include "draw/draw_tess.h"
@@ -41,6 +42,51 @@
 #include "gallivm/lp_bld_debug.h"
 
 
+/* Draws with fewer vertices than this are shaded on the calling thread. */
+#define LLVM_VS_THREADS_MIN_VERTICES 2048
+
+/* Maximum number of chunks in flight on the vertex shader threads. */
+#define LLVM_VS_MAX_JOBS 16
+
+
+/**
+ * Inputs and results of the vertex fetch/shade/cliptest JIT function for
+ * one chunk of a draw, captured so it can run on another thread.
+ */
+struct llvm_vs_chunk {
+   const unsigned *elts;
+   unsigned count;
+   unsigned start;
+   unsigned vertex_id_offset;
+   unsigned instance_id;
+   unsigned start_instance;
+   unsigned drawid;
+   unsigned viewid;
+
+   struct vertex_header *verts;
+   bool clipped;
+};
+
+
+/**
+ * A chunk queued on the vertex shader threads, along with copies of the
+ * element lists vsplit reuses for the next chunk.
+ */
+struct llvm_vs_job {
+   struct llvm_middle_end *fpme;
+   struct util_queue_fence fence;
+
+   struct llvm_vs_chunk chunk;
+   struct draw_prim_info prim_info;
+   unsigned prim_count;
+
+   unsigned *fetch_elts;
+   unsigned fetch_elts_size;
+   uint16_t *draw_elts;
+   unsigned draw_elts_size;
+};
+
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -58,6 +104,16 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* DRAW_VS_THREADS: chunks of large draws are shaded on these threads
+    * and then emitted in order on the calling thread.
+    */
+   unsigned num_vs_threads;
+   struct util_queue vs_queue;
+   bool vs_async;
+   struct llvm_vs_job jobs[LLVM_VS_MAX_JOBS];
+   unsigned job_head;
+   unsigned num_jobs;
 };
 
 
@@ -491,12 +547,85 @@ emit(struct pt_emit *emit,
 }
 
 
+/**
+ * Capture the JIT function inputs for the vertices of \p fetch_info and
+ * allocate the output vertices.
+ */
+static bool
+llvm_vs_chunk_init(struct llvm_middle_end *fpme,
+                   const struct draw_fetch_info *fetch_info,
+                   struct llvm_vs_chunk *chunk)
+{
+   struct draw_context *draw = fpme->draw;
+
+   assert(fetch_info->count > 0);
+
+   chunk->count = fetch_info->count;
+   if (fetch_info->linear) {
+      chunk->start = fetch_info->start;
+      chunk->vertex_id_offset = draw->start_index;
+      chunk->elts = NULL;
+   } else {
+      chunk->start = draw->pt.user.eltMax;
+      chunk->vertex_id_offset = draw->pt.user.eltBias;
+      chunk->elts = fetch_info->elts;
+   }
+   chunk->instance_id = draw->instance_id;
+   chunk->start_instance = draw->start_instance;
+   chunk->drawid = draw->pt.user.drawid;
+   chunk->viewid = draw->pt.user.viewid;
+   chunk->clipped = false;
+
+   chunk->verts = (struct vertex_header *)
+      MALLOC(fpme->vertex_size *
+             align(fetch_info->count, lp_native_vector_width / 32) +
+             DRAW_EXTRA_VERTICES_PADDING);
+   if (!chunk->verts) {
+      assert(0);
+      return false;
+   }
+   return true;
+}
+
+
+/**
+ * Run vertex fetch, the vertex shader and the clip test for a chunk.
+ * Only reads state that stays constant for the duration of a draw, so
+ * this is safe to call from the vertex shader threads.
+ */
 static void
-llvm_pipeline_generic(struct draw_pt_middle_end *middle,
-                      const struct draw_fetch_info *fetch_info,
-                      const struct draw_prim_info *in_prim_info)
+llvm_vs_chunk_run(struct llvm_middle_end *fpme, struct llvm_vs_chunk *chunk)
+{
+   struct draw_context *draw = fpme->draw;
+
+   chunk->clipped =
+      fpme->current_variant->jit_func(&fpme->llvm->vs_jit_context,
+                                      &fpme->llvm->jit_resources[PIPE_SHADER_VERTEX],
+                                      chunk->verts,
+                                      draw->pt.user.vbuffer,
+                                      chunk->count,
+                                      chunk->start,
+                                      fpme->vertex_size,
+                                      draw->pt.vertex_buffer,
+                                      chunk->instance_id,
+                                      chunk->vertex_id_offset,
+                                      chunk->start_instance,
+                                      chunk->elts,
+                                      chunk->drawid,
+                                      chunk->viewid);
+}
+
+
+/**
+ * Everything after the vertex shader: tessellation, geometry shader,
+ * stream output, clipping and emit.  Always runs on the calling thread, in
+ * submission order.
+ */
+static void
+llvm_pipeline_finish_chunk(struct llvm_middle_end *fpme,
+                           struct llvm_vs_chunk *chunk,
+                           const struct draw_prim_info *in_prim_info)
 {
-   struct llvm_middle_end *fpme = llvm_middle_end(middle);
    struct draw_context *draw = fpme->draw;
    struct draw_geometry_shader *gshader = draw->gs.geometry_shader;
    struct draw_tess_ctrl_shader *tcs_shader = draw->tcs.tess_ctrl_shader;
@@ -513,22 +642,14 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
    const struct draw_prim_info *prim_info = in_prim_info;
    bool free_prim_info = false;
    unsigned opt = fpme->opt;
-   bool clipped = 0;
+   bool clipped = chunk->clipped;
    uint16_t *tes_elts_out = NULL;
 
-   assert(fetch_info->count > 0);
-
-   llvm_vert_info.count = fetch_info->count;
+   llvm_vert_info.count = chunk->count;
    llvm_vert_info.vertex_size = fpme->vertex_size;
    llvm_vert_info.stride = fpme->vertex_size;
-   llvm_vert_info.verts = (struct vertex_header *)
-      MALLOC(fpme->vertex_size *
-             align(fetch_info->count, lp_native_vector_width / 32) +
-             DRAW_EXTRA_VERTICES_PADDING);
-   if (!llvm_vert_info.verts) {
-      assert(0);
-      return;
-   }
+   llvm_vert_info.verts = chunk->verts;
+   vert_info = &llvm_vert_info;
 
    if (draw->collect_statistics) {
       draw->statistics.ia_vertices += prim_info->count;
@@ -538,41 +659,7 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       else
          draw->statistics.ia_primitives +=
             u_decomposed_prims_for_vertices(prim_info->prim, prim_info->count);
-      draw->statistics.vs_invocations += fetch_info->count;
-   }
-
-   {
-      unsigned start, vertex_id_offset;
-      const unsigned *elts;
-
-      if (fetch_info->linear) {
-         start = fetch_info->start;
-         vertex_id_offset = draw->start_index;
-         elts = NULL;
-      } else {
-         start = draw->pt.user.eltMax;
-         vertex_id_offset = draw->pt.user.eltBias;
-         elts = fetch_info->elts;
-      }
-      /* Run vertex fetch shader */
-      clipped = fpme->current_variant->jit_func(&fpme->llvm->vs_jit_context,
-                                                &fpme->llvm->jit_resources[PIPE_SHADER_VERTEX],
-                                                llvm_vert_info.verts,
-                                                draw->pt.user.vbuffer,
-                                                fetch_info->count,
-                                                start,
-                                                fpme->vertex_size,
-                                                draw->pt.vertex_buffer,
-                                                draw->instance_id,
-                                                vertex_id_offset,
-                                                draw->start_instance,
-                                                elts,
-                                                draw->pt.user.drawid,
-                                                draw->pt.user.viewid);
-
-      /* Finished with fetch and vs */
-      fetch_info = NULL;
-      vert_info = &llvm_vert_info;
+      draw->statistics.vs_invocations += chunk->count;
    }
 
    if (opt & PT_SHADE) {
@@ -717,6 +804,162 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
 }
 
 
+static void
+llvm_vs_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct llvm_vs_job *job = (struct llvm_vs_job *)data;
+
+   /* Match the floating point state draw_vbo() sets on the calling
+    * thread.
+    */
+   unsigned fpstate = util_fpstate_get();
+   util_fpstate_set_denorms_to_zero(fpstate);
+
+   llvm_vs_chunk_run(job->fpme, &job->chunk);
+
+   util_fpstate_set(fpstate);
+}
+
+
+/**
+ * Emit the oldest queued chunk once its vertices are shaded.
+ */
+static void
+llvm_middle_end_finish_job(struct llvm_middle_end *fpme)
+{
+   struct llvm_vs_job *job = &fpme->jobs[fpme->job_head];
+
+   assert(fpme->num_jobs);
+
+   util_queue_fence_wait(&job->fence);
+   llvm_pipeline_finish_chunk(fpme, &job->chunk, &job->prim_info);
+
+   fpme->job_head = (fpme->job_head + 1) % LLVM_VS_MAX_JOBS;
+   fpme->num_jobs--;
+}
+
+
+static bool
+llvm_vs_job_copy_elts(struct llvm_vs_job *job,
+                      const struct draw_fetch_info *fetch_info,
+                      const struct draw_prim_info *prim_info)
+{
+   if (!fetch_info->linear && fetch_info->count > job->fetch_elts_size) {
+      unsigned *elts = REALLOC(job->fetch_elts,
+                               job->fetch_elts_size * sizeof(*elts),
+                               fetch_info->count * sizeof(*elts));
+      if (!elts)
+         return false;
+      job->fetch_elts = elts;
+      job->fetch_elts_size = fetch_info->count;
+   }
+
+   if (!prim_info->linear && prim_info->count > job->draw_elts_size) {
+      uint16_t *elts = REALLOC(job->draw_elts,
+                               job->draw_elts_size * sizeof(*elts),
+                               prim_info->count * sizeof(*elts));
+      if (!elts)
+         return false;
+      job->draw_elts = elts;
+      job->draw_elts_size = prim_info->count;
+   }
+
+   if (!fetch_info->linear)
+      memcpy(job->fetch_elts, fetch_info->elts,
+             fetch_info->count * sizeof(*job->fetch_elts));
+
+   job->prim_info = *prim_info;
+   job->prim_count = prim_info->count;
+   job->prim_info.primitive_lengths = &job->prim_count;
+   if (!prim_info->linear) {
+      memcpy(job->draw_elts, prim_info->elts,
+             prim_info->count * sizeof(*job->draw_elts));
+      job->prim_info.elts = job->draw_elts;
+   }
+   return true;
+}
+
+
+/**
+ * Queue a chunk on the vertex shader threads.  Returns false if it has to
+ * be processed synchronously instead.
+ */
+static bool
+llvm_middle_end_queue_chunk(struct llvm_middle_end *fpme,
+                            const struct draw_fetch_info *fetch_info,
+                            const struct draw_prim_info *prim_info)
+{
+   struct llvm_vs_job *job;
+
+   /* vsplit only ever hands over single primitives. */
+   assert(prim_info->primitive_count == 1);
+
+   if (fpme->num_jobs == LLVM_VS_MAX_JOBS)
+      llvm_middle_end_finish_job(fpme);
+
+   job = &fpme->jobs[(fpme->job_head + fpme->num_jobs) % LLVM_VS_MAX_JOBS];
+   if (!llvm_vs_job_copy_elts(job, fetch_info, prim_info))
+      return false;
+
+   if (!llvm_vs_chunk_init(fpme, fetch_info, &job->chunk))
+      return false;
+
+   if (!fetch_info->linear)
+      job->chunk.elts = job->fetch_elts;
+
+   fpme->num_jobs++;
+   util_queue_add_job(&fpme->vs_queue, job, &job->fence,
+                      llvm_vs_job_execute, NULL, 0);
+   return true;
+}
+
+
+static void
+llvm_pipeline_generic(struct draw_pt_middle_end *middle,
+                      const struct draw_fetch_info *fetch_info,
+                      const struct draw_prim_info *prim_info)
+{
+   struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   struct llvm_vs_chunk chunk;
+
+   if (fpme->vs_async &&
+       llvm_middle_end_queue_chunk(fpme, fetch_info, prim_info))
+      return;
+
+   /* Keep chunks in order if queueing failed. */
+   while (fpme->num_jobs)
+      llvm_middle_end_finish_job(fpme);
+
+   if (!llvm_vs_chunk_init(fpme, fetch_info, &chunk))
+      return;
+
+   llvm_vs_chunk_run(fpme, &chunk);
+   llvm_pipeline_finish_chunk(fpme, &chunk, prim_info);
+}
+
+
+static void
+llvm_middle_end_begin_draw(struct draw_pt_middle_end *middle, unsigned count)
+{
+   struct llvm_middle_end *fpme = llvm_middle_end(middle);
+
+   fpme->vs_async = fpme->num_vs_threads &&
+                    count >= LLVM_VS_THREADS_MIN_VERTICES;
+}
+
+
+static void
+llvm_middle_end_end_draw(struct draw_pt_middle_end *middle)
+{
+   struct llvm_middle_end *fpme = llvm_middle_end(middle);
+
+   while (fpme->num_jobs)
+      llvm_middle_end_finish_job(fpme);
+
+   fpme->vs_async = false;
+}
+
+
 static inline enum mesa_prim
 prim_type(enum mesa_prim prim, unsigned flags)
 {
@@ -829,6 +1072,16 @@ llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
 {
    struct llvm_middle_end *fpme = llvm_middle_end(middle);
 
+   if (fpme->num_vs_threads) {
+      util_queue_destroy(&fpme->vs_queue);
+
+      for (unsigned i = 0; i < LLVM_VS_MAX_JOBS; i++) {
+         util_queue_fence_destroy(&fpme->jobs[i].fence);
+         FREE(fpme->jobs[i].fetch_elts);
+         FREE(fpme->jobs[i].draw_elts);
+      }
+   }
+
    if (fpme->fetch)
       draw_pt_fetch_destroy(fpme->fetch);
 
@@ -845,6 +1098,28 @@ llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
 }
 
 
+static void
+llvm_middle_end_init_vs_threads(struct llvm_middle_end *fpme)
+{
+   unsigned num_threads = debug_get_num_option("DRAW_VS_THREADS", 0);
+
+   num_threads = MIN2(num_threads, LLVM_VS_MAX_JOBS);
+   if (!num_threads)
+      return;
+
+   if (!util_queue_init(&fpme->vs_queue, "drawvs", LLVM_VS_MAX_JOBS,
+                        num_threads, 0, NULL))
+      return;
+
+   for (unsigned i = 0; i < LLVM_VS_MAX_JOBS; i++) {
+      fpme->jobs[i].fpme = fpme;
+      util_queue_fence_init(&fpme->jobs[i].fence);
+   }
+
+   fpme->num_vs_threads = num_threads;
+}
+
+
 struct draw_pt_middle_end *
 draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 {
@@ -862,6 +1137,8 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
    fpme->base.run             = llvm_middle_end_run;
    fpme->base.run_linear      = llvm_middle_end_linear_run;
    fpme->base.run_linear_elts = llvm_middle_end_linear_run_elts;
+   fpme->base.begin_draw      = llvm_middle_end_begin_draw;
+   fpme->base.end_draw        = llvm_middle_end_end_draw;
    fpme->base.finish          = llvm_middle_end_finish;
    fpme->base.destroy         = llvm_middle_end_destroy;
 
@@ -889,6 +1166,8 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   llvm_middle_end_init_vs_threads(fpme);
+
    return &fpme->base;
 
  fail:
@@ -104,7 +104,13 @@ lp_build_min_simple(struct lp_build_context *bld,
 
    /* TODO: optimize the constant case */
 
-   if (type.floating && util_get_cpu_caps()->has_sse) {
+   /*
+    * The AVX-512 min intrinsics take an extra rounding argument; the
+    * compare/select below gets selected to a single 512-bit vminps instead of
+    * two 256-bit halves.
+    */
+   if (type.floating && util_get_cpu_caps()->has_sse &&
+       !(util_get_cpu_caps()->has_avx512f && type.width * type.length == 512)) {
       if (type.width == 32) {
          if (type.length == 1) {
             intrinsic = "llvm.x86.sse.min.ss";
@@ -258,7 +264,13 @@ lp_build_max_simple(struct lp_build_context *bld,
 
    /* TODO: optimize the constant case */
 
-   if (type.floating && util_get_cpu_caps()->has_sse) {
+   /*
+    * The AVX-512 max intrinsics take an extra rounding argument; the
+    * compare/select below gets selected to a single 512-bit vmaxps instead of
+    * two 256-bit halves.
+    */
+   if (type.floating && util_get_cpu_caps()->has_sse &&
+       !(util_get_cpu_caps()->has_avx512f && type.width * type.length == 512)) {
       if (type.width == 32) {
          if (type.length == 1) {
             intrinsic = "llvm.x86.sse.max.ss";
@@ -1922,6 +1934,20 @@ lp_build_iround_nearest_sse2(struct lp_build_context *bld,
       if (type.width* type.length == 128) {
          intrinsic = "llvm.x86.sse2.cvtps2dq";
       }
+      else if (type.width * type.length == 512) {
+         /* Masked, with an explicit rounding argument: use MXCSR (4). */
+         LLVMValueRef args[4];
+
+         assert(util_get_cpu_caps()->has_avx512f);
+
+         args[0] = a;
+         args[1] = LLVMGetUndef(ret_type);
+         args[2] = LLVMConstInt(LLVMInt16TypeInContext(bld->gallivm->context),
+                                0xffff, 0);
+         args[3] = LLVMConstInt(i32t, 4, 0);
+         return lp_build_intrinsic(builder, "llvm.x86.avx512.mask.cvtps2dq.512",
+                                   ret_type, args, 4, 0);
+      }
       else {
          assert(type.width*type.length == 256);
          assert(util_get_cpu_caps()->has_avx);
@@ -2359,7 +2385,8 @@ lp_build_iround(struct lp_build_context *bld,
 
    if ((util_get_cpu_caps()->has_sse2 &&
        ((type.width == 32) && (type.length == 1 || type.length == 4))) ||
-       (util_get_cpu_caps()->has_avx && type.width == 32 && type.length == 8)) {
+       (util_get_cpu_caps()->has_avx && type.width == 32 && type.length == 8) ||
+       (util_get_cpu_caps()->has_avx512f && type.width == 32 && type.length == 16)) {
       return lp_build_iround_nearest_sse2(bld, a);
    }
    if (arch_rounding_available(type)) {
@@ -2766,7 +2793,8 @@ lp_build_fast_rsqrt_available(struct lp_type type)
    assert(type.floating);
 
    if ((util_get_cpu_caps()->has_sse && type.width == 32 && type.length == 4) ||
-       (util_get_cpu_caps()->has_avx && type.width == 32 && type.length == 8)) {
+       (util_get_cpu_caps()->has_avx && type.width == 32 && type.length == 8) ||
+       (util_get_cpu_caps()->has_avx512f && type.width == 32 && type.length == 16)) {
       return true;
    }
    return false;
@@ -2794,9 +2822,19 @@ lp_build_fast_rsqrt(struct lp_build_context *bld,
       if (type.length == 4) {
          intrinsic = "llvm.x86.sse.rsqrt.ps";
       }
-      else {
+      else if (type.length == 8) {
          intrinsic = "llvm.x86.avx.rsqrt.ps.256";
       }
+      else {
+         /* rsqrt14 is masked, pass all lanes through. */
+         LLVMValueRef args[3];
+         args[0] = a;
+         args[1] = bld->undef;
+         args[2] = LLVMConstInt(LLVMInt16TypeInContext(bld->gallivm->context),
+                                0xffff, 0);
+         return lp_build_intrinsic(builder, "llvm.x86.avx512.rsqrt14.ps.512",
+                                   bld->vec_type, args, 3, 0);
+      }
       return lp_build_intrinsic_unary(builder, intrinsic, bld->vec_type, a);
    }
    else {
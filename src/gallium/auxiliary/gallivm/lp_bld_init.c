@@ -107,6 +107,16 @@ enum LLVM_CodeGenOpt_Level {
 };
 
 
+/**
+ * Whether to skip IR optimization and use the fastest code generation.
+ */
+static inline bool
+gallivm_no_opt(const struct gallivm_state *gallivm)
+{
+   return gallivm->no_opt || (gallivm_perf & GALLIVM_PERF_NO_OPT);
+}
+
+
 /**
  * Create the LLVM (optimization) pass manager and install
  * relevant optimization passes.
@@ -150,7 +160,7 @@ create_pass_manager(struct gallivm_state *gallivm)
    LLVMAddCoroElidePass(gallivm->cgpassmgr);
 #endif
 
-   if ((gallivm_perf & GALLIVM_PERF_NO_OPT) == 0) {
+   if (!gallivm_no_opt(gallivm)) {
       /*
        * TODO: Evaluate passes some more - keeping in mind
        * both quality of generated code and compile times.
@@ -274,7 +284,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_perf & GALLIVM_PERF_NO_OPT) {
+      if (gallivm_no_opt(gallivm)) {
          optlevel = None;
       }
       else {
@@ -423,8 +433,14 @@ fail:
 unsigned
 lp_build_init_native_width(void)
 {
-   // Default to 256 until we're confident llvmpipe with 512 is as correct and not slower than 256
-   lp_native_vector_width = MIN2(util_get_cpu_caps()->max_vector_bits, 256);
+   /*
+    * Only go to 512 bits on cpus with the AVX-512 subsets the 16 wide paths
+    * are built from, otherwise (e.g. AVX-512F alone) stay at 256.
+    */
+   const struct util_cpu_caps_t *caps = util_get_cpu_caps();
+   const unsigned max_width = caps->has_avx512f && caps->has_avx512bw &&
+                              caps->has_avx512dq && caps->has_avx512vl ? 512 : 256;
+   lp_native_vector_width = MIN2(caps->max_vector_bits, max_width);
    assert(lp_native_vector_width);
 
    lp_native_vector_width = debug_get_num_option("LP_NATIVE_VECTOR_WIDTH", lp_native_vector_width);
@@ -504,6 +520,29 @@ gallivm_create(const char *name, LLVMContextRef context,
 }
 
 
+/**
+ * Create a new gallivm_state object whose module is compiled without
+ * optimization.  This is much quicker, for code that is only used until
+ * an optimized version is available.  The result is never cached.
+ */
+struct gallivm_state *
+gallivm_create_unoptimized(const char *name, LLVMContextRef context)
+{
+   struct gallivm_state *gallivm;
+
+   gallivm = CALLOC_STRUCT(gallivm_state);
+   if (gallivm) {
+      gallivm->no_opt = true;
+      if (!init_gallivm_state(gallivm, name, context, NULL)) {
+         FREE(gallivm);
+         gallivm = NULL;
+      }
+   }
+
+   return gallivm;
+}
+
+
 /**
  * Destroy a gallivm_state object.
  */
@@ -584,10 +623,10 @@ gallivm_compile_module(struct gallivm_state *gallivm)
       LLVMWriteBitcodeToFile(gallivm->module, filename);
       debug_printf("%s written\n", filename);
       debug_printf("Invoke as \"opt %s %s | llc -O%d %s%s\"\n",
-                   gallivm_perf & GALLIVM_PERF_NO_OPT ? "-mem2reg" :
+                   gallivm_no_opt(gallivm) ? "-mem2reg" :
                    "-sroa -early-cse -simplifycfg -reassociate "
                    "-mem2reg -constprop -instcombine -gvn",
-                   filename, gallivm_perf & GALLIVM_PERF_NO_OPT ? 0 : 2,
+                   filename, gallivm_no_opt(gallivm) ? 0 : 2,
                    "[-mcpu=<-mcpu option>] ",
                    "[-mattr=<-mattr option(s)>]");
    }
@@ -608,7 +647,7 @@ gallivm_compile_module(struct gallivm_state *gallivm)
    LLVMPassBuilderOptionsRef opts = LLVMCreatePassBuilderOptions();
    LLVMRunPasses(gallivm->module, passes, LLVMGetExecutionEngineTargetMachine(gallivm->engine), opts);
 
-   if (!(gallivm_perf & GALLIVM_PERF_NO_OPT))
+   if (!gallivm_no_opt(gallivm))
       strcpy(passes, "sroa,early-cse,simplifycfg,reassociate,mem2reg,instsimplify,instcombine");
    else
       strcpy(passes, "mem2reg");
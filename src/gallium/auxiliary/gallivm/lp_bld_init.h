@@ -58,6 +58,7 @@ struct gallivm_state
    struct lp_generated_code *code;
    struct lp_cached_code *cache;
    unsigned compiled;
+   bool no_opt;
    LLVMValueRef coro_malloc_hook;
    LLVMValueRef coro_free_hook;
    LLVMValueRef debug_printf_hook;
@@ -82,6 +83,9 @@ struct gallivm_state *
 gallivm_create(const char *name, LLVMContextRef context,
                struct lp_cached_code *cache);
 
+struct gallivm_state *
+gallivm_create_unoptimized(const char *name, LLVMContextRef context);
+
 void
 gallivm_destroy(struct gallivm_state *gallivm);
 
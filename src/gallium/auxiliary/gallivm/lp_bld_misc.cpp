@@ -99,6 +99,7 @@
 #include "util/u_cpu_detect.h"
 
 #include "lp_bld_misc.h"
+#include "lp_bld_type.h"
 #include "lp_bld_debug.h"
 
 static void lp_run_atexit_for_destructors(void);
@@ -441,6 +442,12 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    MAttrs.push_back(util_get_cpu_caps()->has_avx512bw ? "+avx512bw"  : "-avx512bw");
    MAttrs.push_back(util_get_cpu_caps()->has_avx512dq ? "+avx512dq"  : "-avx512dq");
    MAttrs.push_back(util_get_cpu_caps()->has_avx512vl ? "+avx512vl"  : "-avx512vl");
+   /*
+    * Most AVX-512 cpus are tuned to prefer 256-bit vectors, which makes llvm
+    * split every 512-bit operation in two unless told otherwise.
+    */
+   if (lp_native_vector_width > 256)
+      MAttrs.push_back("-prefer-256-bit");
 #endif
 #if DETECT_ARCH_ARM
    if (!util_get_cpu_caps()->has_neon) {
@@ -30,6 +30,7 @@
 #include "lp_bld_gather.h"
 #include "lp_bld_const.h"
 #include "lp_bld_struct.h"
+#include "lp_bld_swizzle.h"
 #include "lp_bld_jit_types.h"
 #include "lp_bld_arit.h"
 #include "lp_bld_bitarit.h"
@@ -2354,38 +2355,10 @@ static void emit_shuffle(struct lp_build_nir_context *bld_base, LLVMValueRef src
 {
    assert(instr->intrinsic == nir_intrinsic_shuffle);
 
-   struct gallivm_state *gallivm = bld_base->base.gallivm;
-   LLVMBuilderRef builder = gallivm->builder;
    uint32_t bit_size = nir_src_bit_size(instr->src[0]);
-   uint32_t index_bit_size = nir_src_bit_size(instr->src[1]);
    struct lp_build_context *int_bld = get_int_bld(bld_base, true, bit_size);
 
-   if (util_get_cpu_caps()->has_avx2 && bit_size == 32 && index_bit_size == 32 && int_bld->type.length == 8) {
-      /* freeze `src` in case inactive invocations contain poison */
-      src = LLVMBuildFreeze(builder, src, "");
-      result[0] = lp_build_intrinsic_binary(builder, "llvm.x86.avx2.permd", int_bld->vec_type, src, index);
-   } else {
-      LLVMValueRef res_store = lp_build_alloca(gallivm, int_bld->vec_type, "");
-      struct lp_build_loop_state loop_state;
-      lp_build_loop_begin(&loop_state, gallivm, lp_build_const_int32(gallivm, 0));
-
-      LLVMValueRef index_value = LLVMBuildExtractElement(builder, index, loop_state.counter, "");
-
-      LLVMValueRef src_value = LLVMBuildExtractElement(builder, src, index_value, "");
-      /* freeze `src_value` in case an out-of-bounds index or an index into an
-       * inactive invocation results in poison
-       */
-      src_value = LLVMBuildFreeze(builder, src_value, "");
-
-      LLVMValueRef res = LLVMBuildLoad2(builder, int_bld->vec_type, res_store, "");
-      res = LLVMBuildInsertElement(builder, res, src_value, loop_state.counter, "");
-      LLVMBuildStore(builder, res, res_store);
-
-      lp_build_loop_end_cond(&loop_state, lp_build_const_int32(gallivm, bld_base->uint_bld.type.length),
-                             NULL, LLVMIntUGE);
-
-      result[0] = LLVMBuildLoad2(builder, int_bld->vec_type, res_store, "");
-   }
+   result[0] = lp_build_shuffle_dynamic(int_bld, src, index);
 }
 #endif
 
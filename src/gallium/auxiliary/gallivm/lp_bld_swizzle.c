@@ -34,11 +34,14 @@
 
 #include <inttypes.h>  /* for PRIx64 macro */
 #include "util/compiler.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
 
 #include "lp_bld_type.h"
 #include "lp_bld_const.h"
+#include "lp_bld_flow.h"
 #include "lp_bld_init.h"
+#include "lp_bld_intr.h"
 #include "lp_bld_logic.h"
 #include "lp_bld_swizzle.h"
 #include "lp_bld_pack.h"
@@ -301,6 +304,61 @@ lp_build_swizzle_scalar_aos(struct lp_build_context *bld,
 }
 
 
+#if LLVM_VERSION_MAJOR >= 10
+/**
+ * Build a vector whose element i is element index[i] of \p src, i.e. a
+ * shuffle whose selector is only known at run time.
+ *
+ * Out-of-range indices give an undefined (but not poison) element.
+ */
+LLVMValueRef
+lp_build_shuffle_dynamic(struct lp_build_context *bld,
+                         LLVMValueRef src,
+                         LLVMValueRef index)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   const struct lp_type type = bld->type;
+   const unsigned index_bit_size =
+      LLVMGetIntTypeWidth(LLVMGetElementType(LLVMTypeOf(index)));
+
+   if (util_get_cpu_caps()->has_avx2 && type.width == 32 &&
+       index_bit_size == 32 && type.length == 8) {
+      /* freeze `src` in case inactive invocations contain poison */
+      src = LLVMBuildFreeze(builder, src, "");
+      return lp_build_intrinsic_binary(builder, "llvm.x86.avx2.permd",
+                                       bld->vec_type, src, index);
+   } else if (util_get_cpu_caps()->has_avx512f && type.width == 32 &&
+              index_bit_size == 32 && type.length == 16) {
+      src = LLVMBuildFreeze(builder, src, "");
+      return lp_build_intrinsic_binary(builder, "llvm.x86.avx512.permvar.si.512",
+                                       bld->vec_type, src, index);
+   } else {
+      LLVMValueRef res_store = lp_build_alloca(gallivm, bld->vec_type, "");
+      struct lp_build_loop_state loop_state;
+      lp_build_loop_begin(&loop_state, gallivm, lp_build_const_int32(gallivm, 0));
+
+      LLVMValueRef index_value = LLVMBuildExtractElement(builder, index, loop_state.counter, "");
+
+      LLVMValueRef src_value = LLVMBuildExtractElement(builder, src, index_value, "");
+      /* freeze `src_value` in case an out-of-bounds index or an index into an
+       * inactive invocation results in poison
+       */
+      src_value = LLVMBuildFreeze(builder, src_value, "");
+
+      LLVMValueRef res = LLVMBuildLoad2(builder, bld->vec_type, res_store, "");
+      res = LLVMBuildInsertElement(builder, res, src_value, loop_state.counter, "");
+      LLVMBuildStore(builder, res, res_store);
+
+      lp_build_loop_end_cond(&loop_state, lp_build_const_int32(gallivm, type.length),
+                             NULL, LLVMIntUGE);
+
+      return LLVMBuildLoad2(builder, bld->vec_type, res_store, "");
+   }
+}
+#endif
+
+
 /**
  * Swizzle a vector consisting of an array of XYZW structs.
  *
@@ -132,6 +132,14 @@ lp_build_transpose_aos_n(struct gallivm_state *gallivm,
                          LLVMValueRef* dst);
 
 
+#if LLVM_VERSION_MAJOR >= 10
+LLVMValueRef
+lp_build_shuffle_dynamic(struct lp_build_context *bld,
+                         LLVMValueRef src,
+                         LLVMValueRef index);
+#endif
+
+
 LLVMValueRef
 lp_build_pack_aos_scalars(struct gallivm_state *gallivm,
                           struct lp_type src_type,
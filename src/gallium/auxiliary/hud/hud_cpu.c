@@ -424,6 +424,17 @@ static unsigned get_counter(struct hud_graph *gr, enum hud_counter counter)
       value = mon->num_batches;
       mon->num_batches = 0;
       return value;
+   case HUD_COUNTER_ELIDED:
+      value = mon->num_elided_cmds;
+      mon->num_elided_cmds = 0;
+      return value;
+   case HUD_COUNTER_BATCH_FILL:
+      /* Average percentage of the batch buffer used by submitted batches. */
+      value = mon->num_filled_batches ?
+                 mon->batch_fill_percent_sum / mon->num_filled_batches : 0;
+      mon->batch_fill_percent_sum = 0;
+      mon->num_filled_batches = 0;
+      return value;
    default:
       assert(0);
       return 0;
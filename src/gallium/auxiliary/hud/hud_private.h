@@ -40,6 +40,8 @@ enum hud_counter {
    HUD_COUNTER_DIRECT,
    HUD_COUNTER_SYNCS,
    HUD_COUNTER_BATCHES,
+   HUD_COUNTER_ELIDED,
+   HUD_COUNTER_BATCH_FILL,
 };
 
 struct hud_context {
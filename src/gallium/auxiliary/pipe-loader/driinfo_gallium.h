@@ -39,6 +39,7 @@ DRI_CONF_SECTION_DEBUG
    DRI_CONF_GLSL_IGNORE_WRITE_TO_READONLY_VAR(false)
    DRI_CONF_ALLOW_DRAW_OUT_OF_ORDER(true)
    DRI_CONF_GLTHREAD_NOP_CHECK_FRAMEBUFFER_STATUS(false)
+   DRI_CONF_GLTHREAD_BATCH_POLICY(0)
    DRI_CONF_FORCE_COMPAT_PROFILE(false)
    DRI_CONF_FORCE_COMPAT_SHADERS(false)
    DRI_CONF_FORCE_GL_NAMES_REUSE(false)
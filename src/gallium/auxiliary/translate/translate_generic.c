@@ -68,11 +68,15 @@ struct translate_generic {
        * to do a full conversion
        *
        * this value is set to the format size in bytes if
-       * output_format == input_format or for 32-bit instance ids:
+       * output_format == input_format, if the output format holds the
+       * first channels of the input format, or for 32-bit instance ids:
        * in this case, memcpy is used to copy this amount of bytes
        */
       int copy_size;
 
+      /* direct conversion for common layouts, replaces fetch + emit */
+      emit_func convert;
+
    } attrib[TRANSLATE_MAX_ATTRIBS];
 
    unsigned nr_attrib;
@@ -584,6 +588,162 @@ get_emit_func(enum pipe_format format)
    }
 }
 
+
+/**
+ * Direct conversions for the most common vertex layouts: the usual
+ * attribute formats fetched into float4 by the draw module, and float4
+ * vertex shader outputs emitted as packed colors.  These skip the float[4]
+ * round trip through util_format and the emit function, and produce the
+ * same results.
+ */
+#define CONVERT_TO_FLOAT4(NAME, SRCTYPE, NR, FROM)      \
+static void                                             \
+convert_##NAME##_to_float4(const void *attrib, void *ptr) \
+{                                                       \
+   SRCTYPE in[NR];                                      \
+   float out[4] = { 0.0f, 0.0f, 0.0f, 1.0f };           \
+   unsigned i;                                          \
+                                                        \
+   memcpy(in, attrib, sizeof(in));                      \
+   for (i = 0; i < NR; i++)                             \
+      out[i] = FROM(in[i]);                             \
+   memcpy(ptr, out, sizeof(out));                       \
+}
+
+#define FROM_32_FLOAT(x)   (x)
+#define FROM_16_FLOAT(x)   _mesa_half_to_float(x)
+#define FROM_8_UNORM(x)    ubyte_to_float(x)
+
+CONVERT_TO_FLOAT4(R32_FLOAT,          float,    1, FROM_32_FLOAT)
+CONVERT_TO_FLOAT4(R32G32_FLOAT,       float,    2, FROM_32_FLOAT)
+CONVERT_TO_FLOAT4(R32G32B32_FLOAT,    float,    3, FROM_32_FLOAT)
+CONVERT_TO_FLOAT4(R16G16_FLOAT,       uint16_t, 2, FROM_16_FLOAT)
+CONVERT_TO_FLOAT4(R16G16B16A16_FLOAT, uint16_t, 4, FROM_16_FLOAT)
+CONVERT_TO_FLOAT4(R8G8B8A8_UNORM,     uint8_t,  4, FROM_8_UNORM)
+
+static void
+convert_B8G8R8A8_UNORM_to_float4(const void *attrib, void *ptr)
+{
+   const uint8_t *in = (const uint8_t *)attrib;
+   float out[4];
+
+   out[0] = ubyte_to_float(in[2]);
+   out[1] = ubyte_to_float(in[1]);
+   out[2] = ubyte_to_float(in[0]);
+   out[3] = ubyte_to_float(in[3]);
+   memcpy(ptr, out, sizeof(out));
+}
+
+static void
+convert_float4_to_R8G8B8A8_UNORM(const void *attrib, void *ptr)
+{
+   float in[4];
+
+   memcpy(in, attrib, sizeof(in));
+   emit_R8G8B8A8_UNORM(in, ptr);
+}
+
+static void
+convert_float4_to_B8G8R8A8_UNORM(const void *attrib, void *ptr)
+{
+   float in[4];
+
+   memcpy(in, attrib, sizeof(in));
+   emit_B8G8R8A8_UNORM(in, ptr);
+}
+
+static const struct {
+   enum pipe_format input_format;
+   enum pipe_format output_format;
+   emit_func convert;
+} generic_converters[] = {
+#define TO_FLOAT4(NAME) \
+   { PIPE_FORMAT_##NAME, PIPE_FORMAT_R32G32B32A32_FLOAT, convert_##NAME##_to_float4 }
+#define FROM_FLOAT4(NAME) \
+   { PIPE_FORMAT_R32G32B32A32_FLOAT, PIPE_FORMAT_##NAME, convert_float4_to_##NAME }
+   TO_FLOAT4(R32_FLOAT),
+   TO_FLOAT4(R32G32_FLOAT),
+   TO_FLOAT4(R32G32B32_FLOAT),
+   TO_FLOAT4(R16G16_FLOAT),
+   TO_FLOAT4(R16G16B16A16_FLOAT),
+   TO_FLOAT4(R8G8B8A8_UNORM),
+   TO_FLOAT4(B8G8R8A8_UNORM),
+   FROM_FLOAT4(R8G8B8A8_UNORM),
+   FROM_FLOAT4(B8G8R8A8_UNORM),
+#undef TO_FLOAT4
+#undef FROM_FLOAT4
+};
+
+static emit_func
+get_convert_func(enum pipe_format input_format, enum pipe_format output_format)
+{
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(generic_converters); i++) {
+      if (generic_converters[i].input_format == input_format &&
+          generic_converters[i].output_format == output_format)
+         return generic_converters[i].convert;
+   }
+   return NULL;
+}
+
+/**
+ * Returns the number of bytes to copy if the output format consists of the
+ * first channels of the input format, unchanged, e.g. R32G32B32A32_FLOAT
+ * emitted as R32G32B32_FLOAT.  Returns -1 otherwise.
+ */
+static int
+get_copy_size(const struct util_format_description *in_desc,
+              const struct util_format_description *out_desc)
+{
+   unsigned i;
+
+   if (in_desc->format == out_desc->format) {
+      if (in_desc->block.width != 1 || in_desc->block.height != 1 ||
+          (in_desc->block.bits & 7))
+         return -1;
+      return in_desc->block.bits >> 3;
+   }
+
+   if (!in_desc->is_array || !out_desc->is_array ||
+       in_desc->colorspace != out_desc->colorspace ||
+       out_desc->nr_channels > in_desc->nr_channels)
+      return -1;
+
+   for (i = 0; i < out_desc->nr_channels; i++) {
+      if (in_desc->swizzle[i] != PIPE_SWIZZLE_X + i ||
+          out_desc->swizzle[i] != PIPE_SWIZZLE_X + i ||
+          memcmp(&in_desc->channel[i], &out_desc->channel[i],
+                 sizeof(in_desc->channel[i])) != 0)
+         return -1;
+   }
+
+   return out_desc->block.bits >> 3;
+}
+
+static ALWAYS_INLINE void
+generic_copy(uint8_t *dst, const uint8_t *src, int size)
+{
+   /* Constant sizes let the compiler inline the copy. */
+   switch (size) {
+   case 4:
+      memcpy(dst, src, 4);
+      break;
+   case 8:
+      memcpy(dst, src, 8);
+      break;
+   case 12:
+      memcpy(dst, src, 12);
+      break;
+   case 16:
+      memcpy(dst, src, 16);
+      break;
+   default:
+      memcpy(dst, src, size);
+      break;
+   }
+}
+
 static ALWAYS_INLINE void UTIL_CDECL
 generic_run_one(struct translate_generic *tg,
                 unsigned elt,
@@ -625,7 +785,9 @@ generic_run_one(struct translate_generic *tg,
 
          copy_size = tg->attrib[attr].copy_size;
          if (likely(copy_size >= 0)) {
-            memcpy(dst, src, copy_size);
+            generic_copy(dst, src, copy_size);
+         } else if (tg->attrib[attr].convert) {
+            tg->attrib[attr].convert(src, dst);
          } else {
             tg->attrib[attr].fetch(data, src, 1);
 
@@ -828,11 +990,13 @@ translate_generic_create(const struct translate_key *key)
              || key->element[i].output_format == PIPE_FORMAT_R32_SSCALED)
             tg->attrib[i].copy_size = 4;
       } else {
-         if (key->element[i].input_format == key->element[i].output_format
-             && format_desc->block.width == 1
-             && format_desc->block.height == 1
-             && !(format_desc->block.bits & 7))
-            tg->attrib[i].copy_size = format_desc->block.bits >> 3;
+         tg->attrib[i].copy_size =
+            get_copy_size(format_desc,
+                          util_format_description(key->element[i].output_format));
+         if (tg->attrib[i].copy_size < 0)
+            tg->attrib[i].convert =
+               get_convert_func(key->element[i].input_format,
+                                key->element[i].output_format);
       }
 
       if (tg->attrib[i].copy_size < 0)
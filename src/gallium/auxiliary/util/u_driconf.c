@@ -65,6 +65,7 @@ u_driconf_fill_st_options(struct st_config_options *options,
    query_bool_option(do_dce_before_clip_cull_analysis);
    query_bool_option(allow_draw_out_of_order);
    query_bool_option(glthread_nop_check_framebuffer_status);
+   query_int_option(glthread_batch_policy);
    query_bool_option(ignore_map_unsynchronized);
    query_bool_option(ignore_discard_framebuffer);
    query_bool_option(force_gl_names_reuse);
@@ -521,7 +521,9 @@ tc_batch_execute(void *job, UNUSED void *gdata, int thread_index)
    struct util_queue_fence *fence =
       &tc->buffer_lists[batch->buffer_list_index].driver_flushed_fence;
 
-   if (tc->options.driver_calls_flush_notify) {
+   if (batch->shares_buffer_list) {
+      /* The next batch will add the fence. */
+   } else if (tc->options.driver_calls_flush_notify) {
       tc->signal_fences_next_flush[tc->num_signal_fences_next_flush++] = fence;
 
       /* Since our buffer lists are chained as a ring, we need to flush
@@ -541,6 +543,7 @@ tc_batch_execute(void *job, UNUSED void *gdata, int thread_index)
    batch->num_total_slots = 0;
    batch->last_mergeable_call = NULL;
    batch->first_set_fb = false;
+   batch->shares_buffer_list = false;
    batch->max_renderpass_info_idx = 0;
    batch->tc->last_completed = batch->batch_idx;
 }
@@ -549,6 +552,7 @@ static void
 tc_begin_next_buffer_list(struct threaded_context *tc)
 {
    tc->next_buf_list = (tc->next_buf_list + 1) % TC_MAX_BUFFER_LISTS;
+   tc->buffer_list_slots = 0;
 
    tc->batch_slots[tc->next].buffer_list_index = tc->next_buf_list;
 
@@ -581,6 +585,8 @@ tc_batch_flush(struct threaded_context *tc, bool full_copy)
 {
    struct tc_batch *next = &tc->batch_slots[tc->next];
    unsigned next_id = (tc->next + 1) % TC_MAX_BATCHES;
+   /* read before the batch is queued, it's cleared once executed */
+   bool shares_buffer_list = next->shares_buffer_list;
 
    tc_assert(next->num_total_slots != 0);
    tc_add_call_end(next);
@@ -611,10 +617,38 @@ tc_batch_flush(struct threaded_context *tc, bool full_copy)
    tc->next = next_id;
    if (next_id == 0)
       tc->batch_generation++;
-   tc_begin_next_buffer_list(tc);
+   if (shares_buffer_list)
+      tc->batch_slots[next_id].buffer_list_index = tc->next_buf_list;
+   else
+      tc_begin_next_buffer_list(tc);
 
 }
 
+/* Adapt the batch size to the driver thread before flushing a batch that
+ * filled up.  If the previous batch has already been executed, the driver
+ * thread is idle and waiting for this one, so the next batches are made
+ * smaller to hand it work sooner.  If the oldest batch of the ring is still
+ * busy, the driver thread is the bottleneck and the batches are made larger
+ * again to lower the queuing overhead.
+ */
+static void
+tc_update_batch_slot_limit(struct threaded_context *tc)
+{
+   unsigned oldest = (tc->next + 1) % TC_MAX_BATCHES;
+
+   /* No batch has been flushed yet, tc->last is the recording batch. */
+   if (tc->last == tc->next)
+      return;
+
+   if (util_queue_fence_is_signalled(&tc->batch_slots[tc->last].fence)) {
+      tc->batch_slot_limit = MAX2(tc->batch_slot_limit / 2,
+                                  TC_MIN_SLOTS_PER_BATCH);
+   } else if (!util_queue_fence_is_signalled(&tc->batch_slots[oldest].fence)) {
+      tc->batch_slot_limit = MIN2(tc->batch_slot_limit * 2,
+                                  TC_SLOTS_PER_BATCH - 1);
+   }
+}
+
 /* This is the function that adds variable-sized calls into the current
  * batch. It also flushes the batch if there is not enough space there.
  * All other higher-level "add" functions use it.
@@ -628,7 +662,19 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
    assert(num_slots <= TC_SLOTS_PER_BATCH - 1);
    tc_debug_check(tc);
 
-   if (unlikely(next->num_total_slots + num_slots > TC_SLOTS_PER_BATCH - 1)) {
+   /* A call larger than the limit still goes into an empty batch. */
+   if (unlikely(next->num_total_slots + num_slots > tc->batch_slot_limit &&
+                next->num_total_slots)) {
+      tc_update_batch_slot_limit(tc);
+      /* A batch flushed before it's full leaves its buffer list to the next
+       * one until the list has seen a full batch worth of slots.  Buffer
+       * lists and the driver flushes that recycle them (see
+       * tc_batch_execute) then follow the amount of work, not the number
+       * of batches.
+       */
+      tc->buffer_list_slots += next->num_total_slots;
+      next->shares_buffer_list =
+         tc->buffer_list_slots + tc->batch_slot_limit <= TC_SLOTS_PER_BATCH - 1;
       /* copy existing renderpass info during flush */
       tc_batch_flush(tc, true);
       next = &tc->batch_slots[tc->next];
@@ -4048,10 +4094,10 @@ tc_draw_multi(struct pipe_context *_pipe, const struct pipe_draw_info *info,
    while (num_draws) {
       struct tc_batch *next = &tc->batch_slots[tc->next];
 
-      int nb_slots_left = TC_SLOTS_PER_BATCH - 1 - next->num_total_slots;
+      int nb_slots_left = (int)tc->batch_slot_limit - next->num_total_slots;
       /* If there isn't enough place for one draw, try to fill the next one */
       if (nb_slots_left < SLOTS_FOR_ONE_DRAW)
-         nb_slots_left = TC_SLOTS_PER_BATCH - 1;
+         nb_slots_left = tc->batch_slot_limit;
       const int size_left_bytes = nb_slots_left * sizeof(struct tc_call_base);
 
       /* How many draws can we fit in the current batch */
@@ -4117,10 +4163,10 @@ tc_draw_user_indices_multi(struct pipe_context *_pipe,
    while (num_draws) {
       struct tc_batch *next = &tc->batch_slots[tc->next];
 
-      int nb_slots_left = TC_SLOTS_PER_BATCH - 1 - next->num_total_slots;
+      int nb_slots_left = (int)tc->batch_slot_limit - next->num_total_slots;
       /* If there isn't enough place for one draw, try to fill the next one */
       if (nb_slots_left < SLOTS_FOR_ONE_DRAW)
-         nb_slots_left = TC_SLOTS_PER_BATCH - 1;
+         nb_slots_left = tc->batch_slot_limit;
       const int size_left_bytes = nb_slots_left * sizeof(struct tc_call_base);
 
       /* How many draws can we fit in the current batch */
@@ -4412,10 +4458,10 @@ tc_draw_vertex_state(struct pipe_context *_pipe,
    while (num_draws) {
       struct tc_batch *next = &tc->batch_slots[tc->next];
 
-      int nb_slots_left = TC_SLOTS_PER_BATCH - 1 - next->num_total_slots;
+      int nb_slots_left = (int)tc->batch_slot_limit - next->num_total_slots;
       /* If there isn't enough place for one draw, try to fill the next one */
       if (nb_slots_left < slots_for_one_draw)
-         nb_slots_left = TC_SLOTS_PER_BATCH - 1;
+         nb_slots_left = tc->batch_slot_limit;
       const int size_left_bytes = nb_slots_left * sizeof(struct tc_call_base);
 
       /* How many draws can we fit in the current batch */
@@ -5257,6 +5303,7 @@ threaded_context_create(struct pipe_context *pipe,
       goto fail;
 
    tc->last_completed = -1;
+   tc->batch_slot_limit = TC_SLOTS_PER_BATCH - 1;
    for (unsigned i = 0; i < TC_MAX_BATCHES; i++) {
 #if !defined(NDEBUG) && TC_DEBUG >= 1
       tc->batch_slots[i].sentinel = TC_SENTINEL;
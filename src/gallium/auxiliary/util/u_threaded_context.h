@@ -189,7 +189,9 @@
  * Once a batch is full and there is no space for the next call, it's flushed,
  * meaning that it's added to the queue for execution in the other thread.
  * The batches are ordered in a ring and reused once they are idle again.
- * The batching is necessary for low queue/mutex overhead.
+ * The batching is necessary for low queue/mutex overhead. When the other
+ * thread keeps up and sits idle, batches are flushed before they are full
+ * to lower latency.
  */
 
 #ifndef U_THREADED_CONTEXT_H
@@ -250,6 +252,12 @@ struct tc_unflushed_batch_token;
  */
 #define TC_SLOTS_PER_BATCH    1536
 
+/* Batches are flushed before they are full when the driver thread runs out
+ * of work, down to this size.  See tc_update_batch_slot_limit.  Such batches
+ * share a buffer list until it has seen TC_SLOTS_PER_BATCH slots.
+ */
+#define TC_MIN_SLOTS_PER_BATCH (TC_SLOTS_PER_BATCH / 4)
+
 /* The buffer list queue is much deeper than the batch queue because buffer
  * lists need to stay around until the driver internally flushes its command
  * buffer.
@@ -515,6 +523,8 @@ struct tc_batch {
    struct util_queue_fence fence;
    /* whether the first set_framebuffer_state call has been seen by this batch */
    bool first_set_fb;
+   /* whether the next batch records into the same buffer list */
+   bool shares_buffer_list;
    uint8_t batch_idx;
    struct tc_unflushed_batch_token *token;
    uint64_t slots[TC_SLOTS_PER_BATCH];
@@ -625,6 +635,11 @@ struct threaded_context {
 
    unsigned last, next, next_buf_list, batch_generation;
 
+   /* The number of slots after which the recorded batch is flushed. */
+   unsigned batch_slot_limit;
+   /* The number of slots of flushed batches in the current buffer list. */
+   unsigned buffer_list_slots;
+
    /* The list fences that the driver should signal after the next flush.
     * If this is empty, all driver command buffers have been flushed.
     */
@@ -457,6 +457,17 @@ lp_build_occlusion_count(struct gallivm_state *gallivm,
       count = lp_build_intrinsic_unary(builder, popcntintr,
                                        LLVMInt32TypeInContext(context), bits);
       count = LLVMBuildZExt(builder, count, LLVMIntTypeInContext(context, 64), "");
+   }
+   else if (util_get_cpu_caps()->has_avx512f && type.length == 16) {
+      /* Compare into a k register and count its bits. */
+      LLVMTypeRef i16t = LLVMInt16TypeInContext(context);
+      LLVMValueRef bits = LLVMBuildBitCast(builder, maskvalue,
+                                           lp_build_int_vec_type(gallivm, type), "");
+      bits = LLVMBuildICmp(builder, LLVMIntNE, bits,
+                           LLVMConstNull(LLVMTypeOf(bits)), "");
+      bits = LLVMBuildBitCast(builder, bits, i16t, "");
+      count = lp_build_intrinsic_unary(builder, "llvm.ctpop.i16", i16t, bits);
+      count = LLVMBuildZExt(builder, count, LLVMIntTypeInContext(context, 64), "");
    } else {
       LLVMValueRef countv = LLVMBuildAnd(builder, maskvalue, countmask, "countv");
       LLVMTypeRef counttype = LLVMIntTypeInContext(context, type.length * 8);
@@ -514,6 +525,28 @@ lp_build_occlusion_count(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Position of the value of fragment vector element i, which are ordered
+ * as n 2x2 quads, within the rows of the 4x4 block.
+ */
+static inline unsigned
+quad_to_row_index(unsigned i)
+{
+   return (i & 1) + (i & 2) * 2 + (i & 4) / 2 + (i & 8);
+}
+
+
+/**
+ * Fragment vector element of the value at x, y of the 4x4 block, the
+ * inverse of quad_to_row_index().
+ */
+static inline unsigned
+row_to_quad_index(unsigned x, unsigned y)
+{
+   return (x & 1) + (y & 1) * 2 + (x & 2) * 2 + (y & 2) * 4;
+}
+
+
 /**
  * Load depth/stencil values.
  * The stored values are linear, swizzle them.
@@ -540,12 +573,14 @@ lp_build_depth_stencil_load_swizzled(struct gallivm_state *gallivm,
 {
    LLVMBuilderRef builder = gallivm->builder;
    LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 4];
-   LLVMValueRef depth_offset1, depth_offset2;
+   LLVMValueRef depth_offset1;
    const unsigned depth_bytes = format_desc->block.bits / 8;
    struct lp_type zs_type = lp_depth_type(format_desc, z_src_type.length);
 
+   /* 16 wide vectors cover the whole 4x4 block, smaller ones 2 rows of it */
+   const unsigned num_rows = z_src_type.length == 16 ? 4 : 2;
    struct lp_type zs_load_type = zs_type;
-   zs_load_type.length = zs_load_type.length / 2;
+   zs_load_type.length = zs_load_type.length / num_rows;
 
    LLVMTypeRef zs_dst_type = lp_build_vec_type(gallivm, zs_load_type);
 
@@ -565,39 +600,43 @@ lp_build_depth_stencil_load_swizzled(struct gallivm_state *gallivm,
          shuffles[i] = lp_build_const_int32(gallivm, i);
       }
    } else {
-      unsigned i;
-      LLVMValueRef loopx2 = LLVMBuildShl(builder, loop_counter,
-                                         lp_build_const_int32(gallivm, 1), "");
-      assert(z_src_type.length == 8);
-      depth_offset1 = LLVMBuildMul(builder, loopx2, depth_stride, "");
+      if (z_src_type.length == 8) {
+         LLVMValueRef loopx2 = LLVMBuildShl(builder, loop_counter,
+                                            lp_build_const_int32(gallivm, 1), "");
+         depth_offset1 = LLVMBuildMul(builder, loopx2, depth_stride, "");
+      } else {
+         assert(z_src_type.length == 16);
+         depth_offset1 = lp_build_const_int32(gallivm, 0);
+      }
       /*
-       * We load 2x4 values, and need to swizzle them (order
-       * 0,1,4,5,2,3,6,7) - not so hot with avx unfortunately.
+       * We load 2x4 or 4x4 values, and need to swizzle them (order
+       * 0,1,4,5,2,3,6,7,...) - not so hot with avx unfortunately.
        */
-      for (i = 0; i < 8; i++) {
-         shuffles[i] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2);
+      for (unsigned i = 0; i < z_src_type.length; i++) {
+         shuffles[i] = lp_build_const_int32(gallivm, quad_to_row_index(i));
       }
    }
 
-   depth_offset2 = LLVMBuildAdd(builder, depth_offset1, depth_stride, "");
-
    /* Load current z/stencil values from z/stencil buffer */
    LLVMTypeRef load_ptr_type = LLVMPointerType(zs_dst_type, 0);
    LLVMTypeRef int8_type = LLVMInt8TypeInContext(gallivm->context);
-   LLVMValueRef zs_dst_ptr =
-      LLVMBuildGEP2(builder, int8_type, depth_ptr, &depth_offset1, 1, "");
-   zs_dst_ptr = LLVMBuildBitCast(builder, zs_dst_ptr, load_ptr_type, "");
-   LLVMValueRef zs_dst1 = LLVMBuildLoad2(builder, zs_dst_type, zs_dst_ptr, "");
-   LLVMValueRef zs_dst2;
-   if (is_1d) {
-      zs_dst2 = lp_build_undef(gallivm, zs_load_type);
-   } else {
-      zs_dst_ptr = LLVMBuildGEP2(builder, int8_type, depth_ptr, &depth_offset2, 1, "");
+   LLVMValueRef zs_dst[4];
+   LLVMValueRef depth_offset = depth_offset1;
+   for (unsigned r = 0; r < num_rows; r++) {
+      if (is_1d && r > 0) {
+         zs_dst[r] = lp_build_undef(gallivm, zs_load_type);
+         continue;
+      }
+      LLVMValueRef zs_dst_ptr =
+         LLVMBuildGEP2(builder, int8_type, depth_ptr, &depth_offset, 1, "");
       zs_dst_ptr = LLVMBuildBitCast(builder, zs_dst_ptr, load_ptr_type, "");
-      zs_dst2 = LLVMBuildLoad2(builder, zs_dst_type, zs_dst_ptr, "");
+      zs_dst[r] = LLVMBuildLoad2(builder, zs_dst_type, zs_dst_ptr, "");
+      depth_offset = LLVMBuildAdd(builder, depth_offset, depth_stride, "");
    }
 
-   *z_fb = LLVMBuildShuffleVector(builder, zs_dst1, zs_dst2,
+   LLVMValueRef zs_rows = lp_build_concat(gallivm, zs_dst, zs_load_type,
+                                          num_rows);
+   *z_fb = LLVMBuildShuffleVector(builder, zs_rows, zs_rows,
                                   LLVMConstVector(shuffles, zs_type.length), "");
    *s_fb = *z_fb;
 
@@ -680,18 +719,17 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
                                       LLVMValueRef s_value)
 {
    struct lp_build_context z_bld;
-   LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 4];
    LLVMBuilderRef builder = gallivm->builder;
-   LLVMValueRef zs_dst1, zs_dst2;
-   LLVMValueRef zs_dst_ptr1, zs_dst_ptr2;
-   LLVMValueRef depth_offset1, depth_offset2;
+   LLVMValueRef depth_offset;
    LLVMTypeRef load_ptr_type;
    unsigned depth_bytes = format_desc->block.bits / 8;
    struct lp_type zs_type = lp_depth_type(format_desc, z_src_type.length);
    struct lp_type z_type = zs_type;
    struct lp_type zs_load_type = zs_type;
+   /* 16 wide vectors cover the whole 4x4 block, smaller ones 2 rows of it */
+   const unsigned num_rows = z_src_type.length == 16 ? 4 : 2;
 
-   zs_load_type.length = zs_load_type.length / 2;
+   zs_load_type.length = zs_load_type.length / num_rows;
    load_ptr_type = LLVMPointerType(lp_build_vec_type(gallivm, zs_load_type), 0);
 
    z_type.width = z_src_type.width;
@@ -709,31 +747,18 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
                                           lp_build_const_int32(gallivm, 2), "");
       LLVMValueRef offset2 = LLVMBuildMul(builder, loopmsb,
                                           depth_stride, "");
-      depth_offset1 = LLVMBuildMul(builder, looplsb,
-                                   lp_build_const_int32(gallivm, depth_bytes * 2), "");
-      depth_offset1 = LLVMBuildAdd(builder, depth_offset1, offset2, "");
-   } else {
+      depth_offset = LLVMBuildMul(builder, looplsb,
+                                  lp_build_const_int32(gallivm, depth_bytes * 2), "");
+      depth_offset = LLVMBuildAdd(builder, depth_offset, offset2, "");
+   } else if (z_src_type.length == 8) {
       LLVMValueRef loopx2 = LLVMBuildShl(builder, loop_counter,
                                          lp_build_const_int32(gallivm, 1), "");
-      assert(z_src_type.length == 8);
-      depth_offset1 = LLVMBuildMul(builder, loopx2, depth_stride, "");
-      /*
-       * We load 2x4 values, and need to swizzle them (order
-       * 0,1,4,5,2,3,6,7) - not so hot with avx unfortunately.
-       */
-      for (unsigned i = 0; i < 8; i++) {
-         shuffles[i] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2);
-      }
+      depth_offset = LLVMBuildMul(builder, loopx2, depth_stride, "");
+   } else {
+      assert(z_src_type.length == 16);
+      depth_offset = lp_build_const_int32(gallivm, 0);
    }
 
-   depth_offset2 = LLVMBuildAdd(builder, depth_offset1, depth_stride, "");
-
-   LLVMTypeRef int8_type = LLVMInt8TypeInContext(gallivm->context);
-   zs_dst_ptr1 = LLVMBuildGEP2(builder, int8_type, depth_ptr, &depth_offset1, 1, "");
-   zs_dst_ptr1 = LLVMBuildBitCast(builder, zs_dst_ptr1, load_ptr_type, "");
-   zs_dst_ptr2 = LLVMBuildGEP2(builder, int8_type, depth_ptr, &depth_offset2, 1, "");
-   zs_dst_ptr2 = LLVMBuildBitCast(builder, zs_dst_ptr2, load_ptr_type, "");
-
    if (format_desc->block.bits > 32) {
       s_value = LLVMBuildBitCast(builder, s_value, z_bld.vec_type, "");
    }
@@ -752,49 +777,41 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
                                lp_build_int_vec_type(gallivm, zs_type), "");
    }
 
-   if (format_desc->block.bits <= 32) {
-      if (z_src_type.length == 4) {
-         zs_dst1 = lp_build_extract_range(gallivm, z_value, 0, 2);
-         zs_dst2 = lp_build_extract_range(gallivm, z_value, 2, 2);
-      } else {
-         assert(z_src_type.length == 8);
-         zs_dst1 = LLVMBuildShuffleVector(builder, z_value, z_value,
-                                          LLVMConstVector(&shuffles[0],
-                                                          zs_load_type.length), "");
-         zs_dst2 = LLVMBuildShuffleVector(builder, z_value, z_value,
-                                          LLVMConstVector(&shuffles[4],
-                                                          zs_load_type.length), "");
-      }
-   } else {
-      if (z_src_type.length == 4) {
-         zs_dst1 = lp_build_interleave2(gallivm, z_type,
-                                        z_value, s_value, 0);
-         zs_dst2 = lp_build_interleave2(gallivm, z_type,
-                                        z_value, s_value, 1);
+   /*
+    * Pick each row out of the swizzled values (order 0,1,4,5 for the
+    * first row, 2,3,6,7 for the second, ...) - not so hot with avx
+    * unfortunately. With stencil in the upper half the z and s values
+    * get interleaved.
+    */
+   LLVMTypeRef int8_type = LLVMInt8TypeInContext(gallivm->context);
+   for (unsigned r = 0; r < (is_1d ? 1 : num_rows); r++) {
+      LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 2];
+      LLVMValueRef zs_dst, zs_dst_ptr;
+
+      if (format_desc->block.bits <= 32) {
+         for (unsigned x = 0; x < zs_load_type.length; x++) {
+            shuffles[x] = lp_build_const_int32(gallivm, row_to_quad_index(x, r));
+         }
+         zs_dst = LLVMBuildShuffleVector(builder, z_value, z_value,
+                                         LLVMConstVector(shuffles,
+                                                         zs_load_type.length), "");
       } else {
-         LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 2];
-         assert(z_src_type.length == 8);
-         for (unsigned i = 0; i < 8; i++) {
-            shuffles[i*2] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2);
-            shuffles[i*2+1] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2 +
+         for (unsigned x = 0; x < zs_load_type.length; x++) {
+            shuffles[x*2] = lp_build_const_int32(gallivm, row_to_quad_index(x, r));
+            shuffles[x*2+1] = lp_build_const_int32(gallivm, row_to_quad_index(x, r) +
                                                    z_src_type.length);
          }
-         zs_dst1 = LLVMBuildShuffleVector(builder, z_value, s_value,
-                                          LLVMConstVector(&shuffles[0],
-                                                          z_src_type.length), "");
-         zs_dst2 = LLVMBuildShuffleVector(builder, z_value, s_value,
-                                          LLVMConstVector(&shuffles[8],
-                                                          z_src_type.length), "");
+         zs_dst = LLVMBuildShuffleVector(builder, z_value, s_value,
+                                         LLVMConstVector(shuffles,
+                                                         zs_load_type.length * 2), "");
+         zs_dst = LLVMBuildBitCast(builder, zs_dst,
+                                   lp_build_vec_type(gallivm, zs_load_type), "");
       }
-      zs_dst1 = LLVMBuildBitCast(builder, zs_dst1,
-                                 lp_build_vec_type(gallivm, zs_load_type), "");
-      zs_dst2 = LLVMBuildBitCast(builder, zs_dst2,
-                                 lp_build_vec_type(gallivm, zs_load_type), "");
-   }
 
-   LLVMBuildStore(builder, zs_dst1, zs_dst_ptr1);
-   if (!is_1d) {
-      LLVMBuildStore(builder, zs_dst2, zs_dst_ptr2);
+      zs_dst_ptr = LLVMBuildGEP2(builder, int8_type, depth_ptr, &depth_offset, 1, "");
+      zs_dst_ptr = LLVMBuildBitCast(builder, zs_dst_ptr, load_ptr_type, "");
+      LLVMBuildStore(builder, zs_dst, zs_dst_ptr);
+      depth_offset = LLVMBuildAdd(builder, depth_offset, depth_stride, "");
    }
 }
 
@@ -59,6 +59,9 @@ llvmpipe_destroy(struct pipe_context *pipe)
    mtx_lock(&lp_screen->ctx_mutex);
    list_del(&llvmpipe->list);
    mtx_unlock(&lp_screen->ctx_mutex);
+
+   llvmpipe_fini_fs_jit(llvmpipe);
+
    lp_print_counters();
 
    if (llvmpipe->csctx) {
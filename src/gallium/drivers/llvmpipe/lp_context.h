@@ -35,6 +35,7 @@
 
 #include "draw/draw_vertex.h"
 #include "util/u_blitter.h"
+#include "util/u_queue.h"
 
 #include "lp_tex_sample.h"
 #include "lp_jit.h"
@@ -165,6 +166,11 @@ struct llvmpipe_context {
    unsigned nr_fs_variants;
    unsigned nr_fs_instrs;
 
+   /** Background compilation of optimized fs variants (LP_ASYNC_JIT) */
+   struct util_queue fs_jit_queue;
+   unsigned fs_jit_done;   /**< jobs finished, incremented by the queue */
+   unsigned fs_jit_seen;   /**< fs_jit_done when last checked */
+
    bool permit_linear_rasterizer;
    bool single_vp;
 
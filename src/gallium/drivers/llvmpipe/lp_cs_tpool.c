@@ -28,9 +28,84 @@
  * based on threadpool.c but modified heavily to be compute shader tuned.
  */
 
+#include "util/u_atomic.h"
 #include "util/u_thread.h"
 #include "util/u_memory.h"
 #include "lp_cs_tpool.h"
+#include "lp_debug.h"
+#include "lp_rast.h"
+
+/**
+ * One contiguous slice of a task's iterations.  Each range gets its own
+ * cache line so threads working through their own range don't bounce each
+ * other's counters.
+ */
+struct lp_cs_tpool_range {
+   unsigned next;    /**< next unclaimed iteration, advanced atomically */
+   unsigned end;
+   char pad[CACHE_LINE_SIZE - 2 * sizeof(unsigned)];
+};
+
+
+/**
+ * Claim one iteration of \p task, starting with range \p home and stealing
+ * from the other ranges once that one is exhausted.
+ * Returns false if every iteration has been claimed.
+ */
+static bool
+lp_cs_tpool_claim(struct lp_cs_tpool_task *task, unsigned home,
+                  unsigned *iter_idx)
+{
+   for (unsigned i = 0; i < task->num_ranges; i++) {
+      struct lp_cs_tpool_range *range =
+         &task->ranges[(home + i) % task->num_ranges];
+
+      /* Skip exhausted ranges without dirtying their cache line. */
+      if (p_atomic_read(&range->next) >= range->end)
+         continue;
+
+      unsigned idx = p_atomic_fetch_add(&range->next, 1);
+      if (idx < range->end) {
+         *iter_idx = idx;
+         return true;
+      }
+   }
+   return false;
+}
+
+
+/**
+ * Run iterations of \p task until there are none left to claim.
+ * Called with the pool mutex held, which is dropped while working.
+ */
+static void
+lp_cs_tpool_run_task(struct lp_cs_tpool *pool,
+                     struct lp_cs_tpool_task *task,
+                     unsigned home,
+                     struct lp_cs_local_mem *lmem)
+{
+   unsigned iter_idx, count = 0;
+
+   task->num_busy++;
+   mtx_unlock(&pool->m);
+
+   while (lp_cs_tpool_claim(task, home, &iter_idx)) {
+      task->work(task->data, iter_idx, lmem);
+      count++;
+   }
+
+   mtx_lock(&pool->m);
+
+   /* Everything is claimed, let idle workers move on to the next task. */
+   if (!list_is_empty(&task->list))
+      list_delinit(&task->list);
+
+   task->num_busy--;
+   task->iter_finished += count;
+   if (task->iter_finished == task->iter_total && !task->num_busy)
+      cnd_broadcast(&task->finish);
+}
+
 
 static int
 lp_cs_tpool_worker(void *data)
@@ -41,9 +116,14 @@ lp_cs_tpool_worker(void *data)
    memset(&lmem, 0, sizeof(lmem));
    mtx_lock(&pool->m);
 
+   /* num_threads is only final once all threads have been spawned, which
+    * happens with the pool mutex held.
+    */
+   unsigned thread_index = pool->num_started++;
+   lp_rast_pin_thread(thread_index, pool->num_threads);
+
    while (!pool->shutdown) {
       struct lp_cs_tpool_task *task;
-      unsigned iter_per_thread;
 
       while (list_is_empty(&pool->workqueue) && !pool->shutdown)
          cnd_wait(&pool->new_work, &pool->m);
@@ -54,29 +134,7 @@ lp_cs_tpool_worker(void *data)
       task = list_first_entry(&pool->workqueue, struct lp_cs_tpool_task,
                               list);
 
-      unsigned this_iter = task->iter_start;
-
-      iter_per_thread = task->iter_per_thread;
-
-      if (task->iter_remainder &&
-          task->iter_start + task->iter_remainder == task->iter_total) {
-         task->iter_remainder--;
-         iter_per_thread = 1;
-      }
-
-      task->iter_start += iter_per_thread;
-
-      if (task->iter_start == task->iter_total)
-         list_del(&task->list);
-
-      mtx_unlock(&pool->m);
-      for (unsigned i = 0; i < iter_per_thread; i++)
-         task->work(task->data, this_iter + i, &lmem);
-
-      mtx_lock(&pool->m);
-      task->iter_finished += iter_per_thread;
-      if (task->iter_finished == task->iter_total)
-         cnd_broadcast(&task->finish);
+      lp_cs_tpool_run_task(pool, task, thread_index, &lmem);
    }
    mtx_unlock(&pool->m);
    FREE(lmem.local_mem_ptr);
@@ -96,6 +154,7 @@ lp_cs_tpool_create(unsigned num_threads)
 
    list_inithead(&pool->workqueue);
    assert (num_threads <= LP_MAX_THREADS);
+   mtx_lock(&pool->m);
    for (unsigned i = 0; i < num_threads; i++) {
       if (thrd_success != u_thread_create(pool->threads + i, lp_cs_tpool_worker, pool)) {
          num_threads = i;  /* previous thread is max */
@@ -103,6 +162,7 @@ lp_cs_tpool_create(unsigned num_threads)
       }
    }
    pool->num_threads = num_threads;
+   mtx_unlock(&pool->m);
    return pool;
 }
 
@@ -132,7 +192,10 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
 {
    struct lp_cs_tpool_task *task;
 
-   if (pool->num_threads == 0) {
+   /* A single workgroup gains nothing from a round trip through the
+    * workers, run it right away.
+    */
+   if (pool->num_threads == 0 || num_iters <= 1) {
       struct lp_cs_local_mem lmem;
 
       memset(&lmem, 0, sizeof(lmem));
@@ -151,8 +214,25 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
    task->data = data;
    task->iter_total = num_iters;
 
-   task->iter_per_thread = num_iters / pool->num_threads;
-   task->iter_remainder = num_iters % pool->num_threads;
+   /* One range per worker plus one for the thread waiting on the task.
+    * LP_PERF=no_cs_steal makes all threads claim from a single range, for
+    * comparison.
+    */
+   if (LP_PERF & PERF_NO_CS_STEAL)
+      task->num_ranges = 1;
+   else
+      task->num_ranges = MIN2(num_iters, pool->num_threads + 1);
+   task->ranges = align_calloc(task->num_ranges * sizeof(*task->ranges),
+                               CACHE_LINE_SIZE);
+   if (!task->ranges) {
+      FREE(task);
+      return NULL;
+   }
+
+   for (unsigned r = 0; r < task->num_ranges; r++) {
+      task->ranges[r].next = (uint64_t)r * num_iters / task->num_ranges;
+      task->ranges[r].end = (uint64_t)(r + 1) * num_iters / task->num_ranges;
+   }
 
    cnd_init(&task->finish);
 
@@ -160,7 +240,12 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
 
    list_addtail(&task->list, &pool->workqueue);
 
-   cnd_broadcast(&pool->new_work);
+   /* Only wake as many workers as there are iterations besides the
+    * waiter's, busy ones pick the task up once they are done with their
+    * current one.
+    */
+   for (unsigned i = 0; i < MIN2(num_iters - 1, pool->num_threads); i++)
+      cnd_signal(&pool->new_work);
    mtx_unlock(&pool->m);
    return task;
 }
@@ -171,15 +256,25 @@ lp_cs_tpool_wait_for_task(struct lp_cs_tpool *pool,
 {
    struct lp_cs_tpool_task *task = *task_handle;
 
+   struct lp_cs_local_mem lmem;
+
    if (!pool || !task)
       return;
 
+   memset(&lmem, 0, sizeof(lmem));
+
+   /* Work on the task rather than sleep, stealing from the workers once
+    * the waiter's own range is done.
+    */
    mtx_lock(&pool->m);
-   while (task->iter_finished < task->iter_total)
+   lp_cs_tpool_run_task(pool, task, pool->num_threads, &lmem);
+   while (task->iter_finished < task->iter_total || task->num_busy)
       cnd_wait(&task->finish, &pool->m);
    mtx_unlock(&pool->m);
 
+   FREE(lmem.local_mem_ptr);
    cnd_destroy(&task->finish);
+   align_free(task->ranges);
    FREE(task);
    *task_handle = NULL;
 }
@@ -30,6 +30,14 @@
  * structs with just unique indexes in them.
  * It also supports a local memory support struct to be passed from
  * outside the thread exec function.
+ *
+ * The iterations of a task are split into one range per worker plus one
+ * for the thread waiting on the task, which helps out instead of sleeping.
+ * Every thread claims iterations from its own range first and steals from
+ * the others once it runs dry, so uneven workgroups don't leave threads
+ * idle.  Workers move on to the next queued task as soon as the current
+ * one has nothing left to claim, so dispatches queued from different
+ * contexts overlap.
  */
 #ifndef LP_CS_QUEUE
 #define LP_CS_QUEUE
@@ -47,6 +55,7 @@ struct lp_cs_tpool {
 
    thrd_t threads[LP_MAX_THREADS];
    unsigned num_threads;
+   unsigned num_started;
    struct list_head workqueue;
    bool shutdown;
 };
@@ -58,16 +67,19 @@ struct lp_cs_local_mem {
 
 typedef void (*lp_cs_tpool_task_func)(void *data, int iter_idx, struct lp_cs_local_mem *lmem);
 
+struct lp_cs_tpool_range;
+
 struct lp_cs_tpool_task {
    lp_cs_tpool_task_func work;
    void *data;
    struct list_head list;
    cnd_t finish;
    unsigned iter_total;
-   unsigned iter_start;
-   unsigned iter_finished;
-   unsigned iter_per_thread;
-   unsigned iter_remainder;
+   unsigned iter_finished;    /**< protected by the pool mutex */
+   unsigned num_busy;         /**< threads claiming from the task, ditto */
+
+   unsigned num_ranges;
+   struct lp_cs_tpool_range *ranges;
 };
 
 struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads);
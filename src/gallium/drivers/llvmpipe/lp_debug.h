@@ -65,6 +65,9 @@
 #define PERF_NO_ALPHATEST   0x80  	/* disable alpha testing */
 #define PERF_NO_RAST_LINEAR 0x100  	/* disable linear rast */
 #define PERF_NO_SHADE       0x200  	/* disable fragment shaders */
+#define PERF_NO_SCENE_OVERLAP 0x400	/* rasterize one scene at a time */
+#define PERF_NO_HIZ         0x800  	/* no tile depth bounds culling */
+#define PERF_NO_CS_STEAL    0x1000 	/* one shared compute iteration counter */
 
 
 extern int LP_PERF;
@@ -66,7 +66,12 @@
 
 #define LP_MAX_SAMPLES 4
 
-#define LP_MAX_THREADS 32
+/**
+ * Upper bound on rasterizer and compute threads.  Per-thread state is
+ * kept in fixed-size arrays, so keep this a reasonable multiple of the
+ * core counts of current many-core machines.
+ */
+#define LP_MAX_THREADS 128
 
 
 /**
@@ -81,6 +86,18 @@
  */
 #define LP_MAX_SHADER_INSTRUCTIONS (2048 * LP_MAX_SHADER_VARIANTS)
 
+/**
+ * Max total size of compiled shader objects kept in memory per screen,
+ * see lp_disk_cache_find_shader().
+ */
+#define LP_MAX_OBJECT_CACHE_SIZE (64 * 1024 * 1024)
+
+/**
+ * Shader compiles taking longer than this (in microseconds) on the draw
+ * path are counted as hitches.
+ */
+#define LP_JIT_HITCH_TIME 10000
+
 /**
  * Max number of setup variants that will be kept around.
  *
@@ -33,6 +33,7 @@
 #include "util/u_pack_color.h"
 #include "util/u_rect.h"
 #include "util/u_sse.h"
+#include "util/format/u_format.h"
 
 #include "lp_jit.h"
 #include "lp_rast.h"
@@ -86,8 +87,8 @@ lp_fs_linear_run(const struct lp_rast_state *state,
    const struct lp_fragment_shader_variant *variant = state->variant;
    const struct lp_tgsi_info *info = &variant->shader->info;
    const struct lp_fragment_shader_variant_key *key = &variant->key;
-   bool rgba_order = (key->cbuf_format[0] == PIPE_FORMAT_R8G8B8A8_UNORM ||
-                      key->cbuf_format[0] == PIPE_FORMAT_R8G8B8X8_UNORM);
+   const enum pipe_format cbuf_format = key->cbuf_format[0];
+   bool rgba_order = lp_linear_rgba_order(cbuf_format);
    uint8_t constants[LP_MAX_LINEAR_CONSTANTS * 4];
 
    LP_DBG(DEBUG_RAST, "%s\n", __func__);
@@ -195,9 +196,35 @@ lp_fs_linear_run(const struct lp_rast_state *state,
    }
 
    /* JIT function already does blending */
-   jit.color0 = color + x * 4 + y * stride;
    lp_jit_linear_llvm_func jit_func = variant->jit_linear_llvm;
 
+   if (cbuf_format == PIPE_FORMAT_B5G6R5_UNORM) {
+      /* The shader works on 8888 pixels, expand each row of the 565
+       * color buffer into a temporary and pack the result back.
+       */
+      const struct util_format_unpack_description *unpack =
+         util_format_unpack_description(cbuf_format);
+      const struct util_format_pack_description *pack =
+         util_format_pack_description(cbuf_format);
+      alignas(16) uint8_t row[TILE_SIZE * 4];
+
+      assert(width <= TILE_SIZE);
+
+      color += x * 2 + y * stride;
+      jit.color0 = row;
+
+      for (unsigned iy = 0; iy < height; iy++) {
+         unpack->unpack_rgba_8unorm(row, color, width);
+         jit_func(&jit, 0, 0, width);
+         pack->pack_rgba_8unorm(color, 0, row, 0, width, 1);
+         color += stride;
+      }
+
+      return true;
+   }
+
+   jit.color0 = color + x * 4 + y * stride;
+
    for (unsigned iy = 0; iy < height; iy++) {
       jit_func(&jit, 0, 0, width);  // x=0, y=0
       jit.color0 += stride;
@@ -208,7 +235,7 @@ lp_fs_linear_run(const struct lp_rast_state *state,
 fail:
    /* Visually distinguish this from other fallbacks:
     */
-   if (LP_DEBUG & DEBUG_LINEAR) {
+   if ((LP_DEBUG & DEBUG_LINEAR) && cbuf_format != PIPE_FORMAT_B5G6R5_UNORM) {
       return linear_fallback(state, x, y, width, height, color, stride);
    }
 
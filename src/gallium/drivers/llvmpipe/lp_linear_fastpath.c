@@ -198,7 +198,7 @@ lp_linear_check_fastpath(struct lp_fragment_shader_variant *variant)
    struct lp_sampler_static_state *samp0 =
       lp_fs_variant_key_sampler_idx(&variant->key, 0);
 
-   if (!samp0)
+   if (!samp0 || !is_bgra_cbuf(variant))
       return false;
 
    const enum pipe_format tex_format = samp0->texture_state.format;
@@ -126,6 +126,18 @@ is_linear_clamp_sampler(const struct lp_sampler_static_state *sampler)
 }
 
 
+/* The C fastpaths write texels as they are, so the color buffer has to
+ * have the layout of the B8G8R8A8 textures they read.
+ */
+static inline bool
+is_bgra_cbuf(const struct lp_fragment_shader_variant *variant)
+{
+   return
+      variant->key.cbuf_format[0] == PIPE_FORMAT_B8G8R8A8_UNORM ||
+      variant->key.cbuf_format[0] == PIPE_FORMAT_B8G8R8X8_UNORM;
+}
+
+
 bool
 lp_linear_init_interp(struct lp_linear_interp *interp,
                       int x, int y, int width, int height,
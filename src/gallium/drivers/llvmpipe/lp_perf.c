@@ -113,6 +113,25 @@ lp_print_counters(void)
       debug_printf("llvmpipe:   nr_rect_full_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_rect_fully_covered_4, p1, total_4);
       debug_printf("llvmpipe:   nr_rect_part_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_rect_partially_covered_4, p2, total_4);
 
+      debug_printf("llvmpipe: nr_hiz_scans:                 %9u\n", lp_count.nr_hiz_scans);
+      debug_printf("llvmpipe:   nr_hiz_culled_64x64:        %9u\n", lp_count.nr_hiz_culled_64);
+      debug_printf("llvmpipe:   nr_hiz_culled_16x16:        %9u\n", lp_count.nr_hiz_culled_16);
+
+      total_64 = lp_count.nr_linear_bins + lp_count.nr_linear_rejected_bins;
+      p1 = 100.0 * (float) lp_count.nr_linear_bins / (float) total_64;
+      p2 = 100.0 * (float) lp_count.nr_linear_rejected_bins / (float) total_64;
+
+      debug_printf("llvmpipe: nr_linear_permitted_bins:     %9u\n", total_64);
+      debug_printf("llvmpipe:   nr_linear_bins:             %9u (%3.0f%% of %u)\n", lp_count.nr_linear_bins, p1, total_64);
+      debug_printf("llvmpipe:   nr_linear_rejected_bins:    %9u (%3.0f%% of %u)\n", lp_count.nr_linear_rejected_bins, p2, total_64);
+
+      total_4 = lp_count.nr_linear_shaded + lp_count.nr_linear_fallback;
+      p1 = 100.0 * (float) lp_count.nr_linear_shaded / (float) total_4;
+      p2 = 100.0 * (float) lp_count.nr_linear_fallback / (float) total_4;
+
+      debug_printf("llvmpipe: nr_linear_shade:              %9u\n", total_4);
+      debug_printf("llvmpipe:   nr_linear_shaded:           %9u (%3.0f%% of %u)\n", lp_count.nr_linear_shaded, p1, total_4);
+      debug_printf("llvmpipe:   nr_linear_fallback:         %9u (%3.0f%% of %u)\n", lp_count.nr_linear_fallback, p2, total_4);
 
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
@@ -121,6 +140,8 @@ lp_print_counters(void)
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
+      debug_printf("llvmpipe: nr_llvm_hitches:              %u\n", lp_count.nr_llvm_hitches);
+      debug_printf("llvmpipe: nr_async_compiles:            %u\n", lp_count.nr_async_compiles);
 
    }
 }
@@ -62,8 +62,17 @@ struct lp_counters
    unsigned nr_rect_fully_covered_4;
    unsigned nr_rect_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_hiz_scans;
+   unsigned nr_hiz_culled_64;
+   unsigned nr_hiz_culled_16;
+   unsigned nr_linear_bins;           /**< bins on the linear rasterizer */
+   unsigned nr_linear_rejected_bins;  /**< linear permitted, not all rects */
+   unsigned nr_linear_shaded;         /**< rects/tiles run by linear shaders */
+   unsigned nr_linear_fallback;       /**< rects/tiles run by the SoA shader */
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
+   unsigned nr_llvm_hitches;   /**< draws stalled > LP_JIT_HITCH_TIME */
+   unsigned nr_async_compiles;
 
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
@@ -25,6 +25,7 @@
  *
  **************************************************************************/
 
+#include <float.h>
 #include <limits.h>
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -33,6 +34,7 @@
 #include "util/u_pack_color.h"
 #include "util/u_string.h"
 #include "util/u_thread.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_memset.h"
 #include "util/os_time.h"
 
@@ -126,6 +128,55 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
                          scene->zsbuf.stride * task->y +
                          scene->zsbuf.format_bytes * task->x;
    }
+
+   task->hiz.enabled = false;
+   task->hiz.valid = false;
+   task->hiz.age = 0;
+}
+
+
+/**
+ * Recompute the depth bounds of the current tile from the depth buffer.
+ * Parts of blocks outside the framebuffer are never shaded and don't
+ * contribute.
+ */
+void
+lp_rast_hiz_update(struct lp_rasterizer_task *task)
+{
+   const struct lp_scene *scene = task->scene;
+   const enum pipe_format format = scene->fb.zsbuf->format;
+   const struct util_format_description *desc = util_format_description(format);
+   const unsigned depth_bits = desc->channel[desc->swizzle[0]].size;
+   float row[TILE_SIZE];
+
+   LP_COUNT(nr_hiz_scans);
+
+   for (unsigned by = 0; by < TILE_SIZE / 16; by++)
+      for (unsigned bx = 0; bx < TILE_SIZE / 16; bx++)
+         task->hiz.block_max[by][bx] = -FLT_MAX;
+
+   for (unsigned y = 0; y < task->height; y++) {
+      float *block_max = task->hiz.block_max[y / 16];
+
+      util_format_unpack_z_float(format, row,
+                                 task->depth_tile + y * scene->zsbuf.stride,
+                                 task->width);
+
+      for (unsigned x = 0; x < task->width; x++)
+         block_max[x / 16] = MAX2(block_max[x / 16], row[x]);
+   }
+
+   task->hiz.tile_max = -FLT_MAX;
+   for (unsigned by = 0; by < TILE_SIZE / 16; by++)
+      for (unsigned bx = 0; bx < TILE_SIZE / 16; bx++)
+         task->hiz.tile_max = MAX2(task->hiz.tile_max,
+                                   task->hiz.block_max[by][bx]);
+
+   /* Unorm depth is quantized before the test, allow for one step. */
+   task->hiz.eps = util_format_is_float(util_format_get_depth_only(format)) ?
+                   0.0f : (float) (1.0 / (double) ((1ull << depth_bits) - 1));
+   task->hiz.valid = true;
+   task->hiz.age = 0;
 }
 
 
@@ -203,6 +254,9 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
     */
 
    if (scene->fb.zsbuf) {
+      task->hiz.valid = false;
+      task->hiz.age = 0;
+
       for (unsigned s = 0; s < scene->zsbuf.nr_samples; s++) {
          uint8_t *dst_layer =
             task->depth_tile + (s * scene->zsbuf.sample_stride);
@@ -317,6 +371,9 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
 
    const struct lp_fragment_shader_variant *variant = state->variant;
 
+   if (lp_rast_hiz_tile_occluded(task, inputs))
+      return;
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (unsigned y = 0; y < task->height; y += 4){
       for (unsigned x = 0; x < task->width; x += 4) {
@@ -684,7 +741,18 @@ void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg)
 {
+   const struct lp_scene *scene = task->scene;
+   const struct lp_fragment_shader_variant *variant = arg.set_state->variant;
+
    task->state = arg.set_state;
+
+   /* A variant that may raise depth values invalidates the tile bounds. */
+   if (!variant->hiz_preserve)
+      task->hiz.valid = false;
+
+   task->hiz.enabled = variant->hiz_cull &&
+                       scene->fb.zsbuf && scene->zsbuf.map &&
+                       scene->fb_max_layer == 0;
 }
 
 
@@ -1000,6 +1068,8 @@ rasterize_bin(struct lp_rasterizer_task *task,
             (info.type & LP_RAST_FLAGS_RECT)) {
       lp_linear_rasterize_bin(task, bin);
    } else {
+      if (task->scene->permit_linear_rasterizer)
+         LP_COUNT(nr_linear_rejected_bins);
       tri_rasterize_bin(task, bin, x, y);
    }
 
@@ -1099,6 +1169,24 @@ lp_rast_queue_scene(struct lp_rasterizer *rast,
 {
    LP_DBG(DEBUG_SETUP, "%s\n", __func__);
 
+   /* Decide whether the threads may start on this scene before they're
+    * done with the previous one.  The previous scene can only be inspected
+    * while it's still in flight, and only if it comes from the same setup
+    * context (which is the one calling us, so it can't recycle it
+    * concurrently).  Otherwise play safe.
+    */
+   if (LP_PERF & PERF_NO_SCENE_OVERLAP) {
+      scene->rast_serialize = true;
+   } else if (!rast->last_fence || lp_fence_signalled(rast->last_fence)) {
+      scene->rast_serialize = false;
+   } else if (rast->last_setup != scene->setup) {
+      scene->rast_serialize = true;
+   } else {
+      scene->rast_serialize = lp_scene_depends_on(scene, rast->last_scene);
+   }
+   rast->last_scene = scene;
+   rast->last_setup = scene->setup;
+
    lp_fence_reference(&rast->last_fence, scene->fence);
    if (rast->last_fence)
       rast->last_fence->issued = true;
@@ -1149,6 +1237,107 @@ lp_rast_finish(struct lp_rasterizer *rast)
 }
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(pin_threads, "LP_PIN_THREADS", true)
+
+/**
+ * Pin the calling worker thread to one L3 cache domain.
+ *
+ * On machines with several L3 caches (multi-CCX or multi-socket), threads
+ * left to the OS scheduler migrate between domains and lose their cache
+ * contents.  Spread the worker threads evenly over the L3 domains instead,
+ * so that neighbouring thread indices share a cache.  Does nothing on
+ * machines with a single L3 or when LP_PIN_THREADS=false.
+ */
+void
+lp_rast_pin_thread(unsigned thread_index, unsigned num_threads)
+{
+   const struct util_cpu_caps_t *caps = util_get_cpu_caps();
+
+   if (!debug_get_option_pin_threads() || caps->num_L3_caches <= 1 || !caps->L3_affinity_mask ||
+       num_threads == 0)
+      return;
+
+   unsigned L3_cache = thread_index * caps->num_L3_caches / num_threads;
+   util_set_current_thread_affinity(caps->L3_affinity_mask[L3_cache], NULL,
+                                    caps->num_cpu_mask_bits);
+}
+
+
+/**
+ * Get the next scene for a rasterizer thread.
+ *
+ * Scenes are rasterized in queue order, but threads don't wait for each
+ * other between scenes: the first thread to run out of tiles in a scene
+ * begins the next one and starts on its tiles while the others finish
+ * theirs.  This keeps threads busy across scene boundaries, where the
+ * tail of a scene leaves most of them idle.  At most
+ * LP_RAST_MAX_INFLIGHT_SCENES scenes are in flight, and scenes that depend
+ * on the previous one (see lp_scene_depends_on()) wait for it to complete.
+ */
+static struct lp_scene *
+lp_rast_acquire_scene(struct lp_rasterizer *rast,
+                      struct lp_rasterizer_task *task)
+{
+   const unsigned seq = task->scene_seq;
+   const unsigned slot = seq % LP_RAST_MAX_INFLIGHT_SCENES;
+
+   mtx_lock(&rast->scene_mutex);
+
+   /* Wait for the scene that used this slot before to complete. */
+   while (rast->scenes_completed + LP_RAST_MAX_INFLIGHT_SCENES <= seq)
+      cnd_wait(&rast->scene_cond, &rast->scene_mutex);
+
+   if (rast->scenes_dequeued == seq) {
+      struct lp_scene *scene = lp_scene_dequeue(rast->full_scenes, true);
+      rast->scenes_dequeued++;
+
+      while (scene->rast_serialize && rast->scenes_completed < seq)
+         cnd_wait(&rast->scene_cond, &rast->scene_mutex);
+
+      lp_scene_begin_rasterization(scene);
+      lp_scene_bin_iter_begin(scene);
+
+      rast->inflight_scenes[slot] = scene;
+      rast->threads_done[slot] = 0;
+      rast->scenes_begun++;
+      cnd_broadcast(&rast->scene_cond);
+   } else {
+      while (rast->scenes_begun <= seq)
+         cnd_wait(&rast->scene_cond, &rast->scene_mutex);
+   }
+
+   struct lp_scene *scene = rast->inflight_scenes[slot];
+
+   mtx_unlock(&rast->scene_mutex);
+
+   return scene;
+}
+
+
+/**
+ * Done with the current scene, which may complete it.
+ * The scene must not be touched anymore as its fence has been signalled.
+ */
+static void
+lp_rast_release_scene(struct lp_rasterizer *rast,
+                      struct lp_rasterizer_task *task)
+{
+   const unsigned slot = task->scene_seq % LP_RAST_MAX_INFLIGHT_SCENES;
+
+   mtx_lock(&rast->scene_mutex);
+
+   /* Threads finish scenes in order, so scenes complete in order too. */
+   if (++rast->threads_done[slot] == rast->num_threads) {
+      rast->inflight_scenes[slot] = NULL;
+      rast->scenes_completed++;
+      cnd_broadcast(&rast->scene_cond);
+   }
+   task->scene_seq++;
+
+   mtx_unlock(&rast->scene_mutex);
+}
+
+
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
@@ -1167,6 +1356,8 @@ thread_function(void *init_data)
    snprintf(thread_name, sizeof thread_name, "llvmpipe-%u", task->thread_index);
    u_thread_setname(thread_name);
 
+   lp_rast_pin_thread(task->thread_index, rast->num_threads);
+
    /* Make sure that denorms are treated like zeros. This is
     * the behavior required by D3D10. OpenGL doesn't care.
     */
@@ -1182,33 +1373,15 @@ thread_function(void *init_data)
       if (rast->exit_flag)
          break;
 
-      if (task->thread_index == 0) {
-         /* thread[0]:
-          *  - get next scene to rasterize
-          *  - map the framebuffer surfaces
-          */
-         lp_rast_begin(rast, lp_scene_dequeue(rast->full_scenes, true));
-      }
-
-      /* Wait for all threads to get here so that threads[1+] don't
-       * get a null rast->curr_scene pointer.
-       */
-      util_barrier_wait(&rast->barrier);
+      struct lp_scene *scene = lp_rast_acquire_scene(rast, task);
 
       /* do work */
       if (debug)
          debug_printf("thread %d doing work\n", task->thread_index);
 
-      rasterize_scene(task, rast->curr_scene);
+      rasterize_scene(task, scene);
 
-      /* wait for all threads to finish with this scene */
-      util_barrier_wait(&rast->barrier);
-
-      /* XXX: shouldn't be necessary:
-       */
-      if (task->thread_index == 0) {
-         lp_rast_end(rast);
-      }
+      lp_rast_release_scene(rast, task);
 
       /* signal done with work */
       if (debug)
@@ -1282,10 +1455,8 @@ lp_rast_create(unsigned num_threads)
 
    create_rast_threads(rast);
 
-   /* for synchronizing rasterization threads */
-   if (rast->num_threads > 0) {
-      util_barrier_init(&rast->barrier, rast->num_threads);
-   }
+   (void) mtx_init(&rast->scene_mutex, mtx_plain);
+   cnd_init(&rast->scene_cond);
 
    memset(lp_dummy_tile, 0, sizeof lp_dummy_tile);
 
@@ -1352,10 +1523,8 @@ lp_rast_destroy(struct lp_rasterizer *rast)
 
    lp_fence_reference(&rast->last_fence, NULL);
 
-   /* for synchronizing rasterization threads */
-   if (rast->num_threads > 0) {
-      util_barrier_destroy(&rast->barrier);
-   }
+   cnd_destroy(&rast->scene_cond);
+   mtx_destroy(&rast->scene_mutex);
 
    lp_scene_queue_destroy(rast->full_scenes);
 
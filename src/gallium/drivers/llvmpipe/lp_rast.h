@@ -236,6 +236,9 @@ lp_rast_create(unsigned num_threads);
 void
 lp_rast_destroy(struct lp_rasterizer *);
 
+void
+lp_rast_pin_thread(unsigned thread_index, unsigned num_threads);
+
 void
 lp_rast_queue_scene(struct lp_rasterizer *rast,
                      struct lp_scene *scene);
@@ -50,9 +50,11 @@ lp_rast_linear_clear(struct lp_rasterizer_task *task,
 
    union util_color uc = arg.clear_rb->color_val;
 
+   /* The color is already packed, only the pixel size matters. */
    const struct lp_scene *scene = task->scene;
    util_fill_rect(scene->cbufs[0].map,
-                  PIPE_FORMAT_B8G8R8A8_UNORM,
+                  scene->cbufs[0].format_bytes == 2 ?
+                     PIPE_FORMAT_B5G6R5_UNORM : PIPE_FORMAT_B8G8R8A8_UNORM,
                   scene->cbufs[0].stride,
                   task->x,
                   task->y,
@@ -91,8 +93,10 @@ lp_rast_linear_tile(struct lp_rasterizer_task *task,
                                    GET_DADX(inputs),
                                    GET_DADY(inputs),
                                    scene->cbufs[0].map,
-                                   scene->cbufs[0].stride))
+                                   scene->cbufs[0].stride)) {
+         LP_COUNT(nr_linear_shaded);
          return;
+      }
    }
 
    if (variant->jit_linear) {
@@ -105,10 +109,14 @@ lp_rast_linear_tile(struct lp_rasterizer_task *task,
                               GET_DADX(inputs),
                               GET_DADY(inputs),
                               scene->cbufs[0].map,
-                              scene->cbufs[0].stride))
+                              scene->cbufs[0].stride)) {
+         LP_COUNT(nr_linear_shaded);
          return;
+      }
    }
 
+   LP_COUNT(nr_linear_fallback);
+
    {
       struct u_rect box;
       box.x0 = task->x;
@@ -160,6 +168,7 @@ lp_rast_linear_rect(struct lp_rasterizer_task *task,
                                    GET_DADY(inputs),
                                    scene->cbufs[0].map,
                                    scene->cbufs[0].stride)) {
+         LP_COUNT(nr_linear_shaded);
          return;
       }
    }
@@ -173,10 +182,12 @@ lp_rast_linear_rect(struct lp_rasterizer_task *task,
                               GET_DADY(inputs),
                               scene->cbufs[0].map,
                               scene->cbufs[0].stride)) {
+         LP_COUNT(nr_linear_shaded);
          return;
       }
    }
 
+   LP_COUNT(nr_linear_fallback);
    lp_rast_linear_rect_fallback(task, inputs, &box);
 }
 
@@ -231,7 +242,7 @@ dispatch_linear[] = {
 
 
 /* Assumptions for this path:
- *   - Single color buffer, PIPE_FORMAT_B8G8R8A8_UNORM
+ *   - Single 8888 or 565 color buffer
  *   - No depth buffer
  *   - All primitives in bins are rect, tile, blit or clear.
  *   - All shaders have a linear variant.
@@ -244,6 +255,8 @@ lp_linear_rasterize_bin(struct lp_rasterizer_task *task,
 
    if (0) debug_printf("%s\n", __func__);
 
+   LP_COUNT(nr_linear_bins);
+
    const struct cmd_block *block;
    for (block = bin->head; block; block = block->next) {
       for (unsigned k = 0; k < block->count; k++) {
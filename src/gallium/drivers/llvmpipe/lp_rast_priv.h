@@ -37,11 +37,20 @@
 #include "lp_state.h"
 #include "lp_texture.h"
 #include "lp_limits.h"
+#include "lp_perf.h"
 
 
 #define TILE_VECTOR_HEIGHT 4
 #define TILE_VECTOR_WIDTH 4
 
+/* Number of depth culling checks in a tile before its depth bounds are
+ * (re)computed, see lp_rast_hiz_update().
+ */
+#define LP_HIZ_SCAN_INTERVAL 16
+
+/* Max number of scenes the rasterizer threads work on at the same time */
+#define LP_RAST_MAX_INFLIGHT_SCENES 2
+
 /* If we crash in a jitted function, we can examine jit_line and jit_state
  * to get some info.  This is not thread-safe, however.
  */
@@ -100,6 +109,24 @@ struct lp_rasterizer_task
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
 
+   /** Number of scenes this thread has rasterized */
+   unsigned scene_seq;
+
+   /**
+    * Upper bounds of the depth values in the current tile and in each of
+    * its 16x16 blocks, for culling fragments that can't pass a LESS/LEQUAL
+    * depth test.  The bounds stay conservative while only variants with
+    * hiz_preserve set draw into the tile.
+    */
+   struct {
+      bool enabled;     /**< current state can be culled */
+      bool valid;       /**< bounds below are conservative */
+      unsigned age;     /**< culling checks since the last scan */
+      float eps;        /**< depth buffer precision */
+      float tile_max;
+      float block_max[TILE_SIZE / 16][TILE_SIZE / 16];
+   } hiz;
+
    util_semaphore work_ready;
    util_semaphore work_done;
 #ifdef _WIN32
@@ -121,18 +148,33 @@ struct lp_rasterizer
    /** The incoming queue of scenes ready to rasterize */
    struct lp_scene_queue *full_scenes;
 
-   /** The scene currently being rasterized by the threads */
+   /** The scene currently being rasterized when there are no threads */
    struct lp_scene *curr_scene;
 
+   /**
+    * Scenes being rasterized by the threads, indexed by sequence number
+    * modulo LP_RAST_MAX_INFLIGHT_SCENES.  A thread that runs out of tiles
+    * in one scene moves on to the next one while the others finish, see
+    * lp_rast_acquire_scene().  All protected by scene_mutex.
+    */
+   mtx_t scene_mutex;
+   cnd_t scene_cond;
+   struct lp_scene *inflight_scenes[LP_RAST_MAX_INFLIGHT_SCENES];
+   unsigned threads_done[LP_RAST_MAX_INFLIGHT_SCENES];
+   unsigned scenes_dequeued;
+   unsigned scenes_begun;
+   unsigned scenes_completed;  /**< all scenes before this one are done */
+
+   /** The scene queued last, to find dependencies of the next one */
+   struct lp_scene *last_scene;
+   const struct lp_setup_context *last_setup;
+
    /** A task object for each rasterization thread */
    struct lp_rasterizer_task tasks[LP_MAX_THREADS];
 
    unsigned num_threads;
    thrd_t threads[LP_MAX_THREADS];
 
-   /** For synchronizing the rasterization threads */
-   util_barrier barrier;
-
    struct lp_fence *last_fence;
 };
 
@@ -218,6 +260,88 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
 }
 
 
+void
+lp_rast_hiz_update(struct lp_rasterizer_task *task);
+
+
+/**
+ * Whether no fragment of the primitive inside the size x size square at
+ * x, y (in window coords) can have a depth below max_z.
+ * The minimum is taken from the depth plane over the square grown by a
+ * pixel, which covers pixel center and sample offsets.
+ */
+static inline bool
+lp_rast_hiz_occluded(const struct lp_rasterizer_task *task,
+                     const struct lp_rast_shader_inputs *inputs,
+                     int x, int y, unsigned size, float max_z)
+{
+   const float (*a0)[4] = (const float (*)[4]) GET_A0(inputs);
+   const float (*dadx)[4] = (const float (*)[4]) GET_DADX(inputs);
+   const float (*dady)[4] = (const float (*)[4]) GET_DADY(inputs);
+   const float x0 = (float) (x - 1), x1 = (float) (x + size + 1);
+   const float y0 = (float) (y - 1), y1 = (float) (y + size + 1);
+
+   /* Position z, plus the polygon offset kept in a0[0][0]. */
+   const float c = a0[0][2] + a0[0][0];
+   const float dx = MIN2(dadx[0][2] * x0, dadx[0][2] * x1);
+   const float dy = MIN2(dady[0][2] * y0, dady[0][2] * y1);
+   const float eps = task->hiz.eps +
+                     1e-5f * (fabsf(c) + fabsf(dx) + fabsf(dy));
+
+   /* Depth may get clamped to 1.0, never raised. */
+   const float min_z = MIN2(c + dx + dy, 1.0f);
+
+   return min_z - eps > max_z;
+}
+
+
+/**
+ * Whether the primitive is occluded in the whole current tile.
+ */
+static inline bool
+lp_rast_hiz_tile_occluded(struct lp_rasterizer_task *task,
+                          const struct lp_rast_shader_inputs *inputs)
+{
+   if (!task->hiz.enabled)
+      return false;
+
+   if (++task->hiz.age >= LP_HIZ_SCAN_INTERVAL)
+      lp_rast_hiz_update(task);
+
+   if (!task->hiz.valid ||
+       !lp_rast_hiz_occluded(task, inputs, task->x, task->y, TILE_SIZE,
+                             task->hiz.tile_max))
+      return false;
+
+   LP_COUNT(nr_hiz_culled_64);
+   return true;
+}
+
+
+/**
+ * Whether the primitive is occluded in the 16x16 block at x, y.
+ */
+static inline bool
+lp_rast_hiz_block_occluded(struct lp_rasterizer_task *task,
+                           const struct lp_rast_shader_inputs *inputs,
+                           int x, int y)
+{
+   if (!task->hiz.enabled || !task->hiz.valid)
+      return false;
+
+   const unsigned bx = (x - task->x) / 16;
+   const unsigned by = (y - task->y) / 16;
+   assert(bx < TILE_SIZE / 16 && by < TILE_SIZE / 16);
+
+   if (!lp_rast_hiz_occluded(task, inputs, x, y, 16,
+                             task->hiz.block_max[by][bx]))
+      return false;
+
+   LP_COUNT(nr_hiz_culled_16);
+   return true;
+}
+
+
 /**
  * Shade all pixels in a 4x4 block.  The fragment code omits the
  * triangle in/out tests.
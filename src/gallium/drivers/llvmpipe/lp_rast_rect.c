@@ -160,6 +160,9 @@ lp_rast_rectangle(struct lp_rasterizer_task *task,
       return;
    }
 
+   if (lp_rast_hiz_tile_occluded(task, &rect->inputs))
+      return;
+
    /* Intersect the rectangle with this tile.
     */
    struct u_rect box;
@@ -210,6 +210,9 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
       return;
    }
 
+   if (lp_rast_hiz_tile_occluded(task, &tri->inputs))
+      return;
+
    outmask = 0;                 /* outside one or more trivial reject planes */
    partmask = 0;                /* outside one or more trivial accept planes */
 
@@ -315,13 +318,16 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
       int py = y + iy;
       int64_t cx[NR_PLANES];
 
+      partial_mask &= ~(1 << i);
+
+      if (lp_rast_hiz_block_occluded(task, &tri->inputs, px, py))
+         continue;
+
       for (j = 0; j < NR_PLANES; j++)
          cx[j] = (c[j]
                   - IMUL64(plane[j].dcdx, ix)
                   + IMUL64(plane[j].dcdy, iy));
 
-      partial_mask &= ~(1 << i);
-
       LP_COUNT(nr_partially_covered_16);
       TAG(do_block_16)(task, tri, plane, px, py, cx);
    }
@@ -337,6 +343,9 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
 
       inmask &= ~(1 << i);
 
+      if (lp_rast_hiz_block_occluded(task, &tri->inputs, px, py))
+         continue;
+
       LP_COUNT(nr_fully_covered_16);
       block_full_16(task, tri, px, py);
    }
@@ -360,6 +369,9 @@ TRI_16(struct lp_rasterizer_task *task,
    int y = (mask >> 8);
    unsigned outmask = 0;    /* outside one or more trivial reject planes */
 
+   if (lp_rast_hiz_tile_occluded(task, &tri->inputs))
+      return;
+
    if (x + 12 >= 64) {
       int i = ((x + 12) - 64) / 4;
       outmask |= right_mask_tab[i];
@@ -438,6 +450,9 @@ TRI_4(struct lp_rasterizer_task *task,
    const int x = task->x + (mask & 0xff);
    const int y = task->y + (mask >> 8);
 
+   if (lp_rast_hiz_tile_occluded(task, &tri->inputs))
+      return;
+
    /* Iterate over partials:
     */
    unsigned mask = 0xffff;
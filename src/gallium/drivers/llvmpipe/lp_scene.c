@@ -147,6 +147,7 @@ lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y)
    struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
 
    bin->last_state = NULL;
+   bin->reset = true;
    bin->head = bin->tail;
    if (bin->tail) {
       bin->tail->next = NULL;
@@ -375,6 +376,137 @@ lp_scene_new_data_block(struct lp_scene *scene)
 }
 
 
+/**
+ * Prepare \p shard to bin a slice of \p scene's primitives, typically on
+ * another thread.  The shard mirrors the scene's framebuffer layout and
+ * current bin state but gets its own bins and data blocks, so it can be
+ * filled without touching the scene.  At most \p budget bytes of data
+ * blocks may be allocated before the shard reports out-of-memory.
+ */
+bool
+lp_scene_begin_shard(struct lp_scene *shard,
+                     const struct lp_scene *scene,
+                     unsigned budget)
+{
+   const unsigned num_bins = lp_scene_get_num_bins(scene);
+
+   if (shard->num_alloced_tiles < num_bins) {
+      free(shard->tiles);
+      shard->tiles = calloc(num_bins, sizeof(struct cmd_bin));
+      if (!shard->tiles) {
+         shard->num_alloced_tiles = 0;
+         return false;
+      }
+      shard->num_alloced_tiles = num_bins;
+   }
+
+   for (unsigned i = 0; i < num_bins; i++) {
+      shard->tiles[i].head = NULL;
+      shard->tiles[i].tail = NULL;
+      shard->tiles[i].last_state = scene->tiles[i].last_state;
+      shard->tiles[i].reset = false;
+   }
+
+   /* The framebuffer is only borrowed, see lp_scene_discard_shard(). */
+   memcpy(&shard->fb, &scene->fb, sizeof shard->fb);
+   shard->fb_max_layer = scene->fb_max_layer;
+   shard->fb_max_samples = scene->fb_max_samples;
+   shard->tiles_x = scene->tiles_x;
+   shard->tiles_y = scene->tiles_y;
+   shard->had_queries = scene->had_queries;
+   shard->permit_linear_rasterizer = scene->permit_linear_rasterizer;
+
+   /* Never hand out the embedded first block: the shard is reused while
+    * the blocks it allocated live on in the scene until rasterization.
+    */
+   assert(shard->data.head == &shard->data.first);
+   shard->data.first.used = DATA_BLOCK_SIZE;
+   shard->data.first.next = NULL;
+
+   shard->scene_size = LP_SCENE_MAX_SIZE - MIN2(budget, LP_SCENE_MAX_SIZE);
+   shard->alloc_failed = false;
+
+   return true;
+}
+
+
+/**
+ * Append everything binned into \p shard to the end of the corresponding
+ * bins of \p scene and hand the shard's data blocks over to the scene.
+ * Merging shards in the order their primitives were submitted yields the
+ * same per-bin command order as binning them serially.  Bins the shard
+ * reset for an opaque whole tile replace the scene's bins instead, as
+ * lp_scene_bin_reset() would have dropped their commands.
+ */
+void
+lp_scene_merge_shard(struct lp_scene *scene, struct lp_scene *shard)
+{
+   const unsigned num_bins = lp_scene_get_num_bins(scene);
+   struct data_block *first = shard->data.head;
+
+   if (first != &shard->data.first) {
+      struct data_block *last = first;
+      unsigned num_blocks = 1;
+
+      while (last->next != &shard->data.first) {
+         last = last->next;
+         num_blocks++;
+      }
+
+      /* Keep the scene's current block at the head so that allocations
+       * continue to fill it.
+       */
+      last->next = scene->data.head->next;
+      scene->data.head->next = first;
+      scene->scene_size += num_blocks * sizeof(struct data_block);
+
+      shard->data.head = &shard->data.first;
+   }
+
+   for (unsigned i = 0; i < num_bins; i++) {
+      struct cmd_bin *src = &shard->tiles[i];
+      struct cmd_bin *dst = &scene->tiles[i];
+
+      if (src->reset) {
+         dst->head = src->head;
+         dst->tail = src->tail;
+         dst->last_state = src->last_state;
+         continue;
+      }
+
+      if (!src->head)
+         continue;
+
+      if (dst->tail)
+         dst->tail->next = src->head;
+      else
+         dst->head = src->head;
+      dst->tail = src->tail;
+      dst->last_state = src->last_state;
+   }
+}
+
+
+/**
+ * Throw away whatever was binned into \p shard.
+ */
+void
+lp_scene_discard_shard(struct lp_scene *shard)
+{
+   struct data_block_list *list = &shard->data;
+   struct data_block *block, *tmp;
+
+   for (block = list->head; block != &list->first; block = tmp) {
+      tmp = block->next;
+      FREE(block);
+   }
+   list->head = &list->first;
+   list->first.next = NULL;
+
+   memset(&shard->fb, 0, sizeof shard->fb);
+}
+
+
 /**
  * Return number of bytes used for all bin data within a scene.
  * This does not include resources (textures) referenced by the scene.
@@ -547,6 +679,64 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 }
 
 
+static bool
+scene_writes_resource(const struct lp_scene *scene,
+                      const struct pipe_resource *resource)
+{
+   for (unsigned j = 0; j < scene->fb.nr_cbufs; j++) {
+      if (scene->fb.cbufs[j] && scene->fb.cbufs[j]->texture == resource)
+         return true;
+   }
+   if (scene->fb.zsbuf && scene->fb.zsbuf->texture == resource)
+      return true;
+
+   for (const struct resource_ref *ref = scene->writeable_resources; ref;
+        ref = ref->next) {
+      for (int i = 0; i < ref->count; i++)
+         if (ref->resource[i] == resource)
+            return true;
+   }
+
+   return false;
+}
+
+
+/**
+ * Does rasterizing \p scene have to wait for \p prev to complete?
+ * That's the case if it writes anything \p prev references, or reads
+ * anything \p prev writes.  Both scenes must be fully binned.
+ */
+bool
+lp_scene_depends_on(const struct lp_scene *scene,
+                    const struct lp_scene *prev)
+{
+   const struct resource_ref *ref;
+
+   for (unsigned j = 0; j < scene->fb.nr_cbufs; j++) {
+      if (scene->fb.cbufs[j] &&
+          lp_scene_is_resource_referenced(prev, scene->fb.cbufs[j]->texture))
+         return true;
+   }
+   if (scene->fb.zsbuf &&
+       lp_scene_is_resource_referenced(prev, scene->fb.zsbuf->texture))
+      return true;
+
+   for (ref = scene->writeable_resources; ref; ref = ref->next) {
+      for (int i = 0; i < ref->count; i++)
+         if (lp_scene_is_resource_referenced(prev, ref->resource[i]))
+            return true;
+   }
+
+   for (ref = scene->resources; ref; ref = ref->next) {
+      for (int i = 0; i < ref->count; i++)
+         if (scene_writes_resource(prev, ref->resource[i]))
+            return true;
+   }
+
+   return false;
+}
+
+
 /** advance curr_x,y to the next bin */
 static bool
 next_bin(struct lp_scene *scene)
@@ -98,6 +98,7 @@ struct cmd_bin {
    const struct lp_rast_state *last_state;  /* most recent state set in bin */
    struct cmd_block *head;
    struct cmd_block *tail;
+   bool reset;  /* shards only: bin was reset, see lp_scene_merge_shard() */
 };
 
 
@@ -189,6 +190,9 @@ struct lp_scene {
    bool alloc_failed;
    bool permit_linear_rasterizer;
 
+   /** Must not be rasterized until the previous scene is complete */
+   bool rast_serialize;
+
    /**
     * Number of active tiles in each dimension.
     * This basically the framebuffer size divided by tile size
@@ -226,6 +230,9 @@ bool lp_scene_add_resource_reference(struct lp_scene *scene,
 unsigned lp_scene_is_resource_referenced(const struct lp_scene *scene,
                                          const struct pipe_resource *resource);
 
+bool lp_scene_depends_on(const struct lp_scene *scene,
+                         const struct lp_scene *prev);
+
 bool lp_scene_add_frag_shader_reference(struct lp_scene *scene,
                                         struct lp_fragment_shader_variant *variant);
 
@@ -403,6 +410,20 @@ lp_scene_bin_iter_next(struct lp_scene *scene, int *x, int *y);
 
 
 
+/* Shards: private bins used to bin part of a scene on another thread
+ */
+bool
+lp_scene_begin_shard(struct lp_scene *shard,
+                     const struct lp_scene *scene,
+                     unsigned budget);
+
+void
+lp_scene_merge_shard(struct lp_scene *scene, struct lp_scene *shard);
+
+void
+lp_scene_discard_shard(struct lp_scene *shard);
+
+
 /* Begin/end binning of a scene
  */
 void
@@ -39,6 +39,7 @@
 #include "gallivm/lp_bld_type.h"
 #include "gallivm/lp_bld_nir.h"
 #include "util/disk_cache.h"
+#include "util/hash_table.h"
 #include "util/hex.h"
 #include "util/os_misc.h"
 #include "util/os_time.h"
@@ -96,6 +97,9 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
    { "no_rast_linear", PERF_NO_RAST_LINEAR, NULL },
    { "no_shade",       PERF_NO_SHADE, NULL },
+   { "no_scene_overlap", PERF_NO_SCENE_OVERLAP, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
+   { "no_cs_steal",    PERF_NO_CS_STEAL, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -261,6 +265,11 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_QUERY_SO_OVERFLOW:
    case PIPE_CAP_TGSI_DIV:
       return 1;
+   case PIPE_CAP_PREFER_REAL_BUFFER_IN_CONSTBUF0:
+      /* User constant buffers are copied into the const uploader anyway, so
+       * let the frontend do it and keep rebinding unchanged uploads.
+       */
+      return 1;
    case PIPE_CAP_VENDOR_ID:
       return 0xFFFFFFFF;
    case PIPE_CAP_DEVICE_ID:
@@ -870,6 +879,132 @@ llvmpipe_flush_frontbuffer(struct pipe_screen *_screen,
 }
 
 
+struct lp_object_cache_entry {
+   struct list_head lru;
+   unsigned char sha1[20];
+   size_t size;
+   uint8_t data[];
+};
+
+
+static uint32_t
+lp_object_cache_hash(const void *key)
+{
+   /* The key is a sha1 already. */
+   uint32_t hash;
+   memcpy(&hash, key, sizeof hash);
+   return hash;
+}
+
+
+static bool
+lp_object_cache_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, 20) == 0;
+}
+
+
+static void
+lp_object_cache_init(struct llvmpipe_screen *screen)
+{
+   (void) mtx_init(&screen->object_cache_mutex, mtx_plain);
+   list_inithead(&screen->object_cache_lru);
+   screen->object_cache = _mesa_hash_table_create(NULL, lp_object_cache_hash,
+                                                  lp_object_cache_equal);
+}
+
+
+static void
+lp_object_cache_destroy(struct llvmpipe_screen *screen)
+{
+   list_for_each_entry_safe(struct lp_object_cache_entry, entry,
+                            &screen->object_cache_lru, lru)
+      FREE(entry);
+
+   _mesa_hash_table_destroy(screen->object_cache, NULL);
+   mtx_destroy(&screen->object_cache_mutex);
+}
+
+
+/**
+ * Look up a compiled object in memory, returning a copy for gallivm to
+ * own.
+ */
+static bool
+lp_object_cache_get(struct llvmpipe_screen *screen,
+                    struct lp_cached_code *cache,
+                    const unsigned char ir_sha1_cache_key[20])
+{
+   bool found = false;
+
+   if (!screen->object_cache)
+      return false;
+
+   mtx_lock(&screen->object_cache_mutex);
+   struct hash_entry *he = _mesa_hash_table_search(screen->object_cache,
+                                                   ir_sha1_cache_key);
+   if (he) {
+      struct lp_object_cache_entry *entry = he->data;
+
+      cache->data = malloc(entry->size);
+      if (cache->data) {
+         memcpy(cache->data, entry->data, entry->size);
+         cache->data_size = entry->size;
+         list_move_to(&entry->lru, &screen->object_cache_lru);
+         found = true;
+      }
+   }
+   mtx_unlock(&screen->object_cache_mutex);
+
+   return found;
+}
+
+
+static void
+lp_object_cache_put(struct llvmpipe_screen *screen,
+                    const void *data, size_t size,
+                    const unsigned char ir_sha1_cache_key[20])
+{
+   if (!screen->object_cache || size > LP_MAX_OBJECT_CACHE_SIZE / 16)
+      return;
+
+   struct lp_object_cache_entry *entry =
+      MALLOC(sizeof *entry + size);
+   if (!entry)
+      return;
+
+   memcpy(entry->sha1, ir_sha1_cache_key, 20);
+   memcpy(entry->data, data, size);
+   entry->size = size;
+
+   mtx_lock(&screen->object_cache_mutex);
+
+   if (_mesa_hash_table_search(screen->object_cache, entry->sha1)) {
+      mtx_unlock(&screen->object_cache_mutex);
+      FREE(entry);
+      return;
+   }
+
+   /* Evict the least recently used objects. */
+   while (screen->object_cache_size + size > LP_MAX_OBJECT_CACHE_SIZE) {
+      struct lp_object_cache_entry *old =
+         list_last_entry(&screen->object_cache_lru,
+                         struct lp_object_cache_entry, lru);
+
+      _mesa_hash_table_remove_key(screen->object_cache, old->sha1);
+      list_del(&old->lru);
+      screen->object_cache_size -= old->size;
+      FREE(old);
+   }
+
+   _mesa_hash_table_insert(screen->object_cache, entry->sha1, entry);
+   list_add(&entry->lru, &screen->object_cache_lru);
+   screen->object_cache_size += size;
+
+   mtx_unlock(&screen->object_cache_mutex);
+}
+
+
 static void
 llvmpipe_destroy_screen(struct pipe_screen *_screen)
 {
@@ -885,6 +1020,8 @@ llvmpipe_destroy_screen(struct pipe_screen *_screen)
 
    disk_cache_destroy(screen->disk_shader_cache);
 
+   lp_object_cache_destroy(screen);
+
    glsl_type_singleton_decref();
 
    mtx_destroy(&screen->rast_mutex);
@@ -960,6 +1097,9 @@ lp_disk_cache_create(struct llvmpipe_screen *screen)
       return;
 
    _mesa_sha1_update(&ctx, &gallivm_perf, sizeof(gallivm_perf));
+   /* the shader variants are built for the vector width in use */
+   _mesa_sha1_update(&ctx, &lp_native_vector_width,
+                     sizeof(lp_native_vector_width));
    update_cache_sha1_cpu(&ctx);
    _mesa_sha1_final(&ctx, sha1);
    mesa_bytes_to_hex(cache_id, sha1, 20);
@@ -989,6 +1129,11 @@ llvmpipe_screen_get_fd(struct pipe_screen *_screen)
 }
 
 
+/**
+ * Look up a compiled shader object, first in the screen's memory cache,
+ * which is shared by all contexts, then in the disk cache, which is shared
+ * between processes.
+ */
 void
 lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
                           struct lp_cached_code *cache,
@@ -996,6 +1141,9 @@ lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
 {
    unsigned char sha1[CACHE_KEY_SIZE];
 
+   if (lp_object_cache_get(screen, cache, ir_sha1_cache_key))
+      return;
+
    if (!screen->disk_shader_cache)
       return;
    disk_cache_compute_key(screen->disk_shader_cache, ir_sha1_cache_key,
@@ -1010,6 +1158,8 @@ lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
    }
    cache->data_size = binary_size;
    cache->data = buffer;
+
+   lp_object_cache_put(screen, buffer, binary_size, ir_sha1_cache_key);
 }
 
 
@@ -1020,7 +1170,13 @@ lp_disk_cache_insert_shader(struct llvmpipe_screen *screen,
 {
    unsigned char sha1[CACHE_KEY_SIZE];
 
-   if (!screen->disk_shader_cache || !cache->data_size || cache->dont_cache)
+   if (!cache->data_size || cache->dont_cache)
+      return;
+
+   lp_object_cache_put(screen, cache->data, cache->data_size,
+                       ir_sha1_cache_key);
+
+   if (!screen->disk_shader_cache)
       return;
    disk_cache_compute_key(screen->disk_shader_cache, ir_sha1_cache_key,
                           20, sha1);
@@ -1136,5 +1292,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
 
    (void) mtx_init(&screen->late_mutex, mtx_plain);
 
+   lp_object_cache_init(screen);
+
    return &screen->base;
 }
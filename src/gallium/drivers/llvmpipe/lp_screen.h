@@ -43,6 +43,7 @@
 
 struct sw_winsys;
 struct lp_cs_tpool;
+struct hash_table;
 
 struct llvmpipe_screen
 {
@@ -73,6 +74,15 @@ struct llvmpipe_screen
    char renderer_string[100];
 
    struct disk_cache *disk_shader_cache;
+
+   /**
+    * Compiled objects of recently used shaders, in front of the disk
+    * cache and shared by all contexts.  Keyed by IR sha1, in LRU order.
+    */
+   mtx_t object_cache_mutex;
+   struct hash_table *object_cache;
+   struct list_head object_cache_lru;
+   size_t object_cache_size;
 };
 
 
@@ -42,6 +42,7 @@
 #include "util/u_cpu_detect.h"
 #include "util/u_viewport.h"
 #include "draw/draw_pipe.h"
+#include "util/os_misc.h"
 #include "util/os_time.h"
 #include "lp_context.h"
 #include "lp_memory.h"
@@ -77,6 +78,24 @@ lp_setup_wait_empty_scene(struct lp_setup_context *setup)
 }
 
 
+/**
+ * Bin memory held by scenes which are queued or being rasterized.
+ */
+static uint64_t
+lp_setup_busy_scene_size(const struct lp_setup_context *setup)
+{
+   uint64_t size = 0;
+
+   for (unsigned i = 0; i < setup->num_active_scenes; i++) {
+      struct lp_scene *scene = setup->scenes[i];
+      if (scene->fence && !lp_fence_signalled(scene->fence))
+         size += scene->scene_size;
+   }
+
+   return size;
+}
+
+
 static void
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
@@ -98,8 +117,13 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
    if (setup->num_active_scenes + 1 > MAX_SCENES) {
       i = lp_setup_wait_empty_scene(setup);
    } else if (i == setup->num_active_scenes) {
-      /* allocate a new scene */
-      struct lp_scene *scene = lp_scene_create(setup);
+      /* Allocate a new scene, unless the busy ones already hold so much
+       * memory that waiting for one of them is the better option.
+       */
+      struct lp_scene *scene = NULL;
+      if (lp_setup_busy_scene_size(setup) + LP_SCENE_MAX_SIZE <=
+          setup->scene_memory_budget)
+         scene = lp_scene_create(setup);
       if (!scene) {
          /* block and reuse scenes */
          i = lp_setup_wait_empty_scene(setup);
@@ -1314,6 +1338,7 @@ lp_setup_destroy(struct lp_setup_context *setup)
    }
 
    LP_DBG(DEBUG_SETUP, "number of scenes used: %d\n", setup->num_active_scenes);
+   lp_setup_bin_destroy(setup);
    slab_destroy(&setup->scene_slab);
 
    FREE(setup);
@@ -1347,6 +1372,23 @@ lp_setup_create(struct pipe_context *pipe,
    setup->pipe = pipe;
 
    setup->num_threads = screen->num_threads;
+
+   /* Scenes in flight may use up to 1/16th of system memory, within the
+    * limits of the scene pool.
+    */
+   uint64_t total_memory = 0;
+   os_get_total_physical_memory(&total_memory);
+   setup->scene_memory_budget =
+      CLAMP(total_memory / 16,
+            (uint64_t) INITIAL_SCENES * LP_SCENE_MAX_SIZE,
+            (uint64_t) MAX_SCENES * LP_SCENE_MAX_SIZE);
+
+   slab_create(&setup->scene_slab,
+               sizeof(struct lp_scene),
+               INITIAL_SCENES);
+
+   lp_setup_bin_init(setup);
+
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1354,10 +1396,6 @@ lp_setup_create(struct pipe_context *pipe,
 
    draw_set_rasterize_stage(draw, setup->vbuf);
    draw_set_render(draw, &setup->base);
-
-   slab_create(&setup->scene_slab,
-               sizeof(struct lp_scene),
-               INITIAL_SCENES);
    /* create just one scene for starting point */
    setup->scenes[0] = lp_scene_create(setup);
    if (!setup->scenes[0]) {
@@ -1386,6 +1424,8 @@ no_scenes:
 
    setup->vbuf->destroy(setup->vbuf);
 no_vbuf:
+   lp_setup_bin_destroy(setup);
+   slab_destroy(&setup->scene_slab);
    FREE(setup);
 no_setup:
    return NULL;
@@ -1520,6 +1560,10 @@ lp_setup_flush_and_restart(struct lp_setup_context *setup)
 {
    if (0) debug_printf("%s\n", __func__);
 
+   /* Binning workers can't flush, see lp_setup_bin.c */
+   if (setup->is_bin_shard)
+      return false;
+
    assert(setup->state == SETUP_ACTIVE);
 
    if (!set_scene_state(setup, SETUP_FLUSHED, __func__))
@@ -0,0 +1,333 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Parallel binning of large triangle and line batches.
+ *
+ * Primitive setup and binning normally run on the context thread only,
+ * which becomes the bottleneck for scenes with many small primitives while
+ * the rasterizer threads sit idle.  When LP_BIN_THREADS is set, large
+ * triangle and line lists coming from the draw module are split into
+ * contiguous slices.  Each slice is set up on its own thread, into the
+ * bins of a private shard scene (see lp_scene_begin_shard()), using a
+ * setup context that only carries the state triangle and line setup read
+ * (see bin_shard_setup_init()).  Once all slices are done, the shards are
+ * appended to the real scene's bins in submission order, so every bin ends
+ * up with exactly the commands serial binning would have produced.
+ *
+ * Points and strips stay serial: points are rarely drawn in large enough
+ * batches to pay for the handoff, and strips would need their slices to
+ * overlap and keep track of the provoking vertex and winding.
+ *
+ * A shard that runs out of memory cannot flush the scene from a worker
+ * thread.  It and all following shards are discarded and their slices are
+ * binned serially instead, which takes the usual flush-and-retry path.
+ */
+
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "lp_context.h"
+#include "lp_limits.h"
+#include "lp_setup_context.h"
+
+
+/* Minimum number of primitives per slice; below this the thread handoff
+ * costs more than it saves.
+ */
+#define LP_BIN_MIN_PRIMS 256
+
+/* The draw module hands over vertices in small batches sized for cache
+ * locality.  Parallel binning needs larger ones to have anything to split.
+ */
+#define LP_BIN_VBUF_INDEXES (16 * 1020)
+#define LP_BIN_VBUF_SIZE    (64 * 4096)
+
+
+struct lp_bin_shard {
+   struct util_queue_fence fence;
+   struct lp_setup_context *setup;  /**< worker copy of the setup context */
+   struct lp_scene *scene;          /**< private bins of this slice */
+
+   enum mesa_prim prim;             /**< MESA_PRIM_LINES or _TRIANGLES */
+   const void *vertex_buffer;
+   const uint16_t *indices;         /**< NULL for non-indexed draws */
+   unsigned stride;
+   unsigned start, end;             /**< vertex range of the slice */
+};
+
+
+static inline const float (*
+get_vert(const void *vertex_buffer, const uint16_t *indices,
+         unsigned i, unsigned stride))[4]
+{
+   const unsigned index = indices ? indices[i] : i;
+   return (const float (*)[4])((const char *)vertex_buffer + index * stride);
+}
+
+
+static void
+bin_prims(struct lp_setup_context *setup, enum mesa_prim prim,
+          const void *vertex_buffer, const uint16_t *indices,
+          unsigned stride, unsigned start, unsigned end)
+{
+   if (prim == MESA_PRIM_LINES) {
+      for (unsigned i = start + 1; i < end; i += 2) {
+         setup->line(setup,
+                     get_vert(vertex_buffer, indices, i - 1, stride),
+                     get_vert(vertex_buffer, indices, i - 0, stride));
+
+         /* A shard can't flush, the rest of its slice is redone serially. */
+         if (setup->is_bin_shard && lp_scene_is_oom(setup->scene))
+            break;
+      }
+   } else {
+      for (unsigned i = start + 2; i < end; i += 3) {
+         setup->triangle(setup,
+                         get_vert(vertex_buffer, indices, i - 2, stride),
+                         get_vert(vertex_buffer, indices, i - 1, stride),
+                         get_vert(vertex_buffer, indices, i - 0, stride));
+
+         if (setup->is_bin_shard && lp_scene_is_oom(setup->scene))
+            break;
+      }
+   }
+}
+
+
+static void
+bin_shard_execute(void *data, void *gdata, int thread_index)
+{
+   struct lp_bin_shard *shard = (struct lp_bin_shard *) data;
+
+   bin_prims(shard->setup, shard->prim, shard->vertex_buffer, shard->indices,
+             shard->stride, shard->start, shard->end);
+}
+
+
+/**
+ * Copy the state that triangle and line setup read from \p setup to the
+ * worker setup context \p shard.  Everything else in the worker context
+ * stays zeroed, and most of the fragment shader state isn't needed either.
+ */
+static void
+bin_shard_setup_init(struct lp_setup_context *shard,
+                     const struct lp_setup_context *setup,
+                     struct lp_scene *scene)
+{
+   shard->scene = scene;
+   shard->view_index = setup->view_index;
+
+   shard->flatshade_first = setup->flatshade_first;
+   shard->ccw_is_frontface = setup->ccw_is_frontface;
+   shard->rasterizer_discard = setup->rasterizer_discard;
+   shard->multisample = setup->multisample;
+   shard->rectangular_lines = setup->rectangular_lines;
+   shard->cullmode = setup->cullmode;
+   shard->bottom_edge_rule = setup->bottom_edge_rule;
+   shard->pixel_offset = setup->pixel_offset;
+   shard->line_width = setup->line_width;
+   shard->viewport_index_slot = setup->viewport_index_slot;
+   shard->layer_slot = setup->layer_slot;
+   shard->face_slot = setup->face_slot;
+
+   shard->fb.width = setup->fb.width;
+   shard->fb.height = setup->fb.height;
+   memcpy(shard->draw_regions, setup->draw_regions,
+          sizeof shard->draw_regions);
+
+   /* check_opaque() and lp_setup_is_blit() look at the shader variant,
+    * its first constant buffer and first texture.
+    */
+   shard->fs.stored = setup->fs.stored;
+   shard->fs.current.variant = setup->fs.current.variant;
+   shard->fs.current.jit_context.sample_mask =
+      setup->fs.current.jit_context.sample_mask;
+   shard->fs.current.jit_resources.constants[0] =
+      setup->fs.current.jit_resources.constants[0];
+   shard->fs.current.jit_resources.textures[0] =
+      setup->fs.current.jit_resources.textures[0];
+   shard->fs.current_tex_num = setup->fs.current_tex_num;
+   shard->setup.variant = setup->setup.variant;
+
+   shard->triangle = setup->triangle;
+   shard->line = setup->line;
+}
+
+
+/**
+ * Bin a list of \p nr vertices of MESA_PRIM_LINES or MESA_PRIM_TRIANGLES
+ * \p prim in parallel.
+ * Returns false if the batch should be binned serially instead, in which
+ * case nothing has been binned.
+ */
+bool
+lp_setup_bin_prims(struct lp_setup_context *setup,
+                   enum mesa_prim prim,
+                   const void *vertex_buffer,
+                   unsigned stride,
+                   const uint16_t *indices,
+                   unsigned nr)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
+   struct lp_scene *scene = setup->scene;
+   const unsigned verts_per_prim = prim == MESA_PRIM_LINES ? 2 : 3;
+   const unsigned num_prims = nr / verts_per_prim;
+
+   if (!setup->num_bin_threads)
+      return false;
+
+   assert(prim == MESA_PRIM_LINES || prim == MESA_PRIM_TRIANGLES);
+
+   /* The linear rasterizer path bins rectangles rather than triangles, and
+    * primitive statistics are counted on the context.
+    */
+   if (setup->permit_linear_rasterizer ||
+       lp->active_statistics_queries)
+      return false;
+
+   unsigned num_shards = MIN2(setup->num_bin_threads + 1,
+                              num_prims / LP_BIN_MIN_PRIMS);
+   if (num_shards < 2)
+      return false;
+
+   /* Split what's left of the scene's memory budget between the shards,
+    * and let the serial path flush the scene if that's too little.
+    */
+   assert(scene->scene_size <= LP_SCENE_MAX_SIZE);
+   const unsigned budget = (LP_SCENE_MAX_SIZE - scene->scene_size) / num_shards;
+   if (budget < 2 * sizeof(struct data_block))
+      return false;
+
+   /* Resolve first_triangle/first_line before the setup state gets
+    * copied.
+    */
+   if (prim == MESA_PRIM_LINES)
+      lp_setup_choose_line(setup);
+   else
+      lp_setup_choose_triangle(setup);
+
+   for (unsigned s = 0; s < num_shards; s++) {
+      struct lp_bin_shard *shard = &setup->bin_shards[s];
+
+      if (!lp_scene_begin_shard(shard->scene, scene, budget))
+         return false;
+
+      bin_shard_setup_init(shard->setup, setup, shard->scene);
+
+      shard->prim = prim;
+      shard->vertex_buffer = vertex_buffer;
+      shard->indices = indices;
+      shard->stride = stride;
+      shard->start = (s * num_prims / num_shards) * verts_per_prim;
+      shard->end = ((s + 1) * num_prims / num_shards) * verts_per_prim;
+   }
+
+   for (unsigned s = 1; s < num_shards; s++) {
+      struct lp_bin_shard *shard = &setup->bin_shards[s];
+      util_queue_add_job(&setup->bin_queue, shard, &shard->fence,
+                         bin_shard_execute, NULL, 0);
+   }
+
+   bin_shard_execute(&setup->bin_shards[0], NULL, 0);
+
+   for (unsigned s = 1; s < num_shards; s++)
+      util_queue_fence_wait(&setup->bin_shards[s].fence);
+
+   /* Merge in submission order, up to the first shard that ran out of
+    * memory.
+    */
+   unsigned s;
+   for (s = 0; s < num_shards; s++) {
+      struct lp_bin_shard *shard = &setup->bin_shards[s];
+
+      if (lp_scene_is_oom(shard->scene))
+         break;
+
+      lp_scene_merge_shard(scene, shard->scene);
+   }
+
+   if (s < num_shards) {
+      const unsigned start = setup->bin_shards[s].start;
+
+      for (unsigned i = s; i < num_shards; i++)
+         lp_scene_discard_shard(setup->bin_shards[i].scene);
+
+      LP_DBG(DEBUG_SETUP, "%s: shard %u out of memory, binning %u vertices "
+             "serially\n", __func__, s, nr - start);
+
+      bin_prims(setup, prim, vertex_buffer, indices, stride, start, nr);
+   }
+
+   return true;
+}
+
+
+/**
+ * Set up parallel binning if requested with LP_BIN_THREADS.  Must be called
+ * before the draw module's vbuf stage is created, as this raises the vbuf
+ * batch limits.
+ */
+void
+lp_setup_bin_init(struct lp_setup_context *setup)
+{
+   unsigned num_threads = debug_get_num_option("LP_BIN_THREADS", 0);
+
+   num_threads = MIN2(num_threads, LP_MAX_THREADS - 1);
+   if (!num_threads)
+      return;
+
+   setup->bin_shards = CALLOC(num_threads + 1, sizeof(struct lp_bin_shard));
+   if (!setup->bin_shards)
+      return;
+   setup->num_bin_threads = num_threads;
+
+   for (unsigned i = 0; i < num_threads + 1; i++) {
+      struct lp_bin_shard *shard = &setup->bin_shards[i];
+
+      util_queue_fence_init(&shard->fence);
+      shard->setup = CALLOC_STRUCT(lp_setup_context);
+      shard->scene = lp_scene_create(setup);
+      if (!shard->setup || !shard->scene) {
+         lp_setup_bin_destroy(setup);
+         return;
+      }
+      shard->setup->pipe = setup->pipe;
+      shard->setup->is_bin_shard = true;
+   }
+
+   if (!util_queue_init(&setup->bin_queue, "lpbin", 2 * num_threads,
+                        num_threads, 0, NULL)) {
+      lp_setup_bin_destroy(setup);
+      return;
+   }
+
+   setup->base.max_indices = LP_BIN_VBUF_INDEXES;
+   setup->base.max_vertex_buffer_bytes = LP_BIN_VBUF_SIZE;
+}
+
+
+void
+lp_setup_bin_destroy(struct lp_setup_context *setup)
+{
+   if (!setup->bin_shards)
+      return;
+
+   if (util_queue_is_initialized(&setup->bin_queue))
+      util_queue_destroy(&setup->bin_queue);
+
+   for (unsigned i = 0; i < setup->num_bin_threads + 1; i++) {
+      struct lp_bin_shard *shard = &setup->bin_shards[i];
+
+      if (shard->scene) {
+         lp_scene_discard_shard(shard->scene);
+         lp_scene_destroy(shard->scene);
+      }
+      FREE(shard->setup);
+   }
+
+   FREE(setup->bin_shards);
+   setup->bin_shards = NULL;
+   setup->num_bin_threads = 0;
+}
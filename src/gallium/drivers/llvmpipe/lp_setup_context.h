@@ -44,6 +44,7 @@
 #include "util/u_rect.h"
 #include "util/u_pack_color.h"
 #include "util/slab.h"
+#include "util/u_queue.h"
 
 #define LP_SETUP_NEW_FS          0x01
 #define LP_SETUP_NEW_CONSTANTS   0x02
@@ -53,6 +54,7 @@
 #define LP_SETUP_NEW_SSBOS       0x20
 
 struct lp_setup_variant;
+struct lp_bin_shard;
 
 
 /** Max number of scenes */
@@ -95,6 +97,13 @@ struct lp_setup_context
    int num_active_scenes;
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
+   uint64_t scene_memory_budget;         /**< for scenes being rasterized */
+
+   /* Parallel binning of large primitive batches, see lp_setup_bin.c */
+   unsigned num_bin_threads;
+   struct util_queue bin_queue;
+   struct lp_bin_shard *bin_shards;      /**< num_bin_threads + 1 of them */
+   bool is_bin_shard;                    /**< worker copy, may not flush */
 
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
@@ -232,6 +241,20 @@ lp_setup_choose_rect(struct lp_setup_context *setup);
 void
 lp_setup_init_vbuf(struct lp_setup_context *setup);
 
+void
+lp_setup_bin_init(struct lp_setup_context *setup);
+
+void
+lp_setup_bin_destroy(struct lp_setup_context *setup);
+
+bool
+lp_setup_bin_prims(struct lp_setup_context *setup,
+                   enum mesa_prim prim,
+                   const void *vertex_buffer,
+                   unsigned stride,
+                   const uint16_t *indices,
+                   unsigned nr);
+
 bool
 lp_setup_update_state(struct lp_setup_context *setup,
                       bool update_scene);
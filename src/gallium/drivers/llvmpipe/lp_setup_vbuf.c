@@ -194,10 +194,15 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const uint16_t *indices, uint nr
       break;
 
    case MESA_PRIM_LINES:
-      for (i = 1; i < nr; i += 2) {
-         setup->line(setup,
-                     get_vert(vertex_buffer, indices[i-1], stride),
-                     get_vert(vertex_buffer, indices[i-0], stride));
+      if (lp_setup_bin_prims(setup, MESA_PRIM_LINES, vertex_buffer, stride,
+                             indices, nr)) {
+         /* binned in parallel */
+      } else {
+         for (i = 1; i < nr; i += 2) {
+            setup->line(setup,
+                        get_vert(vertex_buffer, indices[i-1], stride),
+                        get_vert(vertex_buffer, indices[i-0], stride));
+         }
       }
       break;
 
@@ -223,7 +228,10 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const uint16_t *indices, uint nr
       break;
 
    case MESA_PRIM_TRIANGLES:
-      if (nr % 6 == 0 && !uses_constant_interp) {
+      if (lp_setup_bin_prims(setup, MESA_PRIM_TRIANGLES, vertex_buffer,
+                             stride, indices, nr)) {
+         /* binned in parallel */
+      } else if (nr % 6 == 0 && !uses_constant_interp) {
          for (i = 5; i < nr; i += 6) {
             rect(setup,
                  get_vert(vertex_buffer, indices[i-5], stride),
@@ -402,10 +410,15 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case MESA_PRIM_LINES:
-      for (i = 1; i < nr; i += 2) {
-         setup->line(setup,
-                     get_vert(vertex_buffer, i-1, stride),
-                     get_vert(vertex_buffer, i-0, stride));
+      if (lp_setup_bin_prims(setup, MESA_PRIM_LINES, vertex_buffer, stride,
+                             NULL, nr)) {
+         /* binned in parallel */
+      } else {
+         for (i = 1; i < nr; i += 2) {
+            setup->line(setup,
+                        get_vert(vertex_buffer, i-1, stride),
+                        get_vert(vertex_buffer, i-0, stride));
+         }
       }
       break;
 
@@ -431,7 +444,10 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case MESA_PRIM_TRIANGLES:
-      if (nr % 6 == 0 && !uses_constant_interp) {
+      if (lp_setup_bin_prims(setup, MESA_PRIM_TRIANGLES, vertex_buffer,
+                             stride, NULL, nr)) {
+         /* binned in parallel */
+      } else if (nr % 6 == 0 && !uses_constant_interp) {
          for (i = 5; i < nr; i += 6) {
             rect(setup,
                  get_vert(vertex_buffer, i-5, stride),
@@ -167,6 +167,9 @@ llvmpipe_init_clip_funcs(struct llvmpipe_context *llvmpipe);
 void
 llvmpipe_init_fs_funcs(struct llvmpipe_context *llvmpipe);
 
+void
+llvmpipe_fini_fs_jit(struct llvmpipe_context *llvmpipe);
+
 void
 llvmpipe_init_vs_funcs(struct llvmpipe_context *llvmpipe);
 
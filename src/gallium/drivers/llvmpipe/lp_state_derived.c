@@ -205,7 +205,8 @@ check_linear_rasterizer(struct llvmpipe_context *lp)
        (lp->framebuffer.cbufs[0]->format == PIPE_FORMAT_B8G8R8A8_UNORM ||
         lp->framebuffer.cbufs[0]->format == PIPE_FORMAT_B8G8R8X8_UNORM ||
         lp->framebuffer.cbufs[0]->format == PIPE_FORMAT_R8G8B8A8_UNORM ||
-        lp->framebuffer.cbufs[0]->format == PIPE_FORMAT_R8G8B8X8_UNORM));
+        lp->framebuffer.cbufs[0]->format == PIPE_FORMAT_R8G8B8X8_UNORM ||
+        lp->framebuffer.cbufs[0]->format == PIPE_FORMAT_B5G6R5_UNORM));
 
    /* permit_linear means guardband, hence fake scissor, which we can only
     * handle if there's just one vp. */
@@ -282,6 +283,14 @@ llvmpipe_update_derived(struct llvmpipe_context *llvmpipe)
       llvmpipe->dirty |= LP_NEW_SAMPLER_VIEW;
    }
 
+   /* Pick up fragment shader variants compiled in the background.
+    */
+   const unsigned fs_jit_done = p_atomic_read(&llvmpipe->fs_jit_done);
+   if (llvmpipe->fs_jit_seen != fs_jit_done) {
+      llvmpipe->fs_jit_seen = fs_jit_done;
+      llvmpipe->dirty |= LP_NEW_FS;
+   }
+
    if (llvmpipe->dirty & (LP_NEW_TASK))
       llvmpipe_update_task_shader(llvmpipe);
 
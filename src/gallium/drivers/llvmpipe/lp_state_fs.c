@@ -66,6 +66,7 @@
 #include "util/u_dump.h"
 #include "util/u_string.h"
 #include "util/u_dual_blend.h"
+#include "util/hash_table.h"
 #include "util/u_upload_mgr.h"
 #include "util/os_time.h"
 #include "pipe/p_shader_tokens.h"
@@ -566,7 +567,7 @@ fs_fb_fetch(const struct lp_build_fs_iface *iface,
    }
 
    /* fragment shader executes on 4x4 blocks. depending on vector width it can
-    * execute 2 or 4 iterations.  only move to the next row once the top row
+    * execute 1, 2 or 4 iterations.  only move to the next row once the top row
     * has completed 8 wide 1 iteration, 4 wide 2 iterations */
    LLVMValueRef x_offset = NULL, y_offset = NULL;
    if (!key->resource_1d) {
@@ -586,14 +587,14 @@ fs_fb_fetch(const struct lp_build_fs_iface *iface,
       unsigned x = i % block_width;
       unsigned y = i / block_width;
 
-      if (block_size == 8) {
+      if (block_size >= 8) {
          /* remap the raw slots into the fragment shader execution mode. */
          /* this math took me way too long to work out, I'm sure it's
           * overkill.
           */
-         x = (i & 1) + ((i >> 2) << 1);
+         x = (i & 1) + (((i >> 2) & 1) << 1);
          if (!key->resource_1d)
-            y = (i & 2) >> 1;
+            y = ((i & 2) >> 1) + ((i >> 3) << 1);
       }
 
       LLVMValueRef x_val;
@@ -2483,7 +2484,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
 
    row_type.length = fs_type.length;
    unsigned vector_width =
-      dst_type.floating ? lp_native_vector_width : lp_integer_vector_width;
+      dst_type.floating ? MIN2(lp_native_vector_width, 256) : lp_integer_vector_width;
 
    /* Compute correct swizzle and count channels */
    memset(swizzle, LP_BLD_SWIZZLE_DONTCARE, TGSI_NUM_CHANNELS);
@@ -3085,6 +3086,49 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Hand the fs color output of loop iteration i to the blend.  Blending
+ * works on at most 8 wide vectors, so a 16 wide output is split into two
+ * halves of two rows each, which go through allocas of their own: reading
+ * the halves straight out of the 16 wide color store makes llvm pick the
+ * vectors apart element by element.
+ */
+static void
+split_fs_out_color(struct gallivm_state *gallivm,
+                   struct lp_type fs_type,
+                   struct lp_type blend_fs_type,
+                   unsigned blend_num_fs,
+                   LLVMValueRef ptr,
+                   unsigned i,
+                   LLVMValueRef fs_out_color[4])
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   const unsigned blend_split = fs_type.length / blend_fs_type.length;
+
+   if (blend_split == 1) {
+      fs_out_color[i] = ptr;
+      return;
+   }
+
+   LLVMValueRef color = LLVMBuildLoad2(builder,
+                                       lp_build_vec_type(gallivm, fs_type),
+                                       ptr, "");
+   for (unsigned h = 0; h < blend_split; h++) {
+      unsigned blend_idx = i * blend_split + h;
+      if (blend_idx >= blend_num_fs)
+         break;
+      LLVMValueRef half_ptr =
+         lp_build_alloca(gallivm, lp_build_vec_type(gallivm, blend_fs_type), "");
+      LLVMBuildStore(builder,
+                     lp_build_extract_range(gallivm, color,
+                                            h * blend_fs_type.length,
+                                            blend_fs_type.length),
+                     half_ptr);
+      fs_out_color[blend_idx] = half_ptr;
+   }
+}
+
+
 /**
  * Generate the runtime callable function for the whole fragment pipeline.
  * Note that the function which we generate operates on a block of 16
@@ -3291,9 +3335,17 @@ generate_fragment(struct llvmpipe_context *lp,
 
    unsigned num_fs = 16 / fs_type.length; /* number of loops per 4x4 stamp */
    /* for 1d resources only run "upper half" of stamp */
-   if (key->resource_1d)
+   if (key->resource_1d && num_fs > 1)
       num_fs /= 2;
 
+   /* blending works on at most 8 wide vectors, see split_fs_out_color() */
+   struct lp_type blend_fs_type = fs_type;
+   blend_fs_type.length = MIN2(fs_type.length, 8);
+   const unsigned blend_split = fs_type.length / blend_fs_type.length;
+   unsigned blend_num_fs = 16 / blend_fs_type.length;
+   if (key->resource_1d)
+      blend_num_fs /= 2;
+
    {
       LLVMValueRef num_loop = lp_build_const_int32(gallivm, num_fs);
       LLVMTypeRef mask_type = lp_build_int_vec_type(gallivm, fs_type);
@@ -3436,7 +3488,16 @@ generate_fragment(struct llvmpipe_context *lp,
             LLVMValueRef sindexi = lp_build_const_int32(gallivm, idx);
             ptr = LLVMBuildGEP2(builder, mask_type, mask_store, &sindexi, 1, "");
 
-            fs_mask[idx] = LLVMBuildLoad2(builder, mask_type, ptr, "smask");
+            LLVMValueRef smask = LLVMBuildLoad2(builder, mask_type, ptr, "smask");
+            for (unsigned h = 0; h < blend_split; h++) {
+               unsigned blend_idx = i * blend_split + h;
+               if (blend_idx >= blend_num_fs)
+                  break;
+               fs_mask[s * blend_num_fs + blend_idx] = blend_split == 1 ? smask :
+                  lp_build_extract_range(gallivm, smask,
+                                         h * blend_fs_type.length,
+                                         blend_fs_type.length);
+            }
          }
 
          for (unsigned s = 0; s < key->min_samples; s++) {
@@ -3448,7 +3509,9 @@ generate_fragment(struct llvmpipe_context *lp,
                   ptr = LLVMBuildGEP2(builder, fs_vec_type,
                                       color_store[cbuf][chan],
                                       &sindexi, 1, "");
-                  fs_out_color[s][cbuf][chan][i] = ptr;
+                  split_fs_out_color(gallivm, fs_type, blend_fs_type,
+                                     blend_num_fs, ptr, i,
+                                     fs_out_color[s][cbuf][chan]);
                }
             }
             if (dual_source_blend) {
@@ -3459,7 +3522,9 @@ generate_fragment(struct llvmpipe_context *lp,
                   ptr = LLVMBuildGEP2(builder, fs_vec_type,
                                       color_store[1][chan],
                                       &sindexi, 1, "");
-                  fs_out_color[s][1][chan][i] = ptr;
+                  split_fs_out_color(gallivm, fs_type, blend_fs_type,
+                                     blend_num_fs, ptr, i,
+                                     fs_out_color[s][1][chan]);
                }
             }
          }
@@ -3502,7 +3567,7 @@ generate_fragment(struct llvmpipe_context *lp,
                                                          &index, 1, ""), "");
 
          for (unsigned s = 0; s < key->cbuf_nr_samples[cbuf]; s++) {
-            unsigned mask_idx = num_fs * (key->multisample ? s : 0);
+            unsigned mask_idx = blend_num_fs * (key->multisample ? s : 0);
             unsigned out_idx = key->min_samples == 1 ? 0 : s;
             LLVMValueRef out_ptr = color_ptr;
 
@@ -3519,7 +3584,7 @@ generate_fragment(struct llvmpipe_context *lp,
 
             generate_unswizzled_blend(gallivm, cbuf, variant,
                                       key->cbuf_format[cbuf],
-                                      num_fs, fs_type, &fs_mask[mask_idx],
+                                      blend_num_fs, blend_fs_type, &fs_mask[mask_idx],
                                       fs_out_color[out_idx],
                                       variant->jit_context_type,
                                       context_ptr, blend_vec_type, out_ptr, stride,
@@ -3717,11 +3782,16 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
+ * This may run on the fs_jit_queue thread, with its own LLVM \p context.
+ * If \p allow_unoptimized is set and the shader isn't in the cache, the
+ * variant is compiled without optimization and marked unoptimized.
  */
 static struct lp_fragment_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
                  struct lp_fragment_shader *shader,
-                 const struct lp_fragment_shader_variant_key *key)
+                 const struct lp_fragment_shader_variant_key *key,
+                 LLVMContextRef context,
+                 bool allow_unoptimized)
 {
    struct nir_shader *nir = shader->base.ir.nir;
    struct lp_fragment_shader_variant *variant =
@@ -3736,6 +3806,8 @@ generate_variant(struct llvmpipe_context *lp,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
+   mtx_lock(&shader->ir_mutex);
+
    struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
    struct lp_cached_code cached = { 0 };
    unsigned char ir_sha1_cache_key[20];
@@ -3751,8 +3823,15 @@ generate_variant(struct llvmpipe_context *lp,
    char module_name[64];
    snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
             shader->no, shader->variants_created);
-   variant->gallivm = gallivm_create(module_name, lp->context, &cached);
+   if (allow_unoptimized && !cached.data_size) {
+      variant->gallivm = gallivm_create_unoptimized(module_name, context);
+      variant->unoptimized = 1;
+      needs_caching = false;
+   } else {
+      variant->gallivm = gallivm_create(module_name, context, &cached);
+   }
    if (!variant->gallivm) {
+      mtx_unlock(&shader->ir_mutex);
       FREE(variant);
       return NULL;
    }
@@ -3846,6 +3925,34 @@ generate_variant(struct llvmpipe_context *lp,
       }
    }
 
+   /* Fragments of this variant can be culled against the tile depth bounds
+    * (see lp_rast_hiz_update()) if failing the depth test has no side
+    * effects and the tested depth is the interpolated position z.
+    */
+   const bool depth_less =
+         key->depth.func == PIPE_FUNC_LESS ||
+         key->depth.func == PIPE_FUNC_LEQUAL;
+
+   variant->hiz_cull =
+         key->depth.enabled &&
+         depth_less &&
+         !key->stencil[0].enabled &&
+         !key->multisample &&
+         key->zsbuf_nr_samples <= 1 &&
+         !key->depth_clamp &&
+         util_format_has_depth(util_format_description(key->zsbuf_format)) &&
+         !(nir->info.outputs_written & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) &&
+         !nir->info.writes_memory &&
+         !(LP_PERF & PERF_NO_HIZ);
+
+   variant->hiz_preserve =
+         !key->depth.enabled ||
+         !key->depth.writemask ||
+         ((depth_less ||
+           key->depth.func == PIPE_FUNC_EQUAL ||
+           key->depth.func == PIPE_FUNC_NEVER) &&
+          !(nir->info.outputs_written & BITFIELD64_BIT(FRAG_RESULT_DEPTH)));
+
    /* Determine whether this shader + pipeline state is a candidate for
     * the linear path.
     */
@@ -3857,7 +3964,8 @@ generate_variant(struct llvmpipe_context *lp,
          (key->cbuf_format[0] == PIPE_FORMAT_B8G8R8A8_UNORM ||
           key->cbuf_format[0] == PIPE_FORMAT_B8G8R8X8_UNORM ||
           key->cbuf_format[0] == PIPE_FORMAT_R8G8B8A8_UNORM ||
-          key->cbuf_format[0] == PIPE_FORMAT_R8G8B8X8_UNORM);
+          key->cbuf_format[0] == PIPE_FORMAT_R8G8B8X8_UNORM ||
+          key->cbuf_format[0] == PIPE_FORMAT_B5G6R5_UNORM);
 
    memcpy(&variant->key, key, sizeof *key);
 
@@ -3909,6 +4017,8 @@ generate_variant(struct llvmpipe_context *lp,
       }
    }
 
+   mtx_unlock(&shader->ir_mutex);
+
    /*
     * Compile everything
     */
@@ -3955,6 +4065,29 @@ generate_variant(struct llvmpipe_context *lp,
 }
 
 
+static inline size_t
+fs_variant_key_size(const struct lp_fragment_shader_variant_key *key)
+{
+   return lp_fs_variant_key_size(MAX2(key->nr_samplers,
+                                      key->nr_sampler_views),
+                                 key->nr_images);
+}
+
+
+static uint32_t
+fs_variant_key_hash(const void *key)
+{
+   return _mesa_hash_data(key, fs_variant_key_size(key));
+}
+
+
+static bool
+fs_variant_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, fs_variant_key_size(a)) == 0;
+}
+
+
 static void *
 llvmpipe_create_fs_state(struct pipe_context *pipe,
                          const struct pipe_shader_state *templ)
@@ -3969,6 +4102,15 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
    shader->no = fs_no++;
    list_inithead(&shader->variants.list);
 
+   shader->variants_by_key = _mesa_hash_table_create(NULL,
+                                                     fs_variant_key_hash,
+                                                     fs_variant_key_equal);
+   if (!shader->variants_by_key) {
+      FREE(shader);
+      return NULL;
+   }
+   (void) mtx_init(&shader->ir_mutex, mtx_plain);
+
    shader->base.type = PIPE_SHADER_IR_NIR;
 
    if (templ->type == PIPE_SHADER_IR_TGSI) {
@@ -3989,6 +4131,8 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
 
    shader->draw_data = draw_create_fragment_shader(llvmpipe->draw, templ);
    if (shader->draw_data == NULL) {
+      _mesa_hash_table_destroy(shader->variants_by_key, NULL);
+      mtx_destroy(&shader->ir_mutex);
       FREE(shader);
       return NULL;
    }
@@ -4077,6 +4221,84 @@ llvmpipe_bind_fs_state(struct pipe_context *pipe, void *fs)
 }
 
 
+/**
+ * Background compilation of the optimized version of a variant that was
+ * compiled unoptimized, see LP_ASYNC_JIT.
+ */
+struct lp_fs_jit_job {
+   struct util_queue_fence fence;
+   struct llvmpipe_context *lp;
+   struct lp_fragment_shader_variant *fallback;  /**< the unoptimized one */
+   struct lp_fragment_shader_variant *variant;   /**< result */
+};
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(async_jit, "LP_ASYNC_JIT", false)
+
+
+static void
+fs_jit_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct lp_fs_jit_job *job = (struct lp_fs_jit_job *) data;
+   struct lp_fragment_shader_variant *fallback = job->fallback;
+
+   /* LLVM contexts can't be shared between threads. */
+   LLVMContextRef context = LLVMContextCreate();
+   if (!context)
+      return;
+#if LLVM_VERSION_MAJOR == 15
+   LLVMContextSetOpaquePointers(context, false);
+#endif
+
+   int64_t t0 = os_time_get();
+   job->variant = generate_variant(job->lp, fallback->shader, &fallback->key,
+                                   context, false);
+   LP_COUNT_ADD(llvm_compile_time, os_time_get() - t0);
+   LP_COUNT_ADD(nr_llvm_compiles, 2);
+   LP_COUNT(nr_async_compiles);
+
+   /* The IR is gone, only the generated code is left. */
+   LLVMContextDispose(context);
+
+   p_atomic_inc(&job->lp->fs_jit_done);
+}
+
+
+static void
+fs_jit_job_destroy(struct llvmpipe_context *lp, struct lp_fs_jit_job *job)
+{
+   util_queue_fence_wait(&job->fence);
+   util_queue_fence_destroy(&job->fence);
+
+   if (job->variant)
+      lp_fs_variant_reference(lp, &job->variant, NULL);
+
+   job->fallback->jit_job = NULL;
+   FREE(job);
+}
+
+
+/**
+ * Queue compiling the optimized version of an unoptimized variant.
+ */
+static void
+fs_jit_job_queue(struct llvmpipe_context *lp,
+                 struct lp_fragment_shader_variant *fallback)
+{
+   struct lp_fs_jit_job *job = CALLOC_STRUCT(lp_fs_jit_job);
+   if (!job)
+      return;
+
+   util_queue_fence_init(&job->fence);
+   job->lp = lp;
+   job->fallback = fallback;
+   fallback->jit_job = job;
+
+   util_queue_add_job(&lp->fs_jit_queue, job, &job->fence,
+                      fs_jit_job_execute, NULL, 0);
+}
+
+
 /**
  * Remove shader variant from two lists: the shader's variant list
  * and the context's variant list.
@@ -4096,6 +4318,8 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
 
    /* remove from shader's list */
    list_del(&variant->list_item_local.list);
+   _mesa_hash_table_remove_key(variant->shader->variants_by_key,
+                               &variant->key);
    variant->shader->variants_cached--;
 
    /* remove from context's list */
@@ -4109,6 +4333,9 @@ void
 llvmpipe_destroy_shader_variant(struct llvmpipe_context *lp,
                                 struct lp_fragment_shader_variant *variant)
 {
+   if (variant->jit_job)
+      fs_jit_job_destroy(lp, variant->jit_job);
+
    gallivm_destroy(variant->gallivm);
    lp_fs_reference(lp, &variant->shader, NULL);
    FREE(variant);
@@ -4124,6 +4351,8 @@ llvmpipe_destroy_fs(struct llvmpipe_context *llvmpipe,
 
    ralloc_free(shader->base.ir.nir);
    assert(shader->variants_cached == 0);
+   _mesa_hash_table_destroy(shader->variants_by_key, NULL);
+   mtx_destroy(&shader->ir_mutex);
    FREE(shader);
 }
 
@@ -4615,6 +4844,50 @@ make_variant_key(struct llvmpipe_context *lp,
 }
 
 
+static void
+llvmpipe_add_shader_variant(struct llvmpipe_context *lp,
+                            struct lp_fragment_shader *shader,
+                            struct lp_fragment_shader_variant *variant)
+{
+   list_add(&variant->list_item_local.list, &shader->variants.list);
+   _mesa_hash_table_insert(shader->variants_by_key, &variant->key, variant);
+   list_add(&variant->list_item_global.list, &lp->fs_variants_list.list);
+   lp->nr_fs_variants++;
+   lp->nr_fs_instrs += variant->nr_instrs;
+   shader->variants_cached++;
+}
+
+
+/**
+ * Replace an unoptimized variant with the optimized one if that has been
+ * compiled by now.
+ */
+static struct lp_fragment_shader_variant *
+fs_jit_job_finish(struct llvmpipe_context *lp,
+                  struct lp_fragment_shader *shader,
+                  struct lp_fragment_shader_variant *fallback)
+{
+   struct lp_fs_jit_job *job = fallback->jit_job;
+
+   if (!util_queue_fence_is_signalled(&job->fence))
+      return fallback;
+
+   struct lp_fragment_shader_variant *variant = job->variant;
+   job->variant = NULL;
+   fs_jit_job_destroy(lp, job);
+
+   /* Keep the unoptimized variant if compilation failed. */
+   if (!variant)
+      return fallback;
+
+   llvmpipe_remove_shader_variant(lp, fallback);
+   lp_fs_variant_reference(lp, &fallback, NULL);
+   llvmpipe_add_shader_variant(lp, shader, variant);
+
+   return variant;
+}
+
+
 /**
  * Update fragment shader state.  This is called just prior to drawing
  * something when some fragment-related state has changed.
@@ -4629,14 +4902,14 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       make_variant_key(lp, shader, store);
 
    struct lp_fragment_shader_variant *variant = NULL;
-   struct lp_fs_variant_list_item *li;
    /* Search the variants for one which matches the key */
-   LIST_FOR_EACH_ENTRY(li, &shader->variants.list, list) {
-      if (memcmp(&li->base->key, key, shader->variant_key_size) == 0) {
-         variant = li->base;
-         break;
-      }
-   }
+   struct hash_entry *he = _mesa_hash_table_search(shader->variants_by_key,
+                                                   key);
+   if (he)
+      variant = he->data;
+
+   if (variant && variant->jit_job)
+      variant = fs_jit_job_finish(lp, shader, variant);
 
    if (variant) {
       /* Move this variant to the head of the list to implement LRU
@@ -4697,20 +4970,22 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       /*
        * Generate the new variant.
        */
+      const bool async = util_queue_is_initialized(&lp->fs_jit_queue);
       int64_t t0 = os_time_get();
-      variant = generate_variant(lp, shader, key);
+      variant = generate_variant(lp, shader, key, lp->context, async);
       int64_t t1 = os_time_get();
       int64_t dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
+      if (dt > LP_JIT_HITCH_TIME)
+         LP_COUNT(nr_llvm_hitches);
 
       /* Put the new variant into the list */
       if (variant) {
-         list_add(&variant->list_item_local.list, &shader->variants.list);
-         list_add(&variant->list_item_global.list, &lp->fs_variants_list.list);
-         lp->nr_fs_variants++;
-         lp->nr_fs_instrs += variant->nr_instrs;
-         shader->variants_cached++;
+         llvmpipe_add_shader_variant(lp, shader, variant);
+
+         if (variant->unoptimized)
+            fs_jit_job_queue(lp, variant);
       }
    }
 
@@ -4719,6 +4994,31 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 }
 
 
+static void
+llvmpipe_init_fs_jit(struct llvmpipe_context *llvmpipe)
+{
+#ifndef USE_GLOBAL_LLVM_CONTEXT
+   if (!debug_get_option_async_jit())
+      return;
+
+   /* On failure the queue stays zeroed and variants compile synchronously. */
+   util_queue_init(&llvmpipe->fs_jit_queue, "lpjit", 64, 1,
+                   UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                   UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY, NULL);
+#endif
+}
+
+
+void
+llvmpipe_fini_fs_jit(struct llvmpipe_context *llvmpipe)
+{
+   if (util_queue_is_initialized(&llvmpipe->fs_jit_queue)) {
+      util_queue_finish(&llvmpipe->fs_jit_queue);
+      util_queue_destroy(&llvmpipe->fs_jit_queue);
+   }
+}
+
+
 void
 llvmpipe_init_fs_funcs(struct llvmpipe_context *llvmpipe)
 {
@@ -4728,4 +5028,6 @@ llvmpipe_init_fs_funcs(struct llvmpipe_context *llvmpipe)
    llvmpipe->pipe.set_constant_buffer = llvmpipe_set_constant_buffer;
    llvmpipe->pipe.set_shader_buffers = llvmpipe_set_shader_buffers;
    llvmpipe->pipe.set_shader_images = llvmpipe_set_shader_images;
+
+   llvmpipe_init_fs_jit(llvmpipe);
 }
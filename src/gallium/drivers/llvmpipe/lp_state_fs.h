@@ -41,6 +41,8 @@
 #include "lp_jit.h"
 
 struct lp_fragment_shader;
+struct lp_fs_jit_job;
+struct hash_table;
 
 
 /** Indexes into jit_function[] array */
@@ -133,6 +135,26 @@ lp_fs_variant_key_images(struct lp_fragment_shader_variant_key *key)
                                              key->nr_sampler_views)]);
 }
 
+/**
+ * Color format the linear path shaders operate on.  16-bit color buffers
+ * are expanded to 8888 rows around the shader, see lp_fs_linear_run().
+ */
+static inline enum pipe_format
+lp_linear_color_format(enum pipe_format cbuf_format)
+{
+   if (cbuf_format == PIPE_FORMAT_B5G6R5_UNORM)
+      return PIPE_FORMAT_R8G8B8X8_UNORM;
+   return cbuf_format;
+}
+
+static inline bool
+lp_linear_rgba_order(enum pipe_format cbuf_format)
+{
+   const enum pipe_format format = lp_linear_color_format(cbuf_format);
+   return format == PIPE_FORMAT_R8G8B8A8_UNORM ||
+          format == PIPE_FORMAT_R8G8B8X8_UNORM;
+}
+
 /** doubly-linked list item */
 struct lp_fs_variant_list_item
 {
@@ -150,6 +172,21 @@ struct lp_fragment_shader_variant
 
    unsigned opaque:1;
    unsigned blit:1;
+
+   /*
+    * Whether fragments can be rejected against the rasterizer's per-tile
+    * depth bounds (hiz_cull), and whether drawing with this variant keeps
+    * those bounds valid, i.e. can only lower depth values (hiz_preserve).
+    */
+   unsigned hiz_cull:1;
+   unsigned hiz_preserve:1;
+
+   /*
+    * Compiled without optimization, to be replaced by the result of
+    * jit_job once that is done.
+    */
+   unsigned unoptimized:1;
+   struct lp_fs_jit_job *jit_job;
    unsigned linear_input_mask:16;
    struct pipe_reference reference;
 
@@ -208,6 +245,10 @@ struct lp_fragment_shader
    enum lp_fs_kind kind;
 
    struct lp_fs_variant_list_item variants;
+   struct hash_table *variants_by_key;  /**< same variants, hashed by key */
+
+   /** Serializes IR generation, which modifies the NIR */
+   mtx_t ir_mutex;
 
    struct draw_fragment_shader *draw_data;
 
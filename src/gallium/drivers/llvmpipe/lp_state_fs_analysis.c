@@ -202,6 +202,41 @@ check_load_const_in_zero_one(const nir_load_const_instr *load)
 }
 
 
+/*
+ * Check that an ALU result only reaches the FS output store, possibly
+ * through moves and vector constructors, and is not an operand of any
+ * other arithmetic.
+ */
+static bool
+def_only_feeds_output_store(const nir_def *def)
+{
+   if (nir_def_used_by_if(def))
+      return false;
+
+   nir_foreach_use(use, def) {
+      const nir_instr *instr = nir_src_parent_instr(use);
+
+      if (instr->type == nir_instr_type_intrinsic) {
+         const nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(instr);
+         if (intrin->intrinsic != nir_intrinsic_store_deref ||
+             use != &intrin->src[1])
+            return false;
+      } else if (instr->type == nir_instr_type_alu) {
+         const nir_alu_instr *alu = nir_instr_as_alu(instr);
+         if (alu->op != nir_op_mov &&
+             alu->op != nir_op_vec2 &&
+             alu->op != nir_op_vec4)
+            return false;
+         if (!def_only_feeds_output_store(&alu->def))
+            return false;
+      } else {
+         return false;
+      }
+   }
+   return true;
+}
+
+
 /*
  * Examine the NIR shader to determine if it's "linear".
  * For the linear path, we're optimizing the case of rendering a window-
@@ -325,10 +360,20 @@ llvmpipe_nir_fn_is_linear_compat(const struct nir_shader *shader,
             case nir_op_vec4:
                // these instructions are OK
                break;
-            case nir_op_fmul: {
+            case nir_op_fmul:
+            case nir_op_fadd: {
+               /* Sums of products cover color-matrix style shaders.  The
+                * linear path computes them in unorm8 and saturates after
+                * each op.  That only matches the float result, which is
+                * clamped once at the store, when the sum is the last op:
+                * (a+b)*c or a+b+c would see a clamped a+b.
+                */
+               if (alu->op == nir_op_fadd &&
+                   !def_only_feeds_output_store(&alu->def))
+                  return false;
                unsigned num_src = nir_op_infos[alu->op].num_inputs;;
                for (unsigned s = 0; s < num_src; s++) {
-                  /* If the MUL uses immediate values, the values must
+                  /* If the MUL/ADD uses immediate values, the values must
                    * be 32-bit floats in the range [0,1].
                    */
                   if (nir_src_is_const(alu->src[s].src)) {
@@ -653,13 +653,14 @@ void
 llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
 {
    if (LP_PERF & PERF_NO_SHADE) {
-      variant->jit_linear = linear_red;
+      if (is_bgra_cbuf(variant))
+         variant->jit_linear = linear_red;
       return;
    }
 
    struct lp_sampler_static_state *samp0 =
       lp_fs_variant_key_sampler_idx(&variant->key, 0);
-   if (!samp0)
+   if (!samp0 || !is_bgra_cbuf(variant))
       return;
 
    enum pipe_format tex_format = samp0->texture_state.format;
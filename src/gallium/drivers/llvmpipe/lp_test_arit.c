@@ -39,6 +39,9 @@
 #include "gallivm/lp_bld_debug.h"
 #include "gallivm/lp_bld_init.h"
 #include "gallivm/lp_bld_arit.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_gather.h"
+#include "gallivm/lp_bld_swizzle.h"
 
 #include "lp_test.h"
 
@@ -251,6 +254,66 @@ const float round_values[] = {
       -FLT_MAX
 };
 
+/* No halfway cases, whose rounding differs between lp_build_iround paths,
+ * and no values outside the int range.
+ */
+const float iround_values[] = {
+      -10.0, -1, 0.0, 12.0,
+      -1.49, -0.25, 1.25, 2.51,
+      -0.99, -0.01, 0.01, 0.99,
+      -1.51, 1.51,
+      123456.75, -123456.25,
+      8388607.0, -8388607.0,
+};
+
+/* Only normal positive values, fast rsqrt differs on the rest. */
+const float fast_rsqrt_values[] = {
+   1.0, 4.0, 0.3, 1e-007, 100000, 1e+035,
+};
+
+const float minmax_values[] = {
+   -INFINITY, -FLT_MAX, -10.0, -1.0, -0.0, 0.0,
+   0.25, 0.5, 0.75, 1.0, 12.0, FLT_MAX, INFINITY,
+};
+
+static float fminhalff(float x)
+{
+   return fminf(x, 0.5f);
+}
+
+static float fmaxhalff(float x)
+{
+   return fmaxf(x, 0.5f);
+}
+
+static LLVMValueRef
+build_iround(struct lp_build_context *bld, LLVMValueRef a)
+{
+   /* Convert back, so that the float reference applies. */
+   return LLVMBuildSIToFP(bld->gallivm->builder, lp_build_iround(bld, a),
+                          bld->vec_type, "");
+}
+
+static LLVMValueRef
+build_fast_rsqrt(struct lp_build_context *bld, LLVMValueRef a)
+{
+   if (lp_build_fast_rsqrt_available(bld->type))
+      return lp_build_fast_rsqrt(bld, a);
+   return lp_build_rsqrt(bld, a);
+}
+
+static LLVMValueRef
+build_minhalf(struct lp_build_context *bld, LLVMValueRef a)
+{
+   return lp_build_min(bld, a, lp_build_const_vec(bld->gallivm, bld->type, 0.5));
+}
+
+static LLVMValueRef
+build_maxhalf(struct lp_build_context *bld, LLVMValueRef a)
+{
+   return lp_build_max(bld, a, lp_build_const_vec(bld->gallivm, bld->type, 0.5));
+}
+
 static float fractf(float x)
 {
    x -= floorf(x);
@@ -328,6 +391,11 @@ unary_tests[] = {
    {"trunc", &lp_build_trunc, &truncf, round_values, ARRAY_SIZE(round_values), 24.0 },
    {"floor", &lp_build_floor, &floorf, round_values, ARRAY_SIZE(round_values), 24.0 },
    {"ceil", &lp_build_ceil, &ceilf, round_values, ARRAY_SIZE(round_values), 24.0 },
+   {"iround", &build_iround, &nearbyintf, iround_values, ARRAY_SIZE(iround_values), 24.0 },
+   /* rsqrtps guarantees a relative error of at most 1.5 * 2^-12. */
+   {"fast_rsqrt", &build_fast_rsqrt, &rsqrtf, fast_rsqrt_values, ARRAY_SIZE(fast_rsqrt_values), 11.0 },
+   {"min", &build_minhalf, &fminhalff, minmax_values, ARRAY_SIZE(minmax_values), 24.0 },
+   {"max", &build_maxhalf, &fmaxhalff, minmax_values, ARRAY_SIZE(minmax_values), 24.0 },
    {"fract", &lp_build_fract_safe, &fractf, fract_values, ARRAY_SIZE(fract_values), 24.0 },
 };
 
@@ -521,15 +589,120 @@ test_unary(unsigned verbose, FILE *fp, const struct unary_test_t *test, unsigned
 }
 
 
+#if LLVM_VERSION_MAJOR >= 10
+typedef void (*permute_func_t)(float *gathered, float *shuffled, const float *in);
+
+/*
+ * Test lp_build_gather and lp_build_shuffle_dynamic, by reversing a vector
+ * with each.
+ */
+static bool
+test_permute(unsigned verbose, unsigned length)
+{
+   char test_name[128];
+   snprintf(test_name, sizeof test_name, "permute.v%u", length);
+   struct lp_type type = lp_type_float_vec(32, length * 32);
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+   permute_func_t test_func_jit;
+   bool success = true;
+   unsigned i;
+   float *in, *gathered, *shuffled;
+
+   in = align_malloc(length * 4, length * 4);
+   gathered = align_malloc(length * 4, length * 4);
+   shuffled = align_malloc(length * 4, length * 4);
+
+   for (i = 0; i < length; i++)
+      in[i] = i + 0.5f;
+
+   context = LLVMContextCreate();
+#if LLVM_VERSION_MAJOR == 15
+   LLVMContextSetOpaquePointers(context, false);
+#endif
+   gallivm = gallivm_create("test_module", context, NULL);
+
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef vf32t = lp_build_vec_type(gallivm, type);
+   LLVMTypeRef args[3] = {
+      LLVMPointerType(vf32t, 0), LLVMPointerType(vf32t, 0), LLVMPointerType(vf32t, 0)
+   };
+   LLVMValueRef func = LLVMAddFunction(gallivm->module, test_name,
+                                       LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                                        args, ARRAY_SIZE(args), 0));
+   LLVMBasicBlockRef block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMValueRef offsets[LP_MAX_VECTOR_LENGTH];
+   LLVMValueRef indices[LP_MAX_VECTOR_LENGTH];
+   struct lp_build_context int_bld;
+
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   LLVMPositionBuilderAtEnd(builder, block);
+   lp_build_context_init(&int_bld, gallivm, lp_int_type(type));
+
+   for (i = 0; i < length; i++) {
+      indices[i] = lp_build_const_int32(gallivm, length - 1 - i);
+      offsets[i] = lp_build_const_int32(gallivm, (length - 1 - i) * 4);
+   }
+
+   LLVMValueRef base_ptr =
+      LLVMBuildBitCast(builder, LLVMGetParam(func, 2),
+                       LLVMPointerType(LLVMInt8TypeInContext(context), 0), "");
+   /* dst_type is per gathered element, i.e. scalar here. */
+   LLVMValueRef res = lp_build_gather(gallivm, length, 32, lp_type_float(32),
+                                      true, base_ptr,
+                                      LLVMConstVector(offsets, length), false);
+   LLVMBuildStore(builder, res, LLVMGetParam(func, 0));
+
+   res = LLVMBuildLoad2(builder, vf32t, LLVMGetParam(func, 2), "");
+   res = LLVMBuildBitCast(builder, res, int_bld.vec_type, "");
+   res = lp_build_shuffle_dynamic(&int_bld, res, LLVMConstVector(indices, length));
+   res = LLVMBuildBitCast(builder, res, vf32t, "");
+   LLVMBuildStore(builder, res, LLVMGetParam(func, 1));
+
+   LLVMBuildRetVoid(builder);
+   gallivm_verify_function(gallivm, func);
+
+   gallivm_compile_module(gallivm);
+   test_func_jit = (permute_func_t) gallivm_jit_function(gallivm, func);
+   gallivm_free_ir(gallivm);
+
+   test_func_jit(gathered, shuffled, in);
+
+   for (i = 0; i < length; i++) {
+      float ref = in[length - 1 - i];
+      bool pass = gathered[i] == ref && shuffled[i] == ref;
+
+      if (!pass || verbose) {
+         printf("%s[%u]: ref = %g, gather = %g, shuffle = %g, %s\n",
+                test_name, i, ref, gathered[i], shuffled[i],
+                pass ? "PASS" : "FAIL");
+         fflush(stdout);
+      }
+      if (!pass)
+         success = false;
+   }
+
+   gallivm_destroy(gallivm);
+   LLVMContextDispose(context);
+
+   align_free(in);
+   align_free(gathered);
+   align_free(shuffled);
+
+   return success;
+}
+#endif
+
+
 bool
 test_all(unsigned verbose, FILE *fp)
 {
+   unsigned max_length = lp_native_vector_width / 32;
+   unsigned length;
    bool success = true;
    int i;
 
    for (i = 0; i < ARRAY_SIZE(unary_tests); ++i) {
-      unsigned max_length = lp_native_vector_width / 32;
-      unsigned length;
       for (length = 1; length <= max_length; length *= 2) {
          if (!test_unary(verbose, fp, &unary_tests[i], length)) {
             success = false;
@@ -537,6 +710,14 @@ test_all(unsigned verbose, FILE *fp)
       }
    }
 
+#if LLVM_VERSION_MAJOR >= 10
+   for (length = 4; length <= max_length; length *= 2) {
+      if (!test_permute(verbose, length)) {
+         success = false;
+      }
+   }
+#endif
+
    return success;
 }
 
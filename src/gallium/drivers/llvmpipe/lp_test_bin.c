@@ -0,0 +1,337 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks that parallel binning (LP_BIN_THREADS) renders exactly what
+ * serial binning does.
+ *
+ * Every case draws thousands of small triangles or lines, enough for each
+ * vbuf batch to be split into several slices, once with a context that
+ * bins serially and once with one that uses three binning threads.  The
+ * blended cases depend on the order primitives land in each bin, the
+ * opaque one mixes in triangles covering whole tiles, which reset the bins
+ * they cover, and the others vary the setup state the binning threads
+ * copy: culling, flat shading and line width.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "cso_cache/cso_context.h"
+#include "nir/nir_builder.h"
+#include "util/format/u_format.h"
+#include "util/u_box.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_simple_shaders.h"
+#include "sw/null/null_sw_winsys.h"
+#include "lp_context.h"
+#include "lp_public.h"
+#include "lp_setup_context.h"
+
+#define SIZE            256
+#define NUM_PRIMS       6000
+#define BIN_THREADS     "3"
+
+
+struct bin_case {
+   const char *name;
+   enum mesa_prim prim;
+   bool indexed;
+   bool blend;
+   bool opaque_tiles;   /**< every 64th triangle covers whole tiles */
+   bool cull;
+   bool flat;
+   float line_width;
+};
+
+static const struct bin_case cases[] = {
+   { "triangles", MESA_PRIM_TRIANGLES, false, true, false, false, false, 1.0f },
+   { "indexed triangles", MESA_PRIM_TRIANGLES, true, true, false, false, false, 1.0f },
+   { "opaque tiles", MESA_PRIM_TRIANGLES, false, false, true, false, false, 1.0f },
+   { "cull back", MESA_PRIM_TRIANGLES, false, true, false, true, false, 1.0f },
+   { "flat first", MESA_PRIM_TRIANGLES, true, true, false, false, true, 1.0f },
+   { "lines", MESA_PRIM_LINES, false, true, false, false, false, 1.0f },
+   { "indexed lines", MESA_PRIM_LINES, true, true, false, false, false, 1.0f },
+   { "wide lines", MESA_PRIM_LINES, false, true, false, false, false, 2.5f },
+};
+
+
+static float
+rand_float(unsigned *seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return ((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+
+static void *
+create_fs(struct pipe_screen *screen, struct pipe_context *pipe, bool flat)
+{
+   const nir_shader_compiler_options *options =
+      screen->get_compiler_options(screen, PIPE_SHADER_IR_NIR,
+                                   PIPE_SHADER_FRAGMENT);
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT,
+                                                  options, "bin");
+   nir_variable *in = nir_variable_create(b.shader, nir_var_shader_in,
+                                          glsl_vec4_type(), "color");
+   nir_variable *out = nir_variable_create(b.shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "color");
+
+   in->data.location = VARYING_SLOT_VAR0;
+   in->data.interpolation = flat ? INTERP_MODE_FLAT : INTERP_MODE_SMOOTH;
+   out->data.location = FRAG_RESULT_DATA0;
+   b.shader->num_inputs = 1;
+   b.shader->num_outputs = 1;
+
+   nir_store_var(&b, out, nir_load_var(&b, in), 0xf);
+
+   nir_shader_gather_info(b.shader, nir_shader_get_entrypoint(b.shader));
+   screen->finalize_nir(screen, b.shader);
+
+   struct pipe_shader_state state = {
+      .type = PIPE_SHADER_IR_NIR,
+      .ir.nir = b.shader,
+   };
+   return pipe->create_fs_state(pipe, &state);
+}
+
+
+/* Small primitives all over the target, with random winding. */
+static void
+make_vertices(const struct bin_case *bc, float (*vertices)[2][4])
+{
+   const unsigned verts_per_prim = bc->prim == MESA_PRIM_LINES ? 2 : 3;
+   unsigned seed = 1;
+
+   for (unsigned p = 0; p < NUM_PRIMS; p++) {
+      const bool large = bc->opaque_tiles && p % 64 == 0;
+      const float size = large ? 1.5f : 0.08f;
+      const float x = rand_float(&seed) * (2.0f - size) - 1.0f;
+      const float y = rand_float(&seed) * (2.0f - size) - 1.0f;
+      const bool flip = rand_float(&seed) < 0.5f;
+
+      for (unsigned v = 0; v < verts_per_prim; v++) {
+         const unsigned corner = flip && v ? 3 - v : v;
+         float *pos = vertices[p * verts_per_prim + v][0];
+         float *color = vertices[p * verts_per_prim + v][1];
+
+         pos[0] = x + (corner == 1 ? size : 0.0f) + rand_float(&seed) * 0.01f;
+         pos[1] = y + (corner != 0 ? size : 0.0f) * (corner == 2 ? 1.0f : 0.5f);
+         pos[2] = 0.0f;
+         pos[3] = 1.0f;
+         for (unsigned c = 0; c < 4; c++)
+            color[c] = rand_float(&seed);
+      }
+   }
+}
+
+
+static void
+render(struct pipe_screen *screen, const char *bin_threads,
+       uint8_t *results[ARRAY_SIZE(cases)], bool *threads_enabled)
+{
+   /* llvmpipe picks up the binning threads when the context is created */
+   if (bin_threads)
+      setenv("LP_BIN_THREADS", bin_threads, 1);
+   else
+      unsetenv("LP_BIN_THREADS");
+
+   struct pipe_context *pipe = screen->context_create(screen, NULL, 0);
+   struct cso_context *cso = cso_create_context(pipe, 0);
+   const enum tgsi_semantic semantic_names[] =
+      { TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_GENERIC };
+   const unsigned semantic_indexes[] = { 0, 0 };
+   const unsigned num_verts = NUM_PRIMS * 3;
+   float (*vertices)[2][4] = malloc(num_verts * sizeof(*vertices));
+   uint32_t *indices = malloc(num_verts * sizeof(*indices));
+   void *vs = util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
+                                                  semantic_indexes, false);
+
+   *threads_enabled = llvmpipe_context(pipe)->setup->num_bin_threads > 0;
+
+   /* not a format the linear rasterizer takes, that path is always binned
+    * serially
+    */
+   struct pipe_resource templ = {
+      .target = PIPE_TEXTURE_2D,
+      .format = PIPE_FORMAT_B10G10R10A2_UNORM,
+      .width0 = SIZE,
+      .height0 = SIZE,
+      .depth0 = 1,
+      .array_size = 1,
+      .bind = PIPE_BIND_RENDER_TARGET,
+   };
+   struct pipe_resource *cbuf = screen->resource_create(screen, &templ);
+   struct pipe_surface surf_templ = { .format = templ.format };
+   struct pipe_surface *csurf = pipe->create_surface(pipe, cbuf, &surf_templ);
+   const struct pipe_framebuffer_state fb = {
+      .width = SIZE,
+      .height = SIZE,
+      .nr_cbufs = 1,
+      .cbufs[0] = csurf,
+   };
+   const struct pipe_viewport_state viewport = {
+      .scale = { SIZE / 2.0f, SIZE / 2.0f, 0.5f },
+      .translate = { SIZE / 2.0f, SIZE / 2.0f, 0.5f },
+      .swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X,
+      .swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y,
+      .swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z,
+      .swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W,
+   };
+   const struct pipe_depth_stencil_alpha_state dsa = {0};
+   struct cso_velems_state velem = { .count = 2 };
+   const union pipe_color_union clear_color = { .f = { 0.25f, 0.5f, 0.75f, 1.0f } };
+
+   for (unsigned i = 0; i < 2; i++) {
+      velem.velems[i].src_offset = i * 4 * sizeof(float);
+      velem.velems[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+      velem.velems[i].src_stride = 2 * 4 * sizeof(float);
+   }
+
+   cso_set_framebuffer(cso, &fb);
+   cso_set_depth_stencil_alpha(cso, &dsa);
+   cso_set_viewport(cso, &viewport);
+   cso_set_vertex_shader_handle(cso, vs);
+   cso_set_vertex_elements(cso, &velem);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+      const struct bin_case *bc = &cases[i];
+      const unsigned count =
+         NUM_PRIMS * (bc->prim == MESA_PRIM_LINES ? 2 : 3);
+      struct pipe_blend_state blend = {
+         .rt[0].colormask = PIPE_MASK_RGBA,
+      };
+      const struct pipe_rasterizer_state rast = {
+         .cull_face = bc->cull ? PIPE_FACE_BACK : PIPE_FACE_NONE,
+         .front_ccw = 1,
+         .flatshade = bc->flat,
+         .flatshade_first = bc->flat,
+         .line_width = bc->line_width,
+         .line_rectangular = bc->line_width > 1.0f,
+         .half_pixel_center = 1,
+         .bottom_edge_rule = 1,
+         .depth_clip_near = 1,
+         .depth_clip_far = 1,
+      };
+      void *fs = create_fs(screen, pipe, bc->flat);
+
+      if (bc->blend) {
+         blend.rt[0].blend_enable = 1;
+         blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+         blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+         blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+         blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+         blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+         blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+      }
+
+      make_vertices(bc, vertices);
+      struct pipe_resource *vbuf =
+         pipe_buffer_create(screen, PIPE_BIND_VERTEX_BUFFER,
+                            PIPE_USAGE_DEFAULT, count * sizeof(*vertices));
+      pipe_buffer_write(pipe, vbuf, 0, count * sizeof(*vertices), vertices);
+      const struct pipe_vertex_buffer vb = {
+         .buffer.resource = vbuf,
+      };
+
+      cso_set_blend(cso, &blend);
+      cso_set_rasterizer(cso, &rast);
+      cso_set_fragment_shader_handle(cso, fs);
+      cso_set_vertex_buffers(cso, 1, false, &vb);
+
+      pipe->clear(pipe, PIPE_CLEAR_COLOR, NULL, &clear_color, 1.0, 0);
+
+      /* indexed draws go through lp_setup_draw_elements(), in reverse */
+      struct pipe_draw_info info = {
+         .mode = bc->prim,
+         .instance_count = 1,
+         .index_size = bc->indexed ? 4 : 0,
+         .has_user_indices = bc->indexed,
+         .index.user = indices,
+      };
+      const struct pipe_draw_start_count_bias draw = {
+         .count = count,
+      };
+      for (unsigned v = 0; v < count; v++)
+         indices[v] = count - 1 - v;
+      cso_draw_vbo(cso, &info, 0, NULL, &draw, 1);
+
+      struct pipe_transfer *transfer;
+      struct pipe_box box;
+      u_box_2d(0, 0, SIZE, SIZE, &box);
+      const uint8_t *map = pipe->texture_map(pipe, cbuf, 0, PIPE_MAP_READ,
+                                             &box, &transfer);
+      for (unsigned y = 0; y < SIZE; y++)
+         memcpy(results[i] + y * SIZE * 4, map + y * transfer->stride,
+                SIZE * 4);
+      pipe->texture_unmap(pipe, transfer);
+
+      cso_set_fragment_shader_handle(cso, NULL);
+      pipe->delete_fs_state(pipe, fs);
+      pipe_resource_reference(&vbuf, NULL);
+   }
+
+   cso_destroy_context(cso);
+   pipe->delete_vs_state(pipe, vs);
+   pipe_surface_reference(&csurf, NULL);
+   pipe_resource_reference(&cbuf, NULL);
+   pipe->destroy(pipe);
+   free(vertices);
+   free(indices);
+}
+
+
+int
+main(int argc, char **argv)
+{
+   uint8_t *results[2][ARRAY_SIZE(cases)];
+   bool threads_enabled[2];
+   bool pass = true;
+
+   for (unsigned r = 0; r < 2; r++) {
+      for (unsigned i = 0; i < ARRAY_SIZE(cases); i++)
+         results[r][i] = calloc(SIZE * SIZE, 4);
+   }
+
+   struct pipe_screen *screen = llvmpipe_create_screen(null_sw_create());
+   render(screen, NULL, results[0], &threads_enabled[0]);
+   render(screen, BIN_THREADS, results[1], &threads_enabled[1]);
+   screen->destroy(screen);
+
+   if (threads_enabled[0] || !threads_enabled[1]) {
+      printf("LP_BIN_THREADS wasn't picked up\n");
+      pass = false;
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+      unsigned num_diffs = 0, first = 0;
+
+      for (unsigned p = 0; p < SIZE * SIZE; p++) {
+         if (memcmp(results[0][i] + p * 4, results[1][i] + p * 4, 4)) {
+            if (!num_diffs)
+               first = p;
+            num_diffs++;
+         }
+      }
+
+      if (num_diffs) {
+         printf("%s: %u pixels differ, first at %u,%u\n", cases[i].name,
+                num_diffs, first % SIZE, first / SIZE);
+         pass = false;
+      }
+   }
+
+   for (unsigned r = 0; r < 2; r++) {
+      for (unsigned i = 0; i < ARRAY_SIZE(cases); i++)
+         free(results[r][i]);
+   }
+
+   printf("%s\n", pass ? "PASS" : "FAIL");
+   return pass ? 0 : 1;
+}
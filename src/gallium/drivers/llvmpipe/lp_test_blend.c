@@ -628,9 +628,19 @@ const struct lp_type blend_types[] = {
    /* float, fixed,  sign,  norm, width, len */
    {   true, false,  true, false,    32,   4 }, /* f32 x 4 */
    {  false, false, false,  true,     8,  16 }, /* u8n x 16 */
+   {   true, false,  true, false,    32,   8 }, /* f32 x 8 */
+   {   true, false,  true, false,    32,  16 }, /* f32 x 16 */
 };
 
 
+/* Wider vectors are only tested with a matching LP_NATIVE_VECTOR_WIDTH. */
+static bool
+blend_type_supported(const struct lp_type *type)
+{
+   return type->width * type->length <= MAX2(lp_native_vector_width, 128);
+}
+
+
 const unsigned num_funcs = ARRAY_SIZE(blend_funcs);
 const unsigned num_factors = ARRAY_SIZE(blend_factors);
 const unsigned num_types = ARRAY_SIZE(blend_types);
@@ -661,6 +671,9 @@ test_all(unsigned verbose, FILE *fp)
                            *alpha_dst_factor == PIPE_BLENDFACTOR_SRC_ALPHA_SATURATE)
                            continue;
 
+                        if (!blend_type_supported(type))
+                           continue;
+
                         memset(&blend, 0, sizeof blend);
                         blend.rt[0].blend_enable      = 1;
                         blend.rt[0].rgb_func          = *rgb_func;
@@ -714,7 +727,9 @@ test_some(unsigned verbose, FILE *fp,
          alpha_dst_factor = &blend_factors[rand() % num_factors];
       } while(*alpha_dst_factor == PIPE_BLENDFACTOR_SRC_ALPHA_SATURATE);
 
-      type = &blend_types[rand() % num_types];
+      do {
+         type = &blend_types[rand() % num_types];
+      } while (!blend_type_supported(type));
 
       memset(&blend, 0, sizeof blend);
       blend.rt[0].blend_enable      = 1;
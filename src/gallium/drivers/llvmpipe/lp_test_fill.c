@@ -0,0 +1,408 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Fill rate benchmark of the fragment shader path, run at each vector
+ * width the CPU supports.
+ *
+ * Overlapping smooth shaded triangles are drawn with depth/stencil
+ * testing, blending or framebuffer fetch.  With 256-bit vectors the
+ * fragment shader covers each 4x4 block in two 8 wide iterations, with
+ * 512-bit vectors in a single 16 wide one, so the color and depth/stencil
+ * buffers of both runs are compared and must match.
+ *
+ * Usage: lp_test_fill [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "cso_cache/cso_context.h"
+#include "nir/nir_builder.h"
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_box.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_draw_quad.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_simple_shaders.h"
+#include "sw/null/null_sw_winsys.h"
+#include "lp_debug.h"
+#include "lp_public.h"
+
+#define SIZE            256
+#define NUM_TRIS        64
+
+
+struct fill_case {
+   const char *name;
+   enum pipe_format cbuf_format;
+   enum pipe_format zsbuf_format;
+   bool blend;
+   bool fbfetch;
+   bool is_1d;
+};
+
+static const struct fill_case cases[] = {
+   { "color", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_NONE, false, false, false },
+   { "blend", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_NONE, true, false, false },
+   { "blend float", PIPE_FORMAT_R32G32B32A32_FLOAT, PIPE_FORMAT_NONE, true, false, false },
+   { "fbfetch", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_NONE, false, true, false },
+   { "z16", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_Z16_UNORM, false, false, false },
+   { "z24s8", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_Z24_UNORM_S8_UINT, false, false, false },
+   { "z32f", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_Z32_FLOAT, true, false, false },
+   { "z32fs8", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_Z32_FLOAT_S8X24_UINT, false, false, false },
+   { "1d blend", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_NONE, true, false, true },
+   { "1d fbfetch", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_NONE, false, true, true },
+   { "1d z32f", PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_Z32_FLOAT, false, false, true },
+};
+
+
+struct fill_result {
+   uint8_t *color;
+   uint8_t *zs;
+   double mpixels_per_sec;
+};
+
+
+static float
+rand_float(unsigned *seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return ((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+
+static void *
+create_fs(struct pipe_screen *screen, struct pipe_context *pipe,
+          bool fbfetch)
+{
+   const nir_shader_compiler_options *options =
+      screen->get_compiler_options(screen, PIPE_SHADER_IR_NIR,
+                                   PIPE_SHADER_FRAGMENT);
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT,
+                                                  options, "fill");
+   nir_variable *in = nir_variable_create(b.shader, nir_var_shader_in,
+                                          glsl_vec4_type(), "color");
+   nir_variable *out = nir_variable_create(b.shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "color");
+
+   in->data.location = VARYING_SLOT_VAR0;
+   in->data.interpolation = INTERP_MODE_SMOOTH;
+   out->data.location = FRAG_RESULT_DATA0;
+   out->data.fb_fetch_output = fbfetch;
+   b.shader->num_inputs = 1;
+   b.shader->num_outputs = 1;
+
+   nir_def *color = nir_load_var(&b, in);
+   if (fbfetch) {
+      nir_def *half = nir_imm_float(&b, 0.5f);
+      color = nir_ffma(&b, nir_load_var(&b, out), half,
+                       nir_fmul(&b, color, half));
+   }
+   nir_store_var(&b, out, color, 0xf);
+
+   nir_shader_gather_info(b.shader, nir_shader_get_entrypoint(b.shader));
+   b.shader->info.fs.uses_fbfetch_output = fbfetch;
+   screen->finalize_nir(screen, b.shader);
+
+   struct pipe_shader_state state = {
+      .type = PIPE_SHADER_IR_NIR,
+      .ir.nir = b.shader,
+   };
+   return pipe->create_fs_state(pipe, &state);
+}
+
+
+static struct pipe_resource *
+create_texture(struct pipe_screen *screen, const struct fill_case *fc,
+               enum pipe_format format, unsigned bind)
+{
+   struct pipe_resource templ = {
+      .target = fc->is_1d ? PIPE_TEXTURE_1D : PIPE_TEXTURE_2D,
+      .format = format,
+      .width0 = SIZE,
+      .height0 = fc->is_1d ? 1 : SIZE,
+      .depth0 = 1,
+      .array_size = 1,
+      .bind = bind,
+   };
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+static void
+read_back(struct pipe_context *pipe, struct pipe_resource *res,
+          uint8_t *result)
+{
+   const unsigned row_size = util_format_get_stride(res->format, SIZE);
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+
+   u_box_2d(0, 0, SIZE, res->height0, &box);
+   const uint8_t *map = pipe->texture_map(pipe, res, 0, PIPE_MAP_READ, &box,
+                                          &transfer);
+   for (unsigned y = 0; y < res->height0; y++)
+      memcpy(result + y * row_size, map + y * transfer->stride, row_size);
+   pipe->texture_unmap(pipe, transfer);
+}
+
+
+static void
+run_case(struct pipe_screen *screen, struct pipe_context *pipe,
+         struct cso_context *cso, void *vs, struct pipe_resource *vbuf,
+         const struct fill_case *fc, unsigned iterations,
+         struct fill_result *result)
+{
+   const unsigned height = fc->is_1d ? 1 : SIZE;
+   struct pipe_resource *cbuf =
+      create_texture(screen, fc, fc->cbuf_format, PIPE_BIND_RENDER_TARGET);
+   struct pipe_resource *zsbuf = NULL;
+   struct pipe_surface surf_templ = {0}, *csurf, *zssurf = NULL;
+
+   surf_templ.format = fc->cbuf_format;
+   csurf = pipe->create_surface(pipe, cbuf, &surf_templ);
+   if (fc->zsbuf_format != PIPE_FORMAT_NONE) {
+      zsbuf = create_texture(screen, fc, fc->zsbuf_format,
+                             PIPE_BIND_DEPTH_STENCIL);
+      surf_templ.format = fc->zsbuf_format;
+      zssurf = pipe->create_surface(pipe, zsbuf, &surf_templ);
+   }
+
+   const struct pipe_framebuffer_state fb = {
+      .width = SIZE,
+      .height = height,
+      .nr_cbufs = 1,
+      .cbufs[0] = csurf,
+      .zsbuf = zssurf,
+   };
+   struct pipe_blend_state blend = {
+      .rt[0].colormask = PIPE_MASK_RGBA,
+   };
+   struct pipe_depth_stencil_alpha_state dsa = {0};
+   const struct pipe_rasterizer_state rast = {
+      .cull_face = PIPE_FACE_NONE,
+      .half_pixel_center = 1,
+      .bottom_edge_rule = 1,
+      .depth_clip_near = 1,
+      .depth_clip_far = 1,
+   };
+   const struct pipe_viewport_state viewport = {
+      .scale = { SIZE / 2.0f, height / 2.0f, 0.5f },
+      .translate = { SIZE / 2.0f, height / 2.0f, 0.5f },
+      .swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X,
+      .swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y,
+      .swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z,
+      .swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W,
+   };
+   struct cso_velems_state velem = { .count = 2 };
+   const union pipe_color_union clear_color = { .f = { 0.25f, 0.5f, 0.75f, 1.0f } };
+   void *fs = create_fs(screen, pipe, fc->fbfetch);
+
+   if (fc->blend) {
+      blend.rt[0].blend_enable = 1;
+      blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+      blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+      blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+      blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+      blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+      blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   }
+   if (zsbuf) {
+      dsa.depth_enabled = 1;
+      dsa.depth_writemask = 1;
+      dsa.depth_func = PIPE_FUNC_LESS;
+      if (util_format_has_stencil(util_format_description(zsbuf->format))) {
+         dsa.stencil[0].enabled = 1;
+         dsa.stencil[0].func = PIPE_FUNC_ALWAYS;
+         dsa.stencil[0].fail_op = PIPE_STENCIL_OP_KEEP;
+         dsa.stencil[0].zfail_op = PIPE_STENCIL_OP_DECR;
+         dsa.stencil[0].zpass_op = PIPE_STENCIL_OP_INCR;
+         dsa.stencil[0].valuemask = 0xff;
+         dsa.stencil[0].writemask = 0xff;
+      }
+   }
+
+   for (unsigned i = 0; i < 2; i++) {
+      velem.velems[i].src_offset = i * 4 * sizeof(float);
+      velem.velems[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+      velem.velems[i].src_stride = 2 * 4 * sizeof(float);
+   }
+
+   cso_set_framebuffer(cso, &fb);
+   cso_set_blend(cso, &blend);
+   cso_set_depth_stencil_alpha(cso, &dsa);
+   cso_set_rasterizer(cso, &rast);
+   cso_set_viewport(cso, &viewport);
+   cso_set_fragment_shader_handle(cso, fs);
+   cso_set_vertex_shader_handle(cso, vs);
+   cso_set_vertex_elements(cso, &velem);
+
+   /* The first frame compiles the shader variant and gives the result,
+    * the following ones are timed.
+    */
+   int64_t start = 0;
+   for (unsigned i = 0; i <= iterations; i++) {
+      if (i == 1)
+         start = os_time_get_nano();
+      pipe->clear(pipe, PIPE_CLEAR_COLOR | (zsbuf ? PIPE_CLEAR_DEPTHSTENCIL : 0),
+                  NULL, &clear_color, 1.0, 0x80);
+      util_draw_vertex_buffer(pipe, cso, vbuf, 0, MESA_PRIM_TRIANGLES,
+                              NUM_TRIS * 3, 2);
+      if (i == 0) {
+         read_back(pipe, cbuf, result->color);
+         if (zsbuf)
+            read_back(pipe, zsbuf, result->zs);
+      }
+   }
+
+   struct pipe_fence_handle *fence = NULL;
+   pipe->flush(pipe, &fence, 0);
+   screen->fence_finish(screen, NULL, fence, OS_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &fence, NULL);
+   const double secs = (os_time_get_nano() - start) / 1e9;
+
+   /* every triangle covers about an eighth of the target */
+   result->mpixels_per_sec = iterations && secs > 0.0 ?
+      iterations * (double)NUM_TRIS * SIZE * height / 8 / secs / 1e6 : 0.0;
+
+   cso_set_fragment_shader_handle(cso, NULL);
+   pipe->delete_fs_state(pipe, fs);
+   pipe_surface_reference(&csurf, NULL);
+   pipe_surface_reference(&zssurf, NULL);
+   pipe_resource_reference(&cbuf, NULL);
+   pipe_resource_reference(&zsbuf, NULL);
+}
+
+
+static void
+run_width(unsigned width, unsigned iterations,
+          struct fill_result results[ARRAY_SIZE(cases)])
+{
+   char value[8];
+
+   /* llvmpipe picks up the vector width when the screen is created */
+   snprintf(value, sizeof(value), "%u", width);
+   setenv("LP_NATIVE_VECTOR_WIDTH", value, 1);
+
+   struct pipe_screen *screen = llvmpipe_create_screen(null_sw_create());
+   struct pipe_context *pipe = screen->context_create(screen, NULL, 0);
+   struct cso_context *cso = cso_create_context(pipe, 0);
+   const enum tgsi_semantic semantic_names[] =
+      { TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_GENERIC };
+   const unsigned semantic_indexes[] = { 0, 0 };
+   float (*vertices)[2][4] = malloc(NUM_TRIS * 3 * sizeof(*vertices));
+   unsigned seed = 1;
+
+   for (unsigned t = 0; t < NUM_TRIS; t++) {
+      /* triangles of about half the target's width, at odd offsets */
+      const float x = rand_float(&seed) * 1.5f - 1.0f;
+      const float y = rand_float(&seed) * 1.5f - 1.0f;
+      for (unsigned v = 0; v < 3; v++) {
+         float *pos = vertices[t * 3 + v][0];
+         float *color = vertices[t * 3 + v][1];
+
+         pos[0] = x + (v == 1 ? 0.5f : 0.0f) + rand_float(&seed) * 0.1f;
+         pos[1] = y + (v == 2 ? 0.5f : 0.0f) + rand_float(&seed) * 0.1f;
+         pos[2] = rand_float(&seed) * 2.0f - 1.0f;
+         pos[3] = 1.0f;
+         for (unsigned c = 0; c < 4; c++)
+            color[c] = rand_float(&seed);
+      }
+   }
+
+   struct pipe_resource *vbuf =
+      pipe_buffer_create(screen, PIPE_BIND_VERTEX_BUFFER, PIPE_USAGE_DEFAULT,
+                         NUM_TRIS * 3 * sizeof(*vertices));
+   pipe_buffer_write(pipe, vbuf, 0, NUM_TRIS * 3 * sizeof(*vertices),
+                     vertices);
+   void *vs = util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
+                                                  semantic_indexes, false);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+      run_case(screen, pipe, cso, vs, vbuf, &cases[i], iterations,
+               &results[i]);
+      if (iterations)
+         printf("%-12s %u-bit: %8.1f Mpixels/s\n", cases[i].name, width,
+                results[i].mpixels_per_sec);
+   }
+
+   cso_destroy_context(cso);
+   pipe->delete_vs_state(pipe, vs);
+   pipe_resource_reference(&vbuf, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+   free(vertices);
+}
+
+
+static bool
+compare(const char *name, const char *what, const uint8_t *a,
+        const uint8_t *b, unsigned size)
+{
+   for (unsigned i = 0; i < size; i++) {
+      if (a[i] != b[i]) {
+         printf("%s: %s byte %u is 0x%02x with 512-bit vectors, "
+                "0x%02x with 256-bit ones\n", name, what, i, b[i], a[i]);
+         return false;
+      }
+   }
+   return true;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   const unsigned iterations = argc > 1 ? atoi(argv[1]) : 4;
+   struct fill_result results[2][ARRAY_SIZE(cases)];
+   const bool has_512 = util_get_cpu_caps()->has_avx512f;
+   bool pass = true;
+
+   /* no linear rasterizer shortcuts, time the fragment shader variants */
+   LP_PERF |= PERF_NO_RAST_LINEAR;
+
+   for (unsigned w = 0; w < 2; w++) {
+      for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+         results[w][i].color = calloc(SIZE * SIZE, 16);
+         results[w][i].zs = calloc(SIZE * SIZE, 8);
+      }
+   }
+
+   run_width(256, iterations, results[0]);
+   if (has_512) {
+      run_width(512, iterations, results[1]);
+
+      for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+         const struct fill_case *fc = &cases[i];
+         const unsigned pixels = fc->is_1d ? SIZE : SIZE * SIZE;
+
+         pass &= compare(fc->name, "color", results[0][i].color,
+                         results[1][i].color,
+                         pixels * util_format_get_blocksize(fc->cbuf_format));
+         if (fc->zsbuf_format != PIPE_FORMAT_NONE)
+            pass &= compare(fc->name, "depth/stencil", results[0][i].zs,
+                            results[1][i].zs,
+                            pixels * util_format_get_blocksize(fc->zsbuf_format));
+      }
+   } else {
+      printf("no AVX-512, 512-bit vectors not compared\n");
+   }
+
+   for (unsigned w = 0; w < 2; w++) {
+      for (unsigned i = 0; i < ARRAY_SIZE(cases); i++) {
+         free(results[w][i].color);
+         free(results[w][i].zs);
+      }
+   }
+
+   printf("%s\n", pass ? "PASS" : "FAIL");
+   return pass ? 0 : 1;
+}
@@ -0,0 +1,408 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Renders window-aligned textured quads with multiply-add shaders, once
+ * with the linear rasterizer permitted and once with it disabled through
+ * LP_PERF, and checks that both match the float result clamped at the
+ * store.
+ *
+ * The texels and constants are picked so that the sums saturate.  The
+ * linear path saturates after each op, so only shaders whose sum is the
+ * last op may be linear; (a+b)*c and a+b+c must take the general path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "cso_cache/cso_context.h"
+#include "nir/nir_builder.h"
+#include "util/u_box.h"
+#include "util/u_draw_quad.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_sampler.h"
+#include "util/u_simple_shaders.h"
+#include "sw/null/null_sw_winsys.h"
+#include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_public.h"
+#include "lp_state_fs.h"
+
+#define SIZE            64
+
+
+struct test_shader {
+   const char *name;
+   bool linear;
+   nir_def *(*build)(nir_builder *b, nir_def *t, nir_def **c);
+   float (*eval)(float t, const float *c);
+};
+
+
+static nir_def *
+build_mad(nir_builder *b, nir_def *t, nir_def **c)
+{
+   return nir_fadd(b, nir_fmul(b, t, c[0]), c[1]);
+}
+
+
+static float
+eval_mad(float t, const float *c)
+{
+   return t * c[0] + c[1];
+}
+
+
+static nir_def *
+build_mad_mul(nir_builder *b, nir_def *t, nir_def **c)
+{
+   return nir_fmul(b, build_mad(b, t, c), c[2]);
+}
+
+
+static float
+eval_mad_mul(float t, const float *c)
+{
+   return (t * c[0] + c[1]) * c[2];
+}
+
+
+static nir_def *
+build_mad_add(nir_builder *b, nir_def *t, nir_def **c)
+{
+   return nir_fadd(b, build_mad(b, t, c), c[2]);
+}
+
+
+static float
+eval_mad_add(float t, const float *c)
+{
+   return t * c[0] + c[1] + c[2];
+}
+
+
+static const struct test_shader shaders[] = {
+   { "t*c0 + c1", true, build_mad, eval_mad },
+   { "(t*c0 + c1) * c2", false, build_mad_mul, eval_mad_mul },
+   { "t*c0 + c1 + c2", false, build_mad_add, eval_mad_add },
+};
+
+static const float consts[3][4] = {
+   { 0.75f, 0.5f, 0.25f, 1.0f },
+   { 0.75f, 0.75f, 0.5f, 0.0f },
+   { 0.5f, 0.25f, 0.75f, 0.5f },
+};
+
+
+static uint8_t
+texel_value(unsigned x, unsigned y, unsigned c)
+{
+   return (x * 4 + y * 3 + c * 50) & 0xff;
+}
+
+
+/*
+ * The shaders are built in NIR: TGSI shaders read the texcoord with a
+ * swizzled move, which the linear analysis doesn't accept.
+ */
+static void *
+create_fs(struct pipe_screen *screen, struct pipe_context *pipe,
+          const struct test_shader *shader)
+{
+   const nir_shader_compiler_options *options =
+      screen->get_compiler_options(screen, PIPE_SHADER_IR_NIR,
+                                   PIPE_SHADER_FRAGMENT);
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT,
+                                                  options, "%s",
+                                                  shader->name);
+   nir_variable *in = nir_variable_create(b.shader, nir_var_shader_in,
+                                          glsl_vec4_type(), "texcoord");
+   nir_variable *out = nir_variable_create(b.shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "color");
+   nir_variable *sampler =
+      nir_variable_create(b.shader, nir_var_uniform,
+                          glsl_sampler_type(GLSL_SAMPLER_DIM_2D, false,
+                                            false, GLSL_TYPE_FLOAT),
+                          "sampler");
+   nir_def *c[3];
+
+   in->data.location = VARYING_SLOT_VAR0;
+   in->data.interpolation = INTERP_MODE_SMOOTH;
+   out->data.location = FRAG_RESULT_DATA0;
+   sampler->data.binding = 0;
+   b.shader->num_inputs = 1;
+   b.shader->num_outputs = 1;
+   b.shader->info.num_ubos = 1;
+   b.shader->info.num_textures = 1;
+   BITSET_SET(b.shader->info.textures_used, 0);
+   BITSET_SET(b.shader->info.samplers_used, 0);
+
+   nir_def *texcoord = nir_load_var(&b, in);
+   nir_scalar st[2] = {
+      nir_get_scalar(texcoord, 0), nir_get_scalar(texcoord, 1),
+   };
+
+   nir_tex_instr *tex = nir_tex_instr_create(b.shader, 1);
+   tex->op = nir_texop_tex;
+   tex->sampler_dim = GLSL_SAMPLER_DIM_2D;
+   tex->coord_components = 2;
+   tex->dest_type = nir_type_float32;
+   tex->texture_index = 0;
+   tex->sampler_index = 0;
+   tex->src[0] = nir_tex_src_for_ssa(nir_tex_src_coord,
+                                     nir_vec_scalars(&b, st, 2));
+   nir_def_init(&tex->instr, &tex->def, 4, 32);
+   nir_builder_instr_insert(&b, &tex->instr);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(c); i++) {
+      c[i] = nir_load_ubo(&b, 4, 32, nir_imm_int(&b, 0),
+                          nir_imm_int(&b, i * 16), .align_mul = 16,
+                          .range_base = i * 16, .range = 16);
+   }
+
+   nir_store_var(&b, out, shader->build(&b, &tex->def, c), 0xf);
+
+   nir_shader_gather_info(b.shader, nir_shader_get_entrypoint(b.shader));
+   screen->finalize_nir(screen, b.shader);
+
+   struct pipe_shader_state state = {
+      .type = PIPE_SHADER_IR_NIR,
+      .ir.nir = b.shader,
+   };
+   return pipe->create_fs_state(pipe, &state);
+}
+
+
+static struct pipe_resource *
+create_texture(struct pipe_screen *screen, struct pipe_context *pipe,
+               unsigned bind)
+{
+   struct pipe_resource templ = {
+      .target = PIPE_TEXTURE_2D,
+      .format = PIPE_FORMAT_B8G8R8A8_UNORM,
+      .width0 = SIZE,
+      .height0 = SIZE,
+      .depth0 = 1,
+      .array_size = 1,
+      .bind = bind,
+   };
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+static void
+render(struct pipe_context *pipe, struct cso_context *cso, void *vs, void *fs,
+       struct pipe_surface *surf, struct pipe_sampler_view *view,
+       struct pipe_resource *vbuf, uint8_t *result)
+{
+   const struct pipe_framebuffer_state fb = {
+      .width = SIZE,
+      .height = SIZE,
+      .nr_cbufs = 1,
+      .cbufs[0] = surf,
+   };
+   const struct pipe_blend_state blend = {
+      .rt[0].colormask = PIPE_MASK_RGBA,
+   };
+   const struct pipe_depth_stencil_alpha_state dsa = {0};
+   const struct pipe_rasterizer_state rast = {
+      .cull_face = PIPE_FACE_NONE,
+      .half_pixel_center = 1,
+      .bottom_edge_rule = 1,
+      .depth_clip_near = 1,
+      .depth_clip_far = 1,
+   };
+   const struct pipe_sampler_state sampler = {
+      .wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE,
+      .wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE,
+      .wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE,
+      .min_img_filter = PIPE_TEX_FILTER_NEAREST,
+      .mag_img_filter = PIPE_TEX_FILTER_NEAREST,
+      .min_mip_filter = PIPE_TEX_MIPFILTER_NONE,
+   };
+   const struct pipe_sampler_state *samplers[] = { &sampler };
+   const struct pipe_viewport_state viewport = {
+      .scale = { SIZE / 2.0f, SIZE / 2.0f, 0.5f },
+      .translate = { SIZE / 2.0f, SIZE / 2.0f, 0.5f },
+      .swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X,
+      .swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y,
+      .swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z,
+      .swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W,
+   };
+   struct cso_velems_state velem = { .count = 2 };
+   const struct pipe_constant_buffer cb = {
+      .buffer_size = sizeof(consts),
+      .user_buffer = consts,
+   };
+   const union pipe_color_union clear_color = {0};
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+
+   for (unsigned i = 0; i < 2; i++) {
+      velem.velems[i].src_offset = i * 4 * sizeof(float);
+      velem.velems[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+      velem.velems[i].src_stride = 2 * 4 * sizeof(float);
+   }
+
+   cso_set_framebuffer(cso, &fb);
+   pipe->clear(pipe, PIPE_CLEAR_COLOR, NULL, &clear_color, 0, 0);
+   cso_set_blend(cso, &blend);
+   cso_set_depth_stencil_alpha(cso, &dsa);
+   cso_set_rasterizer(cso, &rast);
+   cso_set_viewport(cso, &viewport);
+   cso_set_samplers(cso, PIPE_SHADER_FRAGMENT, 1, samplers);
+   pipe->set_sampler_views(pipe, PIPE_SHADER_FRAGMENT, 0, 1, 0, false, &view);
+   pipe->set_constant_buffer(pipe, PIPE_SHADER_FRAGMENT, 0, false, &cb);
+   cso_set_fragment_shader_handle(cso, fs);
+   cso_set_vertex_shader_handle(cso, vs);
+   cso_set_vertex_elements(cso, &velem);
+   util_draw_vertex_buffer(pipe, cso, vbuf, 0, MESA_PRIM_QUADS, 4, 2);
+   pipe->flush(pipe, NULL, 0);
+
+   u_box_2d(0, 0, SIZE, SIZE, &box);
+   const uint8_t *map = pipe->texture_map(pipe, surf->texture, 0,
+                                          PIPE_MAP_READ, &box, &transfer);
+   for (unsigned y = 0; y < SIZE; y++)
+      memcpy(result + y * SIZE * 4, map + y * transfer->stride, SIZE * 4);
+   pipe->texture_unmap(pipe, transfer);
+}
+
+
+static bool
+check(const char *name, const char *path, const uint8_t *result,
+      const struct test_shader *shader)
+{
+   unsigned fails = 0;
+
+   for (unsigned y = 0; y < SIZE; y++) {
+      for (unsigned x = 0; x < SIZE; x++) {
+         for (unsigned c = 0; c < 4; c++) {
+            /* B8G8R8A8 stores blue first */
+            const unsigned rgba = c == 3 ? 3 : 2 - c;
+            const float t = texel_value(x, y, c) / 255.0f;
+            const float c3[3] = {
+               consts[0][rgba], consts[1][rgba], consts[2][rgba],
+            };
+            const int expected =
+               (int)(CLAMP(shader->eval(t, c3), 0.0f, 1.0f) * 255.0f + 0.5f);
+            const int got = result[(y * SIZE + x) * 4 + c];
+
+            /* unorm8 products round differently from floats */
+            if (abs(got - expected) > 2) {
+               if (fails++ < 8)
+                  printf("%s, %s: pixel %u,%u channel %u is %d, expected %d\n",
+                         name, path, x, y, c, got, expected);
+            }
+         }
+      }
+   }
+   return fails == 0;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_screen *screen = llvmpipe_create_screen(null_sw_create());
+   struct pipe_context *pipe = screen->context_create(screen, NULL, 0);
+   struct cso_context *cso = cso_create_context(pipe, 0);
+   const float vertices[4][2][4] = {
+      { { -1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+      { {  1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+      { {  1.0f,  1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f } },
+      { { -1.0f,  1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+   };
+   const enum tgsi_semantic semantic_names[] =
+      { TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_GENERIC };
+   const unsigned semantic_indexes[] = { 0, 0 };
+   uint8_t (*texels)[4] = malloc(SIZE * SIZE * sizeof(*texels));
+   uint8_t *linear = malloc(SIZE * SIZE * 4);
+   uint8_t *general = malloc(SIZE * SIZE * 4);
+   struct pipe_sampler_view view_templ, *view;
+   struct pipe_surface surf_templ = {0}, *surf;
+   struct pipe_resource *tex, *target, *vbuf;
+   struct pipe_box box;
+   const int perf = LP_PERF;
+   bool pass = true;
+
+   for (unsigned y = 0; y < SIZE; y++)
+      for (unsigned x = 0; x < SIZE; x++)
+         for (unsigned c = 0; c < 4; c++)
+            texels[y * SIZE + x][c] = texel_value(x, y, c);
+
+   tex = create_texture(screen, pipe, PIPE_BIND_SAMPLER_VIEW);
+   u_box_2d(0, 0, SIZE, SIZE, &box);
+   pipe->texture_subdata(pipe, tex, 0, PIPE_MAP_WRITE, &box, texels,
+                         SIZE * sizeof(*texels), 0);
+   u_sampler_view_default_template(&view_templ, tex, tex->format);
+   view = pipe->create_sampler_view(pipe, tex, &view_templ);
+
+   target = create_texture(screen, pipe, PIPE_BIND_RENDER_TARGET);
+   surf_templ.format = target->format;
+   surf = pipe->create_surface(pipe, target, &surf_templ);
+
+   vbuf = pipe_buffer_create(screen, PIPE_BIND_VERTEX_BUFFER,
+                             PIPE_USAGE_DEFAULT, sizeof(vertices));
+   pipe_buffer_write(pipe, vbuf, 0, sizeof(vertices), vertices);
+
+   void *vs = util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
+                                                  semantic_indexes, false);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(shaders); i++) {
+      const struct test_shader *shader = &shaders[i];
+      void *fs = create_fs(screen, pipe, shader);
+
+      if (!fs) {
+         printf("%s: failed to create the shader\n", shader->name);
+         pass = false;
+         continue;
+      }
+
+      /* The draw module wraps the driver's shader objects, so look at the
+       * shader llvmpipe has bound rather than at the returned handle.
+       */
+      cso_set_fragment_shader_handle(cso, fs);
+      const bool is_linear =
+         llvmpipe_context(pipe)->fs->kind == LP_FS_KIND_LLVM_LINEAR;
+      if (is_linear != shader->linear) {
+         printf("%s: shader is %slinear, expected %slinear\n", shader->name,
+                is_linear ? "" : "not ", shader->linear ? "" : "not ");
+         pass = false;
+      }
+
+      LP_PERF = perf & ~PERF_NO_RAST_LINEAR;
+      render(pipe, cso, vs, fs, surf, view, vbuf, linear);
+      LP_PERF = perf | PERF_NO_RAST_LINEAR;
+      render(pipe, cso, vs, fs, surf, view, vbuf, general);
+      LP_PERF = perf;
+
+      pass &= check(shader->name, "linear rasterizer", linear, shader);
+      pass &= check(shader->name, "general rasterizer", general, shader);
+
+      cso_set_fragment_shader_handle(cso, NULL);
+      pipe->delete_fs_state(pipe, fs);
+   }
+
+   cso_destroy_context(cso);
+   pipe->delete_vs_state(pipe, vs);
+   pipe_surface_reference(&surf, NULL);
+   pipe_sampler_view_reference(&view, NULL);
+   pipe_resource_reference(&target, NULL);
+   pipe_resource_reference(&tex, NULL);
+   pipe_resource_reference(&vbuf, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+   free(texels);
+   free(linear);
+   free(general);
+
+   printf("%s\n", pass ? "PASS" : "FAIL");
+   return pass ? 0 : 1;
+}
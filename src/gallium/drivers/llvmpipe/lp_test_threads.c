@@ -0,0 +1,294 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Rasterizer thread scaling benchmark.
+ *
+ * Overlapping blended triangles with depth testing are drawn with
+ * LP_NUM_THREADS set to 8, 16, ... up to LP_MAX_THREADS, and without
+ * rasterizer threads.  Prints the fill rate of each thread count, and
+ * checks that all of them render the same image as the single threaded
+ * run.  Thread counts above the number of CPUs still run, they just don't
+ * scale.
+ *
+ * Usage: lp_test_threads [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "cso_cache/cso_context.h"
+#include "nir/nir_builder.h"
+#include "util/os_time.h"
+#include "util/u_box.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_draw_quad.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_simple_shaders.h"
+#include "sw/null/null_sw_winsys.h"
+#include "lp_limits.h"
+#include "lp_public.h"
+
+#define SIZE            512
+#define NUM_TRIS        128
+
+
+static float
+rand_float(unsigned *seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return ((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+
+static void *
+create_fs(struct pipe_screen *screen, struct pipe_context *pipe)
+{
+   const nir_shader_compiler_options *options =
+      screen->get_compiler_options(screen, PIPE_SHADER_IR_NIR,
+                                   PIPE_SHADER_FRAGMENT);
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT,
+                                                  options, "threads");
+   nir_variable *in = nir_variable_create(b.shader, nir_var_shader_in,
+                                          glsl_vec4_type(), "color");
+   nir_variable *out = nir_variable_create(b.shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "color");
+
+   in->data.location = VARYING_SLOT_VAR0;
+   in->data.interpolation = INTERP_MODE_SMOOTH;
+   out->data.location = FRAG_RESULT_DATA0;
+   b.shader->num_inputs = 1;
+   b.shader->num_outputs = 1;
+
+   nir_store_var(&b, out, nir_load_var(&b, in), 0xf);
+
+   nir_shader_gather_info(b.shader, nir_shader_get_entrypoint(b.shader));
+   screen->finalize_nir(screen, b.shader);
+
+   struct pipe_shader_state state = {
+      .type = PIPE_SHADER_IR_NIR,
+      .ir.nir = b.shader,
+   };
+   return pipe->create_fs_state(pipe, &state);
+}
+
+
+static struct pipe_resource *
+create_texture(struct pipe_screen *screen, enum pipe_format format,
+               unsigned bind)
+{
+   struct pipe_resource templ = {
+      .target = PIPE_TEXTURE_2D,
+      .format = format,
+      .width0 = SIZE,
+      .height0 = SIZE,
+      .depth0 = 1,
+      .array_size = 1,
+      .bind = bind,
+   };
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+/**
+ * Render with \p num_threads rasterizer threads, return the fill rate and
+ * the first frame in \p color.
+ */
+static double
+run_threads(unsigned num_threads, unsigned iterations, uint8_t *color)
+{
+   char value[8];
+
+   /* llvmpipe picks up the thread count when the screen is created */
+   snprintf(value, sizeof(value), "%u", num_threads);
+   setenv("LP_NUM_THREADS", value, 1);
+
+   struct pipe_screen *screen = llvmpipe_create_screen(null_sw_create());
+   struct pipe_context *pipe = screen->context_create(screen, NULL, 0);
+   struct cso_context *cso = cso_create_context(pipe, 0);
+   const enum tgsi_semantic semantic_names[] =
+      { TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_GENERIC };
+   const unsigned semantic_indexes[] = { 0, 0 };
+   float (*vertices)[2][4] = malloc(NUM_TRIS * 3 * sizeof(*vertices));
+   unsigned seed = 1;
+
+   for (unsigned t = 0; t < NUM_TRIS; t++) {
+      /* triangles of about half the target's width, at odd offsets */
+      const float x = rand_float(&seed) * 1.5f - 1.0f;
+      const float y = rand_float(&seed) * 1.5f - 1.0f;
+      for (unsigned v = 0; v < 3; v++) {
+         float *pos = vertices[t * 3 + v][0];
+         float *col = vertices[t * 3 + v][1];
+
+         pos[0] = x + (v == 1 ? 0.5f : 0.0f) + rand_float(&seed) * 0.1f;
+         pos[1] = y + (v == 2 ? 0.5f : 0.0f) + rand_float(&seed) * 0.1f;
+         pos[2] = rand_float(&seed) * 2.0f - 1.0f;
+         pos[3] = 1.0f;
+         for (unsigned c = 0; c < 4; c++)
+            col[c] = rand_float(&seed);
+      }
+   }
+
+   struct pipe_resource *vbuf =
+      pipe_buffer_create(screen, PIPE_BIND_VERTEX_BUFFER, PIPE_USAGE_DEFAULT,
+                         NUM_TRIS * 3 * sizeof(*vertices));
+   pipe_buffer_write(pipe, vbuf, 0, NUM_TRIS * 3 * sizeof(*vertices),
+                     vertices);
+   void *vs = util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
+                                                  semantic_indexes, false);
+   void *fs = create_fs(screen, pipe);
+
+   struct pipe_resource *cbuf =
+      create_texture(screen, PIPE_FORMAT_B8G8R8A8_UNORM,
+                     PIPE_BIND_RENDER_TARGET);
+   struct pipe_resource *zsbuf =
+      create_texture(screen, PIPE_FORMAT_Z32_FLOAT, PIPE_BIND_DEPTH_STENCIL);
+   struct pipe_surface surf_templ = { .format = cbuf->format };
+   struct pipe_surface *csurf = pipe->create_surface(pipe, cbuf, &surf_templ);
+   surf_templ.format = zsbuf->format;
+   struct pipe_surface *zssurf = pipe->create_surface(pipe, zsbuf, &surf_templ);
+
+   const struct pipe_framebuffer_state fb = {
+      .width = SIZE,
+      .height = SIZE,
+      .nr_cbufs = 1,
+      .cbufs[0] = csurf,
+      .zsbuf = zssurf,
+   };
+   const struct pipe_blend_state blend = {
+      .rt[0] = {
+         .blend_enable = 1,
+         .rgb_func = PIPE_BLEND_ADD,
+         .rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA,
+         .rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA,
+         .alpha_func = PIPE_BLEND_ADD,
+         .alpha_src_factor = PIPE_BLENDFACTOR_ONE,
+         .alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA,
+         .colormask = PIPE_MASK_RGBA,
+      },
+   };
+   const struct pipe_depth_stencil_alpha_state dsa = {
+      .depth_enabled = 1,
+      .depth_writemask = 1,
+      .depth_func = PIPE_FUNC_LESS,
+   };
+   const struct pipe_rasterizer_state rast = {
+      .cull_face = PIPE_FACE_NONE,
+      .half_pixel_center = 1,
+      .bottom_edge_rule = 1,
+      .depth_clip_near = 1,
+      .depth_clip_far = 1,
+   };
+   const struct pipe_viewport_state viewport = {
+      .scale = { SIZE / 2.0f, SIZE / 2.0f, 0.5f },
+      .translate = { SIZE / 2.0f, SIZE / 2.0f, 0.5f },
+      .swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X,
+      .swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y,
+      .swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z,
+      .swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W,
+   };
+   struct cso_velems_state velem = { .count = 2 };
+   const union pipe_color_union clear_color = { .f = { 0.25f, 0.5f, 0.75f, 1.0f } };
+
+   for (unsigned i = 0; i < 2; i++) {
+      velem.velems[i].src_offset = i * 4 * sizeof(float);
+      velem.velems[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+      velem.velems[i].src_stride = 2 * 4 * sizeof(float);
+   }
+
+   cso_set_framebuffer(cso, &fb);
+   cso_set_blend(cso, &blend);
+   cso_set_depth_stencil_alpha(cso, &dsa);
+   cso_set_rasterizer(cso, &rast);
+   cso_set_viewport(cso, &viewport);
+   cso_set_fragment_shader_handle(cso, fs);
+   cso_set_vertex_shader_handle(cso, vs);
+   cso_set_vertex_elements(cso, &velem);
+
+   /* The first frame compiles the shader variant and gives the result,
+    * the following ones are timed.
+    */
+   int64_t start = 0;
+   for (unsigned i = 0; i <= iterations; i++) {
+      if (i == 1)
+         start = os_time_get_nano();
+      pipe->clear(pipe, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL, NULL,
+                  &clear_color, 1.0, 0);
+      util_draw_vertex_buffer(pipe, cso, vbuf, 0, MESA_PRIM_TRIANGLES,
+                              NUM_TRIS * 3, 2);
+      if (i == 0) {
+         struct pipe_transfer *transfer;
+         struct pipe_box box;
+
+         u_box_2d(0, 0, SIZE, SIZE, &box);
+         const uint8_t *map = pipe->texture_map(pipe, cbuf, 0, PIPE_MAP_READ,
+                                                &box, &transfer);
+         for (unsigned y = 0; y < SIZE; y++)
+            memcpy(color + y * SIZE * 4, map + y * transfer->stride, SIZE * 4);
+         pipe->texture_unmap(pipe, transfer);
+      }
+   }
+
+   struct pipe_fence_handle *fence = NULL;
+   pipe->flush(pipe, &fence, 0);
+   screen->fence_finish(screen, NULL, fence, OS_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &fence, NULL);
+   const double secs = (os_time_get_nano() - start) / 1e9;
+
+   cso_destroy_context(cso);
+   pipe->delete_fs_state(pipe, fs);
+   pipe->delete_vs_state(pipe, vs);
+   pipe_surface_reference(&csurf, NULL);
+   pipe_surface_reference(&zssurf, NULL);
+   pipe_resource_reference(&cbuf, NULL);
+   pipe_resource_reference(&zsbuf, NULL);
+   pipe_resource_reference(&vbuf, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+   free(vertices);
+
+   /* every triangle covers about an eighth of the target */
+   return iterations && secs > 0.0 ?
+      iterations * (double)NUM_TRIS * SIZE * SIZE / 8 / secs / 1e6 : 0.0;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   const unsigned iterations = argc > 1 ? atoi(argv[1]) : 4;
+   uint8_t *reference = malloc(SIZE * SIZE * 4);
+   uint8_t *color = malloc(SIZE * SIZE * 4);
+   bool pass = true;
+
+   printf("%u CPUs\n", util_get_cpu_caps()->nr_cpus);
+
+   double rate = run_threads(0, iterations, reference);
+   if (iterations)
+      printf("%3u threads: %8.1f Mpixels/s\n", 0, rate);
+
+   for (unsigned num_threads = 8; num_threads <= LP_MAX_THREADS;
+        num_threads *= 2) {
+      rate = run_threads(num_threads, iterations, color);
+      if (iterations)
+         printf("%3u threads: %8.1f Mpixels/s\n", num_threads, rate);
+
+      if (memcmp(reference, color, SIZE * SIZE * 4)) {
+         printf("%u threads render a different image\n", num_threads);
+         pass = false;
+      }
+   }
+
+   free(reference);
+   free(color);
+
+   printf("%s\n", pass ? "PASS" : "FAIL");
+   return pass ? 0 : 1;
+}
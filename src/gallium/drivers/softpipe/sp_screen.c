@@ -55,6 +55,7 @@ static const struct debug_named_value sp_debug_options[] = {
    {"cs",        SP_DBG_CS,         "dump compute shader assembly to stderr"},
    {"no_rast",   SP_DBG_NO_RAST,    "no-ops rasterization, for profiling purposes"},
    {"use_llvm",  SP_DBG_USE_LLVM,   "Use LLVM if available for shaders"},
+   {"tex_cache", SP_DBG_TEX_CACHE,  "print texture tile cache hit rates on context destruction"},
    DEBUG_NAMED_VALUE_END
 };
 
@@ -0,0 +1,235 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks that the quad versions of the 2D repeat_POT image filters give the
+ * same results as the per-pixel versions, for quads whose pixels are far
+ * apart, so that each pixel's texels come from different tiles of the
+ * texture tile cache.  Some quads are picked to put as many tiles as
+ * possible in a single cache set, the others are random and wrap around
+ * the texture.
+ *
+ * The quad filters are used when all four pixels sample the same level.
+ * The per-pixel reference for a pixel is obtained by sampling it in the
+ * first lane of a quad whose other lanes sample level 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_box.h"
+#include "util/u_inlines.h"
+#include "util/u_sampler.h"
+#include "sw/null/null_sw_winsys.h"
+#include "sp_context.h"
+#include "sp_public.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+
+#define TEX_SIZE        512
+#define NUM_RANDOM      20000
+
+
+static float
+texel_value(unsigned x, unsigned y, unsigned level, unsigned c)
+{
+   switch (c) {
+   case 0: return x;
+   case 1: return y;
+   case 2: return level;
+   default: return (x * 7 + y * 13 + level * 3) % 97;
+   }
+}
+
+
+static struct pipe_resource *
+create_texture(struct pipe_screen *screen, struct pipe_context *pipe)
+{
+   struct pipe_resource templ = {
+      .target = PIPE_TEXTURE_2D,
+      .format = PIPE_FORMAT_R32G32B32A32_FLOAT,
+      .width0 = TEX_SIZE,
+      .height0 = TEX_SIZE,
+      .depth0 = 1,
+      .array_size = 1,
+      .last_level = 1,
+      .bind = PIPE_BIND_SAMPLER_VIEW,
+   };
+   struct pipe_resource *tex = screen->resource_create(screen, &templ);
+   float (*data)[4] = malloc(TEX_SIZE * TEX_SIZE * sizeof(*data));
+
+   if (!tex || !data)
+      return NULL;
+
+   for (unsigned level = 0; level <= templ.last_level; level++) {
+      const unsigned size = u_minify(TEX_SIZE, level);
+      struct pipe_box box;
+
+      for (unsigned y = 0; y < size; y++)
+         for (unsigned x = 0; x < size; x++)
+            for (unsigned c = 0; c < 4; c++)
+               data[y * size + x][c] = texel_value(x, y, level, c);
+
+      u_box_2d(0, 0, size, size, &box);
+      pipe->texture_subdata(pipe, tex, level, PIPE_MAP_WRITE, &box, data,
+                            size * sizeof(*data), 0);
+   }
+
+   free(data);
+   return tex;
+}
+
+
+static void
+sample(struct sp_tgsi_sampler *sampler, const float s[TGSI_QUAD_SIZE],
+       const float t[TGSI_QUAD_SIZE], const float lod[TGSI_QUAD_SIZE],
+       float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   static const float zero[TGSI_QUAD_SIZE];
+   static const int8_t offset[3];
+
+   sampler->base.get_samples(&sampler->base, 0, 0, s, t, zero, zero, lod,
+                             NULL, offset, TGSI_SAMPLER_LOD_EXPLICIT, rgba);
+}
+
+
+/**
+ * Sample the quad (s, t) at level 0 with the quad filter, then each pixel
+ * on its own, and compare.
+ */
+static bool
+test_quad(struct sp_tgsi_sampler *sampler, const char *filter,
+          const float s[TGSI_QUAD_SIZE], const float t[TGSI_QUAD_SIZE])
+{
+   static const float quad_lod[TGSI_QUAD_SIZE] = { 0.0f, 0.0f, 0.0f, 0.0f };
+   static const float pixel_lod[TGSI_QUAD_SIZE] = { 0.0f, 1.0f, 1.0f, 1.0f };
+   float quad[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE];
+
+   sample(sampler, s, t, quad_lod, quad);
+
+   for (unsigned j = 0; j < TGSI_QUAD_SIZE; j++) {
+      const float ps[TGSI_QUAD_SIZE] = { s[j], s[j], s[j], s[j] };
+      const float pt[TGSI_QUAD_SIZE] = { t[j], t[j], t[j], t[j] };
+      float pixel[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE];
+
+      sample(sampler, ps, pt, pixel_lod, pixel);
+
+      for (unsigned c = 0; c < TGSI_NUM_CHANNELS; c++) {
+         if (memcmp(&quad[c][j], &pixel[c][0], sizeof(float))) {
+            printf("%s: pixel %u at (%f, %f) channel %u: quad %f, "
+                   "per-pixel %f\n", filter, j, s[j], t[j], c,
+                   quad[c][j], pixel[c][0]);
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+
+static bool
+test_filter(struct pipe_context *pipe, struct sp_tgsi_sampler *sampler,
+            unsigned img_filter)
+{
+   const char *name = img_filter == PIPE_TEX_FILTER_LINEAR ? "linear" : "nearest";
+   /* Where to sample in a texel.  For linear filtering, a quarter texel
+    * past the center, so texel x, y is the top left of the footprint.
+    */
+   const float bias = img_filter == PIPE_TEX_FILTER_LINEAR ? 0.75f : 0.5f;
+   const struct pipe_sampler_state templ = {
+      .wrap_s = PIPE_TEX_WRAP_REPEAT,
+      .wrap_t = PIPE_TEX_WRAP_REPEAT,
+      .wrap_r = PIPE_TEX_WRAP_REPEAT,
+      .min_img_filter = img_filter,
+      .mag_img_filter = img_filter,
+      .min_mip_filter = PIPE_TEX_MIPFILTER_NEAREST,
+      .max_lod = 1.0f,
+   };
+   /* Texels whose filter footprint reaches into a tile of cache set 0:
+    * tile (0, 0) itself, then the last texel of tiles (7, 1), (14, 2) and
+    * (5, 3), whose linear footprint also covers the tiles to the right and
+    * below.
+    */
+   static const unsigned set0[TGSI_QUAD_SIZE][2] = {
+      { 3, 3 },
+      { 7 * TEX_TILE_SIZE + TEX_TILE_SIZE - 1, 1 * TEX_TILE_SIZE + TEX_TILE_SIZE - 1 },
+      { 14 * TEX_TILE_SIZE + TEX_TILE_SIZE - 1, 2 * TEX_TILE_SIZE + TEX_TILE_SIZE - 1 },
+      { 5 * TEX_TILE_SIZE + TEX_TILE_SIZE - 1, 3 * TEX_TILE_SIZE + TEX_TILE_SIZE - 1 },
+   };
+   void *samp = pipe->create_sampler_state(pipe, &templ);
+   float s[TGSI_QUAD_SIZE], t[TGSI_QUAD_SIZE];
+   bool pass = true;
+
+   sampler->sp_sampler[0] = samp;
+
+   for (unsigned j = 0; j < TGSI_QUAD_SIZE; j++) {
+      s[j] = (set0[j][0] + bias) / TEX_SIZE;
+      t[j] = (set0[j][1] + bias) / TEX_SIZE;
+   }
+   pass = test_quad(sampler, name, s, t);
+
+   /* The same quad wrapped around the texture, and random ones. */
+   for (unsigned j = 0; j < TGSI_QUAD_SIZE; j++) {
+      s[j] -= 2.0f;
+      t[j] += 1.0f;
+   }
+   pass = pass && test_quad(sampler, name, s, t);
+
+   for (unsigned i = 0; pass && i < NUM_RANDOM; i++) {
+      for (unsigned j = 0; j < TGSI_QUAD_SIZE; j++) {
+         s[j] = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+         t[j] = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+      }
+      pass = test_quad(sampler, name, s, t);
+   }
+
+   sampler->sp_sampler[0] = NULL;
+   pipe->delete_sampler_state(pipe, samp);
+
+   printf("%s: %s\n", name, pass ? "pass" : "FAIL");
+   return pass;
+}
+
+
+int main(int argc, char **argv)
+{
+   struct pipe_screen *screen = softpipe_create_screen(null_sw_create());
+   struct pipe_context *pipe;
+   struct pipe_resource *tex;
+   struct pipe_sampler_view templ, *view;
+   struct sp_tgsi_sampler *sampler;
+   bool pass = true;
+
+   if (!screen) {
+      printf("failed to create a softpipe screen\n");
+      return 1;
+   }
+   pipe = screen->context_create(screen, NULL, 0);
+   tex = pipe ? create_texture(screen, pipe) : NULL;
+   if (!tex) {
+      printf("failed to create a texture\n");
+      return 1;
+   }
+
+   u_sampler_view_default_template(&templ, tex, tex->format);
+   view = pipe->create_sampler_view(pipe, tex, &templ);
+   pipe->set_sampler_views(pipe, PIPE_SHADER_FRAGMENT, 0, 1, 0, false, &view);
+   sampler = softpipe_context(pipe)->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+
+   srand(1);
+   pass = test_filter(pipe, sampler, PIPE_TEX_FILTER_NEAREST) && pass;
+   pass = test_filter(pipe, sampler, PIPE_TEX_FILTER_LINEAR) && pass;
+
+   pipe->set_sampler_views(pipe, PIPE_SHADER_FRAGMENT, 0, 0, 1, false, NULL);
+   pipe_sampler_view_reference(&view, NULL);
+   pipe_resource_reference(&tex, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return pass ? 0 : 1;
+}
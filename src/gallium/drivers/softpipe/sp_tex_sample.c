@@ -37,6 +37,7 @@
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_shader_tokens.h"
+#include "util/detect_arch.h"
 #include "util/u_math.h"
 #include "util/format/u_format.h"
 #include "util/u_memory.h"
@@ -46,6 +47,13 @@
 #include "sp_texture.h"
 #include "sp_tex_tile_cache.h"
 
+#if DETECT_ARCH_SSE
+#include <xmmintrin.h>
+#elif DETECT_ARCH_AARCH64 || (DETECT_ARCH_ARM && defined(__ARM_NEON))
+#include <arm_neon.h>
+#define SP_TEX_NEON 1
+#endif
+
 
 /** Set to one to help debug texture sampling */
 #define DEBUG_TEX 0
@@ -1273,6 +1281,219 @@ img_filter_2d_nearest_clamp_POT(const struct sp_sampler_view *sp_sview,
 }
 
 
+/* Quad versions of the repeat_POT fastpaths above, for when all four
+ * pixels of a quad sample the same level.  Texels are handled a whole
+ * RGBA vector at a time and transposed into the channel-major layout of
+ * the result.  Results are identical to the per-pixel versions.
+ *
+ * A tile cache lookup may evict any tile but the one it returns, so each
+ * pixel's texels are used or copied before the next pixel is looked up.
+ */
+typedef void (*img_filter_quad_func)(const struct sp_sampler_view *sp_sview,
+                                     unsigned level,
+                                     const float s[TGSI_QUAD_SIZE],
+                                     const float t[TGSI_QUAD_SIZE],
+                                     const int8_t *offset,
+                                     float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE]);
+
+
+#if defined(SP_TEX_NEON)
+static inline void
+store_quad_neon(float32x4_t r0, float32x4_t r1, float32x4_t r2, float32x4_t r3,
+                float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+   const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+
+   vst1q_f32(rgba[0], vcombine_f32(vget_low_f32(t01.val[0]),
+                                   vget_low_f32(t23.val[0])));
+   vst1q_f32(rgba[1], vcombine_f32(vget_low_f32(t01.val[1]),
+                                   vget_low_f32(t23.val[1])));
+   vst1q_f32(rgba[2], vcombine_f32(vget_high_f32(t01.val[0]),
+                                   vget_high_f32(t23.val[0])));
+   vst1q_f32(rgba[3], vcombine_f32(vget_high_f32(t01.val[1]),
+                                   vget_high_f32(t23.val[1])));
+}
+#endif
+
+
+/**
+ * rgba[c][j] = texel[j][c]
+ */
+static inline void
+store_texels_quad(const float texel[TGSI_QUAD_SIZE][TGSI_NUM_CHANNELS],
+                  float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+#if DETECT_ARCH_SSE
+   __m128 r0 = _mm_loadu_ps(texel[0]);
+   __m128 r1 = _mm_loadu_ps(texel[1]);
+   __m128 r2 = _mm_loadu_ps(texel[2]);
+   __m128 r3 = _mm_loadu_ps(texel[3]);
+
+   _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+   _mm_storeu_ps(rgba[0], r0);
+   _mm_storeu_ps(rgba[1], r1);
+   _mm_storeu_ps(rgba[2], r2);
+   _mm_storeu_ps(rgba[3], r3);
+#elif defined(SP_TEX_NEON)
+   store_quad_neon(vld1q_f32(texel[0]), vld1q_f32(texel[1]),
+                   vld1q_f32(texel[2]), vld1q_f32(texel[3]), rgba);
+#else
+   int j, c;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++)
+      for (c = 0; c < TGSI_NUM_CHANNELS; c++)
+         rgba[c][j] = texel[j][c];
+#endif
+}
+
+
+/**
+ * lerp_2d() of the four texels tx[0..3] of one pixel, for all four
+ * channels at once.
+ */
+static inline void
+lerp_2d_texel(float a, float b, const float *tx[4],
+              float out[TGSI_NUM_CHANNELS])
+{
+#if DETECT_ARCH_SSE
+   const __m128 va = _mm_set1_ps(a);
+   const __m128 v00 = _mm_loadu_ps(tx[0]);
+   const __m128 v10 = _mm_loadu_ps(tx[1]);
+   const __m128 v01 = _mm_loadu_ps(tx[2]);
+   const __m128 v11 = _mm_loadu_ps(tx[3]);
+   const __m128 temp0 = _mm_add_ps(v00, _mm_mul_ps(va, _mm_sub_ps(v10, v00)));
+   const __m128 temp1 = _mm_add_ps(v01, _mm_mul_ps(va, _mm_sub_ps(v11, v01)));
+
+   _mm_storeu_ps(out, _mm_add_ps(temp0, _mm_mul_ps(_mm_set1_ps(b),
+                                                   _mm_sub_ps(temp1, temp0))));
+#elif defined(SP_TEX_NEON)
+   const float32x4_t va = vdupq_n_f32(a);
+   const float32x4_t v00 = vld1q_f32(tx[0]);
+   const float32x4_t v10 = vld1q_f32(tx[1]);
+   const float32x4_t v01 = vld1q_f32(tx[2]);
+   const float32x4_t v11 = vld1q_f32(tx[3]);
+   /* Separate multiply and add, like lerp(). */
+   const float32x4_t temp0 = vaddq_f32(v00, vmulq_f32(va, vsubq_f32(v10, v00)));
+   const float32x4_t temp1 = vaddq_f32(v01, vmulq_f32(va, vsubq_f32(v11, v01)));
+
+   vst1q_f32(out, vaddq_f32(temp0, vmulq_f32(vdupq_n_f32(b),
+                                             vsubq_f32(temp1, temp0))));
+#else
+   int c;
+
+   for (c = 0; c < TGSI_NUM_CHANNELS; c++)
+      out[c] = lerp_2d(a, b, tx[0][c], tx[1][c], tx[2][c], tx[3][c]);
+#endif
+}
+
+
+static void
+img_filter_2d_linear_repeat_POT_quad(const struct sp_sampler_view *sp_sview,
+                                     unsigned level,
+                                     const float s[TGSI_QUAD_SIZE],
+                                     const float t[TGSI_QUAD_SIZE],
+                                     const int8_t *offset,
+                                     float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const unsigned xpot = pot_level_size(sp_sview->xpot, level);
+   const unsigned ypot = pot_level_size(sp_sview->ypot, level);
+   const int xmax = (xpot - 1) & (TEX_TILE_SIZE - 1);
+   const int ymax = (ypot - 1) & (TEX_TILE_SIZE - 1);
+   union tex_tile_address addr;
+   float texel[TGSI_QUAD_SIZE][TGSI_NUM_CHANNELS];
+   int j;
+
+   addr.value = 0;
+   addr.bits.level = level;
+   addr.bits.z = sp_sview->base.u.tex.first_layer;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      const float u = (s[j] * xpot - 0.5F) + offset[0];
+      const float v = (t[j] * ypot - 0.5F) + offset[1];
+      const int uflr = util_ifloor(u);
+      const int vflr = util_ifloor(v);
+      const int x0 = uflr & (xpot - 1);
+      const int y0 = vflr & (ypot - 1);
+      const float *tx[4];
+
+      if (x0 < xmax && y0 < ymax) {
+         get_texel_quad_2d_no_border_single_tile(sp_sview, addr, x0, y0, tx);
+      }
+      else {
+         const unsigned x1 = (x0 + 1) & (xpot - 1);
+         const unsigned y1 = (y0 + 1) & (ypot - 1);
+         get_texel_quad_2d_no_border(sp_sview, addr, x0, y0, x1, y1, tx);
+      }
+
+      /* The next pixel's lookups may evict the tiles tx points into. */
+      lerp_2d_texel(u - (float)uflr, v - (float)vflr, tx, texel[j]);
+   }
+
+   store_texels_quad(texel, rgba);
+
+   if (DEBUG_TEX) {
+      print_sample_4(__func__, rgba);
+   }
+}
+
+
+static void
+img_filter_2d_nearest_repeat_POT_quad(const struct sp_sampler_view *sp_sview,
+                                      unsigned level,
+                                      const float s[TGSI_QUAD_SIZE],
+                                      const float t[TGSI_QUAD_SIZE],
+                                      const int8_t *offset,
+                                      float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const unsigned xpot = pot_level_size(sp_sview->xpot, level);
+   const unsigned ypot = pot_level_size(sp_sview->ypot, level);
+   union tex_tile_address addr;
+   float texel[TGSI_QUAD_SIZE][TGSI_NUM_CHANNELS];
+   int j;
+
+   addr.value = 0;
+   addr.bits.level = level;
+   addr.bits.z = sp_sview->base.u.tex.first_layer;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      const float u = s[j] * xpot + offset[0];
+      const float v = t[j] * ypot + offset[1];
+      const int x0 = util_ifloor(u) & (xpot - 1);
+      const int y0 = util_ifloor(v) & (ypot - 1);
+
+      const float *out = get_texel_2d_no_border(sp_sview, addr, x0, y0);
+
+      /* Copy it before the next lookup can evict its tile. */
+      memcpy(texel[j], out, sizeof(texel[j]));
+   }
+
+   store_texels_quad(texel, rgba);
+
+   if (DEBUG_TEX) {
+      print_sample_4(__func__, rgba);
+   }
+}
+
+
+/**
+ * Return the quad version of the image filter used for every pixel of a
+ * quad, or NULL if there's none.
+ */
+static inline img_filter_quad_func
+get_img_filter_quad(img_filter_func min_filter, img_filter_func mag_filter,
+                    bool gather_only)
+{
+   if (gather_only || min_filter != mag_filter)
+      return NULL;
+   if (min_filter == img_filter_2d_linear_repeat_POT)
+      return img_filter_2d_linear_repeat_POT_quad;
+   if (min_filter == img_filter_2d_nearest_repeat_POT)
+      return img_filter_2d_nearest_repeat_POT_quad;
+   return NULL;
+}
+
+
 static void
 img_filter_1d_nearest(const struct sp_sampler_view *sp_sview,
                       const struct sp_sampler *sp_samp,
@@ -2180,6 +2401,9 @@ mip_filter_nearest(const struct sp_sampler_view *sp_sview,
                    float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
 {
    const struct pipe_sampler_view *psview = &sp_sview->base;
+   const img_filter_quad_func quad_filter =
+      get_img_filter_quad(min_filter, mag_filter,
+                          filt_args->control == TGSI_SAMPLER_GATHER);
    int j;
    struct img_filter_args args;
 
@@ -2187,6 +2411,24 @@ mip_filter_nearest(const struct sp_sampler_view *sp_sview,
    args.gather_only = filt_args->control == TGSI_SAMPLER_GATHER;
    args.gather_comp = gather_component;
 
+   if (quad_filter) {
+      int level[TGSI_QUAD_SIZE];
+
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         if (lod[j] <= 0.0f)
+            level[j] = psview->u.tex.first_level;
+         else
+            level[j] = MIN2(psview->u.tex.first_level + (int)(lod[j] + 0.5F),
+                            (int)psview->u.tex.last_level);
+      }
+
+      if (level[0] == level[1] && level[0] == level[2] &&
+          level[0] == level[3]) {
+         quad_filter(sp_sview, level[0], s, t, args.offset, rgba);
+         return;
+      }
+   }
+
    for (j = 0; j < TGSI_QUAD_SIZE; j++) {
       args.s = s[j];
       args.t = t[j];
@@ -2238,6 +2480,7 @@ mip_filter_none(const struct sp_sampler_view *sp_sview,
                 const struct filter_args *filt_args,
                 float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
 {
+   img_filter_quad_func quad_filter;
    int j;
    struct img_filter_args args;
 
@@ -2246,6 +2489,12 @@ mip_filter_none(const struct sp_sampler_view *sp_sview,
    args.gather_only = filt_args->control == TGSI_SAMPLER_GATHER;
    args.gather_comp = gather_component;
 
+   quad_filter = get_img_filter_quad(min_filter, mag_filter, args.gather_only);
+   if (quad_filter) {
+      quad_filter(sp_sview, args.level, s, t, args.offset, rgba);
+      return;
+   }
+
    for (j = 0; j < TGSI_QUAD_SIZE; j++) {
       args.s = s[j];
       args.t = t[j];
@@ -2286,12 +2535,20 @@ mip_filter_none_no_filter_select(const struct sp_sampler_view *sp_sview,
                                  const struct filter_args *filt_args,
                                  float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
 {
+   img_filter_quad_func quad_filter;
    int j;
    struct img_filter_args args;
    args.level = sp_sview->base.u.tex.first_level;
    args.offset = filt_args->offset;
    args.gather_only = filt_args->control == TGSI_SAMPLER_GATHER;
    args.gather_comp = gather_comp;
+
+   quad_filter = get_img_filter_quad(mag_filter, mag_filter, args.gather_only);
+   if (quad_filter) {
+      quad_filter(sp_sview, args.level, s, t, args.offset, rgba);
+      return;
+   }
+
    for (j = 0; j < TGSI_QUAD_SIZE; j++) {
       args.s = s[j];
       args.t = t[j];
@@ -2691,6 +2948,42 @@ mip_filter_linear_2d_linear_repeat_POT(
    const struct pipe_sampler_view *psview = &sp_sview->base;
    int j;
 
+   /* The whole quad usually sits between the same two levels. */
+   if (filt_args->control != TGSI_SAMPLER_GATHER &&
+       (int)lod[0] == (int)lod[1] && (int)lod[0] == (int)lod[2] &&
+       (int)lod[0] == (int)lod[3]) {
+      const int level0 = psview->u.tex.first_level + (int)lod[0];
+
+      if ((unsigned)level0 >= psview->u.tex.last_level) {
+         img_filter_2d_linear_repeat_POT_quad(sp_sview,
+                                              level0 < 0 ?
+                                              psview->u.tex.first_level :
+                                              psview->u.tex.last_level,
+                                              s, t, filt_args->offset, rgba);
+      }
+      else {
+         float rgbax[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE];
+         float levelBlend[TGSI_QUAD_SIZE];
+         int c;
+
+         img_filter_2d_linear_repeat_POT_quad(sp_sview, level0, s, t,
+                                              filt_args->offset, rgba);
+         img_filter_2d_linear_repeat_POT_quad(sp_sview, level0 + 1, s, t,
+                                              filt_args->offset, rgbax);
+
+         for (j = 0; j < TGSI_QUAD_SIZE; j++)
+            levelBlend[j] = frac(lod[j]);
+         for (c = 0; c < TGSI_NUM_CHANNELS; c++)
+            for (j = 0; j < TGSI_QUAD_SIZE; j++)
+               rgba[c][j] = lerp(levelBlend[j], rgba[c][j], rgbax[c][j]);
+      }
+
+      if (DEBUG_TEX) {
+         print_sample_4(__func__, rgba);
+      }
+      return;
+   }
+
    for (j = 0; j < TGSI_QUAD_SIZE; j++) {
       const int level0 = psview->u.tex.first_level + (int)lod[j];
       struct img_filter_args args;
@@ -32,22 +32,41 @@
  *    Brian Paul
  */
 
+#include <inttypes.h>  /* for PRIu64 macro */
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_tile.h"
 #include "util/format/u_format.h"
 #include "util/u_math.h"
 #include "sp_context.h"
+#include "sp_screen.h"
 #include "sp_texture.h"
 #include "sp_tex_tile_cache.h"
 
-   
+
+
+/**
+ * Mark all cache entries as invalid/empty.  The tile storage is kept for
+ * reuse.
+ */
+static void
+tex_cache_invalidate(struct softpipe_tex_tile_cache *tc)
+{
+   uint pos;
+
+   for (pos = 0; pos < ARRAY_SIZE(tc->tags); pos++) {
+      tc->tags[pos].value = 0;
+      tc->tags[pos].bits.invalid = 1;
+   }
+   tc->last_addr.value = 0;
+   tc->last_addr.bits.invalid = 1;
+}
+
 
 struct softpipe_tex_tile_cache *
 sp_create_tex_tile_cache( struct pipe_context *pipe )
 {
    struct softpipe_tex_tile_cache *tc;
-   uint pos;
 
    /* make sure max texture size works */
    assert((TEX_TILE_SIZE << TEX_Y_BITS) >= (1 << (SP_MAX_TEXTURE_2D_LEVELS-1)));
@@ -55,10 +74,7 @@ sp_create_tex_tile_cache( struct pipe_context *pipe )
    tc = CALLOC_STRUCT( softpipe_tex_tile_cache );
    if (tc) {
       tc->pipe = pipe;
-      for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
-         tc->entries[pos].addr.bits.invalid = 1;
-      }
-      tc->last_tile = &tc->entries[0]; /* any tile */
+      tex_cache_invalidate(tc);
    }
    return tc;
 }
@@ -70,8 +86,14 @@ sp_destroy_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
    if (tc) {
       uint pos;
 
+      if ((sp_debug & SP_DBG_TEX_CACHE) && tc->hits + tc->misses) {
+         debug_printf("softpipe: texture tile cache %p: %" PRIu64 " lookups, "
+                      "%.2f%% hits\n", (void *) tc, tc->hits + tc->misses,
+                      100.0 * tc->hits / (tc->hits + tc->misses));
+      }
+
       for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
-         /*assert(tc->entries[pos].x < 0);*/
+         FREE(tc->entries[pos]);
       }
       if (tc->transfer) {
          tc->pipe->texture_unmap(tc->pipe, tc->transfer);
@@ -92,14 +114,10 @@ sp_destroy_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 void
 sp_tex_tile_cache_validate_texture(struct softpipe_tex_tile_cache *tc)
 {
-   unsigned i;
-
    assert(tc);
    assert(tc->texture);
 
-   for (i = 0; i < ARRAY_SIZE(tc->entries); i++) {
-      tc->entries[i].addr.bits.invalid = 1;
-   }
+   tex_cache_invalidate(tc);
 }
 
 static bool
@@ -124,7 +142,6 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
                                    struct pipe_sampler_view *view)
 {
    struct pipe_resource *texture = view ? view->texture : NULL;
-   uint i;
 
    assert(!tc->transfer);
 
@@ -147,9 +164,7 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
 
       /* mark as entries as invalid/empty */
       /* XXX we should try to avoid this when the teximage hasn't changed */
-      for (i = 0; i < ARRAY_SIZE(tc->entries); i++) {
-         tc->entries[i].addr.bits.invalid = 1;
-      }
+      tex_cache_invalidate(tc);
 
       tc->tex_z = -1; /* any invalid value here */
    }
@@ -165,13 +180,9 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
 void
 sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 {
-   int pos;
-
    if (tc->texture) {
       /* caching a texture, mark all entries as empty */
-      for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
-         tc->entries[pos].addr.bits.invalid = 1;
-      }
+      tex_cache_invalidate(tc);
       tc->tex_z = -1;
    }
 
@@ -180,20 +191,19 @@ sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 
 /**
  * Given the texture face, level, zslice, x and y values, compute
- * the cache entry position/index where we'd hope to find the
- * cached texture tile.
- * This is basically a direct-map cache.
- * XXX There's probably lots of ways in which we can improve this.
+ * the cache set where the texture tile may be cached.
+ * Neighbouring tiles of a level, and the same tile of neighbouring
+ * levels and slices, land in different sets.
  */
 static inline uint
-tex_cache_pos( union tex_tile_address addr )
+tex_cache_set( union tex_tile_address addr )
 {
-   uint entry = (addr.bits.x + 
-                 addr.bits.y * 9 + 
-                 addr.bits.z +
-                 addr.bits.level * 7);
+   uint set = (addr.bits.x +
+               addr.bits.y * 9 +
+               addr.bits.z +
+               addr.bits.level * 7);
 
-   return entry % NUM_TEX_TILE_ENTRIES;
+   return set % NUM_TEX_TILE_SETS;
 }
 
 /**
@@ -204,71 +214,96 @@ const struct softpipe_tex_cached_tile *
 sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc, 
                         union tex_tile_address addr )
 {
-   struct softpipe_tex_cached_tile *tile;
+   static const struct softpipe_tex_cached_tile oom_tile;
+   const uint first = tex_cache_set( addr ) * NUM_TEX_TILE_WAYS;
+   uint pos, victim = first;
+
+   tc->lru_clock++;
+
+   for (pos = first; pos < first + NUM_TEX_TILE_WAYS; pos++) {
+      if (tc->tags[pos].value == addr.value) {
+         tc->hits++;
+         tc->last_used[pos] = tc->lru_clock;
+         tc->last_addr = addr;
+         tc->last_tile = tc->entries[pos];
+         return tc->last_tile;
+      }
 
-   tile = tc->entries + tex_cache_pos( addr );
+      /* Replace an empty way if there is one, else the least recently
+       * used one.
+       */
+      if (tc->tags[victim].bits.invalid)
+         continue;
+      if (tc->tags[pos].bits.invalid ||
+          tc->lru_clock - tc->last_used[pos] >
+          tc->lru_clock - tc->last_used[victim])
+         victim = pos;
+   }
 
-   if (addr.value != tile->addr.value) {
+   /* cache miss.  Most misses are because we've invalidated the
+    * texture cache previously -- most commonly on binding a new
+    * texture.  Currently we effectively flush the cache on texture
+    * bind.
+    */
+   tc->misses++;
+   pos = victim;
+
+   if (!tc->entries[pos]) {
+      tc->entries[pos] = MALLOC_STRUCT(softpipe_tex_cached_tile);
+      if (!tc->entries[pos]) {
+         /* Sample black rather than crash, and retry next time. */
+         return &oom_tile;
+      }
+   }
 
-      /* cache miss.  Most misses are because we've invalidated the
-       * texture cache previously -- most commonly on binding a new
-       * texture.  Currently we effectively flush the cache on texture
-       * bind.
-       */
-#if 0
-      _debug_printf("miss at %u:  x=%d y=%d z=%d face=%d level=%d\n"
-                    "   tile %u:  x=%d y=%d z=%d face=%d level=%d\n",
-                    pos, x/TILE_SIZE, y/TILE_SIZE, z, face, level,
-                    pos, tile->addr.bits.x, tile->addr.bits.y, tile->z, tile->face, tile->level);
-#endif
-
-      /* check if we need to get a new transfer */
-      if (!tc->tex_trans ||
-          tc->tex_level != addr.bits.level ||
-          tc->tex_z != addr.bits.z) {
-         /* get new transfer (view into texture) */
-         unsigned width, height, layer;
-
-         if (tc->tex_trans_map) {
-            tc->pipe->texture_unmap(tc->pipe, tc->tex_trans);
-            tc->tex_trans = NULL;
-            tc->tex_trans_map = NULL;
-         }
-
-         width = u_minify(tc->texture->width0, addr.bits.level);
-         if (tc->texture->target == PIPE_TEXTURE_1D_ARRAY) {
-            height = tc->texture->array_size;
-            layer = 0;
-         }
-         else {
-            height = u_minify(tc->texture->height0, addr.bits.level);
-            layer = addr.bits.z;
-         }
-
-         tc->tex_trans_map =
-            pipe_texture_map(tc->pipe, tc->texture,
-                              addr.bits.level,
-                              layer,
-                              PIPE_MAP_READ | PIPE_MAP_UNSYNCHRONIZED,
-                              0, 0, width, height, &tc->tex_trans);
-
-         tc->tex_level = addr.bits.level;
-         tc->tex_z = addr.bits.z;
+   /* check if we need to get a new transfer */
+   if (!tc->tex_trans ||
+       tc->tex_level != addr.bits.level ||
+       tc->tex_z != addr.bits.z) {
+      /* get new transfer (view into texture) */
+      unsigned width, height, layer;
+
+      if (tc->tex_trans_map) {
+         tc->pipe->texture_unmap(tc->pipe, tc->tex_trans);
+         tc->tex_trans = NULL;
+         tc->tex_trans_map = NULL;
       }
 
-      /* Get tile from the transfer (view into texture), explicitly passing
-       * the image format.
-       */
-      pipe_get_tile_rgba(tc->tex_trans, tc->tex_trans_map,
-                         addr.bits.x * TEX_TILE_SIZE,
-                         addr.bits.y * TEX_TILE_SIZE,
-                         TEX_TILE_SIZE,
-                         TEX_TILE_SIZE,
-                         tc->format,
-                         (float *) tile->data.color);
-      tile->addr = addr;
+      width = u_minify(tc->texture->width0, addr.bits.level);
+      if (tc->texture->target == PIPE_TEXTURE_1D_ARRAY) {
+         height = tc->texture->array_size;
+         layer = 0;
+      }
+      else {
+         height = u_minify(tc->texture->height0, addr.bits.level);
+         layer = addr.bits.z;
+      }
+
+      tc->tex_trans_map =
+         pipe_texture_map(tc->pipe, tc->texture,
+                          addr.bits.level,
+                          layer,
+                          PIPE_MAP_READ | PIPE_MAP_UNSYNCHRONIZED,
+                          0, 0, width, height, &tc->tex_trans);
+
+      tc->tex_level = addr.bits.level;
+      tc->tex_z = addr.bits.z;
    }
 
-   tc->last_tile = tile;
-   return tile;
+   /* Get tile from the transfer (view into texture), explicitly passing
+    * the image format.
+    */
+   pipe_get_tile_rgba(tc->tex_trans, tc->tex_trans_map,
+                      addr.bits.x * TEX_TILE_SIZE,
+                      addr.bits.y * TEX_TILE_SIZE,
+                      TEX_TILE_SIZE,
+                      TEX_TILE_SIZE,
+                      tc->format,
+                      (float *) tc->entries[pos]->data.color);
+
+   tc->tags[pos] = addr;
+   tc->last_used[pos] = tc->lru_clock;
+   tc->last_addr = addr;
+   tc->last_tile = tc->entries[pos];
+   return tc->last_tile;
 }
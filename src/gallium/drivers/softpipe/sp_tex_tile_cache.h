@@ -63,7 +63,6 @@ union tex_tile_address {
 
 struct softpipe_tex_cached_tile
 {
-   union tex_tile_address addr;
    union {
       float color[TEX_TILE_SIZE][TEX_TILE_SIZE][4];
       unsigned int colorui[TEX_TILE_SIZE][TEX_TILE_SIZE][4];
@@ -72,12 +71,15 @@ struct softpipe_tex_cached_tile
 };
 
 /*
- * The number of cache entries.
- * Should not be decreased to lower than 16, and even that
- * seems too low to avoid cache thrashing in some cases (because
- * the cache is direct mapped, see tex_cache_pos() function).
+ * The cache is set associative: a tile address maps to one set (see
+ * tex_cache_set()) and may live in any of its ways, the least recently
+ * used way being replaced on a miss.  Tile storage is only allocated once
+ * a way is first filled, so most of the per-view caches of a context cost
+ * no more than their tags.
  */
-#define NUM_TEX_TILE_ENTRIES 16
+#define NUM_TEX_TILE_SETS 16
+#define NUM_TEX_TILE_WAYS 4
+#define NUM_TEX_TILE_ENTRIES (NUM_TEX_TILE_SETS * NUM_TEX_TILE_WAYS)
 
 struct softpipe_tex_tile_cache
 {
@@ -86,9 +88,12 @@ struct softpipe_tex_tile_cache
    void *transfer_map;
 
    struct pipe_resource *texture;  /**< if caching a texture */
-   unsigned timestamp;
+   unsigned timestamp;             /**< texture timestamp last validated */
+   unsigned lru_clock;             /**< bumped on each lookup */
 
-   struct softpipe_tex_cached_tile entries[NUM_TEX_TILE_ENTRIES];
+   union tex_tile_address tags[NUM_TEX_TILE_ENTRIES];
+   unsigned last_used[NUM_TEX_TILE_ENTRIES];
+   struct softpipe_tex_cached_tile *entries[NUM_TEX_TILE_ENTRIES];
 
    struct pipe_transfer *tex_trans;
    void *tex_trans_map;
@@ -100,7 +105,12 @@ struct softpipe_tex_tile_cache
    unsigned swizzle_a;
    enum pipe_format format;
 
-   struct softpipe_tex_cached_tile *last_tile;  /**< most recently retrieved tile */
+   /** most recently retrieved tile and its address */
+   union tex_tile_address last_addr;
+   const struct softpipe_tex_cached_tile *last_tile;
+
+   /** lookup statistics, reported with SOFTPIPE_DEBUG=tex_cache */
+   uint64_t hits, misses;
 };
 
 
@@ -150,8 +160,10 @@ static inline const struct softpipe_tex_cached_tile *
 sp_get_cached_tile_tex(struct softpipe_tex_tile_cache *tc, 
                        union tex_tile_address addr )
 {
-   if (tc->last_tile->addr.value == addr.value)
+   if (tc->last_addr.value == addr.value) {
+      tc->hits++;
       return tc->last_tile;
+   }
 
    return sp_find_cached_tile_tex( tc, addr );
 }
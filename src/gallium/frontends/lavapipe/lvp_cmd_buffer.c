@@ -28,10 +28,17 @@
 #include "vk_common_entrypoints.h"
 
 static void
-lvp_cmd_buffer_destroy(struct vk_command_buffer *cmd_buffer)
+lvp_cmd_buffer_destroy(struct vk_command_buffer *vk_cmd_buffer)
 {
-   vk_command_buffer_finish(cmd_buffer);
-   vk_free(&cmd_buffer->pool->alloc, cmd_buffer);
+   struct lvp_cmd_buffer *cmd_buffer =
+      container_of(vk_cmd_buffer, struct lvp_cmd_buffer, vk);
+
+   util_dynarray_fini(&cmd_buffer->stream);
+   lvp_cmd_buffer_free_resolved(cmd_buffer);
+   util_dynarray_fini(&cmd_buffer->resolved_cmds);
+   util_dynarray_fini(&cmd_buffer->resolved_sets);
+   vk_command_buffer_finish(vk_cmd_buffer);
+   vk_free(&vk_cmd_buffer->pool->alloc, cmd_buffer);
 }
 
 static VkResult
@@ -55,6 +62,11 @@ lvp_create_cmd_buffer(struct vk_command_pool *pool,
    }
 
    cmd_buffer->device = device;
+   cmd_buffer->usage_flags = 0;
+   util_dynarray_init(&cmd_buffer->stream, NULL);
+   cmd_buffer->compiled = false;
+   util_dynarray_init(&cmd_buffer->resolved_cmds, NULL);
+   util_dynarray_init(&cmd_buffer->resolved_sets, NULL);
 
    *cmd_buffer_out = &cmd_buffer->vk;
 
@@ -65,6 +77,12 @@ static void
 lvp_reset_cmd_buffer(struct vk_command_buffer *vk_cmd_buffer,
                      UNUSED VkCommandBufferResetFlags flags)
 {
+   struct lvp_cmd_buffer *cmd_buffer =
+      container_of(vk_cmd_buffer, struct lvp_cmd_buffer, vk);
+
+   util_dynarray_clear(&cmd_buffer->stream);
+   lvp_cmd_buffer_free_resolved(cmd_buffer);
+   cmd_buffer->compiled = false;
    vk_command_buffer_reset(vk_cmd_buffer);
 }
 
@@ -81,6 +99,7 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_BeginCommandBuffer(
    LVP_FROM_HANDLE(lvp_cmd_buffer, cmd_buffer, commandBuffer);
 
    vk_command_buffer_begin(&cmd_buffer->vk, pBeginInfo);
+   cmd_buffer->usage_flags = pBeginInfo->flags;
 
    return VK_SUCCESS;
 }
@@ -89,8 +108,14 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_EndCommandBuffer(
    VkCommandBuffer                             commandBuffer)
 {
    LVP_FROM_HANDLE(lvp_cmd_buffer, cmd_buffer, commandBuffer);
+   VkResult result = vk_command_buffer_end(&cmd_buffer->vk);
+
+   /* Flattening only pays off if the commands are executed again. */
+   if (result == VK_SUCCESS && cmd_buffer->device->compile_cmds &&
+       !(cmd_buffer->usage_flags & VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT))
+      lvp_compile_cmd_buffer(cmd_buffer);
 
-   return vk_command_buffer_end(&cmd_buffer->vk);
+   return result;
 }
 
 static void
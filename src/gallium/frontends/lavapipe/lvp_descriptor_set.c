@@ -184,6 +184,17 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDescriptorSetLayout(
 
    set_layout->dynamic_offset_count = dynamic_offset_count;
 
+   const VkDescriptorSetLayoutBindingFlagsCreateInfo *binding_flags =
+      vk_find_struct_const(pCreateInfo->pNext, DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO);
+   set_layout->update_after_bind =
+      pCreateInfo->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+   for (uint32_t i = 0; binding_flags && i < binding_flags->bindingCount; i++) {
+      if (binding_flags->pBindingFlags[i] &
+          (VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT))
+         set_layout->update_after_bind = true;
+   }
+
    if (set_layout->binding_count == set_layout->immutable_sampler_count) {
       /* create a bindable set with all the immutable samplers */
       lvp_descriptor_set_create(device, set_layout, &set_layout->immutable_set);
@@ -40,6 +40,7 @@
 #include "util/os_time.h"
 #include "util/u_thread.h"
 #include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
 #include "util/timespec.h"
 #include "util/ptralloc.h"
 #include "nir.h"
@@ -1307,7 +1308,18 @@ VKAPI_ATTR void VKAPI_CALL lvp_GetPhysicalDeviceQueueFamilyProperties2(
          .queueFlags = VK_QUEUE_GRAPHICS_BIT |
          VK_QUEUE_COMPUTE_BIT |
          VK_QUEUE_TRANSFER_BIT,
-         .queueCount = 1,
+         .queueCount = MAX_QUEUES_PER_FAMILY,
+         .timestampValidBits = 64,
+         .minImageTransferGranularity = (VkExtent3D) { 1, 1, 1 },
+      };
+   }
+
+   /* async compute */
+   vk_outarray_append_typed(VkQueueFamilyProperties2, &out, p) {
+      p->queueFamilyProperties = (VkQueueFamilyProperties) {
+         .queueFlags = VK_QUEUE_COMPUTE_BIT |
+         VK_QUEUE_TRANSFER_BIT,
+         .queueCount = MAX_QUEUES_PER_FAMILY,
          .timestampValidBits = 64,
          .minImageTransferGranularity = (VkExtent3D) { 1, 1, 1 },
       };
@@ -1414,33 +1426,37 @@ lvp_queue_submit(struct vk_queue *vk_queue,
                  struct vk_queue_submit *submit)
 {
    struct lvp_queue *queue = container_of(vk_queue, struct lvp_queue, vk);
+   struct lvp_device *device = queue->device;
 
-   VkResult result = vk_sync_wait_many(&queue->device->vk,
+   VkResult result = vk_sync_wait_many(&device->vk,
                                        submit->wait_count, submit->waits,
                                        VK_SYNC_WAIT_COMPLETE, UINT64_MAX);
    if (result != VK_SUCCESS)
       return result;
 
+   /* Every queue has its own context and its own shader states, so queues
+    * only hold their own lock to translate and flush, and run in parallel.
+    */
    simple_mtx_lock(&queue->lock);
 
    for (uint32_t i = 0; i < submit->command_buffer_count; i++) {
       struct lvp_cmd_buffer *cmd_buffer =
          container_of(submit->command_buffers[i], struct lvp_cmd_buffer, vk);
 
-      lvp_execute_cmds(queue->device, queue, cmd_buffer);
+      lvp_execute_cmds(device, queue, cmd_buffer);
    }
 
-   simple_mtx_unlock(&queue->lock);
-
    if (submit->command_buffer_count > 0)
       queue->ctx->flush(queue->ctx, &queue->last_fence, 0);
 
+   simple_mtx_unlock(&queue->lock);
+
    for (uint32_t i = 0; i < submit->signal_count; i++) {
       struct lvp_pipe_sync *sync =
          vk_sync_as_lvp_pipe_sync(submit->signals[i].sync);
-      lvp_pipe_sync_signal_with_fence(queue->device, sync, queue->last_fence);
+      lvp_pipe_sync_signal_with_fence(device, sync, queue->last_fence);
    }
-   destroy_pipelines(queue);
+   destroy_pipelines(&device->queue);
 
    return VK_SUCCESS;
 }
@@ -1467,6 +1483,12 @@ lvp_queue_init(struct lvp_device *device, struct lvp_queue *queue,
    queue->cso = cso_create_context(queue->ctx, CSO_NO_VBUF);
    queue->uploader = u_upload_create(queue->ctx, 1024 * 1024, PIPE_BIND_CONSTANT_BUFFER, PIPE_USAGE_STREAM, 0);
 
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT, NULL, "dummy_frag");
+   struct pipe_shader_state shstate = {0};
+   shstate.type = PIPE_SHADER_IR_NIR;
+   shstate.ir.nir = b.shader;
+   queue->noop_fs = queue->ctx->create_fs_state(queue->ctx, &shstate);
+
    queue->vk.driver_submit = lvp_queue_submit;
 
    simple_mtx_init(&queue->lock, mtx_plain);
@@ -1484,6 +1506,9 @@ lvp_queue_finish(struct lvp_queue *queue)
    simple_mtx_destroy(&queue->lock);
    util_dynarray_fini(&queue->pipeline_destroys);
 
+   if (queue->last_fence)
+      queue->device->pscreen->fence_reference(queue->device->pscreen, &queue->last_fence, NULL);
+   queue->ctx->delete_fs_state(queue->ctx, queue->noop_fs);
    u_upload_destroy(queue->uploader);
    cso_destroy_context(queue->cso);
    queue->ctx->destroy(queue->ctx);
@@ -1511,6 +1536,7 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
    device->queue.state = device + 1;
    device->poison_mem = debug_get_bool_option("LVP_POISON_MEMORY", false);
    device->print_cmds = debug_get_bool_option("LVP_CMD_DEBUG", false);
+   device->compile_cmds = debug_get_bool_option("LVP_COMPILE_CMDS", true);
 
    struct vk_device_dispatch_table dispatch_table;
    vk_device_dispatch_table_from_entrypoints(&dispatch_table,
@@ -1535,20 +1561,50 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
 
    device->pscreen = physical_device->pscreen;
 
-   assert(pCreateInfo->queueCreateInfoCount == 1);
-   assert(pCreateInfo->pQueueCreateInfos[0].queueFamilyIndex == 0);
-   assert(pCreateInfo->pQueueCreateInfos[0].queueCount == 1);
-   result = lvp_queue_init(device, &device->queue, pCreateInfo->pQueueCreateInfos, 0);
-   if (result != VK_SUCCESS) {
-      vk_free(&device->vk.alloc, device);
-      return result;
+   uint32_t num_queues = 0;
+   for (uint32_t i = 0; i < pCreateInfo->queueCreateInfoCount; i++)
+      num_queues += pCreateInfo->pQueueCreateInfos[i].queueCount;
+   assert(num_queues > 0);
+
+   if (num_queues > 1) {
+      device->extra_queues = vk_zalloc(&device->vk.alloc,
+                                       (num_queues - 1) * (sizeof(struct lvp_queue) + state_size), 8,
+                                       VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+      if (!device->extra_queues) {
+         vk_free(&device->vk.alloc, device);
+         return vk_error(instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+      }
+   }
+   uint8_t *extra_states = (uint8_t *)(device->extra_queues + num_queues - 1);
+
+   for (uint32_t i = 0; i < pCreateInfo->queueCreateInfoCount; i++) {
+      const VkDeviceQueueCreateInfo *queue_info = &pCreateInfo->pQueueCreateInfos[i];
+
+      for (uint32_t q = 0; q < queue_info->queueCount; q++) {
+         struct lvp_queue *queue = &device->queue;
+
+         if (i || q) {
+            queue = &device->extra_queues[device->num_extra_queues];
+            queue->index = device->num_extra_queues + 1;
+            queue->state = extra_states + device->num_extra_queues * state_size;
+         }
+
+         result = lvp_queue_init(device, queue, queue_info, q);
+         if (result != VK_SUCCESS) {
+            for (uint32_t j = 0; j < device->num_extra_queues; j++)
+               lvp_queue_finish(&device->extra_queues[j]);
+            if (queue != &device->queue)
+               lvp_queue_finish(&device->queue);
+            vk_free(&device->vk.alloc, device->extra_queues);
+            vk_free(&device->vk.alloc, device);
+            return result;
+         }
+
+         if (queue != &device->queue)
+            device->num_extra_queues++;
+      }
    }
 
-   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT, NULL, "dummy_frag");
-   struct pipe_shader_state shstate = {0};
-   shstate.type = PIPE_SHADER_IR_NIR;
-   shstate.ir.nir = b.shader;
-   device->noop_fs = device->queue.ctx->create_fs_state(device->queue.ctx, &shstate);
    _mesa_hash_table_init(&device->bda, NULL, _mesa_hash_pointer, _mesa_key_pointer_equal);
    simple_mtx_init(&device->bda_lock, mtx_plain);
 
@@ -1563,6 +1619,13 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
    util_dynarray_init(&device->bda_texture_handles, NULL);
    util_dynarray_init(&device->bda_image_handles, NULL);
 
+   unsigned num_threads = debug_get_num_option("LVP_PIPELINE_THREADS",
+                                               util_get_cpu_caps()->nr_cpus);
+   if (num_threads > 1 &&
+       util_queue_init(&device->compile_queue, "lvpcomp", 64, num_threads,
+                       UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL))
+      device->num_compile_threads = num_threads;
+
    *pDevice = lvp_device_to_handle(device);
 
    return VK_SUCCESS;
@@ -1575,6 +1638,15 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyDevice(
 {
    LVP_FROM_HANDLE(lvp_device, device, _device);
 
+   if (device->num_compile_threads)
+      util_queue_destroy(&device->compile_queue);
+
+   /* Deferred pipeline destroys delete shader states on every queue. */
+   destroy_pipelines(&device->queue);
+   for (uint32_t i = 0; i < device->num_extra_queues; i++)
+      lvp_queue_finish(&device->extra_queues[i]);
+   vk_free(&device->vk.alloc, device->extra_queues);
+
    util_dynarray_foreach(&device->bda_texture_handles, struct lp_texture_handle *, handle)
       device->queue.ctx->delete_texture_handle(device->queue.ctx, (uint64_t)(uintptr_t)*handle);
 
@@ -1588,10 +1660,6 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyDevice(
    device->queue.ctx->delete_texture_handle(device->queue.ctx, (uint64_t)(uintptr_t)device->null_texture_handle);
    device->queue.ctx->delete_image_handle(device->queue.ctx, (uint64_t)(uintptr_t)device->null_image_handle);
 
-   device->queue.ctx->delete_fs_state(device->queue.ctx, device->noop_fs);
-
-   if (device->queue.last_fence)
-      device->pscreen->fence_reference(device->pscreen, &device->queue.last_fence, NULL);
    ralloc_free(device->bda.table);
    simple_mtx_destroy(&device->bda_lock);
    pipe_resource_reference(&device->zero_buffer, NULL);
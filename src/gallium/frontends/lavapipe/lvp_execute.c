@@ -81,6 +81,7 @@ struct lvp_render_attachment {
 struct rendering_state {
    struct pipe_context *pctx;
    struct lvp_device *device; //for uniform inlining only
+   struct lvp_queue *queue;
    struct u_upload_mgr *uploader;
    struct cso_context *cso;
 
@@ -301,6 +302,7 @@ update_inline_shader_state(struct rendering_state *state, enum pipe_shader_type
       return;
    struct lvp_inline_variant v;
    v.mask = shader->inlines.can_inline;
+   v.queue = state->queue->index;
    /* these buffers have already been flushed in llvmpipe, so they're safe to read */
    nir_shader *base_nir = shader->pipeline_nir->nir;
    if (stage == MESA_SHADER_TESS_EVAL && state->tess_ccw)
@@ -320,9 +322,16 @@ update_inline_shader_state(struct rendering_state *state, enum pipe_shader_type
          v.vals[0][i] = 0;
    }
    bool found = false;
-   struct set_entry *entry = _mesa_set_search_or_add_pre_hashed(&shader->inlines.variants, v.mask, &v, &found);
+   struct set_entry *entry = NULL;
    void *shader_state;
-   if (found) {
+   /* the variants of all queues are in the same set */
+   simple_mtx_lock(&shader->inlines.lock);
+   /* another queue may have stopped inlining since the check above */
+   if (shader->inlines.can_inline)
+      entry = _mesa_set_search_or_add_pre_hashed(&shader->inlines.variants, v.mask, &v, &found);
+   if (!entry) {
+      shader_state = lvp_shader_get_cso(state->queue, shader, false);
+   } else if (found) {
       const struct lvp_inline_variant *variant = entry->key;
       shader_state = variant->cso;
    } else {
@@ -335,16 +344,16 @@ update_inline_shader_state(struct rendering_state *state, enum pipe_shader_type
          /* not enough change; don't inline further */
          shader->inlines.can_inline = 0;
          ralloc_free(nir);
-         shader->shader_cso = lvp_shader_compile(state->device, shader, nir_shader_clone(NULL, shader->pipeline_nir->nir), true);
          _mesa_set_remove(&shader->inlines.variants, entry);
-         shader_state = shader->shader_cso;
+         shader_state = lvp_shader_get_cso(state->queue, shader, false);
       } else {
-         shader_state = lvp_shader_compile(state->device, shader, nir, true);
+         shader_state = lvp_shader_compile_for_queue(state->queue, shader, nir);
          struct lvp_inline_variant *variant = mem_dup(&v, sizeof(v));
          variant->cso = shader_state;
          entry->key = variant;
       }
    }
+   simple_mtx_unlock(&shader->inlines.lock);
    switch (sh) {
    case MESA_SHADER_VERTEX:
       state->pctx->bind_vs_state(state->pctx, shader_state);
@@ -436,7 +445,7 @@ static void update_vertex_elements_buffer_index(struct rendering_state *state)
 static void emit_state(struct rendering_state *state)
 {
    if (!state->shaders[MESA_SHADER_FRAGMENT] && !state->noop_fs_bound) {
-      state->pctx->bind_fs_state(state->pctx, state->device->noop_fs);
+      state->pctx->bind_fs_state(state->pctx, state->queue->noop_fs);
       state->noop_fs_bound = true;
    }
    if (state->blend_dirty) {
@@ -591,7 +600,7 @@ handle_compute_shader(struct rendering_state *state, struct lvp_shader *shader,
    state->dispatch_info.block[2] = shader->pipeline_nir->nir->info.workgroup_size[2];
    state->inlines_dirty[MESA_SHADER_COMPUTE] = shader->inlines.can_inline;
    if (!shader->inlines.can_inline)
-      state->pctx->bind_compute_state(state->pctx, shader->shader_cso);
+      state->pctx->bind_compute_state(state->pctx, lvp_shader_get_cso(state->queue, shader, false));
 }
 
 static void handle_compute_pipeline(struct vk_cmd_queue_entry *cmd,
@@ -657,25 +666,25 @@ handle_graphics_stages(struct rendering_state *state, VkShaderStageFlagBits shad
       case VK_SHADER_STAGE_FRAGMENT_BIT:
          state->inlines_dirty[MESA_SHADER_FRAGMENT] = state->shaders[MESA_SHADER_FRAGMENT]->inlines.can_inline;
          if (!state->shaders[MESA_SHADER_FRAGMENT]->inlines.can_inline) {
-            state->pctx->bind_fs_state(state->pctx, state->shaders[MESA_SHADER_FRAGMENT]->shader_cso);
+            state->pctx->bind_fs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_FRAGMENT], false));
             state->noop_fs_bound = false;
          }
          break;
       case VK_SHADER_STAGE_VERTEX_BIT:
          state->inlines_dirty[MESA_SHADER_VERTEX] = state->shaders[MESA_SHADER_VERTEX]->inlines.can_inline;
          if (!state->shaders[MESA_SHADER_VERTEX]->inlines.can_inline)
-            state->pctx->bind_vs_state(state->pctx, state->shaders[MESA_SHADER_VERTEX]->shader_cso);
+            state->pctx->bind_vs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_VERTEX], false));
          break;
       case VK_SHADER_STAGE_GEOMETRY_BIT:
          state->inlines_dirty[MESA_SHADER_GEOMETRY] = state->shaders[MESA_SHADER_GEOMETRY]->inlines.can_inline;
          if (!state->shaders[MESA_SHADER_GEOMETRY]->inlines.can_inline)
-            state->pctx->bind_gs_state(state->pctx, state->shaders[MESA_SHADER_GEOMETRY]->shader_cso);
+            state->pctx->bind_gs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_GEOMETRY], false));
          state->gs_output_lines = state->shaders[MESA_SHADER_GEOMETRY]->pipeline_nir->nir->info.gs.output_primitive == MESA_PRIM_LINES ? GS_OUTPUT_LINES : GS_OUTPUT_NOT_LINES;
          break;
       case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
          state->inlines_dirty[MESA_SHADER_TESS_CTRL] = state->shaders[MESA_SHADER_TESS_CTRL]->inlines.can_inline;
          if (!state->shaders[MESA_SHADER_TESS_CTRL]->inlines.can_inline)
-            state->pctx->bind_tcs_state(state->pctx, state->shaders[MESA_SHADER_TESS_CTRL]->shader_cso);
+            state->pctx->bind_tcs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_CTRL], false));
          break;
       case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
          state->inlines_dirty[MESA_SHADER_TESS_EVAL] = state->shaders[MESA_SHADER_TESS_EVAL]->inlines.can_inline;
@@ -683,11 +692,11 @@ handle_graphics_stages(struct rendering_state *state, VkShaderStageFlagBits shad
          state->tess_states[1] = NULL;
          if (!state->shaders[MESA_SHADER_TESS_EVAL]->inlines.can_inline) {
             if (dynamic_tess_origin) {
-               state->tess_states[0] = state->shaders[MESA_SHADER_TESS_EVAL]->shader_cso;
-               state->tess_states[1] = state->shaders[MESA_SHADER_TESS_EVAL]->tess_ccw_cso;
+               state->tess_states[0] = lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_EVAL], false);
+               state->tess_states[1] = lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_EVAL], true);
                state->pctx->bind_tes_state(state->pctx, state->tess_states[state->tess_ccw]);
             } else {
-               state->pctx->bind_tes_state(state->pctx, state->shaders[MESA_SHADER_TESS_EVAL]->shader_cso);
+               state->pctx->bind_tes_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_EVAL], false));
             }
          }
          if (!dynamic_tess_origin)
@@ -699,7 +708,7 @@ handle_graphics_stages(struct rendering_state *state, VkShaderStageFlagBits shad
          state->dispatch_info.block[1] = state->shaders[MESA_SHADER_TASK]->pipeline_nir->nir->info.workgroup_size[1];
          state->dispatch_info.block[2] = state->shaders[MESA_SHADER_TASK]->pipeline_nir->nir->info.workgroup_size[2];
          if (!state->shaders[MESA_SHADER_TASK]->inlines.can_inline)
-            state->pctx->bind_ts_state(state->pctx, state->shaders[MESA_SHADER_TASK]->shader_cso);
+            state->pctx->bind_ts_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TASK], false));
          break;
       case VK_SHADER_STAGE_MESH_BIT_EXT:
          state->inlines_dirty[MESA_SHADER_MESH] = state->shaders[MESA_SHADER_MESH]->inlines.can_inline;
@@ -709,7 +718,7 @@ handle_graphics_stages(struct rendering_state *state, VkShaderStageFlagBits shad
             state->dispatch_info.block[2] = state->shaders[MESA_SHADER_MESH]->pipeline_nir->nir->info.workgroup_size[2];
          }
          if (!state->shaders[MESA_SHADER_MESH]->inlines.can_inline)
-            state->pctx->bind_ms_state(state->pctx, state->shaders[MESA_SHADER_MESH]->shader_cso);
+            state->pctx->bind_ms_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_MESH], false));
          break;
       default:
          assert(0);
@@ -1178,24 +1187,16 @@ static void handle_set_stage(struct rendering_state *state,
    handle_set_stage_buffer(state, set->bo, 0, stage, index);
 }
 
-static void
-apply_dynamic_offsets(struct lvp_descriptor_set **out_set, const uint32_t *offsets, uint32_t offset_count,
-                      struct rendering_state *state)
+/* Creates a copy of a set with the dynamic offsets applied. */
+static struct lvp_descriptor_set *
+create_dynamic_offset_set(struct lvp_device *device, struct lvp_descriptor_set *in_set,
+                          const uint32_t *offsets, uint32_t offset_count)
 {
-   if (!offset_count)
-      return;
-
-   struct lvp_descriptor_set *in_set = *out_set;
-
    struct lvp_descriptor_set *set;
-   lvp_descriptor_set_create(state->device, in_set->layout, &set);
-
-   util_dynarray_append(&state->push_desc_sets, struct lvp_descriptor_set *, set);
+   lvp_descriptor_set_create(device, in_set->layout, &set);
 
    memcpy(set->map, in_set->map, in_set->bo->width0);
 
-   *out_set = set;
-
    for (uint32_t i = 0; i < set->layout->binding_count; i++) {
       const struct lvp_descriptor_set_binding_layout *binding = &set->layout->binding[i];
       if (binding->type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC &&
@@ -1208,11 +1209,28 @@ apply_dynamic_offsets(struct lvp_descriptor_set **out_set, const uint32_t *offse
       for (uint32_t j = 0; j < binding->array_size; j++) {
          uint32_t offset_index = binding->dynamic_index + j;
          if (offset_index >= offset_count)
-            return;
+            return set;
 
          desc[j].buffer.u = (uint32_t *)((uint8_t *)desc[j].buffer.u + offsets[offset_index]);
       }
    }
+
+   return set;
+}
+
+static void
+apply_dynamic_offsets(struct lvp_descriptor_set **out_set, const uint32_t *offsets, uint32_t offset_count,
+                      struct rendering_state *state)
+{
+   if (!offset_count)
+      return;
+
+   struct lvp_descriptor_set *set =
+      create_dynamic_offset_set(state->device, *out_set, offsets, offset_count);
+
+   util_dynarray_append(&state->push_desc_sets, struct lvp_descriptor_set *, set);
+
+   *out_set = set;
 }
 
 static void
@@ -2769,13 +2787,18 @@ static void handle_push_constants(struct vk_cmd_queue_entry *cmd,
 
 static void lvp_execute_cmd_buffer(struct list_head *cmds,
                                    struct rendering_state *state, bool print_cmds);
+static void lvp_execute_cmd_stream(const struct lvp_cmd_buffer *cmd_buffer,
+                                   struct rendering_state *state, bool print_cmds);
 
 static void handle_execute_commands(struct vk_cmd_queue_entry *cmd,
                                     struct rendering_state *state, bool print_cmds)
 {
    for (unsigned i = 0; i < cmd->u.execute_commands.command_buffer_count; i++) {
       LVP_FROM_HANDLE(lvp_cmd_buffer, secondary_buf, cmd->u.execute_commands.command_buffers[i]);
-      lvp_execute_cmd_buffer(&secondary_buf->vk.cmd_queue.cmds, state, print_cmds);
+      if (secondary_buf->compiled)
+         lvp_execute_cmd_stream(secondary_buf, state, print_cmds);
+      else
+         lvp_execute_cmd_buffer(&secondary_buf->vk.cmd_queue.cmds, state, print_cmds);
    }
 }
 
@@ -4453,6 +4476,366 @@ void lvp_add_enqueue_cmd_entrypoints(struct vk_device_dispatch_table *disp)
 #undef ENQUEUE_CMD
 }
 
+static void lvp_execute_cmd(struct vk_cmd_queue_entry *cmd,
+                            struct rendering_state *state, bool print_cmds)
+{
+   switch (cmd->type) {
+   case VK_CMD_BIND_PIPELINE:
+      handle_pipeline(cmd, state);
+      break;
+   case VK_CMD_SET_VIEWPORT:
+      handle_set_viewport(cmd, state);
+      break;
+   case VK_CMD_SET_VIEWPORT_WITH_COUNT:
+      handle_set_viewport_with_count(cmd, state);
+      break;
+   case VK_CMD_SET_SCISSOR:
+      handle_set_scissor(cmd, state);
+      break;
+   case VK_CMD_SET_SCISSOR_WITH_COUNT:
+      handle_set_scissor_with_count(cmd, state);
+      break;
+   case VK_CMD_SET_LINE_WIDTH:
+      handle_set_line_width(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_BIAS:
+      handle_set_depth_bias(cmd, state);
+      break;
+   case VK_CMD_SET_BLEND_CONSTANTS:
+      handle_set_blend_constants(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_BOUNDS:
+      handle_set_depth_bounds(cmd, state);
+      break;
+   case VK_CMD_SET_STENCIL_COMPARE_MASK:
+      handle_set_stencil_compare_mask(cmd, state);
+      break;
+   case VK_CMD_SET_STENCIL_WRITE_MASK:
+      handle_set_stencil_write_mask(cmd, state);
+      break;
+   case VK_CMD_SET_STENCIL_REFERENCE:
+      handle_set_stencil_reference(cmd, state);
+      break;
+   case VK_CMD_BIND_DESCRIPTOR_SETS2_KHR:
+      handle_descriptor_sets_cmd(cmd, state);
+      break;
+   case VK_CMD_BIND_INDEX_BUFFER:
+      handle_index_buffer(cmd, state);
+      break;
+   case VK_CMD_BIND_INDEX_BUFFER2_KHR:
+      handle_index_buffer2(cmd, state);
+      break;
+   case VK_CMD_BIND_VERTEX_BUFFERS2:
+      handle_vertex_buffers2(cmd, state);
+      break;
+   case VK_CMD_DRAW:
+      emit_state(state);
+      handle_draw(cmd, state);
+      break;
+   case VK_CMD_DRAW_MULTI_EXT:
+      emit_state(state);
+      handle_draw_multi(cmd, state);
+      break;
+   case VK_CMD_DRAW_INDEXED:
+      emit_state(state);
+      handle_draw_indexed(cmd, state);
+      break;
+   case VK_CMD_DRAW_INDIRECT:
+      emit_state(state);
+      handle_draw_indirect(cmd, state, false);
+      break;
+   case VK_CMD_DRAW_INDEXED_INDIRECT:
+      emit_state(state);
+      handle_draw_indirect(cmd, state, true);
+      break;
+   case VK_CMD_DRAW_MULTI_INDEXED_EXT:
+      emit_state(state);
+      handle_draw_multi_indexed(cmd, state);
+      break;
+   case VK_CMD_DISPATCH:
+      emit_compute_state(state);
+      handle_dispatch(cmd, state);
+      break;
+   case VK_CMD_DISPATCH_BASE:
+      emit_compute_state(state);
+      handle_dispatch_base(cmd, state);
+      break;
+   case VK_CMD_DISPATCH_INDIRECT:
+      emit_compute_state(state);
+      handle_dispatch_indirect(cmd, state);
+      break;
+   case VK_CMD_COPY_BUFFER2:
+      handle_copy_buffer(cmd, state);
+      break;
+   case VK_CMD_COPY_IMAGE2:
+      handle_copy_image(cmd, state);
+      break;
+   case VK_CMD_BLIT_IMAGE2:
+      handle_blit_image(cmd, state);
+      break;
+   case VK_CMD_COPY_BUFFER_TO_IMAGE2:
+      handle_copy_buffer_to_image(cmd, state);
+      break;
+   case VK_CMD_COPY_IMAGE_TO_BUFFER2:
+      handle_copy_image_to_buffer2(cmd, state);
+      break;
+   case VK_CMD_UPDATE_BUFFER:
+      handle_update_buffer(cmd, state);
+      break;
+   case VK_CMD_FILL_BUFFER:
+      handle_fill_buffer(cmd, state);
+      break;
+   case VK_CMD_CLEAR_COLOR_IMAGE:
+      handle_clear_color_image(cmd, state);
+      break;
+   case VK_CMD_CLEAR_DEPTH_STENCIL_IMAGE:
+      handle_clear_ds_image(cmd, state);
+      break;
+   case VK_CMD_CLEAR_ATTACHMENTS:
+      handle_clear_attachments(cmd, state);
+      break;
+   case VK_CMD_RESOLVE_IMAGE2:
+      handle_resolve_image(cmd, state);
+      break;
+   case VK_CMD_PIPELINE_BARRIER2:
+      handle_pipeline_barrier(cmd, state);
+      break;
+   case VK_CMD_BEGIN_QUERY_INDEXED_EXT:
+      handle_begin_query_indexed_ext(cmd, state);
+      break;
+   case VK_CMD_END_QUERY_INDEXED_EXT:
+      handle_end_query_indexed_ext(cmd, state);
+      break;
+   case VK_CMD_BEGIN_QUERY:
+      handle_begin_query(cmd, state);
+      break;
+   case VK_CMD_END_QUERY:
+      handle_end_query(cmd, state);
+      break;
+   case VK_CMD_RESET_QUERY_POOL:
+      handle_reset_query_pool(cmd, state);
+      break;
+   case VK_CMD_COPY_QUERY_POOL_RESULTS:
+      handle_copy_query_pool_results(cmd, state);
+      break;
+   case VK_CMD_PUSH_CONSTANTS2_KHR:
+      handle_push_constants(cmd, state);
+      break;
+   case VK_CMD_EXECUTE_COMMANDS:
+      handle_execute_commands(cmd, state, print_cmds);
+      break;
+   case VK_CMD_DRAW_INDIRECT_COUNT:
+      emit_state(state);
+      handle_draw_indirect_count(cmd, state, false);
+      break;
+   case VK_CMD_DRAW_INDEXED_INDIRECT_COUNT:
+      emit_state(state);
+      handle_draw_indirect_count(cmd, state, true);
+      break;
+   case VK_CMD_PUSH_DESCRIPTOR_SET2_KHR:
+      handle_push_descriptor_set(cmd, state);
+      break;
+   case VK_CMD_PUSH_DESCRIPTOR_SET_WITH_TEMPLATE2_KHR:
+      handle_push_descriptor_set_with_template(cmd, state);
+      break;
+   case VK_CMD_BIND_TRANSFORM_FEEDBACK_BUFFERS_EXT:
+      handle_bind_transform_feedback_buffers(cmd, state);
+      break;
+   case VK_CMD_BEGIN_TRANSFORM_FEEDBACK_EXT:
+      handle_begin_transform_feedback(cmd, state);
+      break;
+   case VK_CMD_END_TRANSFORM_FEEDBACK_EXT:
+      handle_end_transform_feedback(cmd, state);
+      break;
+   case VK_CMD_DRAW_INDIRECT_BYTE_COUNT_EXT:
+      emit_state(state);
+      handle_draw_indirect_byte_count(cmd, state);
+      break;
+   case VK_CMD_BEGIN_CONDITIONAL_RENDERING_EXT:
+      handle_begin_conditional_rendering(cmd, state);
+      break;
+   case VK_CMD_END_CONDITIONAL_RENDERING_EXT:
+      handle_end_conditional_rendering(state);
+      break;
+   case VK_CMD_SET_VERTEX_INPUT_EXT:
+      handle_set_vertex_input(cmd, state);
+      break;
+   case VK_CMD_SET_CULL_MODE:
+      handle_set_cull_mode(cmd, state);
+      break;
+   case VK_CMD_SET_FRONT_FACE:
+      handle_set_front_face(cmd, state);
+      break;
+   case VK_CMD_SET_PRIMITIVE_TOPOLOGY:
+      handle_set_primitive_topology(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_TEST_ENABLE:
+      handle_set_depth_test_enable(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_WRITE_ENABLE:
+      handle_set_depth_write_enable(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_COMPARE_OP:
+      handle_set_depth_compare_op(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_BOUNDS_TEST_ENABLE:
+      handle_set_depth_bounds_test_enable(cmd, state);
+      break;
+   case VK_CMD_SET_STENCIL_TEST_ENABLE:
+      handle_set_stencil_test_enable(cmd, state);
+      break;
+   case VK_CMD_SET_STENCIL_OP:
+      handle_set_stencil_op(cmd, state);
+      break;
+   case VK_CMD_SET_LINE_STIPPLE_KHR:
+      handle_set_line_stipple(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_BIAS_ENABLE:
+      handle_set_depth_bias_enable(cmd, state);
+      break;
+   case VK_CMD_SET_LOGIC_OP_EXT:
+      handle_set_logic_op(cmd, state);
+      break;
+   case VK_CMD_SET_PATCH_CONTROL_POINTS_EXT:
+      handle_set_patch_control_points(cmd, state);
+      break;
+   case VK_CMD_SET_PRIMITIVE_RESTART_ENABLE:
+      handle_set_primitive_restart_enable(cmd, state);
+      break;
+   case VK_CMD_SET_RASTERIZER_DISCARD_ENABLE:
+      handle_set_rasterizer_discard_enable(cmd, state);
+      break;
+   case VK_CMD_SET_COLOR_WRITE_ENABLE_EXT:
+      handle_set_color_write_enable(cmd, state);
+      break;
+   case VK_CMD_BEGIN_RENDERING:
+      handle_begin_rendering(cmd, state);
+      break;
+   case VK_CMD_END_RENDERING:
+      handle_end_rendering(cmd, state);
+      break;
+   case VK_CMD_SET_DEVICE_MASK:
+      /* no-op */
+      break;
+   case VK_CMD_RESET_EVENT2:
+      handle_event_reset2(cmd, state);
+      break;
+   case VK_CMD_SET_EVENT2:
+      handle_event_set2(cmd, state);
+      break;
+   case VK_CMD_WAIT_EVENTS2:
+      handle_wait_events2(cmd, state);
+      break;
+   case VK_CMD_WRITE_TIMESTAMP2:
+      handle_write_timestamp2(cmd, state);
+      break;
+   case VK_CMD_SET_POLYGON_MODE_EXT:
+      handle_set_polygon_mode(cmd, state);
+      break;
+   case VK_CMD_SET_TESSELLATION_DOMAIN_ORIGIN_EXT:
+      handle_set_tessellation_domain_origin(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_CLAMP_ENABLE_EXT:
+      handle_set_depth_clamp_enable(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_CLIP_ENABLE_EXT:
+      handle_set_depth_clip_enable(cmd, state);
+      break;
+   case VK_CMD_SET_LOGIC_OP_ENABLE_EXT:
+      handle_set_logic_op_enable(cmd, state);
+      break;
+   case VK_CMD_SET_SAMPLE_MASK_EXT:
+      handle_set_sample_mask(cmd, state);
+      break;
+   case VK_CMD_SET_RASTERIZATION_SAMPLES_EXT:
+      handle_set_samples(cmd, state);
+      break;
+   case VK_CMD_SET_ALPHA_TO_COVERAGE_ENABLE_EXT:
+      handle_set_alpha_to_coverage(cmd, state);
+      break;
+   case VK_CMD_SET_ALPHA_TO_ONE_ENABLE_EXT:
+      handle_set_alpha_to_one(cmd, state);
+      break;
+   case VK_CMD_SET_DEPTH_CLIP_NEGATIVE_ONE_TO_ONE_EXT:
+      handle_set_halfz(cmd, state);
+      break;
+   case VK_CMD_SET_LINE_RASTERIZATION_MODE_EXT:
+      handle_set_line_rasterization_mode(cmd, state);
+      break;
+   case VK_CMD_SET_LINE_STIPPLE_ENABLE_EXT:
+      handle_set_line_stipple_enable(cmd, state);
+      break;
+   case VK_CMD_SET_PROVOKING_VERTEX_MODE_EXT:
+      handle_set_provoking_vertex_mode(cmd, state);
+      break;
+   case VK_CMD_SET_COLOR_BLEND_ENABLE_EXT:
+      handle_set_color_blend_enable(cmd, state);
+      break;
+   case VK_CMD_SET_COLOR_WRITE_MASK_EXT:
+      handle_set_color_write_mask(cmd, state);
+      break;
+   case VK_CMD_SET_COLOR_BLEND_EQUATION_EXT:
+      handle_set_color_blend_equation(cmd, state);
+      break;
+   case VK_CMD_BIND_SHADERS_EXT:
+      handle_shaders(cmd, state);
+      break;
+   case VK_CMD_SET_ATTACHMENT_FEEDBACK_LOOP_ENABLE_EXT:
+      break;
+   case VK_CMD_DRAW_MESH_TASKS_EXT:
+      emit_state(state);
+      handle_draw_mesh_tasks(cmd, state);
+      break;
+   case VK_CMD_DRAW_MESH_TASKS_INDIRECT_EXT:
+      emit_state(state);
+      handle_draw_mesh_tasks_indirect(cmd, state);
+      break;
+   case VK_CMD_DRAW_MESH_TASKS_INDIRECT_COUNT_EXT:
+      emit_state(state);
+      handle_draw_mesh_tasks_indirect_count(cmd, state);
+      break;
+   case VK_CMD_BIND_PIPELINE_SHADER_GROUP_NV:
+      handle_graphics_pipeline_group(cmd, state);
+      break;
+   case VK_CMD_PREPROCESS_GENERATED_COMMANDS_NV:
+      handle_preprocess_generated_commands(cmd, state);
+      break;
+   case VK_CMD_EXECUTE_GENERATED_COMMANDS_NV:
+      handle_execute_generated_commands(cmd, state, print_cmds);
+      break;
+   case VK_CMD_BIND_DESCRIPTOR_BUFFERS_EXT:
+      handle_descriptor_buffers(cmd, state);
+      break;
+   case VK_CMD_SET_DESCRIPTOR_BUFFER_OFFSETS2_EXT:
+      handle_descriptor_buffer_offsets(cmd, state);
+      break;
+   case VK_CMD_BIND_DESCRIPTOR_BUFFER_EMBEDDED_SAMPLERS2_EXT:
+      handle_descriptor_buffer_embedded_samplers(cmd, state);
+      break;
+#ifdef VK_ENABLE_BETA_EXTENSIONS
+   case VK_CMD_INITIALIZE_GRAPH_SCRATCH_MEMORY_AMDX:
+      break;
+   case VK_CMD_DISPATCH_GRAPH_INDIRECT_COUNT_AMDX:
+      break;
+   case VK_CMD_DISPATCH_GRAPH_INDIRECT_AMDX:
+      break;
+   case VK_CMD_DISPATCH_GRAPH_AMDX:
+      handle_dispatch_graph(cmd, state);
+      break;
+#endif
+   case VK_CMD_SET_RENDERING_ATTACHMENT_LOCATIONS_KHR:
+      handle_rendering_attachment_locations(cmd, state);
+      break;
+   case VK_CMD_SET_RENDERING_INPUT_ATTACHMENT_INDICES_KHR:
+      handle_rendering_input_attachment_indices(cmd, state);
+      break;
+   default:
+      fprintf(stderr, "Unsupported command %s\n", vk_cmd_queue_type_names[cmd->type]);
+      unreachable("Unsupported command");
+      break;
+   }
+}
+
 static void lvp_execute_cmd_buffer(struct list_head *cmds,
                                    struct rendering_state *state, bool print_cmds)
 {
@@ -4462,371 +4845,311 @@ static void lvp_execute_cmd_buffer(struct list_head *cmds,
    LIST_FOR_EACH_ENTRY(cmd, cmds, cmd_link) {
       if (print_cmds)
          fprintf(stderr, "%s\n", vk_cmd_queue_type_names[cmd->type]);
-      switch (cmd->type) {
-      case VK_CMD_BIND_PIPELINE:
-         handle_pipeline(cmd, state);
-         break;
-      case VK_CMD_SET_VIEWPORT:
-         handle_set_viewport(cmd, state);
-         break;
-      case VK_CMD_SET_VIEWPORT_WITH_COUNT:
-         handle_set_viewport_with_count(cmd, state);
-         break;
-      case VK_CMD_SET_SCISSOR:
-         handle_set_scissor(cmd, state);
-         break;
-      case VK_CMD_SET_SCISSOR_WITH_COUNT:
-         handle_set_scissor_with_count(cmd, state);
-         break;
-      case VK_CMD_SET_LINE_WIDTH:
-         handle_set_line_width(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_BIAS:
-         handle_set_depth_bias(cmd, state);
-         break;
-      case VK_CMD_SET_BLEND_CONSTANTS:
-         handle_set_blend_constants(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_BOUNDS:
-         handle_set_depth_bounds(cmd, state);
-         break;
-      case VK_CMD_SET_STENCIL_COMPARE_MASK:
-         handle_set_stencil_compare_mask(cmd, state);
-         break;
-      case VK_CMD_SET_STENCIL_WRITE_MASK:
-         handle_set_stencil_write_mask(cmd, state);
-         break;
-      case VK_CMD_SET_STENCIL_REFERENCE:
-         handle_set_stencil_reference(cmd, state);
-         break;
-      case VK_CMD_BIND_DESCRIPTOR_SETS2_KHR:
-         handle_descriptor_sets_cmd(cmd, state);
-         break;
-      case VK_CMD_BIND_INDEX_BUFFER:
-         handle_index_buffer(cmd, state);
-         break;
-      case VK_CMD_BIND_INDEX_BUFFER2_KHR:
-         handle_index_buffer2(cmd, state);
-         break;
-      case VK_CMD_BIND_VERTEX_BUFFERS2:
-         handle_vertex_buffers2(cmd, state);
-         break;
-      case VK_CMD_DRAW:
-         emit_state(state);
-         handle_draw(cmd, state);
-         break;
-      case VK_CMD_DRAW_MULTI_EXT:
-         emit_state(state);
-         handle_draw_multi(cmd, state);
-         break;
-      case VK_CMD_DRAW_INDEXED:
-         emit_state(state);
-         handle_draw_indexed(cmd, state);
-         break;
-      case VK_CMD_DRAW_INDIRECT:
-         emit_state(state);
-         handle_draw_indirect(cmd, state, false);
-         break;
-      case VK_CMD_DRAW_INDEXED_INDIRECT:
-         emit_state(state);
-         handle_draw_indirect(cmd, state, true);
-         break;
-      case VK_CMD_DRAW_MULTI_INDEXED_EXT:
-         emit_state(state);
-         handle_draw_multi_indexed(cmd, state);
-         break;
-      case VK_CMD_DISPATCH:
-         emit_compute_state(state);
-         handle_dispatch(cmd, state);
-         break;
-      case VK_CMD_DISPATCH_BASE:
-         emit_compute_state(state);
-         handle_dispatch_base(cmd, state);
-         break;
-      case VK_CMD_DISPATCH_INDIRECT:
-         emit_compute_state(state);
-         handle_dispatch_indirect(cmd, state);
-         break;
-      case VK_CMD_COPY_BUFFER2:
-         handle_copy_buffer(cmd, state);
-         break;
-      case VK_CMD_COPY_IMAGE2:
-         handle_copy_image(cmd, state);
-         break;
-      case VK_CMD_BLIT_IMAGE2:
-         handle_blit_image(cmd, state);
-         break;
-      case VK_CMD_COPY_BUFFER_TO_IMAGE2:
-         handle_copy_buffer_to_image(cmd, state);
-         break;
-      case VK_CMD_COPY_IMAGE_TO_BUFFER2:
-         handle_copy_image_to_buffer2(cmd, state);
-         break;
-      case VK_CMD_UPDATE_BUFFER:
-         handle_update_buffer(cmd, state);
-         break;
-      case VK_CMD_FILL_BUFFER:
-         handle_fill_buffer(cmd, state);
-         break;
-      case VK_CMD_CLEAR_COLOR_IMAGE:
-         handle_clear_color_image(cmd, state);
-         break;
-      case VK_CMD_CLEAR_DEPTH_STENCIL_IMAGE:
-         handle_clear_ds_image(cmd, state);
-         break;
-      case VK_CMD_CLEAR_ATTACHMENTS:
-         handle_clear_attachments(cmd, state);
-         break;
-      case VK_CMD_RESOLVE_IMAGE2:
-         handle_resolve_image(cmd, state);
-         break;
-      case VK_CMD_PIPELINE_BARRIER2:
+      if (cmd->type == VK_CMD_PIPELINE_BARRIER2) {
          /* flushes are actually stalls, so multiple flushes are redundant */
          if (did_flush)
             continue;
-         handle_pipeline_barrier(cmd, state);
          did_flush = true;
-         continue;
-      case VK_CMD_BEGIN_QUERY_INDEXED_EXT:
-         handle_begin_query_indexed_ext(cmd, state);
-         break;
-      case VK_CMD_END_QUERY_INDEXED_EXT:
-         handle_end_query_indexed_ext(cmd, state);
-         break;
-      case VK_CMD_BEGIN_QUERY:
-         handle_begin_query(cmd, state);
-         break;
-      case VK_CMD_END_QUERY:
-         handle_end_query(cmd, state);
-         break;
-      case VK_CMD_RESET_QUERY_POOL:
-         handle_reset_query_pool(cmd, state);
-         break;
-      case VK_CMD_COPY_QUERY_POOL_RESULTS:
-         handle_copy_query_pool_results(cmd, state);
-         break;
-      case VK_CMD_PUSH_CONSTANTS2_KHR:
-         handle_push_constants(cmd, state);
-         break;
-      case VK_CMD_EXECUTE_COMMANDS:
-         handle_execute_commands(cmd, state, print_cmds);
-         break;
-      case VK_CMD_DRAW_INDIRECT_COUNT:
-         emit_state(state);
-         handle_draw_indirect_count(cmd, state, false);
-         break;
-      case VK_CMD_DRAW_INDEXED_INDIRECT_COUNT:
-         emit_state(state);
-         handle_draw_indirect_count(cmd, state, true);
-         break;
-      case VK_CMD_PUSH_DESCRIPTOR_SET2_KHR:
-         handle_push_descriptor_set(cmd, state);
-         break;
-      case VK_CMD_PUSH_DESCRIPTOR_SET_WITH_TEMPLATE2_KHR:
-         handle_push_descriptor_set_with_template(cmd, state);
-         break;
-      case VK_CMD_BIND_TRANSFORM_FEEDBACK_BUFFERS_EXT:
-         handle_bind_transform_feedback_buffers(cmd, state);
-         break;
-      case VK_CMD_BEGIN_TRANSFORM_FEEDBACK_EXT:
-         handle_begin_transform_feedback(cmd, state);
-         break;
-      case VK_CMD_END_TRANSFORM_FEEDBACK_EXT:
-         handle_end_transform_feedback(cmd, state);
-         break;
-      case VK_CMD_DRAW_INDIRECT_BYTE_COUNT_EXT:
-         emit_state(state);
-         handle_draw_indirect_byte_count(cmd, state);
-         break;
-      case VK_CMD_BEGIN_CONDITIONAL_RENDERING_EXT:
-         handle_begin_conditional_rendering(cmd, state);
-         break;
-      case VK_CMD_END_CONDITIONAL_RENDERING_EXT:
-         handle_end_conditional_rendering(state);
-         break;
-      case VK_CMD_SET_VERTEX_INPUT_EXT:
-         handle_set_vertex_input(cmd, state);
-         break;
-      case VK_CMD_SET_CULL_MODE:
-         handle_set_cull_mode(cmd, state);
-         break;
-      case VK_CMD_SET_FRONT_FACE:
-         handle_set_front_face(cmd, state);
-         break;
-      case VK_CMD_SET_PRIMITIVE_TOPOLOGY:
-         handle_set_primitive_topology(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_TEST_ENABLE:
-         handle_set_depth_test_enable(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_WRITE_ENABLE:
-         handle_set_depth_write_enable(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_COMPARE_OP:
-         handle_set_depth_compare_op(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_BOUNDS_TEST_ENABLE:
-         handle_set_depth_bounds_test_enable(cmd, state);
-         break;
-      case VK_CMD_SET_STENCIL_TEST_ENABLE:
-         handle_set_stencil_test_enable(cmd, state);
-         break;
-      case VK_CMD_SET_STENCIL_OP:
-         handle_set_stencil_op(cmd, state);
-         break;
-      case VK_CMD_SET_LINE_STIPPLE_KHR:
-         handle_set_line_stipple(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_BIAS_ENABLE:
-         handle_set_depth_bias_enable(cmd, state);
-         break;
-      case VK_CMD_SET_LOGIC_OP_EXT:
-         handle_set_logic_op(cmd, state);
-         break;
-      case VK_CMD_SET_PATCH_CONTROL_POINTS_EXT:
-         handle_set_patch_control_points(cmd, state);
-         break;
-      case VK_CMD_SET_PRIMITIVE_RESTART_ENABLE:
-         handle_set_primitive_restart_enable(cmd, state);
-         break;
-      case VK_CMD_SET_RASTERIZER_DISCARD_ENABLE:
-         handle_set_rasterizer_discard_enable(cmd, state);
-         break;
-      case VK_CMD_SET_COLOR_WRITE_ENABLE_EXT:
-         handle_set_color_write_enable(cmd, state);
-         break;
-      case VK_CMD_BEGIN_RENDERING:
-         handle_begin_rendering(cmd, state);
-         break;
-      case VK_CMD_END_RENDERING:
-         handle_end_rendering(cmd, state);
-         break;
-      case VK_CMD_SET_DEVICE_MASK:
-         /* no-op */
-         break;
-      case VK_CMD_RESET_EVENT2:
-         handle_event_reset2(cmd, state);
-         break;
-      case VK_CMD_SET_EVENT2:
-         handle_event_set2(cmd, state);
-         break;
-      case VK_CMD_WAIT_EVENTS2:
-         handle_wait_events2(cmd, state);
-         break;
-      case VK_CMD_WRITE_TIMESTAMP2:
-         handle_write_timestamp2(cmd, state);
-         break;
-      case VK_CMD_SET_POLYGON_MODE_EXT:
-         handle_set_polygon_mode(cmd, state);
-         break;
-      case VK_CMD_SET_TESSELLATION_DOMAIN_ORIGIN_EXT:
-         handle_set_tessellation_domain_origin(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_CLAMP_ENABLE_EXT:
-         handle_set_depth_clamp_enable(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_CLIP_ENABLE_EXT:
-         handle_set_depth_clip_enable(cmd, state);
-         break;
-      case VK_CMD_SET_LOGIC_OP_ENABLE_EXT:
-         handle_set_logic_op_enable(cmd, state);
-         break;
-      case VK_CMD_SET_SAMPLE_MASK_EXT:
-         handle_set_sample_mask(cmd, state);
-         break;
-      case VK_CMD_SET_RASTERIZATION_SAMPLES_EXT:
-         handle_set_samples(cmd, state);
-         break;
-      case VK_CMD_SET_ALPHA_TO_COVERAGE_ENABLE_EXT:
-         handle_set_alpha_to_coverage(cmd, state);
-         break;
-      case VK_CMD_SET_ALPHA_TO_ONE_ENABLE_EXT:
-         handle_set_alpha_to_one(cmd, state);
-         break;
-      case VK_CMD_SET_DEPTH_CLIP_NEGATIVE_ONE_TO_ONE_EXT:
-         handle_set_halfz(cmd, state);
-         break;
-      case VK_CMD_SET_LINE_RASTERIZATION_MODE_EXT:
-         handle_set_line_rasterization_mode(cmd, state);
-         break;
-      case VK_CMD_SET_LINE_STIPPLE_ENABLE_EXT:
-         handle_set_line_stipple_enable(cmd, state);
-         break;
-      case VK_CMD_SET_PROVOKING_VERTEX_MODE_EXT:
-         handle_set_provoking_vertex_mode(cmd, state);
-         break;
-      case VK_CMD_SET_COLOR_BLEND_ENABLE_EXT:
-         handle_set_color_blend_enable(cmd, state);
-         break;
-      case VK_CMD_SET_COLOR_WRITE_MASK_EXT:
-         handle_set_color_write_mask(cmd, state);
-         break;
-      case VK_CMD_SET_COLOR_BLEND_EQUATION_EXT:
-         handle_set_color_blend_equation(cmd, state);
-         break;
-      case VK_CMD_BIND_SHADERS_EXT:
-         handle_shaders(cmd, state);
-         break;
-      case VK_CMD_SET_ATTACHMENT_FEEDBACK_LOOP_ENABLE_EXT:
-         break;
-      case VK_CMD_DRAW_MESH_TASKS_EXT:
-         emit_state(state);
-         handle_draw_mesh_tasks(cmd, state);
-         break;
-      case VK_CMD_DRAW_MESH_TASKS_INDIRECT_EXT:
-         emit_state(state);
-         handle_draw_mesh_tasks_indirect(cmd, state);
-         break;
-      case VK_CMD_DRAW_MESH_TASKS_INDIRECT_COUNT_EXT:
-         emit_state(state);
-         handle_draw_mesh_tasks_indirect_count(cmd, state);
-         break;
-      case VK_CMD_BIND_PIPELINE_SHADER_GROUP_NV:
-         handle_graphics_pipeline_group(cmd, state);
-         break;
-      case VK_CMD_PREPROCESS_GENERATED_COMMANDS_NV:
-         handle_preprocess_generated_commands(cmd, state);
-         break;
-      case VK_CMD_EXECUTE_GENERATED_COMMANDS_NV:
-         handle_execute_generated_commands(cmd, state, print_cmds);
-         break;
-      case VK_CMD_BIND_DESCRIPTOR_BUFFERS_EXT:
-         handle_descriptor_buffers(cmd, state);
-         break;
-      case VK_CMD_SET_DESCRIPTOR_BUFFER_OFFSETS2_EXT:
-         handle_descriptor_buffer_offsets(cmd, state);
-         break;
-      case VK_CMD_BIND_DESCRIPTOR_BUFFER_EMBEDDED_SAMPLERS2_EXT:
-         handle_descriptor_buffer_embedded_samplers(cmd, state);
-         break;
-#ifdef VK_ENABLE_BETA_EXTENSIONS
-      case VK_CMD_INITIALIZE_GRAPH_SCRATCH_MEMORY_AMDX:
-         break;
-      case VK_CMD_DISPATCH_GRAPH_INDIRECT_COUNT_AMDX:
-         break;
-      case VK_CMD_DISPATCH_GRAPH_INDIRECT_AMDX:
-         break;
-      case VK_CMD_DISPATCH_GRAPH_AMDX:
-         handle_dispatch_graph(cmd, state);
-         break;
-#endif
-      case VK_CMD_SET_RENDERING_ATTACHMENT_LOCATIONS_KHR:
-         handle_rendering_attachment_locations(cmd, state);
-         break;
-      case VK_CMD_SET_RENDERING_INPUT_ATTACHMENT_INDICES_KHR:
-         handle_rendering_input_attachment_indices(cmd, state);
-         break;
-      default:
-         fprintf(stderr, "Unsupported command %s\n", vk_cmd_queue_type_names[cmd->type]);
-         unreachable("Unsupported command");
-         break;
+      } else {
+         did_flush = false;
       }
-      did_flush = false;
+      lvp_execute_cmd(cmd, state, print_cmds);
       if (!cmd->cmd_link.next)
          break;
    }
 }
 
+static void lvp_execute_cmd_stream(const struct lvp_cmd_buffer *cmd_buffer,
+                                   struct rendering_state *state, bool print_cmds)
+{
+   util_dynarray_foreach(&cmd_buffer->stream, struct vk_cmd_queue_entry *, cmd) {
+      if (print_cmds)
+         fprintf(stderr, "%s\n", vk_cmd_queue_type_names[(*cmd)->type]);
+      lvp_execute_cmd(*cmd, state, print_cmds);
+   }
+}
+
+/* Dynamic state commands which set nothing but the state they are named
+ * after.  Setting it again to the same value is a no-op, until something
+ * else (e.g. a pipeline bind) may have changed it.
+ */
+enum lvp_plain_state {
+   LVP_PLAIN_STATE_LINE_WIDTH,
+   LVP_PLAIN_STATE_DEPTH_BIAS,
+   LVP_PLAIN_STATE_BLEND_CONSTANTS,
+   LVP_PLAIN_STATE_DEPTH_BOUNDS,
+   LVP_PLAIN_STATE_CULL_MODE,
+   LVP_PLAIN_STATE_FRONT_FACE,
+   LVP_PLAIN_STATE_PRIMITIVE_TOPOLOGY,
+   LVP_PLAIN_STATE_DEPTH_TEST_ENABLE,
+   LVP_PLAIN_STATE_DEPTH_WRITE_ENABLE,
+   LVP_PLAIN_STATE_DEPTH_COMPARE_OP,
+   LVP_PLAIN_STATE_DEPTH_BOUNDS_TEST_ENABLE,
+   LVP_PLAIN_STATE_STENCIL_TEST_ENABLE,
+   LVP_PLAIN_STATE_DEPTH_BIAS_ENABLE,
+   LVP_PLAIN_STATE_PRIMITIVE_RESTART_ENABLE,
+   LVP_PLAIN_STATE_RASTERIZER_DISCARD_ENABLE,
+   LVP_PLAIN_STATE_COUNT,
+   LVP_PLAIN_STATE_NONE = LVP_PLAIN_STATE_COUNT,
+};
+
+static enum lvp_plain_state
+get_plain_state(enum vk_cmd_type type)
+{
+   switch (type) {
+   case VK_CMD_SET_LINE_WIDTH:
+      return LVP_PLAIN_STATE_LINE_WIDTH;
+   case VK_CMD_SET_DEPTH_BIAS:
+      return LVP_PLAIN_STATE_DEPTH_BIAS;
+   case VK_CMD_SET_BLEND_CONSTANTS:
+      return LVP_PLAIN_STATE_BLEND_CONSTANTS;
+   case VK_CMD_SET_DEPTH_BOUNDS:
+      return LVP_PLAIN_STATE_DEPTH_BOUNDS;
+   case VK_CMD_SET_CULL_MODE:
+      return LVP_PLAIN_STATE_CULL_MODE;
+   case VK_CMD_SET_FRONT_FACE:
+      return LVP_PLAIN_STATE_FRONT_FACE;
+   case VK_CMD_SET_PRIMITIVE_TOPOLOGY:
+      return LVP_PLAIN_STATE_PRIMITIVE_TOPOLOGY;
+   case VK_CMD_SET_DEPTH_TEST_ENABLE:
+      return LVP_PLAIN_STATE_DEPTH_TEST_ENABLE;
+   case VK_CMD_SET_DEPTH_WRITE_ENABLE:
+      return LVP_PLAIN_STATE_DEPTH_WRITE_ENABLE;
+   case VK_CMD_SET_DEPTH_COMPARE_OP:
+      return LVP_PLAIN_STATE_DEPTH_COMPARE_OP;
+   case VK_CMD_SET_DEPTH_BOUNDS_TEST_ENABLE:
+      return LVP_PLAIN_STATE_DEPTH_BOUNDS_TEST_ENABLE;
+   case VK_CMD_SET_STENCIL_TEST_ENABLE:
+      return LVP_PLAIN_STATE_STENCIL_TEST_ENABLE;
+   case VK_CMD_SET_DEPTH_BIAS_ENABLE:
+      return LVP_PLAIN_STATE_DEPTH_BIAS_ENABLE;
+   case VK_CMD_SET_PRIMITIVE_RESTART_ENABLE:
+      return LVP_PLAIN_STATE_PRIMITIVE_RESTART_ENABLE;
+   case VK_CMD_SET_RASTERIZER_DISCARD_ENABLE:
+      return LVP_PLAIN_STATE_RASTERIZER_DISCARD_ENABLE;
+   default:
+      return LVP_PLAIN_STATE_NONE;
+   }
+}
+
+/* Commands which don't touch any of the plain state above. */
+static bool
+keeps_plain_state(enum vk_cmd_type type)
+{
+   switch (type) {
+   case VK_CMD_DRAW:
+   case VK_CMD_DRAW_INDEXED:
+   case VK_CMD_DRAW_INDIRECT:
+   case VK_CMD_DRAW_INDEXED_INDIRECT:
+   case VK_CMD_DRAW_MULTI_EXT:
+   case VK_CMD_DRAW_MULTI_INDEXED_EXT:
+   case VK_CMD_DRAW_INDIRECT_COUNT:
+   case VK_CMD_DRAW_INDEXED_INDIRECT_COUNT:
+   case VK_CMD_DISPATCH:
+   case VK_CMD_DISPATCH_BASE:
+   case VK_CMD_DISPATCH_INDIRECT:
+   case VK_CMD_BIND_DESCRIPTOR_SETS2_KHR:
+   case VK_CMD_BIND_INDEX_BUFFER:
+   case VK_CMD_BIND_INDEX_BUFFER2_KHR:
+   case VK_CMD_BIND_VERTEX_BUFFERS2:
+   case VK_CMD_PUSH_CONSTANTS2_KHR:
+   case VK_CMD_SET_VIEWPORT:
+   case VK_CMD_SET_VIEWPORT_WITH_COUNT:
+   case VK_CMD_SET_SCISSOR:
+   case VK_CMD_SET_SCISSOR_WITH_COUNT:
+   case VK_CMD_SET_STENCIL_COMPARE_MASK:
+   case VK_CMD_SET_STENCIL_WRITE_MASK:
+   case VK_CMD_SET_STENCIL_REFERENCE:
+   case VK_CMD_PIPELINE_BARRIER2:
+      return true;
+   default:
+      return get_plain_state(type) != LVP_PLAIN_STATE_NONE;
+   }
+}
+
+struct lvp_cmd_compile_state {
+   struct lvp_cmd_buffer *cmd_buffer;
+   struct util_dynarray *stream;
+   struct vk_cmd_queue_entry *plain_state[LVP_PLAIN_STATE_COUNT];
+   bool did_flush;
+};
+
+static void
+compile_reset_plain_state(struct lvp_cmd_compile_state *cs)
+{
+   memset(cs->plain_state, 0, sizeof(cs->plain_state));
+}
+
+struct lvp_resolved_descriptor_sets {
+   struct vk_cmd_queue_entry cmd;
+   VkBindDescriptorSetsInfoKHR info;
+   VkDescriptorSet sets[];
+};
+
+/**
+ * Applies the dynamic offsets of a descriptor set bind once, instead of
+ * copying the sets on every submit, and returns the bind of the copies.
+ *
+ * Updating a set invalidates the command buffers it is bound in, so the
+ * copies stay valid for as long as the command buffer, unless the layout
+ * allows updates after bind.  Such sets are copied at execution, like in
+ * command buffers which are only submitted once.
+ */
+static struct vk_cmd_queue_entry *
+compile_descriptor_sets(struct lvp_cmd_compile_state *cs, struct vk_cmd_queue_entry *cmd)
+{
+   const VkBindDescriptorSetsInfoKHR *bds = cmd->u.bind_descriptor_sets2_khr.bind_descriptor_sets_info;
+   LVP_FROM_HANDLE(lvp_pipeline_layout, layout, bds->layout);
+   struct lvp_cmd_buffer *cmd_buffer = cs->cmd_buffer;
+
+   if (!bds->dynamicOffsetCount)
+      return cmd;
+
+   for (uint32_t i = 0; i < bds->descriptorSetCount; i++) {
+      struct lvp_descriptor_set *set = lvp_descriptor_set_from_handle(bds->pDescriptorSets[i]);
+      if (set && set->layout->update_after_bind)
+         return cmd;
+   }
+
+   struct lvp_resolved_descriptor_sets *resolved =
+      calloc(1, sizeof(*resolved) + bds->descriptorSetCount * sizeof(VkDescriptorSet));
+   if (!resolved)
+      return cmd;
+
+   resolved->cmd.type = cmd->type;
+   resolved->cmd.u.bind_descriptor_sets2_khr.bind_descriptor_sets_info = &resolved->info;
+   resolved->info = *bds;
+   resolved->info.pDescriptorSets = resolved->sets;
+   resolved->info.dynamicOffsetCount = 0;
+   resolved->info.pDynamicOffsets = NULL;
+   util_dynarray_append(&cmd_buffer->resolved_cmds, struct lvp_resolved_descriptor_sets *, resolved);
+
+   /* consume the offsets the way handle_descriptor_sets() does */
+   uint32_t dynamic_offset_index = 0;
+   for (uint32_t i = 0; i < bds->descriptorSetCount; i++) {
+      struct lvp_descriptor_set *set = lvp_descriptor_set_from_handle(bds->pDescriptorSets[i]);
+
+      resolved->sets[i] = bds->pDescriptorSets[i];
+      if (!layout->vk.set_layouts[bds->firstSet + i] || !set)
+         continue;
+
+      if (dynamic_offset_index < bds->dynamicOffsetCount) {
+         set = create_dynamic_offset_set(cmd_buffer->device, set,
+                                         bds->pDynamicOffsets + dynamic_offset_index,
+                                         bds->dynamicOffsetCount - dynamic_offset_index);
+         util_dynarray_append(&cmd_buffer->resolved_sets, struct lvp_descriptor_set *, set);
+         resolved->sets[i] = lvp_descriptor_set_to_handle(set);
+      }
+
+      dynamic_offset_index += set->layout->dynamic_offset_count;
+   }
+
+   return &resolved->cmd;
+}
+
+/**
+ * Frees what lvp_compile_cmd_buffer() created for a command buffer.
+ */
+void
+lvp_cmd_buffer_free_resolved(struct lvp_cmd_buffer *cmd_buffer)
+{
+   util_dynarray_foreach(&cmd_buffer->resolved_sets, struct lvp_descriptor_set *, set)
+      lvp_descriptor_set_destroy(cmd_buffer->device, *set);
+   util_dynarray_foreach(&cmd_buffer->resolved_cmds, struct lvp_resolved_descriptor_sets *, resolved)
+      free(*resolved);
+   util_dynarray_clear(&cmd_buffer->resolved_sets);
+   util_dynarray_clear(&cmd_buffer->resolved_cmds);
+}
+
+static void
+compile_cmd(struct lvp_cmd_compile_state *cs, struct vk_cmd_queue_entry *cmd)
+{
+   const enum lvp_plain_state plain = get_plain_state(cmd->type);
+
+   switch (cmd->type) {
+   case VK_CMD_SET_DEVICE_MASK:
+   case VK_CMD_SET_ATTACHMENT_FEEDBACK_LOOP_ENABLE_EXT:
+      return;
+   case VK_CMD_PIPELINE_BARRIER2:
+      /* flushes are actually stalls, so multiple flushes are redundant */
+      if (cs->did_flush)
+         return;
+      break;
+   case VK_CMD_BIND_DESCRIPTOR_SETS2_KHR:
+      cmd = compile_descriptor_sets(cs, cmd);
+      break;
+   case VK_CMD_EXECUTE_COMMANDS: {
+      bool all_compiled = true;
+
+      for (unsigned i = 0; i < cmd->u.execute_commands.command_buffer_count; i++) {
+         LVP_FROM_HANDLE(lvp_cmd_buffer, secondary_buf, cmd->u.execute_commands.command_buffers[i]);
+         all_compiled &= secondary_buf->compiled;
+      }
+      if (!all_compiled)
+         break;
+
+      /* Splice the secondaries' streams in, they are already compiled.
+       * Secondaries don't inherit state, so tracking starts over.
+       */
+      for (unsigned i = 0; i < cmd->u.execute_commands.command_buffer_count; i++) {
+         LVP_FROM_HANDLE(lvp_cmd_buffer, secondary_buf, cmd->u.execute_commands.command_buffers[i]);
+         util_dynarray_foreach(&secondary_buf->stream, struct vk_cmd_queue_entry *, sec_cmd) {
+            if ((*sec_cmd)->type == VK_CMD_PIPELINE_BARRIER2 && cs->did_flush)
+               continue;
+            util_dynarray_append(cs->stream, struct vk_cmd_queue_entry *, *sec_cmd);
+            cs->did_flush = (*sec_cmd)->type == VK_CMD_PIPELINE_BARRIER2;
+         }
+      }
+      compile_reset_plain_state(cs);
+      return;
+   }
+   default:
+      break;
+   }
+
+   if (plain != LVP_PLAIN_STATE_NONE) {
+      const struct vk_cmd_queue_entry *prev = cs->plain_state[plain];
+      const size_t size = vk_cmd_queue_type_sizes[cmd->type] -
+                          offsetof(struct vk_cmd_queue_entry, u);
+
+      /* Entries are zero-allocated, so padding compares equal too. */
+      if (prev && !memcmp(&prev->u, &cmd->u, size))
+         return;
+      cs->plain_state[plain] = cmd;
+   } else if (!keeps_plain_state(cmd->type)) {
+      compile_reset_plain_state(cs);
+   }
+
+   util_dynarray_append(cs->stream, struct vk_cmd_queue_entry *, cmd);
+   cs->did_flush = cmd->type == VK_CMD_PIPELINE_BARRIER2;
+}
+
+/**
+ * Flatten a command buffer that may be submitted several times into an
+ * array of the commands that need executing, so replaying it doesn't
+ * have to walk nested lists.  Commands which are no-ops, back-to-back
+ * barriers and dynamic state set again to the same value are dropped,
+ * and the streams of compiled secondaries are inlined.
+ */
+void
+lvp_compile_cmd_buffer(struct lvp_cmd_buffer *cmd_buffer)
+{
+   struct lvp_cmd_compile_state cs = {
+      .cmd_buffer = cmd_buffer,
+      .stream = &cmd_buffer->stream,
+   };
+   struct vk_cmd_queue_entry *cmd;
+
+   util_dynarray_clear(&cmd_buffer->stream);
+   lvp_cmd_buffer_free_resolved(cmd_buffer);
+
+   LIST_FOR_EACH_ENTRY(cmd, &cmd_buffer->vk.cmd_queue.cmds, cmd_link) {
+      compile_cmd(&cs, cmd);
+   }
+
+   cmd_buffer->compiled = true;
+}
+
 VkResult lvp_execute_cmds(struct lvp_device *device,
                           struct lvp_queue *queue,
                           struct lvp_cmd_buffer *cmd_buffer)
@@ -4835,6 +5158,7 @@ VkResult lvp_execute_cmds(struct lvp_device *device,
    memset(state, 0, sizeof(*state));
    state->pctx = queue->ctx;
    state->device = device;
+   state->queue = queue;
    state->uploader = queue->uploader;
    state->cso = queue->cso;
    state->blend_dirty = true;
@@ -4869,7 +5193,10 @@ VkResult lvp_execute_cmds(struct lvp_device *device,
    state->index_buffer = state->device->zero_buffer;
 
    /* create a gallium context */
-   lvp_execute_cmd_buffer(&cmd_buffer->vk.cmd_queue.cmds, state, device->print_cmds);
+   if (cmd_buffer->compiled)
+      lvp_execute_cmd_stream(cmd_buffer, state, device->print_cmds);
+   else
+      lvp_execute_cmd_buffer(&cmd_buffer->vk.cmd_queue.cmds, state, device->print_cmds);
 
    state->start_vb = -1;
    state->num_vb = 0;
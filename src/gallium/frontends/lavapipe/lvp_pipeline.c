@@ -42,37 +42,63 @@
 
 typedef void (*cso_destroy_func)(struct pipe_context*, void*);
 
+static void
+delete_shader_state(struct pipe_context *ctx, gl_shader_stage stage, void *cso)
+{
+   cso_destroy_func destroy[] = {
+      ctx->delete_vs_state,
+      ctx->delete_tcs_state,
+      ctx->delete_tes_state,
+      ctx->delete_gs_state,
+      ctx->delete_fs_state,
+      ctx->delete_compute_state,
+      ctx->delete_ts_state,
+      ctx->delete_ms_state,
+   };
+
+   destroy[stage](ctx, cso);
+}
+
 static void
 shader_destroy(struct lvp_device *device, struct lvp_shader *shader, bool locked)
 {
    if (!shader->pipeline_nir)
       return;
    gl_shader_stage stage = shader->pipeline_nir->nir->info.stage;
-   cso_destroy_func destroy[] = {
-      device->queue.ctx->delete_vs_state,
-      device->queue.ctx->delete_tcs_state,
-      device->queue.ctx->delete_tes_state,
-      device->queue.ctx->delete_gs_state,
-      device->queue.ctx->delete_fs_state,
-      device->queue.ctx->delete_compute_state,
-      device->queue.ctx->delete_ts_state,
-      device->queue.ctx->delete_ms_state,
-   };
 
    if (!locked)
       simple_mtx_lock(&device->queue.lock);
 
+   /* The states of the other queues are deleted under the lock of their
+    * queue, which may be translating commands on its context.
+    */
    set_foreach(&shader->inlines.variants, entry) {
       struct lvp_inline_variant *variant = (void*)entry->key;
-      destroy[stage](device->queue.ctx, variant->cso);
+      struct lvp_queue *queue = lvp_device_get_queue(device, variant->queue);
+      if (variant->queue)
+         simple_mtx_lock(&queue->lock);
+      delete_shader_state(queue->ctx, stage, variant->cso);
+      if (variant->queue)
+         simple_mtx_unlock(&queue->lock);
       free(variant);
    }
    ralloc_free(shader->inlines.variants.table);
+   simple_mtx_destroy(&shader->inlines.lock);
 
    if (shader->shader_cso)
-      destroy[stage](device->queue.ctx, shader->shader_cso);
+      delete_shader_state(device->queue.ctx, stage, shader->shader_cso);
    if (shader->tess_ccw_cso)
-      destroy[stage](device->queue.ctx, shader->tess_ccw_cso);
+      delete_shader_state(device->queue.ctx, stage, shader->tess_ccw_cso);
+   for (uint32_t i = 0; i < device->num_extra_queues; i++) {
+      if (!shader->queue_csos[i][0] && !shader->queue_csos[i][1])
+         continue;
+      simple_mtx_lock(&device->extra_queues[i].lock);
+      for (unsigned j = 0; j < 2; j++) {
+         if (shader->queue_csos[i][j])
+            delete_shader_state(device->extra_queues[i].ctx, stage, shader->queue_csos[i][j]);
+      }
+      simple_mtx_unlock(&device->extra_queues[i].lock);
+   }
 
    if (!locked)
       simple_mtx_unlock(&device->queue.lock);
@@ -363,6 +389,8 @@ inline_variant_equals(const void *a, const void *b)
 {
    const struct lvp_inline_variant *av = a, *bv = b;
    assert(av->mask == bv->mask);
+   if (av->queue != bv->queue)
+      return false;
    u_foreach_bit(slot, av->mask) {
       if (memcmp(av->vals[slot], bv->vals[slot], sizeof(av->vals[slot])))
          return false;
@@ -505,6 +533,7 @@ lvp_shader_init(struct lvp_shader *shader, nir_shader *nir)
    shader->pipeline_nir = create_pipeline_nir(nir);
    if (shader->inlines.can_inline)
       _mesa_set_init(&shader->inlines.variants, NULL, NULL, inline_variant_equals);
+   simple_mtx_init(&shader->inlines.lock, mtx_plain);
 }
 
 static VkResult
@@ -524,6 +553,63 @@ lvp_shader_compile_to_ir(struct lvp_pipeline *pipeline,
    return result;
 }
 
+struct lvp_stage_job {
+   struct util_queue_fence fence;
+   struct lvp_pipeline *pipeline;
+   const VkPipelineShaderStageCreateInfo *sinfo;
+   VkResult result;
+};
+
+static void
+stage_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct lvp_stage_job *job = data;
+
+   job->result = lvp_shader_compile_to_ir(job->pipeline, job->sinfo);
+}
+
+/* Stages only write their own lvp_shader, so they can be translated
+ * concurrently.  Must not be called from the compile queue itself, which
+ * could then end up waiting on its own jobs.
+ */
+static VkResult
+lvp_shader_compile_stages_to_ir(struct lvp_pipeline *pipeline,
+                                const VkPipelineShaderStageCreateInfo **stages,
+                                unsigned num_stages, bool parallel)
+{
+   struct lvp_device *device = pipeline->device;
+   struct lvp_stage_job jobs[LVP_SHADER_STAGES];
+   VkResult result;
+
+   if (!parallel || !device->num_compile_threads || num_stages < 2) {
+      for (unsigned i = 0; i < num_stages; i++) {
+         result = lvp_shader_compile_to_ir(pipeline, stages[i]);
+         if (result != VK_SUCCESS)
+            return result;
+      }
+      return VK_SUCCESS;
+   }
+
+   /* the first stage is done on this thread while the queue does the rest */
+   for (unsigned i = 1; i < num_stages; i++) {
+      jobs[i].pipeline = pipeline;
+      jobs[i].sinfo = stages[i];
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(&device->compile_queue, &jobs[i], &jobs[i].fence,
+                         stage_job_execute, NULL, 0);
+   }
+
+   result = lvp_shader_compile_to_ir(pipeline, stages[0]);
+
+   for (unsigned i = 1; i < num_stages; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+      if (result == VK_SUCCESS)
+         result = jobs[i].result;
+   }
+   return result;
+}
+
 static void
 merge_tess_info(struct shader_info *tes_info,
                 const struct shader_info *tcs_info)
@@ -610,14 +696,14 @@ lvp_pipeline_xfb_init(struct lvp_pipeline *pipeline)
 }
 
 static void *
-lvp_shader_compile_stage(struct lvp_device *device, struct lvp_shader *shader, nir_shader *nir)
+lvp_shader_compile_stage(struct pipe_context *ctx, struct lvp_shader *shader, nir_shader *nir)
 {
    if (nir->info.stage == MESA_SHADER_COMPUTE) {
       struct pipe_compute_state shstate = {0};
       shstate.prog = nir;
       shstate.ir_type = PIPE_SHADER_IR_NIR;
       shstate.static_shared_mem = nir->info.shared_size;
-      return device->queue.ctx->create_compute_state(device->queue.ctx, &shstate);
+      return ctx->create_compute_state(ctx, &shstate);
    } else {
       struct pipe_shader_state shstate = {0};
       shstate.type = PIPE_SHADER_IR_NIR;
@@ -626,19 +712,19 @@ lvp_shader_compile_stage(struct lvp_device *device, struct lvp_shader *shader, n
 
       switch (nir->info.stage) {
       case MESA_SHADER_FRAGMENT:
-         return device->queue.ctx->create_fs_state(device->queue.ctx, &shstate);
+         return ctx->create_fs_state(ctx, &shstate);
       case MESA_SHADER_VERTEX:
-         return device->queue.ctx->create_vs_state(device->queue.ctx, &shstate);
+         return ctx->create_vs_state(ctx, &shstate);
       case MESA_SHADER_GEOMETRY:
-         return device->queue.ctx->create_gs_state(device->queue.ctx, &shstate);
+         return ctx->create_gs_state(ctx, &shstate);
       case MESA_SHADER_TESS_CTRL:
-         return device->queue.ctx->create_tcs_state(device->queue.ctx, &shstate);
+         return ctx->create_tcs_state(ctx, &shstate);
       case MESA_SHADER_TESS_EVAL:
-         return device->queue.ctx->create_tes_state(device->queue.ctx, &shstate);
+         return ctx->create_tes_state(ctx, &shstate);
       case MESA_SHADER_TASK:
-         return device->queue.ctx->create_ts_state(device->queue.ctx, &shstate);
+         return ctx->create_ts_state(ctx, &shstate);
       case MESA_SHADER_MESH:
-         return device->queue.ctx->create_ms_state(device->queue.ctx, &shstate);
+         return ctx->create_ms_state(ctx, &shstate);
       default:
          unreachable("illegal shader");
          break;
@@ -655,7 +741,7 @@ lvp_shader_compile(struct lvp_device *device, struct lvp_shader *shader, nir_sha
    if (!locked)
       simple_mtx_lock(&device->queue.lock);
 
-   void *state = lvp_shader_compile_stage(device, shader, nir);
+   void *state = lvp_shader_compile_stage(device->queue.ctx, shader, nir);
 
    if (!locked)
       simple_mtx_unlock(&device->queue.lock);
@@ -663,6 +749,41 @@ lvp_shader_compile(struct lvp_device *device, struct lvp_shader *shader, nir_sha
    return state;
 }
 
+/* Compiles a shader on the context of a queue.  Must be called with the
+ * lock of that queue held.
+ */
+void *
+lvp_shader_compile_for_queue(struct lvp_queue *queue, struct lvp_shader *shader, nir_shader *nir)
+{
+   queue->device->pscreen->finalize_nir(queue->device->pscreen, nir);
+
+   return lvp_shader_compile_stage(queue->ctx, shader, nir);
+}
+
+/* Returns the shader state of a shader for a queue, creating it if this is
+ * the first time the shader is used there.  Must be called with the lock of
+ * that queue held, which also guards its states in the shader.
+ */
+void *
+lvp_shader_get_cso(struct lvp_queue *queue, struct lvp_shader *shader, bool tess_ccw)
+{
+   void **cso;
+
+   if (tess_ccw && !shader->tess_ccw)
+      return NULL;
+
+   if (queue->index)
+      cso = &shader->queue_csos[queue->index - 1][tess_ccw];
+   else
+      cso = tess_ccw ? &shader->tess_ccw_cso : &shader->shader_cso;
+
+   if (!*cso) {
+      const struct lvp_pipeline_nir *pipeline_nir = tess_ccw ? shader->tess_ccw : shader->pipeline_nir;
+      *cso = lvp_shader_compile_for_queue(queue, shader, nir_shader_clone(NULL, pipeline_nir->nir));
+   }
+   return *cso;
+}
+
 #ifndef NDEBUG
 static bool
 layouts_equal(const struct lvp_descriptor_set_layout *a, const struct lvp_descriptor_set_layout *b)
@@ -777,6 +898,7 @@ copy_shader_sanitized(struct lvp_shader *dst, const struct lvp_shader *src)
    assert(!dst->tess_ccw_cso);
    if (src->inlines.can_inline)
       _mesa_set_init(&dst->inlines.variants, NULL, NULL, inline_variant_equals);
+   simple_mtx_init(&dst->inlines.lock, mtx_plain);
 }
 
 static VkResult
@@ -784,7 +906,8 @@ lvp_graphics_pipeline_init(struct lvp_pipeline *pipeline,
                            struct lvp_device *device,
                            struct lvp_pipeline_cache *cache,
                            const VkGraphicsPipelineCreateInfo *pCreateInfo,
-                           VkPipelineCreateFlagBits2KHR flags)
+                           VkPipelineCreateFlagBits2KHR flags,
+                           bool parallel_stages)
 {
    pipeline->type = LVP_PIPELINE_GRAPHICS;
 
@@ -865,28 +988,28 @@ lvp_graphics_pipeline_init(struct lvp_pipeline *pipeline,
 
    pipeline->device = device;
 
+   const VkPipelineShaderStageCreateInfo *stages[LVP_SHADER_STAGES];
+   unsigned num_stages = 0;
+   bool has_fs = false;
    for (uint32_t i = 0; i < pCreateInfo->stageCount; i++) {
       const VkPipelineShaderStageCreateInfo *sinfo = &pCreateInfo->pStages[i];
       gl_shader_stage stage = vk_to_mesa_shader_stage(sinfo->stage);
       if (stage == MESA_SHADER_FRAGMENT) {
          if (!(pipeline->stages & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT))
             continue;
+         has_fs = true;
       } else {
          if (!(pipeline->stages & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT))
             continue;
       }
-      result = lvp_shader_compile_to_ir(pipeline, sinfo);
-      if (result != VK_SUCCESS)
-         goto fail;
-
-      switch (stage) {
-      case MESA_SHADER_FRAGMENT:
-         if (pipeline->shaders[MESA_SHADER_FRAGMENT].pipeline_nir->nir->info.fs.uses_sample_shading)
-            pipeline->force_min_sample = true;
-         break;
-      default: break;
-      }
+      stages[num_stages++] = sinfo;
    }
+   result = lvp_shader_compile_stages_to_ir(pipeline, stages, num_stages, parallel_stages);
+   if (result != VK_SUCCESS)
+      goto fail;
+
+   if (has_fs && pipeline->shaders[MESA_SHADER_FRAGMENT].pipeline_nir->nir->info.fs.uses_sample_shading)
+      pipeline->force_min_sample = true;
    if (pCreateInfo->stageCount && pipeline->shaders[MESA_SHADER_TESS_EVAL].pipeline_nir) {
       nir_lower_patch_vertices(pipeline->shaders[MESA_SHADER_TESS_EVAL].pipeline_nir->nir, pipeline->shaders[MESA_SHADER_TESS_CTRL].pipeline_nir->nir->info.tess.tcs_vertices_out, NULL);
       merge_tess_info(&pipeline->shaders[MESA_SHADER_TESS_EVAL].pipeline_nir->nir->info, &pipeline->shaders[MESA_SHADER_TESS_CTRL].pipeline_nir->nir->info);
@@ -973,7 +1096,8 @@ lvp_graphics_pipeline_create(
    const VkGraphicsPipelineCreateInfo *pCreateInfo,
    VkPipelineCreateFlagBits2KHR flags,
    VkPipeline *pPipeline,
-   bool group)
+   bool group,
+   bool parallel_stages)
 {
    LVP_FROM_HANDLE(lvp_device, device, _device);
    LVP_FROM_HANDLE(lvp_pipeline_cache, cache, _cache);
@@ -995,7 +1119,8 @@ lvp_graphics_pipeline_create(
    vk_object_base_init(&device->vk, &pipeline->base,
                        VK_OBJECT_TYPE_PIPELINE);
    uint64_t t0 = os_time_get_nano();
-   result = lvp_graphics_pipeline_init(pipeline, device, cache, pCreateInfo, flags);
+   result = lvp_graphics_pipeline_init(pipeline, device, cache, pCreateInfo, flags,
+                                       parallel_stages);
    if (result != VK_SUCCESS) {
       vk_free(&device->vk.alloc, pipeline);
       return result;
@@ -1008,7 +1133,8 @@ lvp_graphics_pipeline_create(
          pci.pTessellationState = g->pTessellationState;
          pci.pStages = g->pStages;
          pci.stageCount = g->stageCount;
-         result = lvp_graphics_pipeline_create(_device, _cache, &pci, flags, &pipeline->groups[i], true);
+         result = lvp_graphics_pipeline_create(_device, _cache, &pci, flags, &pipeline->groups[i],
+                                               true, parallel_stages);
          if (result != VK_SUCCESS) {
             lvp_pipeline_destroy(device, pipeline, false);
             return result;
@@ -1032,6 +1158,113 @@ lvp_graphics_pipeline_create(
    return VK_SUCCESS;
 }
 
+static VkResult
+lvp_compute_pipeline_create(VkDevice _device,
+                            VkPipelineCache _cache,
+                            const VkComputePipelineCreateInfo *pCreateInfo,
+                            VkPipelineCreateFlagBits2KHR flags,
+                            VkPipeline *pPipeline);
+
+struct lvp_pipeline_job {
+   struct util_queue_fence fence;
+   VkDevice device;
+   VkPipelineCache cache;
+   const void *create_info;
+   VkPipelineCreateFlagBits2KHR flags;
+   VkPipeline *pipeline;
+   VkResult result;
+   bool compute;
+};
+
+static void
+pipeline_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct lvp_pipeline_job *job = data;
+
+   if (job->compute)
+      job->result = lvp_compute_pipeline_create(job->device, job->cache,
+                                                job->create_info, job->flags,
+                                                job->pipeline);
+   else
+      job->result = lvp_graphics_pipeline_create(job->device, job->cache,
+                                                 job->create_info, job->flags,
+                                                 job->pipeline, false, false);
+}
+
+/* Creates all the pipelines of the array on the compile queue, with the
+ * calling thread taking the first one, then reports the results in array
+ * order like the serial loop does.  Pipelines created past an
+ * EARLY_RETURN_ON_FAILURE failure are destroyed again.
+ */
+static VkResult
+lvp_create_pipelines_threaded(VkDevice _device,
+                              VkPipelineCache cache,
+                              uint32_t count,
+                              const void *create_infos,
+                              bool compute,
+                              VkPipeline *pPipelines)
+{
+   LVP_FROM_HANDLE(lvp_device, device, _device);
+   const size_t info_size = compute ? sizeof(VkComputePipelineCreateInfo) :
+                                      sizeof(VkGraphicsPipelineCreateInfo);
+   VkResult result = VK_SUCCESS;
+   unsigned i;
+
+   struct lvp_pipeline_job *jobs = vk_zalloc(&device->vk.alloc, count * sizeof(*jobs), 8,
+                                             VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+   if (!jobs) {
+      for (i = 0; i < count; i++)
+         pPipelines[i] = VK_NULL_HANDLE;
+      return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
+   }
+
+   for (i = 0; i < count; i++) {
+      struct lvp_pipeline_job *job = &jobs[i];
+
+      job->device = _device;
+      job->cache = cache;
+      job->create_info = (const uint8_t *)create_infos + i * info_size;
+      job->flags = compute ? vk_compute_pipeline_create_flags(job->create_info) :
+                             vk_graphics_pipeline_create_flags(job->create_info);
+      job->pipeline = &pPipelines[i];
+      job->result = VK_PIPELINE_COMPILE_REQUIRED;
+      job->compute = compute;
+      util_queue_fence_init(&job->fence);
+
+      if (!(job->flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR) && i)
+         util_queue_add_job(&device->compile_queue, job, &job->fence,
+                            pipeline_job_execute, NULL, 0);
+   }
+
+   if (!(jobs[0].flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR))
+      pipeline_job_execute(&jobs[0], NULL, 0);
+
+   for (i = 0; i < count; i++)
+      util_queue_fence_wait(&jobs[i].fence);
+
+   for (i = 0; i < count; i++) {
+      if (jobs[i].result != VK_SUCCESS) {
+         result = jobs[i].result;
+         pPipelines[i] = VK_NULL_HANDLE;
+         if (jobs[i].flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
+            break;
+      }
+   }
+   if (result != VK_SUCCESS) {
+      for (i++; i < count; i++) {
+         if (jobs[i].result == VK_SUCCESS)
+            lvp_DestroyPipeline(_device, pPipelines[i], NULL);
+         pPipelines[i] = VK_NULL_HANDLE;
+      }
+   }
+
+   for (i = 0; i < count; i++)
+      util_queue_fence_destroy(&jobs[i].fence);
+   vk_free(&device->vk.alloc, jobs);
+
+   return result;
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
    VkDevice                                    _device,
    VkPipelineCache                             pipelineCache,
@@ -1040,9 +1273,14 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
    const VkAllocationCallbacks*                pAllocator,
    VkPipeline*                                 pPipelines)
 {
+   LVP_FROM_HANDLE(lvp_device, device, _device);
    VkResult result = VK_SUCCESS;
    unsigned i = 0;
 
+   if (count > 1 && device->num_compile_threads)
+      return lvp_create_pipelines_threaded(_device, pipelineCache, count,
+                                           pCreateInfos, false, pPipelines);
+
    for (; i < count; i++) {
       VkResult r = VK_PIPELINE_COMPILE_REQUIRED;
       VkPipelineCreateFlagBits2KHR flags = vk_graphics_pipeline_create_flags(&pCreateInfos[i]);
@@ -1053,7 +1291,7 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
                                           &pCreateInfos[i],
                                           flags,
                                           &pPipelines[i],
-                                          false);
+                                          false, true);
       if (r != VK_SUCCESS) {
          result = r;
          pPipelines[i] = VK_NULL_HANDLE;
@@ -1142,9 +1380,14 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateComputePipelines(
    const VkAllocationCallbacks*                pAllocator,
    VkPipeline*                                 pPipelines)
 {
+   LVP_FROM_HANDLE(lvp_device, device, _device);
    VkResult result = VK_SUCCESS;
    unsigned i = 0;
 
+   if (count > 1 && device->num_compile_threads)
+      return lvp_create_pipelines_threaded(_device, pipelineCache, count,
+                                           pCreateInfos, true, pPipelines);
+
    for (; i < count; i++) {
       VkResult r = VK_PIPELINE_COMPILE_REQUIRED;
       VkPipelineCreateFlagBits2KHR flags = vk_compute_pipeline_create_flags(&pCreateInfos[i]);
@@ -94,6 +94,8 @@ extern "C" {
 #define MAX_PER_STAGE_DESCRIPTOR_UNIFORM_BLOCKS 8
 #define MAX_DGC_STREAMS 16
 #define MAX_DGC_TOKENS 16
+#define MAX_QUEUES_PER_FAMILY 4
+#define MAX_QUEUES (2 * MAX_QUEUES_PER_FAMILY)
 
 #ifdef _WIN32
 #define lvp_printflike(a, b)
@@ -174,10 +176,12 @@ bool lvp_physical_device_extension_supported(struct lvp_physical_device *dev,
 struct lvp_queue {
    struct vk_queue vk;
    struct lvp_device *                         device;
+   uint32_t index; /* 0 for device->queue, else 1 + index in extra_queues */
    struct pipe_context *ctx;
    struct cso_context *cso;
    struct u_upload_mgr *uploader;
    struct pipe_fence_handle *last_fence;
+   void *noop_fs;
    void *state;
    struct util_dynarray pipeline_destroys;
    simple_mtx_t lock;
@@ -192,16 +196,28 @@ struct lvp_pipeline_cache {
 struct lvp_device {
    struct vk_device vk;
 
+   /* The first queue created.  Its context is also the one used to create
+    * device objects (shaders, texture handles, queries).  Every queue's lock
+    * guards the calls into its context, so the lock of this one also guards
+    * device object creation.
+    */
    struct lvp_queue queue;
+   /* The other queues, each with its own context and submit thread. */
+   struct lvp_queue *extra_queues;
+   uint32_t num_extra_queues;
    struct lvp_instance *                       instance;
    struct lvp_physical_device *physical_device;
    struct pipe_screen *pscreen;
-   void *noop_fs;
    simple_mtx_t bda_lock;
    struct hash_table bda;
    struct pipe_resource *zero_buffer; /* for zeroed bda */
    bool poison_mem;
    bool print_cmds;
+   bool compile_cmds;
+
+   /* Translates shaders of batched pipeline creation in parallel. */
+   struct util_queue compile_queue;
+   unsigned num_compile_threads;
 
    struct lp_texture_handle *null_texture_handle;
    struct lp_texture_handle *null_image_handle;
@@ -209,6 +225,12 @@ struct lvp_device {
    struct util_dynarray bda_image_handles;
 };
 
+static inline struct lvp_queue *
+lvp_device_get_queue(struct lvp_device *device, uint32_t index)
+{
+   return index ? &device->extra_queues[index - 1] : &device->queue;
+}
+
 void lvp_device_get_cache_uuid(void *uuid);
 
 enum lvp_device_memory_type {
@@ -330,6 +352,9 @@ struct lvp_descriptor_set_layout {
    /* Number of dynamic offsets used by this descriptor set */
    uint32_t dynamic_offset_count;
 
+   /* sets may be updated while bound in a command buffer that stays valid */
+   bool update_after_bind;
+
    /* if this layout is comprised solely of immutable samplers, this will be a bindable set */
    struct lvp_descriptor_set *immutable_set;
 
@@ -446,6 +471,7 @@ lvp_pipeline_nir_ref(struct lvp_pipeline_nir **dst, struct lvp_pipeline_nir *src
 
 struct lvp_inline_variant {
    uint32_t mask;
+   uint32_t queue;
    uint32_t vals[PIPE_MAX_CONSTANT_BUFFERS][MAX_INLINABLE_UNIFORMS];
    void *cso;
 };
@@ -457,12 +483,19 @@ struct lvp_shader {
    struct lvp_pipeline_nir *tess_ccw;
    void *shader_cso;
    void *tess_ccw_cso;
+   /* The same for the other queues.  Shader states belong to the context
+    * that created them, so these are created the first time the shader is
+    * bound on each queue.
+    */
+   void *queue_csos[MAX_QUEUES - 1][2];
    struct {
       uint32_t uniform_offsets[PIPE_MAX_CONSTANT_BUFFERS][MAX_INLINABLE_UNIFORMS];
       uint8_t count[PIPE_MAX_CONSTANT_BUFFERS];
       bool must_inline;
       uint32_t can_inline; //bitmask
       struct set variants;
+      /* guards can_inline and variants, which every queue updates */
+      simple_mtx_t lock;
    } inlines;
    struct pipe_stream_output_info stream_output;
    struct blob blob; //preserved for GetShaderBinaryDataEXT
@@ -596,6 +629,20 @@ struct lvp_cmd_buffer {
    struct lvp_device *                          device;
 
    uint8_t push_constants[MAX_PUSH_CONSTANTS_SIZE];
+
+   VkCommandBufferUsageFlags usage_flags;
+
+   /* Commands to execute for a command buffer that may be submitted more
+    * than once, see lvp_compile_cmd_buffer().
+    */
+   struct util_dynarray stream;
+   bool compiled;
+
+   /* Descriptor set binds resolved by lvp_compile_cmd_buffer(), and the
+    * sets they bind.  Both are owned by the command buffer.
+    */
+   struct util_dynarray resolved_cmds;
+   struct util_dynarray resolved_sets;
 };
 
 struct lvp_indirect_command_layout {
@@ -673,6 +720,8 @@ void lvp_add_enqueue_cmd_entrypoints(struct vk_device_dispatch_table *disp);
 VkResult lvp_execute_cmds(struct lvp_device *device,
                           struct lvp_queue *queue,
                           struct lvp_cmd_buffer *cmd_buffer);
+void lvp_compile_cmd_buffer(struct lvp_cmd_buffer *cmd_buffer);
+void lvp_cmd_buffer_free_resolved(struct lvp_cmd_buffer *cmd_buffer);
 size_t
 lvp_get_rendering_state_size(void);
 struct lvp_image *lvp_swapchain_get_image(VkSwapchainKHR swapchain,
@@ -730,6 +779,10 @@ void
 lvp_inline_uniforms(nir_shader *nir, const struct lvp_shader *shader, const uint32_t *uniform_values, uint32_t ubo);
 void *
 lvp_shader_compile(struct lvp_device *device, struct lvp_shader *shader, nir_shader *nir, bool locked);
+void *
+lvp_shader_compile_for_queue(struct lvp_queue *queue, struct lvp_shader *shader, nir_shader *nir);
+void *
+lvp_shader_get_cso(struct lvp_queue *queue, struct lvp_shader *shader, bool tess_ccw);
 enum vk_cmd_type
 lvp_nv_dgc_token_to_cmd_type(const VkIndirectCommandsLayoutTokenNV *token);
 #ifdef __cplusplus
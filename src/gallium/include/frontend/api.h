@@ -193,6 +193,7 @@ struct st_config_options
    bool do_dce_before_clip_cull_analysis;
    bool allow_draw_out_of_order;
    bool glthread_nop_check_framebuffer_status;
+   int glthread_batch_policy;
    bool ignore_map_unsynchronized;
    bool ignore_discard_framebuffer;
    bool force_integer_tex_nearest;
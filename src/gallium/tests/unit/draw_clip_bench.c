@@ -0,0 +1,279 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Throughput of the draw module's clip stage on triangles crossing the near
+ * plane and the sides of the view volume.  The triangles go through a real
+ * draw context: vertex fetch, a pass-through vertex shader with
+ * NUM_ATTRIBS generic outputs, the cliptest and the pipeline, whose last
+ * stage checksums what it receives in a first, untimed pass and drops it
+ * afterwards.
+ *
+ * Every run is done once with DRAW_CLIP_SIMD=0 (the scalar clipper) and
+ * once with DRAW_CLIP_SIMD=1 (the draw_clip_simd.h kernels).  Both must
+ * produce bit-identical vertices.  Set DRAW_USE_LLVM=0 to use the TGSI
+ * interpreter for the vertex shader instead of the JIT.
+ *
+ * Usage: ./draw_clip_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "draw/draw_context.h"
+#include "draw/draw_pipe.h"
+#include "draw/draw_private.h"
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "tgsi/tgsi_text.h"
+#include "util/os_time.h"
+
+#define NUM_TRIS     4096
+#define NUM_LOOPS    50
+#define NUM_ATTRIBS  8
+#define NUM_INPUTS   (NUM_ATTRIBS + 1)
+
+struct checksum_stage {
+   struct draw_stage stage;
+   bool enabled;
+   uint64_t hash;
+   unsigned tris;
+};
+
+
+static void
+checksum_tri(struct draw_stage *stage, struct prim_header *header)
+{
+   struct checksum_stage *cs = (struct checksum_stage *)stage;
+   unsigned num_outputs;
+
+   if (!cs->enabled)
+      return;
+
+   num_outputs = draw_num_shader_outputs(stage->draw);
+
+   /* FNV-1a over the bits of every output of every vertex. */
+   for (unsigned v = 0; v < 3; v++) {
+      const uint32_t *data = (const uint32_t *)header->v[v]->data;
+
+      for (unsigned i = 0; i < num_outputs * 4; i++)
+         cs->hash = (cs->hash ^ data[i]) * 0x100000001b3ull;
+   }
+   cs->tris++;
+}
+
+
+static void
+checksum_point_line(struct draw_stage *stage, struct prim_header *header)
+{
+}
+
+
+static void
+checksum_flush(struct draw_stage *stage, unsigned flags)
+{
+}
+
+
+static void
+checksum_reset_stipple_counter(struct draw_stage *stage)
+{
+}
+
+
+static void
+checksum_destroy(struct draw_stage *stage)
+{
+}
+
+
+static int
+screen_get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   return 0;
+}
+
+
+static float
+rand_float(float lo, float hi)
+{
+   return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+
+/**
+ * Draw all triangles NUM_LOOPS times through a new draw context, with the
+ * SIMD clip kernels on or off.  Returns the time taken in nanoseconds.
+ */
+static int64_t
+run(const float (*verts)[NUM_INPUTS][4], const struct tgsi_token *tokens,
+    bool simd, struct checksum_stage *cs)
+{
+   struct pipe_screen screen = {
+      .get_param = screen_get_param,
+   };
+   struct pipe_context pipe = {
+      .screen = &screen,
+   };
+   struct pipe_rasterizer_state rast = {
+      .fill_front = PIPE_POLYGON_MODE_FILL,
+      .fill_back = PIPE_POLYGON_MODE_FILL,
+      .cull_face = PIPE_FACE_NONE,
+      .half_pixel_center = 1,
+      .depth_clip_near = 1,
+      .depth_clip_far = 1,
+   };
+   struct pipe_viewport_state vp = {
+      .scale = { 256.0f, 256.0f, 0.5f },
+      .translate = { 256.0f, 256.0f, 0.5f },
+      .swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X,
+      .swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y,
+      .swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z,
+      .swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W,
+   };
+   struct pipe_vertex_element elems[NUM_INPUTS];
+   struct pipe_vertex_buffer vb = {
+      .is_user_buffer = true,
+      .buffer.user = verts,
+   };
+   struct pipe_shader_state vs_state = {
+      .type = PIPE_SHADER_IR_TGSI,
+      .tokens = tokens,
+   };
+   struct pipe_draw_info info = {
+      .mode = MESA_PRIM_TRIANGLES,
+      .instance_count = 1,
+   };
+   struct pipe_draw_start_count_bias draw_range = {
+      .count = NUM_TRIS * 3,
+   };
+   struct draw_context *draw;
+   void *vs;
+   int64_t start, elapsed;
+
+   /* The clip stage reads this when the context creates it. */
+   setenv("DRAW_CLIP_SIMD", simd ? "1" : "0", 1);
+
+   draw = draw_create(&pipe);
+   if (!draw)
+      return -1;
+
+   memset(cs, 0, sizeof(*cs));
+   cs->stage.draw = draw;
+   cs->stage.name = "checksum";
+   cs->stage.point = checksum_point_line;
+   cs->stage.line = checksum_point_line;
+   cs->stage.tri = checksum_tri;
+   cs->stage.flush = checksum_flush;
+   cs->stage.reset_stipple_counter = checksum_reset_stipple_counter;
+   cs->stage.destroy = checksum_destroy;
+   draw_set_rasterize_stage(draw, &cs->stage);
+
+   for (unsigned i = 0; i < NUM_INPUTS; i++) {
+      elems[i] = (struct pipe_vertex_element) {
+         .src_offset = i * 4 * sizeof(float),
+         .src_format = PIPE_FORMAT_R32G32B32A32_FLOAT,
+         .src_stride = sizeof(*verts),
+      };
+   }
+
+   draw_set_rasterizer_state(draw, &rast, &rast);
+   draw_set_viewport_states(draw, 0, 1, &vp);
+   draw_set_vertex_elements(draw, NUM_INPUTS, elems);
+   draw_set_vertex_buffers(draw, 1, &vb);
+   draw_set_mapped_vertex_buffer(draw, 0, verts,
+                                 NUM_TRIS * 3 * sizeof(*verts));
+
+   vs = draw_create_vertex_shader(draw, &vs_state);
+   draw_bind_vertex_shader(draw, vs);
+
+   /* Checksum the output once, which also compiles the shader. */
+   cs->enabled = true;
+   cs->hash = 0xcbf29ce484222325ull;
+   draw_vbo(draw, &info, 0, NULL, &draw_range, 1, 0);
+   draw_flush(draw);
+   cs->enabled = false;
+
+   start = os_time_get_nano();
+   for (unsigned l = 0; l < NUM_LOOPS; l++)
+      draw_vbo(draw, &info, 0, NULL, &draw_range, 1, 0);
+   draw_flush(draw);
+   elapsed = os_time_get_nano() - start;
+
+   draw_bind_vertex_shader(draw, NULL);
+   draw_delete_vertex_shader(draw, vs);
+   draw_destroy(draw);
+
+   return elapsed;
+}
+
+
+int main(int argc, char **argv)
+{
+   float (*verts)[NUM_INPUTS][4] = calloc(NUM_TRIS * 3, sizeof(*verts));
+   struct tgsi_token tokens[1024];
+   struct checksum_stage scalar, simd;
+   int64_t scalar_time, simd_time;
+   char text[2048];
+   int len = 0;
+
+   len += snprintf(text + len, sizeof(text) - len, "VERT\n");
+   for (unsigned i = 0; i < NUM_INPUTS; i++)
+      len += snprintf(text + len, sizeof(text) - len, "DCL IN[%u]\n", i);
+   len += snprintf(text + len, sizeof(text) - len, "DCL OUT[0], POSITION\n");
+   for (unsigned i = 1; i < NUM_INPUTS; i++)
+      len += snprintf(text + len, sizeof(text) - len,
+                      "DCL OUT[%u], GENERIC[%u]\n", i, i - 1);
+   for (unsigned i = 0; i < NUM_INPUTS; i++)
+      len += snprintf(text + len, sizeof(text) - len,
+                      "MOV OUT[%u], IN[%u]\n", i, i);
+   snprintf(text + len, sizeof(text) - len, "END\n");
+
+   if (!tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens))) {
+      printf("failed to translate the vertex shader\n");
+      return 1;
+   }
+
+   srand(4359025);
+   for (unsigned i = 0; i < NUM_TRIS * 3; i++) {
+      const float w = rand_float(-0.5f, 4.0f);
+
+      verts[i][0][0] = rand_float(-2.0f, 2.0f) * w;
+      verts[i][0][1] = rand_float(-2.0f, 2.0f) * w;
+      verts[i][0][2] = rand_float(-1.5f, 1.5f) * w;
+      verts[i][0][3] = w;
+      for (unsigned j = 1; j < NUM_INPUTS; j++) {
+         for (unsigned c = 0; c < 4; c++)
+            verts[i][j][c] = rand_float(0.0f, 1.0f);
+      }
+   }
+
+   scalar_time = run(verts, tokens, false, &scalar);
+   simd_time = run(verts, tokens, true, &simd);
+   if (scalar_time < 0 || simd_time < 0) {
+      printf("failed to create a draw context\n");
+      return 1;
+   }
+
+   if (scalar.tris != simd.tris || scalar.hash != simd.hash) {
+      printf("SIMD clipping differs: %u triangles (hash %016llx), "
+             "expected %u (hash %016llx)\n",
+             simd.tris, (unsigned long long)simd.hash,
+             scalar.tris, (unsigned long long)scalar.hash);
+      return 1;
+   }
+
+   printf("%u triangles -> %u triangles, %u attributes\n",
+          NUM_TRIS, scalar.tris, NUM_ATTRIBS);
+   printf("scalar %8.2f Mtris/s\n",
+          (double)NUM_TRIS * NUM_LOOPS * 1000.0 / scalar_time);
+   printf("simd   %8.2f Mtris/s\n",
+          (double)NUM_TRIS * NUM_LOOPS * 1000.0 / simd_time);
+
+   free(verts);
+
+   return 0;
+}
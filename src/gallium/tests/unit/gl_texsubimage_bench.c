@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * CPU cost of glTexSubImage uploads that need a format conversion, which
+ * core Mesa splits between its texstore threads when the image is large
+ * enough.  The upload is one of:
+ *
+ *   rgbx: GL_RGB/GL_UNSIGNED_BYTE into GL_RGB8, i.e. padded to 4 bytes
+ *   half: GL_RGBA/GL_FLOAT into GL_RGBA16F
+ *   565:  GL_RGB/GL_UNSIGNED_BYTE into GL_RGB565
+ *
+ * into a 1024x1024 2D texture, or a 256x256x16 3D one.  The source rows are
+ * padded with GL_UNPACK_ROW_LENGTH.  Run it with MESA_TEXSTORE_THREADS=1 to
+ * compare against converting on the calling thread.  Drivers which upload
+ * through blits, i.e. most hardware drivers, don't use the texstore
+ * conversion, so select a software driver with GALLIUM_DRIVER.
+ *
+ * Usage: ./gl_texsubimage_bench [rgbx|half|565] [2d|3d] [/path/to/libEGL.so.1]
+ */
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include "util/os_time.h"
+
+#define SIZE_2D         1024
+#define SIZE_3D         256
+#define DEPTH_3D        16
+#define ROW_PADDING     16
+#define NUM_UPLOADS     50
+
+static PFNEGLGETPROCADDRESSPROC get_proc;
+
+#define GET_PROC(type, name) \
+   type name = (type) get_proc(#name)
+
+static void
+upload(GLenum target, GLsizei width, GLsizei height, GLsizei depth,
+       GLenum format, GLenum type, const void *pixels)
+{
+   GET_PROC(PFNGLTEXSUBIMAGE2DPROC, glTexSubImage2D);
+   GET_PROC(PFNGLTEXSUBIMAGE3DPROC, glTexSubImage3D);
+
+   if (target == GL_TEXTURE_3D) {
+      glTexSubImage3D(target, 0, 0, 0, 0, width, height, depth,
+                      format, type, pixels);
+   } else {
+      glTexSubImage2D(target, 0, 0, 0, width, height, format, type, pixels);
+   }
+}
+
+int main(int argc, char **argv)
+{
+   const char *mode = argc > 1 ? argv[1] : "rgbx";
+   const char *dims = argc > 2 ? argv[2] : "2d";
+   const char *lib_name = argc > 3 ? argv[3] : "libEGL.so.1";
+   GLenum internal_format, format, type;
+   unsigned texel_size;
+   void *lib;
+
+   if (!strcmp(mode, "rgbx")) {
+      internal_format = GL_RGB8;
+      format = GL_RGB;
+      type = GL_UNSIGNED_BYTE;
+      texel_size = 3;
+   } else if (!strcmp(mode, "half")) {
+      internal_format = GL_RGBA16F;
+      format = GL_RGBA;
+      type = GL_FLOAT;
+      texel_size = 16;
+   } else if (!strcmp(mode, "565")) {
+      internal_format = GL_RGB565;
+      format = GL_RGB;
+      type = GL_UNSIGNED_BYTE;
+      texel_size = 3;
+   } else {
+      mode = NULL;
+   }
+
+   if (!mode || (strcmp(dims, "2d") && strcmp(dims, "3d"))) {
+      printf("Usage: ./gl_texsubimage_bench [rgbx|half|565] [2d|3d] "
+             "[/path/to/libEGL.so.1]\n");
+      return 2;
+   }
+
+   lib = dlopen(lib_name, RTLD_NOW | RTLD_LOCAL);
+   if (!lib) {
+      printf("failed to load %s: %s\n", lib_name, dlerror());
+      return 1;
+   }
+   get_proc = (PFNEGLGETPROCADDRESSPROC) dlsym(lib, "eglGetProcAddress");
+   if (!get_proc) {
+      printf("%s is not an EGL library\n", lib_name);
+      return 1;
+   }
+
+   GET_PROC(PFNEGLGETPLATFORMDISPLAYEXTPROC, eglGetPlatformDisplayEXT);
+   GET_PROC(PFNEGLINITIALIZEPROC, eglInitialize);
+   GET_PROC(PFNEGLBINDAPIPROC, eglBindAPI);
+   GET_PROC(PFNEGLCHOOSECONFIGPROC, eglChooseConfig);
+   GET_PROC(PFNEGLCREATECONTEXTPROC, eglCreateContext);
+   GET_PROC(PFNEGLMAKECURRENTPROC, eglMakeCurrent);
+   GET_PROC(PFNEGLDESTROYCONTEXTPROC, eglDestroyContext);
+   GET_PROC(PFNEGLTERMINATEPROC, eglTerminate);
+
+   EGLDisplay dpy = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                             EGL_DEFAULT_DISPLAY, NULL);
+   if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)) {
+      printf("failed to initialize a surfaceless EGL display\n");
+      return 1;
+   }
+   eglBindAPI(EGL_OPENGL_ES_API);
+
+   static const EGLint config_attribs[] = {
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_NONE,
+   };
+   static const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_NONE,
+   };
+   EGLConfig config;
+   EGLint num_configs;
+   if (!eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs) ||
+       !num_configs) {
+      printf("no GLES 3 config\n");
+      return 1;
+   }
+   EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT,
+                                     context_attribs);
+   if (ctx == EGL_NO_CONTEXT ||
+       !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+      printf("failed to make a surfaceless GLES 3 context current\n");
+      return 1;
+   }
+
+   GET_PROC(PFNGLGENTEXTURESPROC, glGenTextures);
+   GET_PROC(PFNGLBINDTEXTUREPROC, glBindTexture);
+   GET_PROC(PFNGLTEXSTORAGE2DPROC, glTexStorage2D);
+   GET_PROC(PFNGLTEXSTORAGE3DPROC, glTexStorage3D);
+   GET_PROC(PFNGLPIXELSTOREIPROC, glPixelStorei);
+   GET_PROC(PFNGLGETERRORPROC, glGetError);
+   GET_PROC(PFNGLFINISHPROC, glFinish);
+
+   const bool is_3d = !strcmp(dims, "3d");
+   const GLsizei width = is_3d ? SIZE_3D : SIZE_2D;
+   const GLsizei height = width;
+   const GLsizei depth = is_3d ? DEPTH_3D : 1;
+   const GLenum target = is_3d ? GL_TEXTURE_3D : GL_TEXTURE_2D;
+   const size_t row_stride = (size_t)(width + ROW_PADDING) * texel_size;
+   unsigned char *pixels = malloc(row_stride * height * depth);
+
+   if (type == GL_FLOAT) {
+      float *texels = (float *)pixels;
+      for (size_t i = 0; i < row_stride * height * depth / sizeof(float); i++)
+         texels[i] = (i % 251) / 250.0f;
+   } else {
+      for (size_t i = 0; i < row_stride * height * depth; i++)
+         pixels[i] = i * 7;
+   }
+
+   GLuint tex;
+   glGenTextures(1, &tex);
+   glBindTexture(target, tex);
+   if (is_3d)
+      glTexStorage3D(target, 1, internal_format, width, height, depth);
+   else
+      glTexStorage2D(target, 1, internal_format, width, height);
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, width + ROW_PADDING);
+
+   /* The first upload allocates the texture and starts the threads. */
+   upload(target, width, height, depth, format, type, pixels);
+   glFinish();
+   if (glGetError() != GL_NO_ERROR) {
+      printf("%s %s upload failed\n", mode, dims);
+      return 1;
+   }
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < NUM_UPLOADS; i++)
+      upload(target, width, height, depth, format, type, pixels);
+   glFinish();
+
+   int64_t elapsed = os_time_get_nano() - start;
+   const double texels = (double)width * height * depth * NUM_UPLOADS;
+
+   printf("%s %s: %u uploads, %.2f ms/upload, %.1f Mtexels/s\n", mode, dims,
+          NUM_UPLOADS, elapsed / 1e6 / NUM_UPLOADS, texels * 1e3 / elapsed);
+
+   free(pixels);
+   eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+   eglDestroyContext(dpy, ctx);
+   eglTerminate(dpy);
+   dlclose(lib);
+   return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * CPU cost of glUniform* followed by a draw, i.e. of getting the default
+ * uniform block of a program into the driver.  The vertex shader has a
+ * 4 KiB uniform array, and every draw is preceded by one of:
+ *
+ *   partial: a single vec4 of the array is changed
+ *   full:    the whole array is changed
+ *   switch:  nothing is changed, but the draw alternates between two
+ *            programs, so their constant buffers are rebound
+ *
+ * The draws are single points into a 1x1 renderbuffer, so the time measured
+ * is mostly state validation and constant upload.  EGL is loaded directly
+ * and a surfaceless GLES 3 context is used, so no window system is needed.
+ * Select the driver with GALLIUM_DRIVER.
+ *
+ * Usage: ./gl_uniform_bench [partial|full|switch] [/path/to/libEGL.so.1]
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include "util/os_time.h"
+
+#define NUM_VEC4     256
+#define NUM_DRAWS    100000
+
+static PFNEGLGETPROCADDRESSPROC get_proc;
+
+#define GET_PROC(type, name) \
+   type name = (type) get_proc(#name)
+
+static const char *vs_source =
+   "#version 300 es\n"
+   "uniform vec4 u[256];\n"
+   "uniform int idx;\n"
+   "void main() {\n"
+   "   gl_Position = u[idx];\n"
+   "   gl_PointSize = 1.0;\n"
+   "}\n";
+
+static const char *fs_source =
+   "#version 300 es\n"
+   "precision mediump float;\n"
+   "out vec4 color;\n"
+   "void main() {\n"
+   "   color = vec4(1.0);\n"
+   "}\n";
+
+static GLuint
+build_program(void)
+{
+   GET_PROC(PFNGLCREATESHADERPROC, glCreateShader);
+   GET_PROC(PFNGLSHADERSOURCEPROC, glShaderSource);
+   GET_PROC(PFNGLCOMPILESHADERPROC, glCompileShader);
+   GET_PROC(PFNGLCREATEPROGRAMPROC, glCreateProgram);
+   GET_PROC(PFNGLATTACHSHADERPROC, glAttachShader);
+   GET_PROC(PFNGLLINKPROGRAMPROC, glLinkProgram);
+   GET_PROC(PFNGLGETPROGRAMIVPROC, glGetProgramiv);
+
+   GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+   GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+   glShaderSource(vs, 1, &vs_source, NULL);
+   glShaderSource(fs, 1, &fs_source, NULL);
+   glCompileShader(vs);
+   glCompileShader(fs);
+
+   GLuint prog = glCreateProgram();
+   glAttachShader(prog, vs);
+   glAttachShader(prog, fs);
+   glLinkProgram(prog);
+
+   GLint status;
+   glGetProgramiv(prog, GL_LINK_STATUS, &status);
+   return status ? prog : 0;
+}
+
+int main(int argc, char **argv)
+{
+   const char *mode = argc > 1 ? argv[1] : "partial";
+   const char *lib_name = argc > 2 ? argv[2] : "libEGL.so.1";
+   void *lib;
+
+   if (strcmp(mode, "partial") && strcmp(mode, "full") &&
+       strcmp(mode, "switch")) {
+      printf("Usage: ./gl_uniform_bench [partial|full|switch] "
+             "[/path/to/libEGL.so.1]\n");
+      return 2;
+   }
+
+   lib = dlopen(lib_name, RTLD_NOW | RTLD_LOCAL);
+   if (!lib) {
+      printf("failed to load %s: %s\n", lib_name, dlerror());
+      return 1;
+   }
+   get_proc = (PFNEGLGETPROCADDRESSPROC) dlsym(lib, "eglGetProcAddress");
+   if (!get_proc) {
+      printf("%s is not an EGL library\n", lib_name);
+      return 1;
+   }
+
+   GET_PROC(PFNEGLGETPLATFORMDISPLAYEXTPROC, eglGetPlatformDisplayEXT);
+   GET_PROC(PFNEGLINITIALIZEPROC, eglInitialize);
+   GET_PROC(PFNEGLBINDAPIPROC, eglBindAPI);
+   GET_PROC(PFNEGLCHOOSECONFIGPROC, eglChooseConfig);
+   GET_PROC(PFNEGLCREATECONTEXTPROC, eglCreateContext);
+   GET_PROC(PFNEGLMAKECURRENTPROC, eglMakeCurrent);
+   GET_PROC(PFNEGLDESTROYCONTEXTPROC, eglDestroyContext);
+   GET_PROC(PFNEGLTERMINATEPROC, eglTerminate);
+
+   EGLDisplay dpy = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                             EGL_DEFAULT_DISPLAY, NULL);
+   if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)) {
+      printf("failed to initialize a surfaceless EGL display\n");
+      return 1;
+   }
+   eglBindAPI(EGL_OPENGL_ES_API);
+
+   static const EGLint config_attribs[] = {
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_NONE,
+   };
+   static const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_NONE,
+   };
+   EGLConfig config;
+   EGLint num_configs;
+   if (!eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs) ||
+       !num_configs) {
+      printf("no GLES 3 config\n");
+      return 1;
+   }
+   EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT,
+                                     context_attribs);
+   if (ctx == EGL_NO_CONTEXT ||
+       !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+      printf("failed to make a surfaceless GLES 3 context current\n");
+      return 1;
+   }
+
+   GET_PROC(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers);
+   GET_PROC(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer);
+   GET_PROC(PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers);
+   GET_PROC(PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer);
+   GET_PROC(PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage);
+   GET_PROC(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer);
+   GET_PROC(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays);
+   GET_PROC(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray);
+   GET_PROC(PFNGLVIEWPORTPROC, glViewport);
+   GET_PROC(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation);
+   GET_PROC(PFNGLUSEPROGRAMPROC, glUseProgram);
+   GET_PROC(PFNGLUNIFORM1IPROC, glUniform1i);
+   GET_PROC(PFNGLUNIFORM4FVPROC, glUniform4fv);
+   GET_PROC(PFNGLDRAWARRAYSPROC, glDrawArrays);
+   GET_PROC(PFNGLFINISHPROC, glFinish);
+
+   GLuint fb, rb, vao;
+   glGenRenderbuffers(1, &rb);
+   glBindRenderbuffer(GL_RENDERBUFFER, rb);
+   glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 1, 1);
+   glGenFramebuffers(1, &fb);
+   glBindFramebuffer(GL_FRAMEBUFFER, fb);
+   glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_RENDERBUFFER, rb);
+   glGenVertexArrays(1, &vao);
+   glBindVertexArray(vao);
+   glViewport(0, 0, 1, 1);
+
+   GLuint progs[2] = { build_program(), build_program() };
+   if (!progs[0] || !progs[1]) {
+      printf("failed to link the shaders\n");
+      return 1;
+   }
+
+   static float values[NUM_VEC4][4];
+   GLint u_loc[2];
+   for (unsigned i = 0; i < 2; i++) {
+      u_loc[i] = glGetUniformLocation(progs[i], "u");
+      glUseProgram(progs[i]);
+      glUniform4fv(u_loc[i], NUM_VEC4, &values[0][0]);
+      glUniform1i(glGetUniformLocation(progs[i], "idx"), 0);
+   }
+   glUseProgram(progs[0]);
+
+   /* Warm up shader variants and upload buffers. */
+   for (unsigned i = 0; i < 64; i++)
+      glDrawArrays(GL_POINTS, 0, 1);
+   glFinish();
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < NUM_DRAWS; i++) {
+      if (!strcmp(mode, "switch")) {
+         glUseProgram(progs[i & 1]);
+      } else if (!strcmp(mode, "full")) {
+         values[0][0] = i;
+         glUniform4fv(u_loc[0], NUM_VEC4, &values[0][0]);
+      } else {
+         /* Update a different element every time, like per-object data. */
+         unsigned v = i % NUM_VEC4;
+         values[v][0] = i;
+         glUniform4fv(u_loc[0] + v, 1, values[v]);
+      }
+      glDrawArrays(GL_POINTS, 0, 1);
+   }
+   glFinish();
+
+   int64_t elapsed = os_time_get_nano() - start;
+
+   printf("%s: %u draws, %.1f ns/draw\n", mode, NUM_DRAWS,
+          (double)elapsed / NUM_DRAWS);
+
+   eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+   eglDestroyContext(dpy, ctx);
+   eglTerminate(dpy);
+   dlclose(lib);
+   return 0;
+}
@@ -0,0 +1,547 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks that lavapipe's graphics and async compute queues order their work
+ * by semaphores.  The same compute pipeline, which does x = 2 * x + 1 on
+ * every element of a buffer, is dispatched NUM_ROUNDS times on each queue,
+ * the two queues taking turns through a timeline semaphore.  All the
+ * compute queue's submits are made before the graphics queue's, so they
+ * wait for values that haven't been signaled yet.  The compute queue then
+ * signals a binary semaphore that the graphics queue waits on before copying
+ * the result to where the host checks it.
+ *
+ * The buffer is bound as a dynamic storage buffer, and the command buffers
+ * may be submitted more than once, so the dynamic offset is applied when
+ * the driver compiles them.
+ *
+ * The driver is loaded directly, without the Vulkan loader.
+ *
+ * Usage: ./lvp_queue_test /path/to/libvulkan_lvp.so
+ */
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#define NUM_ELEMS    4096
+#define NUM_ROUNDS   8
+
+typedef PFN_vkVoidFunction (VKAPI_PTR *PFN_icdGetInstanceProcAddr)(VkInstance instance,
+                                                                  const char *name);
+
+#define GET_INSTANCE_PROC(inst, name) \
+   PFN_##name name = (PFN_##name) get_instance_proc(inst, #name)
+#define GET_DEVICE_PROC(dev, name) \
+   PFN_##name name = (PFN_##name) vkGetDeviceProcAddr(dev, #name)
+
+/*
+ *             OpCapability Shader
+ *             OpMemoryModel Logical GLSL450
+ *             OpEntryPoint GLCompute %main "main" %gid
+ *             OpExecutionMode %main LocalSize 64 1 1
+ *             OpDecorate %gid BuiltIn GlobalInvocationId
+ *             OpDecorate %rta ArrayStride 4
+ *             OpMemberDecorate %struct 0 Offset 0
+ *             OpDecorate %struct BufferBlock
+ *             OpDecorate %buf DescriptorSet 0
+ *             OpDecorate %buf Binding 0
+ *     %void = OpTypeVoid
+ *       %fn = OpTypeFunction %void
+ *     %uint = OpTypeInt 32 0
+ *   %v3uint = OpTypeVector %uint 3
+ * %ptr_in_v3 = OpTypePointer Input %v3uint
+ *      %gid = OpVariable %ptr_in_v3 Input
+ * %ptr_in_uint = OpTypePointer Input %uint
+ *      %rta = OpTypeRuntimeArray %uint
+ *   %struct = OpTypeStruct %rta
+ * %ptr_u_struct = OpTypePointer Uniform %struct
+ *      %buf = OpVariable %ptr_u_struct Uniform
+ * %ptr_u_uint = OpTypePointer Uniform %uint
+ *   %uint_0 = OpConstant %uint 0
+ *   %uint_1 = OpConstant %uint 1
+ *   %uint_2 = OpConstant %uint 2
+ *     %main = OpFunction %void None %fn
+ *    %label = OpLabel
+ *        %p = OpAccessChain %ptr_in_uint %gid %uint_0
+ *        %x = OpLoad %uint %p
+ *        %e = OpAccessChain %ptr_u_uint %buf %uint_0 %x
+ *        %v = OpLoad %uint %e
+ *        %m = OpIMul %uint %v %uint_2
+ *        %a = OpIAdd %uint %m %uint_1
+ *             OpStore %e %a
+ *             OpReturn
+ *             OpFunctionEnd
+ */
+static const uint32_t shader_words[] = {
+   0x07230203, 0x00010000, 0x00000000, 0x00000018, 0x00000000, 0x00020011,
+   0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0006000f, 0x00000005,
+   0x00000001, 0x6e69616d, 0x00000000, 0x00000002, 0x00060010, 0x00000001,
+   0x00000011, 0x00000040, 0x00000001, 0x00000001, 0x00040047, 0x00000002,
+   0x0000000b, 0x0000001c, 0x00040047, 0x00000003, 0x00000006, 0x00000004,
+   0x00050048, 0x00000004, 0x00000000, 0x00000023, 0x00000000, 0x00030047,
+   0x00000004, 0x00000003, 0x00040047, 0x00000005, 0x00000022, 0x00000000,
+   0x00040047, 0x00000005, 0x00000021, 0x00000000, 0x00020013, 0x00000006,
+   0x00030021, 0x00000007, 0x00000006, 0x00040015, 0x00000008, 0x00000020,
+   0x00000000, 0x00040017, 0x00000009, 0x00000008, 0x00000003, 0x00040020,
+   0x0000000a, 0x00000001, 0x00000009, 0x0004003b, 0x0000000a, 0x00000002,
+   0x00000001, 0x00040020, 0x0000000b, 0x00000001, 0x00000008, 0x0003001d,
+   0x00000003, 0x00000008, 0x0003001e, 0x00000004, 0x00000003, 0x00040020,
+   0x0000000c, 0x00000002, 0x00000004, 0x0004003b, 0x0000000c, 0x00000005,
+   0x00000002, 0x00040020, 0x0000000d, 0x00000002, 0x00000008, 0x0004002b,
+   0x00000008, 0x0000000e, 0x00000000, 0x0004002b, 0x00000008, 0x0000000f,
+   0x00000001, 0x0004002b, 0x00000008, 0x00000010, 0x00000002, 0x00050036,
+   0x00000006, 0x00000001, 0x00000000, 0x00000007, 0x000200f8, 0x00000011,
+   0x00050041, 0x0000000b, 0x00000012, 0x00000002, 0x0000000e, 0x0004003d,
+   0x00000008, 0x00000013, 0x00000012, 0x00060041, 0x0000000d, 0x00000014,
+   0x00000005, 0x0000000e, 0x00000013, 0x0004003d, 0x00000008, 0x00000015,
+   0x00000014, 0x00050084, 0x00000008, 0x00000016, 0x00000015, 0x00000010,
+   0x00050080, 0x00000008, 0x00000017, 0x00000016, 0x0000000f, 0x0003003e,
+   0x00000014, 0x00000017, 0x000100fd, 0x00010038,
+};
+
+int main(int argc, char **argv)
+{
+   void *lib;
+   PFN_icdGetInstanceProcAddr get_instance_proc;
+
+   if (argc != 2) {
+      printf("Usage: ./lvp_queue_test /path/to/libvulkan_lvp.so\n");
+      return 2;
+   }
+
+   lib = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL);
+   if (!lib) {
+      printf("failed to load %s: %s\n", argv[1], dlerror());
+      return 1;
+   }
+   get_instance_proc = (PFN_icdGetInstanceProcAddr)
+      dlsym(lib, "vk_icdGetInstanceProcAddr");
+   if (!get_instance_proc) {
+      printf("%s is not a Vulkan driver\n", argv[1]);
+      return 1;
+   }
+
+   GET_INSTANCE_PROC(NULL, vkCreateInstance);
+
+   const VkApplicationInfo app_info = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .pApplicationName = "lvp_queue_test",
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app_info,
+   };
+   VkInstance instance;
+   if (vkCreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+      printf("vkCreateInstance failed\n");
+      return 1;
+   }
+
+   GET_INSTANCE_PROC(instance, vkDestroyInstance);
+   GET_INSTANCE_PROC(instance, vkEnumeratePhysicalDevices);
+   GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+   GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceMemoryProperties);
+   GET_INSTANCE_PROC(instance, vkCreateDevice);
+   GET_INSTANCE_PROC(instance, vkGetDeviceProcAddr);
+
+   uint32_t num_pdevs = 1;
+   VkPhysicalDevice pdev;
+   vkEnumeratePhysicalDevices(instance, &num_pdevs, &pdev);
+   if (!num_pdevs) {
+      printf("no physical device\n");
+      return 1;
+   }
+
+   /* Family 0 is the universal one; look for one with compute only. */
+   VkQueueFamilyProperties families[8];
+   uint32_t num_families = 8;
+   uint32_t compute_family = UINT32_MAX;
+   vkGetPhysicalDeviceQueueFamilyProperties(pdev, &num_families, families);
+   for (uint32_t i = 0; i < num_families; i++) {
+      if ((families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+          !(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+         compute_family = i;
+   }
+   if (compute_family == UINT32_MAX) {
+      printf("no async compute queue family\n");
+      return 1;
+   }
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_infos[2] = {
+      {
+         .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+         .queueFamilyIndex = 0,
+         .queueCount = 1,
+         .pQueuePriorities = &priority,
+      },
+      {
+         .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+         .queueFamilyIndex = compute_family,
+         .queueCount = 1,
+         .pQueuePriorities = &priority,
+      },
+   };
+   const VkPhysicalDeviceVulkan12Features features12 = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .timelineSemaphore = VK_TRUE,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .pNext = &features12,
+      .queueCreateInfoCount = 2,
+      .pQueueCreateInfos = queue_infos,
+   };
+   VkDevice device;
+   if (vkCreateDevice(pdev, &device_info, NULL, &device) != VK_SUCCESS) {
+      printf("vkCreateDevice failed\n");
+      return 1;
+   }
+
+   GET_DEVICE_PROC(device, vkDestroyDevice);
+   GET_DEVICE_PROC(device, vkGetDeviceQueue);
+   GET_DEVICE_PROC(device, vkCreateBuffer);
+   GET_DEVICE_PROC(device, vkDestroyBuffer);
+   GET_DEVICE_PROC(device, vkGetBufferMemoryRequirements);
+   GET_DEVICE_PROC(device, vkAllocateMemory);
+   GET_DEVICE_PROC(device, vkFreeMemory);
+   GET_DEVICE_PROC(device, vkBindBufferMemory);
+   GET_DEVICE_PROC(device, vkMapMemory);
+   GET_DEVICE_PROC(device, vkCreateDescriptorSetLayout);
+   GET_DEVICE_PROC(device, vkDestroyDescriptorSetLayout);
+   GET_DEVICE_PROC(device, vkCreateDescriptorPool);
+   GET_DEVICE_PROC(device, vkDestroyDescriptorPool);
+   GET_DEVICE_PROC(device, vkAllocateDescriptorSets);
+   GET_DEVICE_PROC(device, vkUpdateDescriptorSets);
+   GET_DEVICE_PROC(device, vkCreatePipelineLayout);
+   GET_DEVICE_PROC(device, vkDestroyPipelineLayout);
+   GET_DEVICE_PROC(device, vkCreateShaderModule);
+   GET_DEVICE_PROC(device, vkDestroyShaderModule);
+   GET_DEVICE_PROC(device, vkCreateComputePipelines);
+   GET_DEVICE_PROC(device, vkDestroyPipeline);
+   GET_DEVICE_PROC(device, vkCreateCommandPool);
+   GET_DEVICE_PROC(device, vkDestroyCommandPool);
+   GET_DEVICE_PROC(device, vkAllocateCommandBuffers);
+   GET_DEVICE_PROC(device, vkBeginCommandBuffer);
+   GET_DEVICE_PROC(device, vkEndCommandBuffer);
+   GET_DEVICE_PROC(device, vkCmdBindPipeline);
+   GET_DEVICE_PROC(device, vkCmdBindDescriptorSets);
+   GET_DEVICE_PROC(device, vkCmdDispatch);
+   GET_DEVICE_PROC(device, vkCmdCopyBuffer);
+   GET_DEVICE_PROC(device, vkCreateSemaphore);
+   GET_DEVICE_PROC(device, vkDestroySemaphore);
+   GET_DEVICE_PROC(device, vkCreateFence);
+   GET_DEVICE_PROC(device, vkDestroyFence);
+   GET_DEVICE_PROC(device, vkWaitForFences);
+   GET_DEVICE_PROC(device, vkQueueSubmit);
+   GET_DEVICE_PROC(device, vkDeviceWaitIdle);
+
+   VkQueue queues[2];
+   vkGetDeviceQueue(device, 0, 0, &queues[0]);
+   vkGetDeviceQueue(device, compute_family, 0, &queues[1]);
+
+   /* The second half of the buffer is the shader's, through the dynamic
+    * offset.  The first half gets the copy of the result.
+    */
+   const uint32_t family_indices[2] = { 0, compute_family };
+   const VkBufferCreateInfo buffer_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = 2 * NUM_ELEMS * sizeof(uint32_t),
+      .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+               VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      .sharingMode = VK_SHARING_MODE_CONCURRENT,
+      .queueFamilyIndexCount = 2,
+      .pQueueFamilyIndices = family_indices,
+   };
+   VkBuffer buffer;
+   vkCreateBuffer(device, &buffer_info, NULL, &buffer);
+
+   VkMemoryRequirements reqs;
+   VkPhysicalDeviceMemoryProperties mem_props;
+   uint32_t mem_type = UINT32_MAX;
+   const VkMemoryPropertyFlags host_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+   vkGetBufferMemoryRequirements(device, buffer, &reqs);
+   vkGetPhysicalDeviceMemoryProperties(pdev, &mem_props);
+   for (uint32_t i = 0; i < mem_props.memoryTypeCount; i++) {
+      if ((reqs.memoryTypeBits & (1u << i)) &&
+          (mem_props.memoryTypes[i].propertyFlags & host_flags) == host_flags) {
+         mem_type = i;
+         break;
+      }
+   }
+   if (mem_type == UINT32_MAX) {
+      printf("no host visible memory type\n");
+      return 1;
+   }
+
+   const VkMemoryAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = reqs.size,
+      .memoryTypeIndex = mem_type,
+   };
+   VkDeviceMemory memory;
+   uint32_t *data;
+   vkAllocateMemory(device, &alloc_info, NULL, &memory);
+   vkBindBufferMemory(device, buffer, memory, 0);
+   vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, (void **)&data);
+   for (uint32_t i = 0; i < NUM_ELEMS; i++) {
+      data[i] = 0;
+      data[NUM_ELEMS + i] = i;
+   }
+
+   const VkDescriptorSetLayoutBinding binding = {
+      .binding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+   };
+   const VkDescriptorSetLayoutCreateInfo set_layout_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .bindingCount = 1,
+      .pBindings = &binding,
+   };
+   VkDescriptorSetLayout set_layout;
+   vkCreateDescriptorSetLayout(device, &set_layout_info, NULL, &set_layout);
+
+   const VkDescriptorPoolSize pool_size = {
+      .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+   };
+   const VkDescriptorPoolCreateInfo desc_pool_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .maxSets = 1,
+      .poolSizeCount = 1,
+      .pPoolSizes = &pool_size,
+   };
+   VkDescriptorPool desc_pool;
+   vkCreateDescriptorPool(device, &desc_pool_info, NULL, &desc_pool);
+
+   const VkDescriptorSetAllocateInfo set_alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = desc_pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &set_layout,
+   };
+   VkDescriptorSet set;
+   vkAllocateDescriptorSets(device, &set_alloc_info, &set);
+
+   const VkDescriptorBufferInfo desc_buffer_info = {
+      .buffer = buffer,
+      .offset = 0,
+      .range = NUM_ELEMS * sizeof(uint32_t),
+   };
+   const VkWriteDescriptorSet write = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = set,
+      .dstBinding = 0,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+      .pBufferInfo = &desc_buffer_info,
+   };
+   vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+
+   const VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &set_layout,
+   };
+   VkPipelineLayout layout;
+   vkCreatePipelineLayout(device, &layout_info, NULL, &layout);
+
+   const VkShaderModuleCreateInfo module_info = {
+      .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = sizeof(shader_words),
+      .pCode = shader_words,
+   };
+   VkShaderModule module;
+   vkCreateShaderModule(device, &module_info, NULL, &module);
+
+   const VkComputePipelineCreateInfo pipeline_info = {
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage = {
+         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+         .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+         .module = module,
+         .pName = "main",
+      },
+      .layout = layout,
+   };
+   VkPipeline pipeline;
+   if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info,
+                                NULL, &pipeline) != VK_SUCCESS) {
+      printf("vkCreateComputePipelines failed\n");
+      return 1;
+   }
+
+   /* The same dispatch on each queue, and the copy on the graphics one. */
+   VkCommandPool pools[2];
+   VkCommandBuffer dispatches[2], copy;
+   const uint32_t dynamic_offset = NUM_ELEMS * sizeof(uint32_t);
+   const VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+   };
+   for (unsigned q = 0; q < 2; q++) {
+      const VkCommandPoolCreateInfo pool_info = {
+         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+         .queueFamilyIndex = family_indices[q],
+      };
+      vkCreateCommandPool(device, &pool_info, NULL, &pools[q]);
+
+      const VkCommandBufferAllocateInfo cmd_alloc_info = {
+         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+         .commandPool = pools[q],
+         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+         .commandBufferCount = 1,
+      };
+      vkAllocateCommandBuffers(device, &cmd_alloc_info, &dispatches[q]);
+      if (q == 0)
+         vkAllocateCommandBuffers(device, &cmd_alloc_info, &copy);
+
+      vkBeginCommandBuffer(dispatches[q], &begin_info);
+      vkCmdBindPipeline(dispatches[q], VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+      vkCmdBindDescriptorSets(dispatches[q], VK_PIPELINE_BIND_POINT_COMPUTE,
+                              layout, 0, 1, &set, 1, &dynamic_offset);
+      vkCmdDispatch(dispatches[q], NUM_ELEMS / 64, 1, 1);
+      vkEndCommandBuffer(dispatches[q]);
+   }
+
+   const VkBufferCopy region = {
+      .srcOffset = NUM_ELEMS * sizeof(uint32_t),
+      .dstOffset = 0,
+      .size = NUM_ELEMS * sizeof(uint32_t),
+   };
+   vkBeginCommandBuffer(copy, &begin_info);
+   vkCmdCopyBuffer(copy, buffer, buffer, 1, &region);
+   vkEndCommandBuffer(copy);
+
+   const VkSemaphoreTypeCreateInfo timeline_type = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+   };
+   const VkSemaphoreCreateInfo timeline_info = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &timeline_type,
+   };
+   const VkSemaphoreCreateInfo binary_info = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+   };
+   const VkFenceCreateInfo fence_info = {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+   };
+   VkSemaphore timeline, binary;
+   VkFence fence;
+   vkCreateSemaphore(device, &timeline_info, NULL, &timeline);
+   vkCreateSemaphore(device, &binary_info, NULL, &binary);
+   vkCreateFence(device, &fence_info, NULL, &fence);
+
+   /* Round r runs on the graphics queue from value 2r to 2r + 1, then on
+    * the compute queue up to 2r + 2.  Queue the compute side first.
+    */
+   const VkPipelineStageFlags compute_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+   for (int q = 1; q >= 0; q--) {
+      for (uint64_t r = 0; r < NUM_ROUNDS; r++) {
+         const uint64_t wait_value = 2 * r + q;
+         const uint64_t signal_value = wait_value + 1;
+         const VkTimelineSemaphoreSubmitInfo timeline_submit = {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .waitSemaphoreValueCount = 1,
+            .pWaitSemaphoreValues = &wait_value,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &signal_value,
+         };
+         const VkSubmitInfo submit = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &timeline_submit,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &timeline,
+            .pWaitDstStageMask = &compute_stage,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &dispatches[q],
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &timeline,
+         };
+         if (vkQueueSubmit(queues[q], 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS) {
+            printf("vkQueueSubmit failed\n");
+            return 1;
+         }
+      }
+   }
+
+   /* Hand the result back to the graphics queue with a binary semaphore. */
+   const uint64_t last_value = 2 * NUM_ROUNDS;
+   const VkTimelineSemaphoreSubmitInfo last_wait = {
+      .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+      .waitSemaphoreValueCount = 1,
+      .pWaitSemaphoreValues = &last_value,
+   };
+   const VkSubmitInfo handoff = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .pNext = &last_wait,
+      .waitSemaphoreCount = 1,
+      .pWaitSemaphores = &timeline,
+      .pWaitDstStageMask = &compute_stage,
+      .signalSemaphoreCount = 1,
+      .pSignalSemaphores = &binary,
+   };
+   const VkPipelineStageFlags transfer_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+   const VkSubmitInfo readback = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .waitSemaphoreCount = 1,
+      .pWaitSemaphores = &binary,
+      .pWaitDstStageMask = &transfer_stage,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &copy,
+   };
+   if (vkQueueSubmit(queues[1], 1, &handoff, VK_NULL_HANDLE) != VK_SUCCESS ||
+       vkQueueSubmit(queues[0], 1, &readback, fence) != VK_SUCCESS) {
+      printf("vkQueueSubmit failed\n");
+      return 1;
+   }
+
+   if (vkWaitForFences(device, 1, &fence, VK_TRUE, 10000000000ull) != VK_SUCCESS) {
+      printf("timed out waiting for the queues\n");
+      return 1;
+   }
+
+   /* 2 * NUM_ROUNDS times x = 2 * x + 1 */
+   bool pass = true;
+   for (uint32_t i = 0; i < NUM_ELEMS; i++) {
+      const uint32_t expected = ((i + 1) << (2 * NUM_ROUNDS)) - 1;
+
+      if (data[i] != expected) {
+         printf("element %u: got 0x%08x, expected 0x%08x\n",
+                i, data[i], expected);
+         pass = false;
+         break;
+      }
+   }
+
+   vkDeviceWaitIdle(device);
+   vkDestroyFence(device, fence, NULL);
+   vkDestroySemaphore(device, binary, NULL);
+   vkDestroySemaphore(device, timeline, NULL);
+   for (unsigned q = 0; q < 2; q++)
+      vkDestroyCommandPool(device, pools[q], NULL);
+   vkDestroyPipeline(device, pipeline, NULL);
+   vkDestroyShaderModule(device, module, NULL);
+   vkDestroyPipelineLayout(device, layout, NULL);
+   vkDestroyDescriptorPool(device, desc_pool, NULL);
+   vkDestroyDescriptorSetLayout(device, set_layout, NULL);
+   vkDestroyBuffer(device, buffer, NULL);
+   vkFreeMemory(device, memory, NULL);
+   vkDestroyDevice(device, NULL);
+   vkDestroyInstance(instance, NULL);
+   dlclose(lib);
+
+   printf("%s\n", pass ? "pass" : "FAIL");
+   return pass ? 0 : 1;
+}
@@ -0,0 +1,544 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Submit throughput of lavapipe, in one of two modes:
+ *
+ *   replay:   a primary command buffer executes the same secondary many
+ *             times, the way engines replay prerecorded work every frame.
+ *             The secondary only holds dynamic state, push constants and
+ *             barriers, so the time measured is mostly command replay.
+ *             Run once with LVP_COMPILE_CMDS=0 to compare against walking
+ *             the recorded command lists.
+ *   dispatch: compute dispatches whose workgroups get more expensive with
+ *             their index, so an even split of the workgroups between the
+ *             compute threads is unbalanced.  Run once with
+ *             LP_PERF=no_cs_steal to compare against all threads claiming
+ *             workgroups from a single counter.  The results are checked.
+ *
+ * The driver is loaded directly, without the Vulkan loader.
+ *
+ * Usage: ./lvp_submit_bench /path/to/libvulkan_lvp.so [replay|dispatch]
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+#include "util/os_time.h"
+
+#define NUM_ITERS         64    /* state groups per secondary */
+#define NUM_SECONDARIES   64    /* secondaries executed per primary */
+#define NUM_SUBMITS       500
+#define CMDS_PER_ITER     8
+
+#define NUM_GROUPS        128   /* workgroups per dispatch */
+#define GROUP_SIZE        64
+#define NUM_DISPATCHES    4     /* dispatches per submit */
+#define NUM_DISPATCH_SUBMITS 20
+
+typedef PFN_vkVoidFunction (VKAPI_PTR *PFN_icdGetInstanceProcAddr)(VkInstance instance,
+                                                                  const char *name);
+
+static PFN_vkGetDeviceProcAddr get_device_proc;
+
+#define GET_INSTANCE_PROC(inst, name) \
+   PFN_##name name = (PFN_##name) get_instance_proc(inst, #name)
+#define GET_DEVICE_PROC(dev, name) \
+   PFN_##name name = (PFN_##name) get_device_proc(dev, #name)
+
+/*
+ * #version 450
+ * layout(local_size_x = 64) in;
+ * layout(set = 0, binding = 0) buffer B { uint data[]; };
+ * void main() {
+ *    uint v = gl_GlobalInvocationID.x;
+ *    for (uint i = 0; i < gl_WorkGroupID.x * 16 + 16; i++)
+ *       v = v * 1103515245u + 12345u;
+ *    data[gl_GlobalInvocationID.x] = v;
+ * }
+ */
+static const uint32_t uneven_cs[] = {
+   0x07230203, 0x00010000, 0x00000000, 0x00000027, 0x00000000, 0x00020011,
+   0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0007000f, 0x00000005,
+   0x00000001, 0x6e69616d, 0x00000000, 0x00000002, 0x00000003, 0x00060010,
+   0x00000001, 0x00000011, 0x00000040, 0x00000001, 0x00000001, 0x00040047,
+   0x00000002, 0x0000000b, 0x0000001c, 0x00040047, 0x00000003, 0x0000000b,
+   0x0000001a, 0x00040047, 0x00000004, 0x00000006, 0x00000004, 0x00050048,
+   0x00000005, 0x00000000, 0x00000023, 0x00000000, 0x00030047, 0x00000005,
+   0x00000003, 0x00040047, 0x00000006, 0x00000022, 0x00000000, 0x00040047,
+   0x00000006, 0x00000021, 0x00000000, 0x00020013, 0x00000007, 0x00030021,
+   0x00000008, 0x00000007, 0x00040015, 0x00000009, 0x00000020, 0x00000000,
+   0x00020014, 0x0000000a, 0x00040017, 0x0000000b, 0x00000009, 0x00000003,
+   0x00040020, 0x0000000c, 0x00000001, 0x0000000b, 0x0004003b, 0x0000000c,
+   0x00000002, 0x00000001, 0x0004003b, 0x0000000c, 0x00000003, 0x00000001,
+   0x0003001d, 0x00000004, 0x00000009, 0x0003001e, 0x00000005, 0x00000004,
+   0x00040020, 0x0000000d, 0x00000002, 0x00000005, 0x0004003b, 0x0000000d,
+   0x00000006, 0x00000002, 0x00040020, 0x0000000e, 0x00000002, 0x00000009,
+   0x0004002b, 0x00000009, 0x0000000f, 0x00000000, 0x0004002b, 0x00000009,
+   0x00000010, 0x00000001, 0x0004002b, 0x00000009, 0x00000011, 0x00000010,
+   0x0004002b, 0x00000009, 0x00000012, 0x41c64e6d, 0x0004002b, 0x00000009,
+   0x00000013, 0x00003039, 0x00050036, 0x00000007, 0x00000001, 0x00000000,
+   0x00000008, 0x000200f8, 0x00000014, 0x0004003d, 0x0000000b, 0x00000015,
+   0x00000002, 0x00050051, 0x00000009, 0x00000016, 0x00000015, 0x00000000,
+   0x0004003d, 0x0000000b, 0x00000017, 0x00000003, 0x00050051, 0x00000009,
+   0x00000018, 0x00000017, 0x00000000, 0x00050084, 0x00000009, 0x00000019,
+   0x00000018, 0x00000011, 0x00050080, 0x00000009, 0x0000001a, 0x00000019,
+   0x00000011, 0x000200f9, 0x0000001b, 0x000200f8, 0x0000001b, 0x000700f5,
+   0x00000009, 0x0000001c, 0x0000000f, 0x00000014, 0x0000001d, 0x0000001e,
+   0x000700f5, 0x00000009, 0x0000001f, 0x00000016, 0x00000014, 0x00000020,
+   0x0000001e, 0x000400f6, 0x00000021, 0x0000001e, 0x00000000, 0x000200f9,
+   0x00000022, 0x000200f8, 0x00000022, 0x000500b0, 0x0000000a, 0x00000023,
+   0x0000001c, 0x0000001a, 0x000400fa, 0x00000023, 0x00000024, 0x00000021,
+   0x000200f8, 0x00000024, 0x00050084, 0x00000009, 0x00000025, 0x0000001f,
+   0x00000012, 0x00050080, 0x00000009, 0x00000020, 0x00000025, 0x00000013,
+   0x000200f9, 0x0000001e, 0x000200f8, 0x0000001e, 0x00050080, 0x00000009,
+   0x0000001d, 0x0000001c, 0x00000010, 0x000200f9, 0x0000001b, 0x000200f8,
+   0x00000021, 0x00060041, 0x0000000e, 0x00000026, 0x00000006, 0x0000000f,
+   0x00000016, 0x0003003e, 0x00000026, 0x0000001f, 0x000100fd, 0x00010038,
+};
+
+static uint32_t
+expected_value(unsigned invocation)
+{
+   const unsigned group = invocation / GROUP_SIZE;
+   uint32_t v = invocation;
+
+   for (unsigned i = 0; i < group * 16 + 16; i++)
+      v = v * 1103515245u + 12345u;
+   return v;
+}
+
+static int
+bench_replay(VkDevice device, VkQueue queue, VkCommandPool pool,
+             VkFence fence)
+{
+   GET_DEVICE_PROC(device, vkAllocateCommandBuffers);
+   GET_DEVICE_PROC(device, vkBeginCommandBuffer);
+   GET_DEVICE_PROC(device, vkEndCommandBuffer);
+   GET_DEVICE_PROC(device, vkCreatePipelineLayout);
+   GET_DEVICE_PROC(device, vkDestroyPipelineLayout);
+   GET_DEVICE_PROC(device, vkWaitForFences);
+   GET_DEVICE_PROC(device, vkResetFences);
+   GET_DEVICE_PROC(device, vkQueueSubmit);
+   GET_DEVICE_PROC(device, vkCmdSetViewport);
+   GET_DEVICE_PROC(device, vkCmdSetScissor);
+   GET_DEVICE_PROC(device, vkCmdSetLineWidth);
+   GET_DEVICE_PROC(device, vkCmdSetCullMode);
+   GET_DEVICE_PROC(device, vkCmdSetFrontFace);
+   GET_DEVICE_PROC(device, vkCmdSetDepthTestEnable);
+   GET_DEVICE_PROC(device, vkCmdPushConstants);
+   GET_DEVICE_PROC(device, vkCmdPipelineBarrier);
+   GET_DEVICE_PROC(device, vkCmdExecuteCommands);
+
+   const VkPushConstantRange push_range = {
+      .stageFlags = VK_SHADER_STAGE_ALL,
+      .size = 16,
+   };
+   const VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_range,
+   };
+   VkPipelineLayout layout;
+   vkCreatePipelineLayout(device, &layout_info, NULL, &layout);
+
+   VkCommandBuffer primary, secondary;
+   VkCommandBufferAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+   };
+   vkAllocateCommandBuffers(device, &alloc_info, &primary);
+   alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+   vkAllocateCommandBuffers(device, &alloc_info, &secondary);
+
+   /* The secondary, executed many times from the same primary. */
+   const VkCommandBufferInheritanceInfo inheritance_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+   };
+   const VkCommandBufferBeginInfo secondary_begin = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+      .pInheritanceInfo = &inheritance_info,
+   };
+   const VkViewport viewport = { 0, 0, 256, 256, 0, 1 };
+   const VkRect2D scissor = { { 0, 0 }, { 256, 256 } };
+   const VkMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+   };
+   const float push_data[4] = { 0 };
+
+   vkBeginCommandBuffer(secondary, &secondary_begin);
+   for (unsigned i = 0; i < NUM_ITERS; i++) {
+      vkCmdSetViewport(secondary, 0, 1, &viewport);
+      vkCmdSetScissor(secondary, 0, 1, &scissor);
+      vkCmdSetLineWidth(secondary, 1.0f);
+      vkCmdSetCullMode(secondary, VK_CULL_MODE_BACK_BIT);
+      vkCmdSetFrontFace(secondary, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+      vkCmdSetDepthTestEnable(secondary, VK_TRUE);
+      vkCmdPushConstants(secondary, layout, VK_SHADER_STAGE_ALL, 0,
+                         sizeof(push_data), push_data);
+      vkCmdPipelineBarrier(secondary, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                           1, &barrier, 0, NULL, 0, NULL);
+   }
+   vkEndCommandBuffer(secondary);
+
+   VkCommandBuffer secondaries[NUM_SECONDARIES];
+   for (unsigned i = 0; i < NUM_SECONDARIES; i++)
+      secondaries[i] = secondary;
+
+   const VkCommandBufferBeginInfo primary_begin = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+   };
+   vkBeginCommandBuffer(primary, &primary_begin);
+   vkCmdExecuteCommands(primary, NUM_SECONDARIES, secondaries);
+   vkEndCommandBuffer(primary);
+
+   const VkSubmitInfo submit = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &primary,
+   };
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < NUM_SUBMITS; i++) {
+      vkQueueSubmit(queue, 1, &submit, fence);
+      vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+      vkResetFences(device, 1, &fence);
+   }
+   int64_t run_time = os_time_get_nano() - start;
+
+   const double cmds = (double)NUM_SUBMITS * NUM_SECONDARIES * NUM_ITERS *
+                       CMDS_PER_ITER;
+   printf("%u commands per submit\n", NUM_SECONDARIES * NUM_ITERS * CMDS_PER_ITER);
+   printf("%8.1f submits/s  %8.2f Mcmds/s\n",
+          NUM_SUBMITS * 1e9 / run_time, cmds * 1000.0 / run_time);
+
+   vkDestroyPipelineLayout(device, layout, NULL);
+   return 0;
+}
+
+static int
+bench_dispatch(VkDevice device, VkQueue queue, VkCommandPool pool,
+               VkFence fence)
+{
+   GET_DEVICE_PROC(device, vkAllocateCommandBuffers);
+   GET_DEVICE_PROC(device, vkBeginCommandBuffer);
+   GET_DEVICE_PROC(device, vkEndCommandBuffer);
+   GET_DEVICE_PROC(device, vkCreateBuffer);
+   GET_DEVICE_PROC(device, vkDestroyBuffer);
+   GET_DEVICE_PROC(device, vkGetBufferMemoryRequirements);
+   GET_DEVICE_PROC(device, vkAllocateMemory);
+   GET_DEVICE_PROC(device, vkFreeMemory);
+   GET_DEVICE_PROC(device, vkBindBufferMemory);
+   GET_DEVICE_PROC(device, vkMapMemory);
+   GET_DEVICE_PROC(device, vkCreateDescriptorSetLayout);
+   GET_DEVICE_PROC(device, vkDestroyDescriptorSetLayout);
+   GET_DEVICE_PROC(device, vkCreateDescriptorPool);
+   GET_DEVICE_PROC(device, vkDestroyDescriptorPool);
+   GET_DEVICE_PROC(device, vkAllocateDescriptorSets);
+   GET_DEVICE_PROC(device, vkUpdateDescriptorSets);
+   GET_DEVICE_PROC(device, vkCreatePipelineLayout);
+   GET_DEVICE_PROC(device, vkDestroyPipelineLayout);
+   GET_DEVICE_PROC(device, vkCreateShaderModule);
+   GET_DEVICE_PROC(device, vkDestroyShaderModule);
+   GET_DEVICE_PROC(device, vkCreateComputePipelines);
+   GET_DEVICE_PROC(device, vkDestroyPipeline);
+   GET_DEVICE_PROC(device, vkWaitForFences);
+   GET_DEVICE_PROC(device, vkResetFences);
+   GET_DEVICE_PROC(device, vkQueueSubmit);
+   GET_DEVICE_PROC(device, vkCmdBindPipeline);
+   GET_DEVICE_PROC(device, vkCmdBindDescriptorSets);
+   GET_DEVICE_PROC(device, vkCmdDispatch);
+   GET_DEVICE_PROC(device, vkCmdPipelineBarrier);
+
+   const VkDeviceSize size = NUM_GROUPS * GROUP_SIZE * sizeof(uint32_t);
+   const VkBufferCreateInfo buffer_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = size,
+      .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+   };
+   VkBuffer buffer;
+   vkCreateBuffer(device, &buffer_info, NULL, &buffer);
+
+   /* lavapipe's only memory type is host visible and coherent */
+   VkMemoryRequirements reqs;
+   vkGetBufferMemoryRequirements(device, buffer, &reqs);
+   const VkMemoryAllocateInfo mem_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = reqs.size,
+      .memoryTypeIndex = 0,
+   };
+   VkDeviceMemory mem;
+   vkAllocateMemory(device, &mem_info, NULL, &mem);
+   vkBindBufferMemory(device, buffer, mem, 0);
+   uint32_t *data;
+   vkMapMemory(device, mem, 0, size, 0, (void **)&data);
+   memset(data, 0, size);
+
+   const VkDescriptorSetLayoutBinding binding = {
+      .binding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+   };
+   const VkDescriptorSetLayoutCreateInfo set_layout_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .bindingCount = 1,
+      .pBindings = &binding,
+   };
+   VkDescriptorSetLayout set_layout;
+   vkCreateDescriptorSetLayout(device, &set_layout_info, NULL, &set_layout);
+
+   const VkDescriptorPoolSize pool_size = {
+      .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+   };
+   const VkDescriptorPoolCreateInfo desc_pool_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .maxSets = 1,
+      .poolSizeCount = 1,
+      .pPoolSizes = &pool_size,
+   };
+   VkDescriptorPool desc_pool;
+   vkCreateDescriptorPool(device, &desc_pool_info, NULL, &desc_pool);
+
+   const VkDescriptorSetAllocateInfo set_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = desc_pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &set_layout,
+   };
+   VkDescriptorSet set;
+   vkAllocateDescriptorSets(device, &set_info, &set);
+
+   const VkDescriptorBufferInfo desc_buffer = { buffer, 0, VK_WHOLE_SIZE };
+   const VkWriteDescriptorSet write = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = set,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .pBufferInfo = &desc_buffer,
+   };
+   vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+
+   const VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &set_layout,
+   };
+   VkPipelineLayout layout;
+   vkCreatePipelineLayout(device, &layout_info, NULL, &layout);
+
+   const VkShaderModuleCreateInfo module_info = {
+      .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = sizeof(uneven_cs),
+      .pCode = uneven_cs,
+   };
+   VkShaderModule module;
+   vkCreateShaderModule(device, &module_info, NULL, &module);
+
+   const VkComputePipelineCreateInfo pipeline_info = {
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage = {
+         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+         .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+         .module = module,
+         .pName = "main",
+      },
+      .layout = layout,
+   };
+   VkPipeline pipeline;
+   if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info,
+                                NULL, &pipeline) != VK_SUCCESS) {
+      printf("vkCreateComputePipelines failed\n");
+      return 1;
+   }
+
+   const VkCommandBufferAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+   };
+   VkCommandBuffer cmd;
+   vkAllocateCommandBuffers(device, &alloc_info, &cmd);
+
+   const VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+   };
+   const VkMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+   };
+   vkBeginCommandBuffer(cmd, &begin_info);
+   vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+   vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0,
+                           1, &set, 0, NULL);
+   for (unsigned i = 0; i < NUM_DISPATCHES; i++) {
+      vkCmdDispatch(cmd, NUM_GROUPS, 1, 1);
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                           1, &barrier, 0, NULL, 0, NULL);
+   }
+   vkEndCommandBuffer(cmd);
+
+   const VkSubmitInfo submit = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &cmd,
+   };
+
+   /* The first submit compiles the shader. */
+   vkQueueSubmit(queue, 1, &submit, fence);
+   vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+   vkResetFences(device, 1, &fence);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < NUM_DISPATCH_SUBMITS; i++) {
+      vkQueueSubmit(queue, 1, &submit, fence);
+      vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+      vkResetFences(device, 1, &fence);
+   }
+   int64_t run_time = os_time_get_nano() - start;
+
+   unsigned mismatches = 0;
+   for (unsigned i = 0; i < NUM_GROUPS * GROUP_SIZE; i++)
+      mismatches += data[i] != expected_value(i);
+
+   printf("%u dispatches of %u workgroups per submit\n", NUM_DISPATCHES,
+          NUM_GROUPS);
+   printf("%8.2f ms/dispatch\n",
+          run_time / 1e6 / (NUM_DISPATCH_SUBMITS * NUM_DISPATCHES));
+   if (mismatches)
+      printf("%u invocations wrote the wrong value\n", mismatches);
+
+   vkDestroyPipeline(device, pipeline, NULL);
+   vkDestroyShaderModule(device, module, NULL);
+   vkDestroyPipelineLayout(device, layout, NULL);
+   vkDestroyDescriptorPool(device, desc_pool, NULL);
+   vkDestroyDescriptorSetLayout(device, set_layout, NULL);
+   vkDestroyBuffer(device, buffer, NULL);
+   vkFreeMemory(device, mem, NULL);
+   return mismatches ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+   const char *mode = argc > 2 ? argv[2] : "replay";
+   void *lib;
+   PFN_icdGetInstanceProcAddr get_instance_proc;
+
+   if (argc < 2 || argc > 3 ||
+       (strcmp(mode, "replay") && strcmp(mode, "dispatch"))) {
+      printf("Usage: ./lvp_submit_bench /path/to/libvulkan_lvp.so "
+             "[replay|dispatch]\n");
+      return 2;
+   }
+
+   lib = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL);
+   if (!lib) {
+      printf("failed to load %s: %s\n", argv[1], dlerror());
+      return 1;
+   }
+   get_instance_proc = (PFN_icdGetInstanceProcAddr)
+      dlsym(lib, "vk_icdGetInstanceProcAddr");
+   if (!get_instance_proc) {
+      printf("%s is not a Vulkan driver\n", argv[1]);
+      return 1;
+   }
+
+   GET_INSTANCE_PROC(NULL, vkCreateInstance);
+
+   const VkApplicationInfo app_info = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .pApplicationName = "lvp_submit_bench",
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app_info,
+   };
+   VkInstance instance;
+   if (vkCreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+      printf("vkCreateInstance failed\n");
+      return 1;
+   }
+
+   GET_INSTANCE_PROC(instance, vkDestroyInstance);
+   GET_INSTANCE_PROC(instance, vkEnumeratePhysicalDevices);
+   GET_INSTANCE_PROC(instance, vkCreateDevice);
+   get_device_proc = (PFN_vkGetDeviceProcAddr)
+      get_instance_proc(instance, "vkGetDeviceProcAddr");
+
+   uint32_t num_pdevs = 1;
+   VkPhysicalDevice pdev;
+   vkEnumeratePhysicalDevices(instance, &num_pdevs, &pdev);
+   if (!num_pdevs) {
+      printf("no physical device\n");
+      return 1;
+   }
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueFamilyIndex = 0,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   VkDevice device;
+   if (vkCreateDevice(pdev, &device_info, NULL, &device) != VK_SUCCESS) {
+      printf("vkCreateDevice failed\n");
+      return 1;
+   }
+
+   GET_DEVICE_PROC(device, vkDestroyDevice);
+   GET_DEVICE_PROC(device, vkGetDeviceQueue);
+   GET_DEVICE_PROC(device, vkCreateCommandPool);
+   GET_DEVICE_PROC(device, vkDestroyCommandPool);
+   GET_DEVICE_PROC(device, vkCreateFence);
+   GET_DEVICE_PROC(device, vkDestroyFence);
+
+   VkQueue queue;
+   vkGetDeviceQueue(device, 0, 0, &queue);
+
+   const VkCommandPoolCreateInfo pool_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .queueFamilyIndex = 0,
+   };
+   VkCommandPool pool;
+   vkCreateCommandPool(device, &pool_info, NULL, &pool);
+
+   const VkFenceCreateInfo fence_info = {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+   };
+   VkFence fence;
+   vkCreateFence(device, &fence_info, NULL, &fence);
+
+   int ret;
+   if (!strcmp(mode, "dispatch"))
+      ret = bench_dispatch(device, queue, pool, fence);
+   else
+      ret = bench_replay(device, queue, pool, fence);
+
+   vkDestroyFence(device, fence, NULL);
+   vkDestroyCommandPool(device, pool, NULL);
+   vkDestroyDevice(device, NULL);
+   vkDestroyInstance(instance, NULL);
+   dlclose(lib);
+
+   return ret;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Vertex throughput of the translate module for a few common layouts,
+ * the way the draw module uses it for vertex fetch and emit.
+ *
+ * Usage: ./translate_bench [default|generic]
+ */
+
+#include <stdio.h>
+#include "translate/translate.h"
+#include "util/u_memory.h"
+#include "util/os_time.h"
+
+#define NUM_VERTS   4096
+#define NUM_LOOPS   2000
+
+struct bench_layout {
+   const char *name;
+   unsigned input_stride;
+   unsigned output_stride;
+   unsigned nr_elements;
+   struct {
+      enum pipe_format input_format;
+      unsigned input_offset;
+      enum pipe_format output_format;
+      unsigned output_offset;
+   } element[4];
+};
+
+static const struct bench_layout layouts[] = {
+   {
+      "fetch pos3f nrm3f tex2f col4ub", 36, 64, 4, {
+         { PIPE_FORMAT_R32G32B32_FLOAT, 0, PIPE_FORMAT_R32G32B32A32_FLOAT, 0 },
+         { PIPE_FORMAT_R32G32B32_FLOAT, 12, PIPE_FORMAT_R32G32B32A32_FLOAT, 16 },
+         { PIPE_FORMAT_R32G32_FLOAT, 24, PIPE_FORMAT_R32G32B32A32_FLOAT, 32 },
+         { PIPE_FORMAT_B8G8R8A8_UNORM, 32, PIPE_FORMAT_R32G32B32A32_FLOAT, 48 },
+      },
+   },
+   {
+      "fetch pos4f tex2h", 20, 32, 2, {
+         { PIPE_FORMAT_R32G32B32A32_FLOAT, 0, PIPE_FORMAT_R32G32B32A32_FLOAT, 0 },
+         { PIPE_FORMAT_R16G16_FLOAT, 16, PIPE_FORMAT_R32G32B32A32_FLOAT, 16 },
+      },
+   },
+   {
+      "emit pos4f col4ub tex2f", 48, 28, 3, {
+         { PIPE_FORMAT_R32G32B32A32_FLOAT, 0, PIPE_FORMAT_R32G32B32A32_FLOAT, 0 },
+         { PIPE_FORMAT_R32G32B32A32_FLOAT, 16, PIPE_FORMAT_B8G8R8A8_UNORM, 16 },
+         { PIPE_FORMAT_R32G32B32A32_FLOAT, 32, PIPE_FORMAT_R32G32_FLOAT, 20 },
+      },
+   },
+};
+
+int main(int argc, char **argv)
+{
+   struct translate *(*create_fn)(const struct translate_key *key) = NULL;
+   unsigned char *input, *output;
+   unsigned *elts;
+   unsigned i, l, n;
+
+   if (argc <= 1 || !strcmp(argv[1], "default"))
+      create_fn = translate_create;
+   else if (!strcmp(argv[1], "generic"))
+      create_fn = translate_generic_create;
+
+   if (!create_fn) {
+      printf("Usage: ./translate_bench [default|generic]\n");
+      return 2;
+   }
+
+   input = align_malloc(NUM_VERTS * 64, 64);
+   output = align_malloc(NUM_VERTS * 64, 64);
+   elts = align_malloc(NUM_VERTS * sizeof *elts, 64);
+
+   srand(4359025);
+   for (i = 0; i < NUM_VERTS * 64; i++)
+      input[i] = rand() & 0x3f;
+   for (i = 0; i < NUM_VERTS; i++)
+      elts[i] = rand() % NUM_VERTS;
+
+   for (l = 0; l < ARRAY_SIZE(layouts); l++) {
+      const struct bench_layout *layout = &layouts[l];
+      struct translate_key key;
+      struct translate *translate;
+      int64_t start, run_time, elts_time;
+
+      memset(&key, 0, sizeof key);
+      key.output_stride = layout->output_stride;
+      key.nr_elements = layout->nr_elements;
+      for (i = 0; i < layout->nr_elements; i++) {
+         key.element[i].type = TRANSLATE_ELEMENT_NORMAL;
+         key.element[i].input_format = layout->element[i].input_format;
+         key.element[i].input_offset = layout->element[i].input_offset;
+         key.element[i].output_format = layout->element[i].output_format;
+         key.element[i].output_offset = layout->element[i].output_offset;
+      }
+
+      translate = create_fn(&key);
+      if (!translate) {
+         printf("%-32s unsupported\n", layout->name);
+         continue;
+      }
+
+      translate->set_buffer(translate, 0, input, layout->input_stride,
+                            NUM_VERTS - 1);
+
+      start = os_time_get_nano();
+      for (n = 0; n < NUM_LOOPS; n++)
+         translate->run(translate, 0, NUM_VERTS, 0, 0, output);
+      run_time = os_time_get_nano() - start;
+
+      start = os_time_get_nano();
+      for (n = 0; n < NUM_LOOPS; n++)
+         translate->run_elts(translate, elts, NUM_VERTS, 0, 0, output);
+      elts_time = os_time_get_nano() - start;
+
+      printf("%-32s run %8.1f Mverts/s  run_elts %8.1f Mverts/s\n",
+             layout->name,
+             (double)NUM_VERTS * NUM_LOOPS * 1000.0 / run_time,
+             (double)NUM_VERTS * NUM_LOOPS * 1000.0 / elts_time);
+
+      translate->release(translate);
+   }
+
+   align_free(elts);
+   align_free(output);
+   align_free(input);
+
+   return 0;
+}
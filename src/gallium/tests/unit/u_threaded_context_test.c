@@ -0,0 +1,311 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Runs u_threaded_context on top of a driver that only counts calls, and
+ * checks the adaptive batch size and the buffer lists that batches flushed
+ * before they are full share:
+ *
+ * - the first batch to fill up doesn't change the limit,
+ * - the limit drops to TC_MIN_SLOTS_PER_BATCH while the driver thread is
+ *   idle and grows back to a full batch while it's busy,
+ * - early flushed batches move to a new buffer list once per full batch
+ *   worth of slots, not once per batch,
+ * - a buffer bound in a batch that has executed stays busy while the
+ *   batch it shares its buffer list with is still recording.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "util/os_time.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_threaded_context.h"
+#include "util/u_upload_mgr.h"
+
+struct mock_buffer {
+   struct threaded_resource b;
+   uint8_t *data;
+};
+
+static unsigned driver_calls;
+static unsigned driver_call_delay_us;
+static unsigned last_map_usage;
+
+
+static int
+mock_get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   return 0;
+}
+
+
+static int
+mock_get_shader_param(struct pipe_screen *screen, enum pipe_shader_type shader,
+                      enum pipe_shader_cap param)
+{
+   return 0;
+}
+
+
+static struct pipe_resource *
+mock_resource_create(struct pipe_screen *screen,
+                     const struct pipe_resource *templ)
+{
+   struct mock_buffer *buf = CALLOC_STRUCT(mock_buffer);
+
+   buf->b.b = *templ;
+   buf->b.b.screen = screen;
+   pipe_reference_init(&buf->b.b.reference, 1);
+   threaded_resource_init(&buf->b.b, false);
+   buf->b.buffer_id_unique = 1;
+   buf->data = CALLOC(1, templ->width0);
+   return &buf->b.b;
+}
+
+
+static void
+mock_resource_destroy(struct pipe_screen *screen, struct pipe_resource *res)
+{
+   struct mock_buffer *buf = (struct mock_buffer *)res;
+
+   threaded_resource_deinit(res);
+   FREE(buf->data);
+   FREE(buf);
+}
+
+
+static bool
+mock_is_resource_busy(struct pipe_screen *screen,
+                      struct pipe_resource *resource, unsigned usage)
+{
+   /* all the driver's work is done once it has executed a batch */
+   return false;
+}
+
+
+static void
+mock_set_blend_color(struct pipe_context *pipe,
+                     const struct pipe_blend_color *color)
+{
+   if (driver_call_delay_us)
+      os_time_sleep(driver_call_delay_us);
+   p_atomic_inc(&driver_calls);
+}
+
+
+static void
+mock_set_vertex_buffers(struct pipe_context *pipe, unsigned count,
+                        bool take_ownership,
+                        const struct pipe_vertex_buffer *buffers)
+{
+   for (unsigned i = 0; i < count; i++)
+      pipe_vertex_buffer_unreference((struct pipe_vertex_buffer *)&buffers[i]);
+}
+
+
+static void *
+mock_buffer_map(struct pipe_context *pipe, struct pipe_resource *resource,
+                unsigned level, unsigned usage, const struct pipe_box *box,
+                struct pipe_transfer **transfer)
+{
+   struct threaded_transfer *ttrans = CALLOC_STRUCT(threaded_transfer);
+
+   last_map_usage = usage;
+   pipe_resource_reference(&ttrans->b.resource, resource);
+   ttrans->b.usage = usage;
+   ttrans->b.box = *box;
+   *transfer = &ttrans->b;
+   return ((struct mock_buffer *)resource)->data + box->x;
+}
+
+
+static void
+mock_buffer_unmap(struct pipe_context *pipe, struct pipe_transfer *transfer)
+{
+   pipe_resource_reference(&transfer->resource, NULL);
+   FREE(transfer);
+}
+
+
+static void
+mock_destroy(struct pipe_context *pipe)
+{
+   u_upload_destroy(pipe->stream_uploader);
+   FREE(pipe);
+}
+
+
+static struct pipe_context *
+mock_context_create(struct pipe_screen *screen)
+{
+   struct pipe_context *pipe = CALLOC_STRUCT(pipe_context);
+
+   pipe->screen = screen;
+   pipe->destroy = mock_destroy;
+   pipe->set_blend_color = mock_set_blend_color;
+   pipe->set_vertex_buffers = mock_set_vertex_buffers;
+   pipe->buffer_map = mock_buffer_map;
+   pipe->buffer_unmap = mock_buffer_unmap;
+   pipe->stream_uploader = u_upload_create(pipe, 4096, PIPE_BIND_VERTEX_BUFFER,
+                                           PIPE_USAGE_STREAM, 0);
+   pipe->const_uploader = pipe->stream_uploader;
+   return pipe;
+}
+
+
+/* Records calls until the recording batch is flushed.  With wait_idle, the
+ * driver thread executes it before this returns.
+ */
+static void
+record_batch(struct threaded_context *tc, bool wait_idle)
+{
+   const struct pipe_blend_color color = {0};
+   const unsigned next = tc->next;
+
+   while (tc->next == next)
+      tc->base.set_blend_color(&tc->base, &color);
+
+   if (wait_idle)
+      util_queue_fence_wait(&tc->batch_slots[tc->last].fence);
+}
+
+
+static bool
+map_is_unsynchronized(struct pipe_context *pipe, struct pipe_resource *buf)
+{
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+
+   u_box_1d(0, buf->width0, &box);
+   pipe->buffer_map(pipe, buf, 0, PIPE_MAP_WRITE, &box, &transfer);
+   pipe->buffer_unmap(pipe, transfer);
+   return last_map_usage & PIPE_MAP_UNSYNCHRONIZED;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_screen screen = {
+      .get_param = mock_get_param,
+      .get_shader_param = mock_get_shader_param,
+      .resource_create = mock_resource_create,
+      .resource_destroy = mock_resource_destroy,
+   };
+   const struct threaded_context_options options = {
+      .is_resource_busy = mock_is_resource_busy,
+   };
+   struct slab_parent_pool transfer_pool;
+   struct threaded_context *tc;
+   bool pass = true;
+
+   slab_create_parent(&transfer_pool, sizeof(struct threaded_transfer), 16);
+   struct pipe_context *pipe =
+      threaded_context_create(mock_context_create(&screen), &transfer_pool,
+                              NULL, &options, &tc);
+   if (!tc) {
+      printf("GALLIUM_THREAD is disabled\n");
+      return 77;
+   }
+
+   /* Nothing has been flushed when the first batch fills up, so the
+    * driver thread can't look idle yet.
+    */
+   record_batch(tc, true);
+   if (tc->batch_slot_limit != TC_SLOTS_PER_BATCH - 1) {
+      printf("first batch changed the slot limit to %u\n",
+             tc->batch_slot_limit);
+      pass = false;
+   }
+
+   /* The driver thread waits for every batch. */
+   for (unsigned i = 0; i < 4; i++)
+      record_batch(tc, true);
+   if (tc->batch_slot_limit != TC_MIN_SLOTS_PER_BATCH) {
+      printf("slot limit is %u with an idle driver thread, expected %u\n",
+             tc->batch_slot_limit, TC_MIN_SLOTS_PER_BATCH);
+      pass = false;
+   }
+
+   /* Early flushed batches share buffer lists. */
+   unsigned batches = 0, buffer_lists = 0;
+   unsigned buf_list = tc->next_buf_list;
+   for (unsigned i = 0; i < 32; i++) {
+      record_batch(tc, true);
+      batches++;
+      if (tc->next_buf_list != buf_list) {
+         buf_list = tc->next_buf_list;
+         buffer_lists++;
+      }
+   }
+   /* four TC_MIN_SLOTS_PER_BATCH batches to a list, one might be cut short */
+   if (buffer_lists > batches / 3) {
+      printf("%u early flushed batches used %u buffer lists\n",
+             batches, buffer_lists);
+      pass = false;
+   }
+
+   /* Bind a buffer in a batch which shares its buffer list with the next
+    * one.  The buffer is busy until both have been flushed.
+    */
+   const struct pipe_resource templ = {
+      .target = PIPE_BUFFER,
+      .format = PIPE_FORMAT_R8_UNORM,
+      .width0 = 256,
+      .height0 = 1,
+      .depth0 = 1,
+      .array_size = 1,
+      .bind = PIPE_BIND_VERTEX_BUFFER,
+   };
+   struct pipe_resource *buf = screen.resource_create(&screen, &templ);
+   util_range_add(buf, &threaded_resource(buf)->valid_buffer_range, 0,
+                  buf->width0);
+
+   while (tc->buffer_list_slots + 2 * tc->batch_slot_limit >
+          TC_SLOTS_PER_BATCH - 1)
+      record_batch(tc, true);
+
+   struct pipe_vertex_buffer vb = {
+      .buffer.resource = buf,
+   };
+   pipe->set_vertex_buffers(pipe, 1, false, &vb);
+   record_batch(tc, true);
+   if (tc->batch_slots[tc->last].buffer_list_index != tc->next_buf_list) {
+      printf("early flushed batch didn't share its buffer list\n");
+      pass = false;
+   } else if (map_is_unsynchronized(pipe, buf)) {
+      printf("buffer of an unflushed buffer list mapped unsynchronized\n");
+      pass = false;
+   }
+
+   /* The synchronized map has executed everything. */
+   if (!map_is_unsynchronized(pipe, buf)) {
+      printf("idle buffer mapped synchronized\n");
+      pass = false;
+   }
+   pipe_resource_reference(&buf, NULL);
+
+   /* A slow driver thread makes the batches full again. */
+   driver_call_delay_us = 20;
+   for (unsigned i = 0; i < 2 * TC_MAX_BATCHES; i++)
+      record_batch(tc, false);
+   if (tc->batch_slot_limit != TC_SLOTS_PER_BATCH - 1) {
+      printf("slot limit is %u with a busy driver thread, expected %u\n",
+             tc->batch_slot_limit, TC_SLOTS_PER_BATCH - 1);
+      pass = false;
+   }
+   driver_call_delay_us = 0;
+
+   pipe->destroy(pipe);
+   slab_destroy_parent(&transfer_pool);
+
+   printf("%s\n", pass ? "PASS" : "FAIL");
+   return pass ? 0 : 1;
+}
@@ -215,9 +215,32 @@ class PrintCode(gl_XML.gl_print_base):
                         out('return;')
                     out('}')
 
-            # Add the call into the batch.
-            out('cmd = _mesa_glthread_allocate_command(ctx, '
-                'DISPATCH_CMD_{0}, cmd_size);'.format(func.name))
+            # Add the call into the batch, or overwrite the previous call if
+            # it sets the same state.
+            if func.marshal_coalesce:
+                assert not variable_params
+                keys = []
+                for name in func.marshal_coalesce.split():
+                    p = [p for p in fixed_params if p.name == name][0]
+                    if marshal_XML.get_marshal_type(func.name, p) == 'GLenum16':
+                        keys.append('cmd->{0} == MIN2({0}, 0xffff)'.format(name))
+                    else:
+                        keys.append('cmd->{0} == {0}'.format(name))
+
+                out('cmd = _mesa_glthread_get_coalescable_cmd(ctx, '
+                    'DISPATCH_CMD_{0});'.format(func.name))
+                out('if (!cmd || !({0})) {{'.format(' && '.join(keys)))
+                with indent():
+                    out('cmd = _mesa_glthread_allocate_command(ctx, '
+                        'DISPATCH_CMD_{0}, cmd_size);'.format(func.name))
+                    out('ctx->GLThread.LastCoalescableCmd = &cmd->cmd_base;')
+                out('} else {')
+                with indent():
+                    out('p_atomic_inc(&ctx->GLThread.stats.num_elided_cmds);')
+                out('}')
+            else:
+                out('cmd = _mesa_glthread_allocate_command(ctx, '
+                    'DISPATCH_CMD_{0}, cmd_size);'.format(func.name))
 
             for p in fixed_params:
                 type = marshal_XML.get_marshal_type(func.name, p)
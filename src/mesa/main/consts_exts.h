@@ -1007,6 +1007,12 @@ struct gl_constants
     */
    bool GLThreadNopCheckFramebufferStatus;
 
+   /**
+    * Whether glthread adapts its batch size to the load of the worker thread
+    * instead of only submitting full batches.
+    */
+   bool GLThreadAdaptiveBatchSize;
+
    /** GL_ARB_sparse_texture */
    GLuint MaxSparseTextureSize;
    GLuint MaxSparse3DTextureSize;
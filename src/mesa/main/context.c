@@ -131,6 +131,7 @@
 #include "shaderimage.h"
 #include "texcompress_s3tc.h"
 #include "texstate.h"
+#include "texstore.h"
 #include "transformfeedback.h"
 #include "mtypes.h"
 #include "varray.h"
@@ -1154,6 +1155,7 @@ _mesa_free_context_data(struct gl_context *ctx, bool destroy_debug_output)
    _mesa_free_feedback(ctx);
    _mesa_free_texture_data( ctx );
    _mesa_free_image_textures(ctx);
+   _mesa_free_texstore_data(ctx);
    _mesa_free_matrix_data( ctx );
    _mesa_free_pipeline_data(ctx);
    _mesa_free_program_data(ctx);
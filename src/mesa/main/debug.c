@@ -159,7 +159,8 @@ set_verbose_flags(const char *str)
       { "list",      VERBOSE_DISPLAY_LIST },
       { "lighting",  VERBOSE_LIGHTING },
       { "disassem",  VERBOSE_DISASSEM },
-      { "swap",      VERBOSE_SWAPBUFFERS }
+      { "swap",      VERBOSE_SWAPBUFFERS },
+      { "glthread",  VERBOSE_GLTHREAD }
    };
    GLuint i;
 
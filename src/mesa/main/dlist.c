@@ -13040,9 +13040,25 @@ execute_list(struct gl_context *ctx, GLuint list)
                                       (n[1].f, n[2].f, n[3].f, n[4].f,
                                        n[5].f, n[6].f, n[7].f, n[8].f));
             break;
-         case OPCODE_VERTEX_LIST:
-            vbo_save_playback_vertex_list(ctx, &n[0], false);
+         case OPCODE_VERTEX_LIST: {
+            /* Replay consecutive vertex lists together, so that states
+             * are validated once and draws are merged.
+             */
+            Node *last = n;
+            unsigned count = 1;
+
+            while (last[last[0].InstSize].opcode == OPCODE_VERTEX_LIST) {
+               last += last[0].InstSize;
+               count++;
+            }
+
+            if (count > 1)
+               vbo_save_playback_vertex_list_run(ctx, &n[0], count);
+            else
+               vbo_save_playback_vertex_list(ctx, &n[0], false);
+            n = last;
             break;
+         }
 
          case OPCODE_VERTEX_LIST_COPY_CURRENT:
             vbo_save_playback_vertex_list(ctx, &n[0], true);
@@ -39,6 +39,7 @@
 #include "util/u_atomic.h"
 #include "util/u_thread.h"
 #include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
 #include "util/thread_sched.h"
 
 #include "state_tracker/st_context.h"
@@ -183,6 +184,129 @@ glthread_apply_thread_sched_policy(struct gl_context *ctx, bool initialization)
    }
 }
 
+/* How many consecutive idle or busy observations of the worker thread are
+ * needed to change the batch size.
+ */
+#define BATCH_SIZE_HYSTERESIS 8
+
+/* How long filling a batch may take before an idle worker thread is worth
+ * smaller batches.
+ */
+#define BATCH_FILL_TARGET_NS 250000
+
+/**
+ * Measure how fast the application produces calls, over the same number of
+ * batches as the hysteresis, because os_time_get_nano() is expensive if the
+ * clock source is not TSC (see glthread_unmarshal_batch).
+ */
+static void
+glthread_sample_producer_rate(struct glthread_state *glthread)
+{
+   glthread->rate_elements += glthread->used;
+   if (++glthread->rate_batches < BATCH_SIZE_HYSTERESIS)
+      return;
+
+   int64_t now = os_time_get_nano();
+
+   /* Whether filling a whole batch at this rate takes too long. */
+   glthread->slow_producer =
+      (uint64_t)(now - glthread->rate_start_time) * glthread->batch_size >
+      (uint64_t)BATCH_FILL_TARGET_NS * glthread->rate_elements;
+
+   glthread->rate_start_time = now;
+   glthread->rate_elements = 0;
+   glthread->rate_batches = 0;
+}
+
+/**
+ * Adaptive batch sizing.
+ *
+ * Called when a batch is submitted or executed directly. If the worker thread
+ * has already finished the previous batch, it has been waiting for us, so
+ * smaller batches would have let it start sooner. That only matters if the
+ * application produces calls slowly, i.e. if filling a whole batch takes
+ * longer than BATCH_FILL_TARGET_NS. A fast producer keeps the worker waiting
+ * only briefly, and smaller batches would just add queue overhead. If the
+ * worker is still busy, the application produces calls faster than they are
+ * executed and bigger batches reduce the queue overhead per call.
+ *
+ * \param direct  whether the calls are executed by the application thread
+ *                because of a sync, which always counts as idle
+ */
+static void
+glthread_update_batch_size(struct glthread_state *glthread, bool worker_idle,
+                           bool direct)
+{
+   if (!glthread->adaptive_batch_size)
+      return;
+
+   glthread_sample_producer_rate(glthread);
+
+   if (worker_idle && !direct && !glthread->slow_producer)
+      return;
+
+   glthread->batch_size_votes += worker_idle ? -1 : 1;
+
+   if (glthread->batch_size_votes <= -BATCH_SIZE_HYSTERESIS) {
+      glthread->batch_size = MAX2(glthread->batch_size / 2,
+                                  MARSHAL_MIN_BATCH_SIZE / 8);
+      glthread->batch_size_votes = 0;
+   } else if (glthread->batch_size_votes >= BATCH_SIZE_HYSTERESIS) {
+      glthread->batch_size = MIN2(glthread->batch_size * 2,
+                                  MARSHAL_MAX_CMD_SIZE / 8);
+      glthread->batch_size_votes = 0;
+   }
+}
+
+static void
+glthread_record_batch_fill(struct glthread_state *glthread)
+{
+   p_atomic_add(&glthread->stats.batch_fill_percent_sum,
+                glthread->used * 100 / (MARSHAL_MAX_CMD_SIZE / 8));
+   p_atomic_inc(&glthread->stats.num_filled_batches);
+}
+
+/**
+ * Count a sync caused by \p func. Callers pass string literals, so they are
+ * identified by pointer.
+ */
+static void
+glthread_count_sync(struct glthread_state *glthread, const char *func)
+{
+   unsigned i;
+
+   for (i = 0; i < MARSHAL_MAX_SYNC_CALLERS - 1; i++) {
+      if (!glthread->sync_callers[i].func)
+         glthread->sync_callers[i].func = func;
+      if (glthread->sync_callers[i].func == func)
+         break;
+   }
+   glthread->sync_callers[i].count++;
+}
+
+static int
+compare_sync_callers(const void *a, const void *b)
+{
+   const struct glthread_sync_caller *ca = a, *cb = b;
+
+   return ca->count < cb->count ? 1 : ca->count > cb->count ? -1 : 0;
+}
+
+static void
+glthread_report_syncs(struct glthread_state *glthread)
+{
+   struct glthread_sync_caller *callers = glthread->sync_callers;
+
+   qsort(callers, MARSHAL_MAX_SYNC_CALLERS, sizeof(callers[0]),
+         compare_sync_callers);
+
+   _mesa_log("glthread: syncs per caller:\n");
+   for (unsigned i = 0; i < MARSHAL_MAX_SYNC_CALLERS && callers[i].count; i++) {
+      _mesa_log("  %8u %s\n", callers[i].count,
+                callers[i].func ? callers[i].func : "(other)");
+   }
+}
+
 static void
 glthread_thread_initialization(void *job, void *gdata, int thread_index)
 {
@@ -246,6 +370,12 @@ _mesa_glthread_init(struct gl_context *ctx)
    }
    glthread->next_batch = &glthread->batches[glthread->next];
    glthread->used = 0;
+   glthread->batch_size = MARSHAL_MAX_CMD_SIZE / 8;
+   glthread->adaptive_batch_size = ctx->Const.GLThreadAdaptiveBatchSize;
+   glthread->slow_producer = true;
+   glthread->report_syncs = debug_get_bool_option("MESA_GLTHREAD_SYNC_REPORT",
+                                                  false);
+   glthread->rate_start_time = os_time_get_nano();
    glthread->stats.queue = &glthread->queue;
 
    _mesa_glthread_init_call_fence(&glthread->LastProgramChangeBatch);
@@ -286,6 +416,9 @@ _mesa_glthread_destroy(struct gl_context *ctx)
    if (util_queue_is_initialized(&glthread->queue)) {
       util_queue_destroy(&glthread->queue);
 
+      if (glthread->report_syncs)
+         glthread_report_syncs(glthread);
+
       for (unsigned i = 0; i < MARSHAL_MAX_BATCHES; i++)
          util_queue_fence_destroy(&glthread->batches[i].fence);
 
@@ -357,6 +490,11 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
       (struct marshal_cmd_base *)&next->buffer[glthread->used];
    last->cmd_id = NUM_DISPATCH_CMD;
 
+   glthread_update_batch_size(glthread,
+      util_queue_fence_is_signalled(&glthread->batches[glthread->last].fence),
+      false);
+   glthread_record_batch_fill(glthread);
+
    p_atomic_add(&glthread->stats.num_offloaded_items, glthread->used);
    next->used = glthread->used;
 
@@ -369,6 +507,7 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
 
    glthread->LastCallList = NULL;
    glthread->LastBindBuffer = NULL;
+   glthread->LastCoalescableCmd = NULL;
 }
 
 /**
@@ -376,13 +515,15 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
  *
  * This can be used by the main thread to synchronize access to the context,
  * since the worker thread will be idle after this.
+ *
+ * \return whether the calling thread had to wait or execute queued calls
  */
-void
-_mesa_glthread_finish(struct gl_context *ctx)
+static bool
+glthread_finish(struct gl_context *ctx)
 {
    struct glthread_state *glthread = &ctx->GLThread;
    if (!glthread->enabled)
-      return;
+      return false;
 
    /* If this is called from the worker thread, then we've hit a path that
     * might be called from either the main thread or the worker (such as some
@@ -390,7 +531,7 @@ _mesa_glthread_finish(struct gl_context *ctx)
     * synchronize against ourself.
     */
    if (u_thread_is_self(glthread->queue.threads[0]))
-      return;
+      return false;
 
    struct glthread_batch *last = &glthread->batches[glthread->last];
    struct glthread_batch *next = glthread->next_batch;
@@ -409,12 +550,19 @@ _mesa_glthread_finish(struct gl_context *ctx)
          (struct marshal_cmd_base *)&next->buffer[glthread->used];
       last->cmd_id = NUM_DISPATCH_CMD;
 
+      /* The calls are executed by this thread, which is just as bad as
+       * the worker thread having been idle.
+       */
+      glthread_update_batch_size(glthread, true, true);
+      glthread_record_batch_fill(glthread);
+
       p_atomic_add(&glthread->stats.num_direct_items, glthread->used);
       next->used = glthread->used;
       glthread->used = 0;
 
       glthread->LastCallList = NULL;
       glthread->LastBindBuffer = NULL;
+      glthread->LastCoalescableCmd = NULL;
 
       /* Since glthread_unmarshal_batch changes the dispatch to direct,
        * restore it after it's done.
@@ -431,15 +579,29 @@ _mesa_glthread_finish(struct gl_context *ctx)
 
    if (synced)
       p_atomic_inc(&glthread->stats.num_syncs);
+
+   return synced;
+}
+
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   glthread_finish(ctx);
 }
 
 void
 _mesa_glthread_finish_before(struct gl_context *ctx, const char *func)
 {
-   _mesa_glthread_finish(ctx);
+   if (!glthread_finish(ctx))
+      return;
+
+   /* Counted in release builds too, use MESA_GLTHREAD_SYNC_REPORT=1 to print
+    * the totals, or MESA_VERBOSE=glthread to print every sync in debug builds.
+    */
+   glthread_count_sync(&ctx->GLThread, func);
 
-   /* Uncomment this if you want to know where glthread syncs. */
-   /*printf("fallback to sync: %s\n", func);*/
+   if (MESA_VERBOSE & VERBOSE_GLTHREAD)
+      _mesa_debug(ctx, "glthread: sync in %s\n", func);
 }
 
 void
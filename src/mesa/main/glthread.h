@@ -40,6 +40,11 @@
  */
 #define MARSHAL_MAX_CMD_SIZE (MARSHAL_MAX_CMD_BUFFER_SIZE - 8)
 
+/* The smallest batch size that adaptive batch sizing can select.
+ * See glthread_update_batch_size.
+ */
+#define MARSHAL_MIN_BATCH_SIZE 1024
+
 /* The number of batch slots in memory.
  *
  * One batch is being executed, one batch is being filled, the rest are
@@ -179,6 +184,17 @@ typedef enum {
    M_NUM_MATRIX_STACKS,
 } gl_matrix_index;
 
+/* The number of _mesa_glthread_finish_before callers whose syncs are
+ * counted separately. Syncs from other callers are counted together.
+ */
+#define MARSHAL_MAX_SYNC_CALLERS 32
+
+struct glthread_sync_caller
+{
+   const char *func;
+   unsigned count;
+};
+
 struct glthread_state
 {
    /** Multithreaded queue. */
@@ -216,6 +232,38 @@ struct glthread_state
    /** Number of uint64_t elements filled already. */
    unsigned used;
 
+   /**
+    * Number of uint64_t elements after which the batch is submitted.
+    * This is MARSHAL_MAX_CMD_SIZE / 8 unless the batch size is adaptive.
+    */
+   unsigned batch_size;
+   bool adaptive_batch_size;
+
+   /**
+    * Positive if the worker thread has recently been busy when we submitted
+    * a batch, negative if it has been idle.
+    */
+   int batch_size_votes;
+
+   /**
+    * Producer rate measurement for adaptive batch sizing: the number of
+    * uint64_t elements submitted in rate_batches batches since
+    * rate_start_time, and whether the last measurement was too slow to fill
+    * a batch in time. See glthread_sample_producer_rate.
+    */
+   int64_t rate_start_time;
+   unsigned rate_elements;
+   unsigned rate_batches;
+   bool slow_producer;
+
+   /**
+    * Number of syncs per _mesa_glthread_finish_before caller. The last entry
+    * has a NULL func and counts the callers that didn't fit. Printed when
+    * the context is destroyed if MESA_GLTHREAD_SYNC_REPORT is set.
+    */
+   struct glthread_sync_caller sync_callers[MARSHAL_MAX_SYNC_CALLERS];
+   bool report_syncs;
+
    /** Upload buffer. */
    struct gl_buffer_object *upload_buffer;
    uint8_t *upload_ptr;
@@ -281,6 +329,9 @@ struct glthread_state
    struct marshal_cmd_CallList *LastCallList;
    struct marshal_cmd_BindBuffer *LastBindBuffer;
 
+   /** The last added call of a function with marshal_coalesce. */
+   struct marshal_cmd_base *LastCoalescableCmd;
+
    /** Global mutex update info. */
    unsigned GlobalLockUpdateBatchCounter;
    bool LockGlobalMutexes;
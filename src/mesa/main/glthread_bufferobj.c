@@ -264,10 +264,12 @@ _mesa_marshal_BindBuffer(GLenum target, GLuint buffer)
        */
       if (target == last->target[0] && !last->buffer[0]) {
          last->buffer[0] = buffer;
+         p_atomic_inc(&glthread->stats.num_elided_cmds);
          return;
       }
       if (target == last->target[1] && !last->buffer[1]) {
          last->buffer[1] = buffer;
+         p_atomic_inc(&glthread->stats.num_elided_cmds);
          return;
       }
 
@@ -275,6 +277,7 @@ _mesa_marshal_BindBuffer(GLenum target, GLuint buffer)
       if (last->target[1] == 0) {
          last->target[1] = MIN2(target, 0xffff); /* clamped to 0xffff (invalid enum) */
          last->buffer[1] = buffer;
+         p_atomic_inc(&glthread->stats.num_elided_cmds);
          return;
       }
    }
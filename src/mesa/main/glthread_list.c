@@ -80,6 +80,7 @@ _mesa_marshal_CallList(GLuint list)
          glthread->used++;
       }
       assert(align(sizeof(*last) + last->num * 4, 8) / 8 == last->cmd_base.cmd_size);
+      p_atomic_inc(&glthread->stats.num_elided_cmds);
       return;
    }
 
@@ -34,6 +34,7 @@
 #include "main/context.h"
 #include "main/macros.h"
 #include "main/matrix.h"
+#include "util/u_atomic.h"
 
 struct marshal_cmd_base
 {
@@ -81,7 +82,7 @@ _mesa_glthread_allocate_command(struct gl_context *ctx,
 
    assert (num_elements <= MARSHAL_MAX_CMD_SIZE / 8);
 
-   if (unlikely(glthread->used + num_elements > MARSHAL_MAX_CMD_SIZE / 8))
+   if (unlikely(glthread->used + num_elements > glthread->batch_size))
       _mesa_glthread_flush_batch(ctx);
 
    struct glthread_batch *next = glthread->next_batch;
@@ -115,6 +116,23 @@ _mesa_glthread_call_is_last(struct glthread_state *glthread,
           &glthread->next_batch->buffer[glthread->used];
 }
 
+/**
+ * Return the previous command if it's of the given type and still the last
+ * one in the batch, so that a call setting the same state can overwrite it
+ * instead of queuing a new command. See "marshal_coalesce" in gl_API.dtd.
+ */
+static inline void *
+_mesa_glthread_get_coalescable_cmd(struct gl_context *ctx, uint16_t cmd_id)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   struct marshal_cmd_base *last = glthread->LastCoalescableCmd;
+
+   if (_mesa_glthread_call_is_last(glthread, last) && last->cmd_id == cmd_id)
+      return last;
+
+   return NULL;
+}
+
 static inline bool
 _mesa_glthread_has_no_pack_buffer(const struct gl_context *ctx)
 {
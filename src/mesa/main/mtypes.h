@@ -3285,6 +3285,12 @@ struct gl_context
 
    struct glthread_state GLThread;
 
+   /**
+    * Worker threads converting large texture uploads in _mesa_texstore,
+    * initialized on first use.
+    */
+   struct util_queue TexStoreQueue;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
@@ -3634,6 +3640,8 @@ struct gl_context
    GLfloat PrimitiveBoundingBox[8];
 
    struct disk_cache *Cache;
+   /** Programs preloaded from the cache, see shader_cache.cpp */
+   struct shader_cache_warm_start *ShaderCacheWarmStart;
 
    /**
     * \name GL_ARB_bindless_texture
@@ -3673,7 +3681,8 @@ enum _verbose
    VERBOSE_PRIMS		= 0x0400,
    VERBOSE_VERTS		= 0x0800,
    VERBOSE_DISASSEM		= 0x1000,
-   VERBOSE_SWAPBUFFERS          = 0x4000
+   VERBOSE_SWAPBUFFERS          = 0x4000,
+   VERBOSE_GLTHREAD             = 0x8000
 };
 
 
@@ -0,0 +1,144 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * \name texstore.cpp
+ *
+ * Check that large uploads converted by the texstore threads store the same
+ * texels as the calling thread does.  The images are split into bands of
+ * rows per slice, so the sizes are picked to leave a short last band, and
+ * the source rows are padded with GL_UNPACK_ROW_LENGTH.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "main/mtypes.h"
+#include "main/formats.h"
+#include "main/glformats.h"
+
+extern "C" {
+#include "main/texstore.h"
+}
+
+struct texstore_case {
+   const char *name;
+   GLuint dims;
+   GLint width, height, depth;
+   GLint row_length;
+   GLenum src_format, src_type;
+   GLenum base_format;
+   mesa_format dst_format;
+};
+
+static const texstore_case cases[] = {
+   /* odd height, last band of 47 rows */
+   { "rgb_ubyte_to_rgbx8", 2, 701, 751, 1, 736,
+     GL_RGB, GL_UNSIGNED_BYTE, GL_RGB, MESA_FORMAT_R8G8B8X8_UNORM },
+   /* depth slices, each of them smaller than a band */
+   { "bgra_ubyte_to_rgba8_3d", 3, 131, 61, 67, 140,
+     GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, MESA_FORMAT_R8G8B8A8_UNORM },
+   { "rgba_float_to_rgba16f", 2, 600, 1001, 1, 613,
+     GL_RGBA, GL_FLOAT, GL_RGBA, MESA_FORMAT_RGBA_FLOAT16 },
+   /* needs the rebase swizzle */
+   { "rgba_ubyte_to_luminance_alpha", 3, 513, 513, 2, 520,
+     GL_RGBA, GL_UNSIGNED_BYTE, GL_LUMINANCE_ALPHA,
+     MESA_FORMAT_R8G8B8A8_UNORM },
+};
+
+class TexstoreTest : public ::testing::Test {
+protected:
+   void SetUp() override;
+   void TearDown() override;
+
+   std::vector<uint8_t> store(struct gl_context *ctx, const char *threads,
+                              const texstore_case &c,
+                              const std::vector<uint8_t> &src);
+
+   struct gl_context *parallel_ctx;
+   struct gl_context *serial_ctx;
+};
+
+void
+TexstoreTest::SetUp()
+{
+   parallel_ctx = (struct gl_context *) calloc(1, sizeof(struct gl_context));
+   serial_ctx = (struct gl_context *) calloc(1, sizeof(struct gl_context));
+}
+
+void
+TexstoreTest::TearDown()
+{
+   _mesa_free_texstore_data(parallel_ctx);
+   _mesa_free_texstore_data(serial_ctx);
+   free(parallel_ctx);
+   free(serial_ctx);
+}
+
+/**
+ * Stores \p src with MESA_TEXSTORE_THREADS set to \p threads, which the
+ * context reads until its queue is created.
+ */
+std::vector<uint8_t>
+TexstoreTest::store(struct gl_context *ctx, const char *threads,
+                    const texstore_case &c, const std::vector<uint8_t> &src)
+{
+   const GLint dst_row_stride =
+      c.width * _mesa_get_format_bytes(c.dst_format) + 36;
+   const size_t slice_size = (size_t) dst_row_stride * c.height;
+   std::vector<uint8_t> dst(slice_size * c.depth, 0xcd);
+   std::vector<GLubyte *> dst_slices(c.depth);
+   struct gl_pixelstore_attrib packing = {};
+
+   packing.Alignment = 4;
+   packing.RowLength = c.row_length;
+
+   for (GLint z = 0; z < c.depth; z++)
+      dst_slices[z] = dst.data() + z * slice_size;
+
+   setenv("MESA_TEXSTORE_THREADS", threads, 1);
+   EXPECT_TRUE(_mesa_texstore(ctx, c.dims, c.base_format, c.dst_format,
+                              dst_row_stride, dst_slices.data(),
+                              c.width, c.height, c.depth,
+                              c.src_format, c.src_type, src.data(), &packing));
+   unsetenv("MESA_TEXSTORE_THREADS");
+
+   return dst;
+}
+
+TEST_F(TexstoreTest, ParallelMatchesSerial)
+{
+   for (const texstore_case &c : cases) {
+      SCOPED_TRACE(c.name);
+
+      const GLint row_stride =
+         ALIGN(c.row_length * _mesa_bytes_per_pixel(c.src_format, c.src_type),
+               4);
+      std::vector<uint8_t> src((size_t) row_stride * c.height * c.depth);
+      unsigned seed = 1;
+
+      if (c.src_type == GL_FLOAT) {
+         float *texels = (float *) src.data();
+         for (size_t i = 0; i < src.size() / sizeof(float); i++) {
+            seed = seed * 1103515245 + 12345;
+            texels[i] = ((seed >> 8) & 0xffff) / 65535.0f;
+         }
+      } else {
+         for (size_t i = 0; i < src.size(); i++) {
+            seed = seed * 1103515245 + 12345;
+            src[i] = seed >> 16;
+         }
+      }
+
+      std::vector<uint8_t> serial = store(serial_ctx, "1", c, src);
+      std::vector<uint8_t> parallel = store(parallel_ctx, "4", c, src);
+
+      EXPECT_TRUE(util_queue_is_initialized(&parallel_ctx->TexStoreQueue));
+      EXPECT_FALSE(util_queue_is_initialized(&serial_ctx->TexStoreQueue));
+      EXPECT_EQ(0, memcmp(serial.data(), parallel.data(), serial.size()));
+   }
+}
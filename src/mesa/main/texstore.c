@@ -75,6 +75,9 @@
 #include "pixeltransfer.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_queue.h"
 
 #include "state_tracker/st_cb_texture.h"
 
@@ -675,6 +678,121 @@ texstore_compressed(TEXSTORE_PARAMS)
                            srcFormat, srcType, srcAddr, srcPacking);
 }
 
+/* Uploads with fewer texels than this are converted by the calling thread,
+ * because the thread handoff would cost more than it saves.
+ */
+#define TEXSTORE_PARALLEL_MIN_TEXELS   (512 * 512)
+#define TEXSTORE_MAX_THREADS           4
+#define TEXSTORE_ROWS_PER_JOB          64
+
+struct texstore_convert_job {
+   struct util_queue_fence fence;
+   void *dst;
+   uint32_t dstFormat;
+   size_t dstRowStride;
+   void *src;
+   uint32_t srcFormat;
+   size_t srcRowStride;
+   unsigned width, height;
+   uint8_t *rebaseSwizzle;
+};
+
+static void
+texstore_convert_execute(void *data, UNUSED void *gdata,
+                         UNUSED int thread_index)
+{
+   struct texstore_convert_job *job = (struct texstore_convert_job *)data;
+
+   _mesa_format_convert(job->dst, job->dstFormat, job->dstRowStride,
+                        job->src, job->srcFormat, job->srcRowStride,
+                        job->width, job->height, job->rebaseSwizzle);
+}
+
+static struct util_queue *
+get_texstore_queue(struct gl_context *ctx)
+{
+   if (!util_queue_is_initialized(&ctx->TexStoreQueue)) {
+      unsigned num_threads =
+         debug_get_num_option("MESA_TEXSTORE_THREADS",
+                              MIN2(util_get_cpu_caps()->nr_cpus,
+                                   TEXSTORE_MAX_THREADS));
+
+      if (num_threads < 2 ||
+          !util_queue_init(&ctx->TexStoreQueue, "texstore", 32, num_threads,
+                           UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL))
+         return NULL;
+   }
+   return &ctx->TexStoreQueue;
+}
+
+void
+_mesa_free_texstore_data(struct gl_context *ctx)
+{
+   if (util_queue_is_initialized(&ctx->TexStoreQueue))
+      util_queue_destroy(&ctx->TexStoreQueue);
+}
+
+/**
+ * Convert a large image with _mesa_format_convert by splitting it into
+ * bands of rows that are converted by the texstore worker threads.
+ *
+ * \return false if the image is too small or threads are unavailable, in
+ *         which case the caller must do the conversion.
+ */
+static bool
+texstore_convert_parallel(struct gl_context *ctx,
+                          mesa_format dstFormat, GLint dstRowStride,
+                          GLubyte **dstSlices,
+                          GLubyte *src, uint32_t srcMesaFormat,
+                          int srcRowStride,
+                          GLint srcWidth, GLint srcHeight, GLint srcDepth,
+                          uint8_t *rebaseSwizzle)
+{
+   if ((int64_t)srcWidth * srcHeight * srcDepth < TEXSTORE_PARALLEL_MIN_TEXELS)
+      return false;
+
+   struct util_queue *queue = get_texstore_queue(ctx);
+   if (!queue)
+      return false;
+
+   unsigned bands_per_image = DIV_ROUND_UP(srcHeight, TEXSTORE_ROWS_PER_JOB);
+   unsigned num_jobs = bands_per_image * srcDepth;
+   struct texstore_convert_job *jobs =
+      malloc(num_jobs * sizeof(struct texstore_convert_job));
+   if (!jobs)
+      return false;
+
+   struct texstore_convert_job *job = jobs;
+
+   for (int img = 0; img < srcDepth; img++) {
+      for (int y = 0; y < srcHeight; y += TEXSTORE_ROWS_PER_JOB, job++) {
+         job->dst = dstSlices[img] + (size_t)y * dstRowStride;
+         job->dstFormat = dstFormat;
+         job->dstRowStride = dstRowStride;
+         job->src = src + (size_t)y * srcRowStride;
+         job->srcFormat = srcMesaFormat;
+         job->srcRowStride = srcRowStride;
+         job->width = srcWidth;
+         job->height = MIN2(TEXSTORE_ROWS_PER_JOB, srcHeight - y);
+         job->rebaseSwizzle = rebaseSwizzle;
+
+         util_queue_fence_init(&job->fence);
+         util_queue_add_job(queue, job, &job->fence,
+                            texstore_convert_execute, NULL, 0);
+      }
+      src += (size_t)srcHeight * srcRowStride;
+   }
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
+   free(jobs);
+   return true;
+}
+
+
 static GLboolean
 texstore_rgba(TEXSTORE_PARAMS)
 {
@@ -814,12 +932,17 @@ texstore_rgba(TEXSTORE_PARAMS)
       needRebase = false;
    }
 
-   for (img = 0; img < srcDepth; img++) {
-      _mesa_format_convert(dstSlices[img], dstFormat, dstRowStride,
-                           src, srcMesaFormat, srcRowStride,
-                           srcWidth, srcHeight,
-                           needRebase ? rebaseSwizzle : NULL);
-      src += srcHeight * srcRowStride;
+   if (!texstore_convert_parallel(ctx, dstFormat, dstRowStride, dstSlices,
+                                  src, srcMesaFormat, srcRowStride,
+                                  srcWidth, srcHeight, srcDepth,
+                                  needRebase ? rebaseSwizzle : NULL)) {
+      for (img = 0; img < srcDepth; img++) {
+         _mesa_format_convert(dstSlices[img], dstFormat, dstRowStride,
+                              src, srcMesaFormat, srcRowStride,
+                              srcWidth, srcHeight,
+                              needRebase ? rebaseSwizzle : NULL);
+         src += srcHeight * srcRowStride;
+      }
    }
 
    free(tempImage);
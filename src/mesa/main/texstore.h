@@ -87,6 +87,9 @@ struct gl_texture_image;
 extern GLboolean
 _mesa_texstore(TEXSTORE_PARAMS);
 
+extern void
+_mesa_free_texstore_data(struct gl_context *ctx);
+
 extern GLboolean
 _mesa_texstore_needs_transfer_ops(struct gl_context *ctx,
                                   GLenum baseInternalFormat,
@@ -1280,6 +1280,94 @@ _mesa_flush_vertices_for_uniforms(struct gl_context *ctx,
    ctx->NewDriverState |= new_driver_state;
 }
 
+/**
+ * Tag the parameter lists of all programs that use the uniform as modified,
+ * so that the state tracker doesn't reuse a stale constant buffer upload.
+ */
+static void
+mark_uniform_values_changed(struct gl_shader_program *shProg,
+                            const struct gl_uniform_storage *uni)
+{
+   unsigned mask = uni->active_shader_mask;
+
+   while (mask) {
+      struct gl_linked_shader *sh = shProg->_LinkedShaders[u_bit_scan(&mask)];
+
+      if (sh && sh->Program->Parameters)
+         _mesa_parameter_values_changed(sh->Program->Parameters);
+   }
+}
+
+/**
+ * Like mark_uniform_values_changed(), but also record which bytes of each
+ * parameter list were written, so that the state tracker can update its
+ * previous constant buffer upload with just those bytes.
+ *
+ * \param packed_elem_bytes  size of one array element in packed driver
+ *                           storage, or 0 if the storage is not packed and
+ *                           the element_stride of each driver storage applies
+ */
+static void
+mark_uniform_range_changed(struct gl_shader_program *shProg,
+                           const struct gl_uniform_storage *uni,
+                           unsigned offset, unsigned count,
+                           unsigned packed_elem_bytes)
+{
+   unsigned mask = uni->active_shader_mask;
+
+   while (mask) {
+      struct gl_linked_shader *sh = shProg->_LinkedShaders[u_bit_scan(&mask)];
+
+      if (!sh || !sh->Program->Parameters)
+         continue;
+
+      struct gl_program_parameter_list *params = sh->Program->Parameters;
+      const uint8_t *values = (const uint8_t *)params->ParameterValues;
+      const unsigned size = params->NumParameterValues * sizeof(gl_constant_value);
+      bool found = false;
+
+      /* Each stage has its own parameter list, and the driver storage of
+       * this uniform that points into it is the one that was written.
+       */
+      for (unsigned s = 0; s < uni->num_driver_storage; s++) {
+         const struct gl_uniform_driver_storage *store = &uni->driver_storage[s];
+         const uint8_t *data = (const uint8_t *)store->data;
+
+         if (data < values || data >= values + size)
+            continue;
+
+         const unsigned elem_bytes =
+            packed_elem_bytes ? packed_elem_bytes : store->element_stride;
+         const unsigned begin = (data - values) + offset * elem_bytes;
+
+         _mesa_parameter_values_range_changed(params, begin,
+                                              MIN2(begin + count * elem_bytes,
+                                                   size));
+         found = true;
+      }
+
+      if (!found)
+         _mesa_parameter_values_changed(params);
+   }
+}
+
+/**
+ * Size of one array element of \p uni in packed driver uniform storage.
+ */
+static unsigned
+packed_uniform_elem_bytes(const struct gl_uniform_storage *uni)
+{
+   unsigned dword_components = uni->type->vector_elements;
+
+   /* 16-bit uniforms are packed. */
+   if (glsl_base_type_is_16bit(uni->type->base_type))
+      dword_components = DIV_ROUND_UP(dword_components, 2);
+
+   return sizeof(gl_constant_value) * dword_components *
+          uni->type->matrix_columns *
+          (glsl_base_type_is_64bit(uni->type->base_type) ? 2 : 1);
+}
+
 static bool
 copy_uniforms_to_storage(gl_constant_value *storage,
                          struct gl_uniform_storage *uni,
@@ -1488,8 +1576,9 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
     */
    bool ctx_flushed = false;
    gl_constant_value *storage;
-   if (ctx->Const.PackedDriverUniformStorage &&
-       (uni->is_bindless || !glsl_contains_opaque(uni->type))) {
+   const bool packed = ctx->Const.PackedDriverUniformStorage &&
+                       (uni->is_bindless || !glsl_contains_opaque(uni->type));
+   if (packed) {
       for (unsigned s = 0; s < uni->num_driver_storage; s++) {
          unsigned dword_components = components;
 
@@ -1518,6 +1607,17 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
    if (!ctx_flushed && !(glsl_type_is_sampler(uni->type) && uni->is_bindless))
       return; /* no change in uniform values */
 
+   if (ctx_flushed) {
+      /* Bindless handles are 64-bit in packed storage even though the
+       * uniform type isn't, so don't try to compute their range.
+       */
+      if (packed && uni->is_bindless)
+         mark_uniform_values_changed(shProg, uni);
+      else
+         mark_uniform_range_changed(shProg, uni, offset, count,
+                                    packed ? packed_uniform_elem_bytes(uni) : 0);
+   }
+
    /* If the uniform is a sampler, do the extra magic necessary to propagate
     * the changes through.
     */
@@ -1934,9 +2034,8 @@ _mesa_uniform_matrix(GLint location, GLsizei count,
     */
    gl_constant_value *storage;
    const unsigned elements = components * vectors;
+   bool flushed = false;
    if (ctx->Const.PackedDriverUniformStorage) {
-      bool flushed = false;
-
       for (unsigned s = 0; s < uni->num_driver_storage; s++) {
          unsigned dword_components = components;
 
@@ -1959,9 +2058,16 @@ _mesa_uniform_matrix(GLint location, GLsizei count,
       if (copy_uniform_matrix_to_storage(ctx, storage, uni, count, values,
                                          size_mul, offset, components, vectors,
                                          transpose, cols, rows, basicType,
-                                         true))
+                                         true)) {
          _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
+         flushed = true;
+      }
    }
+
+   if (flushed)
+      mark_uniform_range_changed(shProg, uni, offset, count,
+                                 ctx->Const.PackedDriverUniformStorage ?
+                                    packed_uniform_elem_bytes(uni) : 0);
 }
 
 static void
@@ -2109,6 +2215,8 @@ _mesa_uniform_handle(GLint location, GLsizei count, const GLvoid *values,
       _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
    }
 
+   mark_uniform_values_changed(shProg, uni);
+
    if (glsl_type_is_sampler(uni->type)) {
       /* Mark this bindless sampler as not bound to a texture unit because
        * it refers to a texture handle.
@@ -31,6 +31,7 @@
 #include "util/glheader.h"
 #include "main/macros.h"
 #include "main/errors.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "prog_instruction.h"
 #include "prog_parameter.h"
@@ -237,6 +238,69 @@ _mesa_reserve_parameter_storage(struct gl_program_parameter_list *paramList,
       memset(paramList->ParameterValues + oldValNum, 0,
              (paramList->SizeValues - oldValNum) * sizeof(gl_constant_value));
    }
+
+   _mesa_parameter_values_changed(paramList);
+}
+
+
+/**
+ * Give the parameter values a new serial number, so that any uploaded copy
+ * of them is considered stale.
+ *
+ * The serial is taken from a global counter rather than incremented per
+ * list, because lists are shared between contexts and a freed list may be
+ * reallocated at the same address.
+ */
+static unsigned
+new_values_serial(void)
+{
+   static uint32_t serial;
+
+   return p_atomic_inc_return(&serial);
+}
+
+void
+_mesa_parameter_values_changed(struct gl_program_parameter_list *paramList)
+{
+   paramList->ValuesSerial = new_values_serial();
+   paramList->DirtyBaseSerial = 0;
+}
+
+
+/**
+ * Like _mesa_parameter_values_changed(), but only the bytes [begin, end) of
+ * ParameterValues[] were written, so an upload tagged DirtyBaseSerial can
+ * be brought up to date by copying just the accumulated dirty range.
+ */
+void
+_mesa_parameter_values_range_changed(struct gl_program_parameter_list *paramList,
+                                     unsigned begin, unsigned end)
+{
+   paramList->ValuesSerial = new_values_serial();
+
+   if (!paramList->DirtyBaseSerial)
+      return;
+
+   if (paramList->DirtyEnd) {
+      paramList->DirtyBegin = MIN2(paramList->DirtyBegin, begin);
+      paramList->DirtyEnd = MAX2(paramList->DirtyEnd, end);
+   } else {
+      paramList->DirtyBegin = begin;
+      paramList->DirtyEnd = end;
+   }
+}
+
+
+/**
+ * Record that the current values have been uploaded under ValuesSerial,
+ * and start tracking the range written since then.
+ */
+void
+_mesa_parameter_values_uploaded(struct gl_program_parameter_list *paramList)
+{
+   paramList->DirtyBaseSerial = paramList->ValuesSerial;
+   paramList->DirtyBegin = 0;
+   paramList->DirtyEnd = 0;
 }
 
 
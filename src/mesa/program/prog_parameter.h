@@ -148,6 +148,24 @@ struct gl_program_parameter_list
    int UniformBytes;
    int FirstStateVarIndex;
    int LastStateVarIndex;
+
+   /**
+    * Globally unique tag of the current contents of ParameterValues[],
+    * excluding state vars (see StateFlags). It changes whenever the list
+    * is resized or uniform values are written through the API, so a driver
+    * may keep reusing an uploaded copy as long as the tag is unchanged.
+    */
+   unsigned ValuesSerial;
+
+   /**
+    * Byte range [DirtyBegin, DirtyEnd) of ParameterValues[] written through
+    * the API since the upload tagged DirtyBaseSerial. That upload with this
+    * range copied over it equals the current values. DirtyBaseSerial is 0
+    * when no such upload is known, and the range is empty when DirtyEnd is 0.
+    */
+   unsigned DirtyBaseSerial;
+   unsigned DirtyBegin;
+   unsigned DirtyEnd;
 };
 
 
@@ -165,6 +183,16 @@ _mesa_reserve_parameter_storage(struct gl_program_parameter_list *paramList,
                                 unsigned reserve_params,
                                 unsigned reserve_values);
 
+extern void
+_mesa_parameter_values_changed(struct gl_program_parameter_list *paramList);
+
+extern void
+_mesa_parameter_values_range_changed(struct gl_program_parameter_list *paramList,
+                                     unsigned begin, unsigned end);
+
+extern void
+_mesa_parameter_values_uploaded(struct gl_program_parameter_list *paramList);
+
 extern void
 _mesa_disallow_parameter_storage_realloc(struct gl_program_parameter_list *paramList);
 
@@ -383,6 +383,9 @@ st_update_array_impl(struct st_context *st)
    } else {
       st_update_array_templ<POPCNT, UPDATE_BUFFERS_ONLY>
          (st, enabled_attribs, enabled_user_attribs, nonzero_divisor_attribs);
+
+      if (unlikely(st->atom_stats))
+         st->atom_stats[ST_NEW_VERTEX_ARRAYS_INDEX].unchanged++;
    }
 }
 
@@ -37,6 +37,7 @@
 #include "main/shaderapi.h"
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
+#include "util/u_box.h"
 #include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
 #include "cso_cache/cso_context.h"
@@ -62,6 +63,75 @@ st_unbind_unused_cb0(struct st_context *st, enum pipe_shader_type shader_type)
    }
 }
 
+/**
+ * Whether the constant buffer of \p prog only holds values that are tracked
+ * by ValuesSerial. Programs whose constants also depend on GL state or
+ * per-context data written at upload time always take the upload path.
+ */
+static bool
+constbuf0_is_cacheable(const struct gl_program *prog)
+{
+   return !prog->Parameters->StateFlags &&
+          !prog->ati_fs &&
+          !prog->sh.NumSubroutineUniformRemapTable &&
+          !prog->sh.HasBoundBindlessSampler &&
+          !prog->sh.HasBoundBindlessImage;
+}
+
+/**
+ * Whether the last constant buffer uploaded for a stage still holds the
+ * current values of \p prog.
+ */
+static bool
+can_reuse_constbuf0(const struct gl_program *prog,
+                    const struct st_constbuf0_upload *last)
+{
+   return last->buffer &&
+          last->prog == prog &&
+          last->serial == prog->Parameters->ValuesSerial &&
+          constbuf0_is_cacheable(prog);
+}
+
+/**
+ * Whether the last constant buffer uploaded for a stage differs from the
+ * current values of \p prog only in the dirty range of its parameter list,
+ * and that range is small enough that copying the rest of the previous
+ * upload on the GPU beats copying all values from the CPU again.
+ *
+ * Drivers that can't copy on the GPU take this path too, so that the dirty
+ * range tracking is used and tested everywhere, but copy the rest from the
+ * CPU.
+ */
+static bool
+can_update_constbuf0(const struct st_context *st,
+                     const struct gl_program *prog,
+                     const struct st_constbuf0_upload *last)
+{
+   const struct gl_program_parameter_list *params = prog->Parameters;
+   const unsigned uniform_bytes = params->UniformBytes;
+
+   return last->buffer &&
+          last->prog == prog &&
+          params->DirtyBaseSerial &&
+          last->serial == params->DirtyBaseSerial &&
+          uniform_bytes >= 1024 &&
+          params->DirtyEnd <= uniform_bytes &&
+          params->DirtyEnd - params->DirtyBegin <= uniform_bytes / 2 &&
+          constbuf0_is_cacheable(prog);
+}
+
+/**
+ * Release the constant buffer uploads remembered for reuse.
+ */
+void
+st_release_constbuf0_uploads(struct st_context *st)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(st->state.constbuf0_upload); i++) {
+      pipe_resource_reference(&st->state.constbuf0_upload[i].buffer, NULL);
+      st->state.constbuf0_upload[i].prog = NULL;
+   }
+}
+
 /**
  * Pass the given program parameters to the graphics pipe as a
  * constant buffer.
@@ -121,30 +191,102 @@ st_upload_constants(struct st_context *st, struct gl_program *prog, gl_shader_st
 
       if (st->prefer_real_buffer_in_constbuf0) {
          struct pipe_context *pipe = st->pipe;
-         uint32_t *ptr;
-
-         const unsigned alignment = MAX2(
-            st->ctx->Const.UniformBufferOffsetAlignment, 64);
-
-         /* fetch_state always stores 4 components (16 bytes) per matrix row,
-          * but matrix rows are sometimes allocated partially, so add 12
-          * to compensate for the fetch_state defect.
-          */
-         u_upload_alloc(pipe->const_uploader, 0, paramBytes + 12,
-            alignment, &cb.buffer_offset, &cb.buffer, (void**)&ptr);
-
+         struct st_constbuf0_upload *last =
+            &st->state.constbuf0_upload[shader_type];
          int uniform_bytes = params->UniformBytes;
-         if (uniform_bytes)
-            memcpy(ptr, params->ParameterValues, uniform_bytes);
 
-         /* Upload the constants which come from fixed-function state, such as
-          * transformation matrices, fog factors, etc.
-          */
-         if (params->StateFlags)
-            _mesa_upload_state_parameters(st->ctx, params, ptr);
+         if (can_reuse_constbuf0(prog, last)) {
+            /* Nothing has changed since the last upload, so rebind it
+             * instead of copying the whole parameter list again. This is
+             * common when apps switch between a few programs per frame.
+             */
+            cb.buffer = last->buffer;
+            cb.buffer_offset = last->offset;
+            pipe->set_constant_buffer(pipe, shader_type, 0, false, &cb);
+         } else if (can_update_constbuf0(st, prog, last)) {
+            /* Only a few uniforms have changed since the last upload. Copy
+             * the unchanged bytes from it into a new suballocation, and only
+             * the changed ones from the CPU.
+             *
+             * CPU drivers copy the unchanged bytes from the parameter list
+             * instead, which holds the same values: their buffer copies are
+             * a memcpy too, and would wait for the scene that reads the
+             * upload buffer.
+             */
+            const unsigned begin = params->DirtyBegin;
+            const unsigned end = params->DirtyEnd;
+            const unsigned alignment = MAX2(
+               st->ctx->Const.UniformBufferOffsetAlignment, 64);
+            struct pipe_box box;
+            uint8_t *ptr;
+
+            u_upload_alloc(pipe->const_uploader, 0, paramBytes + 12,
+               alignment, &cb.buffer_offset, &cb.buffer, (void**)&ptr);
+
+            if (st->update_constbuf0_by_copy) {
+               memcpy(ptr + begin, (uint8_t*)params->ParameterValues + begin,
+                      end - begin);
+               u_upload_unmap(pipe->const_uploader);
+
+               if (begin) {
+                  u_box_1d(last->offset, begin, &box);
+                  pipe->resource_copy_region(pipe, cb.buffer, 0,
+                                             cb.buffer_offset, 0, 0,
+                                             last->buffer, 0, &box);
+               }
+               if (end < (unsigned)uniform_bytes) {
+                  u_box_1d(last->offset + end, uniform_bytes - end, &box);
+                  pipe->resource_copy_region(pipe, cb.buffer, 0,
+                                             cb.buffer_offset + end, 0, 0,
+                                             last->buffer, 0, &box);
+               }
+            } else {
+               memcpy(ptr, params->ParameterValues, uniform_bytes);
+               u_upload_unmap(pipe->const_uploader);
+            }
 
-         u_upload_unmap(pipe->const_uploader);
-         pipe->set_constant_buffer(pipe, shader_type, 0, true, &cb);
+            last->serial = params->ValuesSerial;
+            last->offset = cb.buffer_offset;
+            pipe_resource_reference(&last->buffer, cb.buffer);
+            _mesa_parameter_values_uploaded(params);
+
+            pipe->set_constant_buffer(pipe, shader_type, 0, true, &cb);
+         } else {
+            uint32_t *ptr;
+
+            const unsigned alignment = MAX2(
+               st->ctx->Const.UniformBufferOffsetAlignment, 64);
+
+            /* fetch_state always stores 4 components (16 bytes) per matrix
+             * row, but matrix rows are sometimes allocated partially, so add
+             * 12 to compensate for the fetch_state defect.
+             */
+            u_upload_alloc(pipe->const_uploader, 0, paramBytes + 12,
+               alignment, &cb.buffer_offset, &cb.buffer, (void**)&ptr);
+
+            if (uniform_bytes)
+               memcpy(ptr, params->ParameterValues, uniform_bytes);
+
+            /* Upload the constants which come from fixed-function state,
+             * such as transformation matrices, fog factors, etc.
+             */
+            if (params->StateFlags)
+               _mesa_upload_state_parameters(st->ctx, params, ptr);
+
+            u_upload_unmap(pipe->const_uploader);
+
+            /* Remember the upload. Suballocations are never rewritten by
+             * the uploader, so it stays valid for as long as we hold a
+             * reference.
+             */
+            last->prog = prog;
+            last->serial = params->ValuesSerial;
+            last->offset = cb.buffer_offset;
+            pipe_resource_reference(&last->buffer, cb.buffer);
+            _mesa_parameter_values_uploaded(params);
+
+            pipe->set_constant_buffer(pipe, shader_type, 0, true, &cb);
+         }
 
          /* Set inlinable constants. This is more involved because state
           * parameters are uploaded directly above instead of being loaded
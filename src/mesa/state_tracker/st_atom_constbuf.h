@@ -37,5 +37,7 @@ struct st_context;
 
 void st_upload_constants(struct st_context *st, struct gl_program *prog, gl_shader_stage stage);
 
+void st_release_constbuf0_uploads(struct st_context *st);
+
 
 #endif /* ST_ATOM_CONSTBUF_H */
@@ -395,6 +395,47 @@ try_cached_readpixels(struct st_context *st, struct gl_renderbuffer *rb,
    return dst;
 }
 
+/**
+ * Pack pixels with a compute shader instead of _mesa_readpixels, for the
+ * cases that can't be handled by blitting to a staging texture.
+ */
+static bool
+try_compute_readpixels(struct st_context *st, struct gl_renderbuffer *rb,
+                       GLint x, GLint y, GLsizei width, GLsizei height,
+                       GLenum format, GLenum type,
+                       const struct gl_pixelstore_attrib *pack,
+                       void *pixels)
+{
+   struct gl_context *ctx = st->ctx;
+   struct pipe_screen *screen = st->screen;
+   struct pipe_resource *src = rb->texture;
+   enum pipe_format src_format;
+
+   if (!st->allow_compute_based_texture_transfer &&
+       !st->force_compute_based_texture_transfer)
+      return false;
+
+   if (!src || rb->_BaseFormat != _mesa_get_format_base_format(rb->Format) ||
+       _mesa_readpixels_needs_slow_path(ctx, format, type, GL_TRUE) ||
+       needs_integer_signed_unsigned_conversion(ctx, format, type))
+      return false;
+
+   src_format = util_format_linear(rb->Format);
+   src_format = util_format_luminance_to_red(src_format);
+   src_format = util_format_intensity_to_red(src_format);
+
+   if (!src_format ||
+       !screen->is_format_supported(screen, src_format, src->target,
+                                    src->nr_samples, src->nr_storage_samples,
+                                    PIPE_BIND_SAMPLER_VIEW))
+      return false;
+
+   return st_ReadPixels_shader(ctx, rb,
+                               _mesa_fb_orientation(ctx->ReadBuffer) == Y_0_TOP,
+                               x, y, width, height, format, type, src_format,
+                               pack, pixels);
+}
+
 /**
  * This uses a blit to copy the read buffer to a texture format which matches
  * the format and type combo and then a fast read-back is done using memcpy.
@@ -565,5 +606,9 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    return;
 
 fallback:
+   if (try_compute_readpixels(st, rb, x, y, width, height, format, type,
+                              pack, pixels))
+      return;
+
    _mesa_readpixels(ctx, x, y, width, height, format, type, pack, pixels);
 }
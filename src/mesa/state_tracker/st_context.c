@@ -49,6 +49,7 @@
 #include "st_cb_feedback.h"
 #include "st_cb_flush.h"
 #include "st_atom.h"
+#include "st_atom_constbuf.h"
 #include "st_draw.h"
 #include "st_extensions.h"
 #include "st_gen_mipmap.h"
@@ -65,16 +66,57 @@
 #include "util/u_upload_mgr.h"
 #include "util/u_vbuf.h"
 #include "util/u_memory.h"
+#include "util/os_time.h"
 #include "util/hash_table.h"
 #include "util/thread_sched.h"
 #include "cso_cache/cso_context.h"
 #include "compiler/glsl/glsl_parser_extras.h"
+#include "compiler/glsl/shader_cache.h"
 
 DEBUG_GET_ONCE_BOOL_OPTION(mesa_mvp_dp4, "MESA_MVP_DP4", false)
 
 /* The list of state update functions. */
 st_update_func_t st_update_functions[ST_NUM_ATOMS];
 
+static const char *st_atom_names[ST_NUM_ATOMS] = {
+#define ST_STATE(FLAG, st_update) #FLAG,
+#include "st_atom_list.h"
+#undef ST_STATE
+};
+
+/* Same as st_validate_state, but it also collects per-atom statistics. */
+void
+st_validate_state_with_stats(struct st_context *st, uint64_t dirty)
+{
+   while (dirty) {
+      unsigned i = u_bit_scan64(&dirty);
+      int64_t start = os_time_get_nano();
+
+      st_update_functions[i](st);
+
+      st->atom_stats[i].count++;
+      st->atom_stats[i].time_ns += os_time_get_nano() - start;
+   }
+}
+
+static void
+st_print_atom_stats(struct st_context *st)
+{
+   fprintf(stderr, "st: %-32s %12s %12s %10s %12s\n", "atom", "count",
+           "unchanged", "time (ms)", "ns/call");
+
+   for (unsigned i = 0; i < ST_NUM_ATOMS; i++) {
+      const struct st_atom_stats *stats = &st->atom_stats[i];
+
+      if (!stats->count)
+         continue;
+
+      fprintf(stderr, "st: %-32s %12"PRIu64" %12"PRIu64" %10.3f %12"PRIu64"\n",
+              st_atom_names[i], stats->count, stats->unchanged,
+              stats->time_ns / 1000000.0, stats->time_ns / stats->count);
+   }
+}
+
 static void
 init_atoms_once(void)
 {
@@ -145,11 +187,12 @@ st_invalidate_state(struct gl_context *ctx)
    if (new_state & _NEW_PIXEL)
       ctx->NewDriverState |= ST_NEW_PIXEL_TRANSFER;
 
-   if (new_state & _NEW_CURRENT_ATTRIB && st_vp_uses_current_values(ctx)) {
+   /* Only the vertex buffer with current values needs to be updated.
+    * The vbo module sets NewVertexElements when the format of a current
+    * value changes (e.g. glColor3f -> glColor4f).
+    */
+   if (new_state & _NEW_CURRENT_ATTRIB && st_vp_uses_current_values(ctx))
       ctx->NewDriverState |= ST_NEW_VERTEX_ARRAYS;
-      /* glColor3f -> glColor4f changes the vertex format. */
-      ctx->Array.NewVertexElements = true;
-   }
 
    /* Update the vertex shader if ctx->Light._ClampVertexColor was changed. */
    if (st->clamp_vert_color_in_shader && (new_state & _NEW_LIGHT_STATE)) {
@@ -362,6 +405,12 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
 
    st_destroy_bound_texture_handles(st);
    st_destroy_bound_image_handles(st);
+   st_release_constbuf0_uploads(st);
+
+   if (st->atom_stats) {
+      st_print_atom_stats(st);
+      free(st->atom_stats);
+   }
 
    /* free glReadPixels cache data */
    st_invalidate_readpix_cache(st);
@@ -461,6 +510,9 @@ st_create_context_priv(struct gl_context *ctx, struct pipe_context *pipe,
    st->screen = screen;
    st->pipe = pipe;
 
+   if (ST_DEBUG & DEBUG_ATOMS)
+      st->atom_stats = calloc(ST_NUM_ATOMS, sizeof(*st->atom_stats));
+
    st->can_bind_const_buffer_as_vertex =
       screen->get_param(screen, PIPE_CAP_CAN_BIND_CONST_BUFFER_AS_VERTEX);
 
@@ -626,6 +678,9 @@ st_create_context_priv(struct gl_context *ctx, struct pipe_context *pipe,
       !screen->get_param(screen, PIPE_CAP_CLIP_PLANES);
    st->prefer_real_buffer_in_constbuf0 =
       screen->get_param(screen, PIPE_CAP_PREFER_REAL_BUFFER_IN_CONSTBUF0);
+   /* Buffer copies are only cheaper than CPU uploads on real GPUs. */
+   st->update_constbuf0_by_copy = st->prefer_real_buffer_in_constbuf0 &&
+      screen->get_param(screen, PIPE_CAP_ACCELERATED) > 0;
    st->has_conditional_render =
       screen->get_param(screen, PIPE_CAP_CONDITIONAL_RENDER);
    st->lower_rect_tex =
@@ -866,6 +921,8 @@ st_create_context(gl_api api, struct pipe_context *pipe,
    if (pipe->screen->get_disk_shader_cache)
       ctx->Cache = pipe->screen->get_disk_shader_cache(pipe->screen);
 
+   shader_cache_warm_start_init(ctx);
+
    /* XXX: need a capability bit in gallium to query if the pipe
     * driver prefers DP4 or MUL/MAD for vertex transformation.
     */
@@ -880,6 +937,7 @@ st_create_context(gl_api api, struct pipe_context *pipe,
 
    st = st_create_context_priv(ctx, pipe, options);
    if (!st) {
+      shader_cache_warm_start_fini(ctx);
       _mesa_free_context_data(ctx, true);
       align_free(ctx);
    }
@@ -945,6 +1003,8 @@ st_destroy_context(struct st_context *st)
    /* This must be called first so that glthread has a chance to finish */
    _mesa_glthread_destroy(ctx);
 
+   shader_cache_warm_start_fini(ctx);
+
    _mesa_HashWalk(ctx->Shared->TexObjects, destroy_tex_sampler_cb, st);
 
    /* For the fallback textures, free any sampler views belonging to this
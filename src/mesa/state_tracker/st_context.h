@@ -121,6 +121,30 @@ struct st_zombie_shader_node
 };
 
 
+/** Per-atom statistics collected with ST_DEBUG=atoms. */
+struct st_atom_stats
+{
+   uint64_t count;      /**< number of executions */
+   uint64_t time_ns;    /**< total CPU time spent in the atom */
+   /** Executions that reused the previously computed CSO. Only counted by
+    * atoms that can tell, currently ST_NEW_VERTEX_ARRAYS.
+    */
+   uint64_t unchanged;
+};
+
+
+/**
+ * Last constant buffer 0 uploaded for a shader stage, see
+ * st_upload_constants().
+ */
+struct st_constbuf0_upload
+{
+   const struct gl_program *prog;
+   unsigned serial; /**< gl_program_parameter_list::ValuesSerial */
+   struct pipe_resource *buffer;
+   unsigned offset;
+};
+
 struct st_context
 {
    struct gl_context *ctx;
@@ -174,6 +198,7 @@ struct st_context
    bool lower_two_sided_color;
    bool lower_ucp;
    bool prefer_real_buffer_in_constbuf0;
+   bool update_constbuf0_by_copy;
    bool has_conditional_render;
    bool lower_rect_tex;
 
@@ -225,6 +250,7 @@ struct st_context
       unsigned num_images[PIPE_SHADER_TYPES];
       struct pipe_clip_state clip;
       unsigned constbuf0_enabled_shader_mask;
+      struct st_constbuf0_upload constbuf0_upload[PIPE_SHADER_TYPES];
       unsigned fb_width;
       unsigned fb_height;
       unsigned fb_num_samples;
@@ -359,6 +385,9 @@ struct st_context
 
    bool uses_user_vertex_buffers;
 
+   /** ST_NUM_ATOMS entries if ST_DEBUG=atoms is set, NULL otherwise. */
+   struct st_atom_stats *atom_stats;
+
    unsigned last_used_atomic_bindings[PIPE_SHADER_TYPES];
    unsigned last_num_ssbos[PIPE_SHADER_TYPES];
 
@@ -518,6 +547,9 @@ typedef void (*st_update_func_t)(struct st_context *st);
 
 extern st_update_func_t st_update_functions[ST_NUM_ATOMS];
 
+void
+st_validate_state_with_stats(struct st_context *st, uint64_t dirty);
+
 #ifdef __cplusplus
 }
 #endif
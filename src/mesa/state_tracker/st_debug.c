@@ -52,6 +52,7 @@ static const struct debug_named_value st_debug_flags[] = {
    { "wf",       DEBUG_WIREFRAME, NULL },
    { "gremedy",  DEBUG_GREMEDY, "Enable GREMEDY debug extensions" },
    { "noreadpixcache", DEBUG_NOREADPIXCACHE, NULL },
+   { "atoms",    DEBUG_ATOMS, "Print how often each state atom runs and its CPU time" },
    DEBUG_NAMED_VALUE_END
 };
 
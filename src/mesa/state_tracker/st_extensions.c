@@ -1838,6 +1838,7 @@ void st_init_extensions(struct pipe_screen *screen,
       options->allow_draw_out_of_order &&
       screen->get_param(screen, PIPE_CAP_ALLOW_DRAW_OUT_OF_ORDER);
    consts->GLThreadNopCheckFramebufferStatus = options->glthread_nop_check_framebuffer_status;
+   consts->GLThreadAdaptiveBatchSize = options->glthread_batch_policy == 1;
 
    const struct nir_shader_compiler_options *nir_options =
       consts->ShaderCompilerOptions[MESA_SHADER_FRAGMENT].NirOptions;
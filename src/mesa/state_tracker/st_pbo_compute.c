@@ -25,6 +25,7 @@
  */
 
 #include <stdbool.h>
+#include "main/glformats.h"
 #include "main/image.h"
 #include "main/pbo.h"
 
@@ -1230,6 +1231,50 @@ copy_converted_buffer(struct gl_context * ctx,
    pipe_buffer_unmap(st->pipe, xfer);
 }
 
+/* Choose the buffer format written by the conversion shader and the extra
+ * swizzling needed to produce the GL format/type.
+ */
+static enum pipe_format
+get_download_dst_format(struct gl_context *ctx, enum pipe_format src_format,
+                        GLenum format, GLenum type,
+                        enum swizzle_clamp *swizzle_clamp)
+{
+   enum pipe_format dst_format =
+      st_pbo_get_dst_format(ctx, PIPE_BUFFER, src_format, false, format, type, 0);
+
+   if (dst_format == PIPE_FORMAT_NONE) {
+      bool need_bgra_swizzle = false;
+      dst_format = get_convert_format(ctx, src_format, format, type, &need_bgra_swizzle);
+      if (dst_format == PIPE_FORMAT_NONE)
+         return PIPE_FORMAT_NONE;
+      /* special swizzling for component selection */
+      if (need_bgra_swizzle)
+         *swizzle_clamp |= SWIZZLE_CLAMP_BGRA;
+      else if (format == GL_GREEN_INTEGER)
+         *swizzle_clamp |= SWIZZLE_CLAMP_GREEN;
+      else if (format == GL_BLUE_INTEGER)
+         *swizzle_clamp |= SWIZZLE_CLAMP_BLUE;
+   }
+   return dst_format;
+}
+
+static bool
+can_download_compute(struct pipe_resource *src, enum pipe_format src_format,
+                     enum pipe_format dst_format)
+{
+   /* I don't know why this works
+    * only for the texture rects
+    * but that's how it is
+    */
+   return !((src->target != PIPE_TEXTURE_RECT &&
+            /* this would need multiple samplerviews */
+            ((util_format_is_depth_and_stencil(src_format) && util_format_is_depth_and_stencil(dst_format)) ||
+            /* these format just doesn't work and science can't explain why */
+            dst_format == PIPE_FORMAT_Z32_FLOAT)) ||
+            /* L8 -> L32_FLOAT is another thinker */
+            (!util_format_is_float(src_format) && dst_format == PIPE_FORMAT_L32_FLOAT));
+}
+
 bool
 st_GetTexSubImage_shader(struct gl_context * ctx,
                          GLint xoffset, GLint yoffset, GLint zoffset,
@@ -1276,21 +1321,9 @@ st_GetTexSubImage_shader(struct gl_context * ctx,
          swizzle_clamp = SWIZZLE_CLAMP_RGBX;
    }
 
-   dst_format = st_pbo_get_dst_format(ctx, PIPE_BUFFER, src_format, false, format, type, 0);
-
-   if (dst_format == PIPE_FORMAT_NONE) {
-      bool need_bgra_swizzle = false;
-      dst_format = get_convert_format(ctx, src_format, format, type, &need_bgra_swizzle);
-      if (dst_format == PIPE_FORMAT_NONE)
-         return false;
-      /* special swizzling for component selection */
-      if (need_bgra_swizzle)
-         swizzle_clamp |= SWIZZLE_CLAMP_BGRA;
-      else if (format == GL_GREEN_INTEGER)
-         swizzle_clamp |= SWIZZLE_CLAMP_GREEN;
-      else if (format == GL_BLUE_INTEGER)
-         swizzle_clamp |= SWIZZLE_CLAMP_BLUE;
-   }
+   dst_format = get_download_dst_format(ctx, src_format, format, type, &swizzle_clamp);
+   if (dst_format == PIPE_FORMAT_NONE)
+      return false;
 
    /* check with the driver to see if memcpy is likely to be faster */
    if (!st->force_compute_based_texture_transfer &&
@@ -1298,17 +1331,7 @@ st_GetTexSubImage_shader(struct gl_context * ctx,
       return false;
 
    view_target = get_target_from_texture(src);
-   /* I don't know why this works
-    * only for the texture rects
-    * but that's how it is
-    */
-   if ((src->target != PIPE_TEXTURE_RECT &&
-       /* this would need multiple samplerviews */
-       ((util_format_is_depth_and_stencil(src_format) && util_format_is_depth_and_stencil(dst_format)) ||
-       /* these format just doesn't work and science can't explain why */
-       dst_format == PIPE_FORMAT_Z32_FLOAT)) ||
-       /* L8 -> L32_FLOAT is another thinker */
-       (!util_format_is_float(src_format) && dst_format == PIPE_FORMAT_L32_FLOAT))
+   if (!can_download_compute(src, src_format, dst_format))
       return false;
 
    dst = download_texture_compute(st, &ctx->Pack, xoffset, yoffset, zoffset, width, height, depth,
@@ -1327,6 +1350,75 @@ st_GetTexSubImage_shader(struct gl_context * ctx,
    return true;
 }
 
+/**
+ * Pack a glReadPixels region with the conversion shader. This covers the
+ * format/type combinations that st_ReadPixels can't blit to a matching
+ * staging texture, which would otherwise be packed on the CPU.
+ *
+ * \param invert_y  whether the renderbuffer is stored upside down, i.e.
+ *                  it's a window-system buffer
+ */
+bool
+st_ReadPixels_shader(struct gl_context *ctx, struct gl_renderbuffer *rb,
+                     bool invert_y,
+                     GLint x, GLint y, GLsizei width, GLsizei height,
+                     GLenum format, GLenum type,
+                     enum pipe_format src_format,
+                     const struct gl_pixelstore_attrib *pack, void *pixels)
+{
+   struct st_context *st = st_context(ctx);
+   struct pipe_screen *screen = st->screen;
+   struct pipe_resource *src = rb->texture;
+   struct pipe_resource *dst;
+   enum swizzle_clamp swizzle_clamp = 0;
+   enum pipe_format dst_format;
+
+   /* PBOs are handled by try_pbo_readpixels, and multisampled renderbuffers
+    * can't be sampled.
+    */
+   if (pack->BufferObj || src->nr_samples > 1 ||
+       _mesa_is_depth_or_stencil_format(format))
+      return false;
+
+   /* The memcpy-based fast path is better in this case. */
+   if (_mesa_format_matches_format_and_type(rb->Format, format, type,
+                                            pack->SwapBytes, NULL))
+      return false;
+
+   dst_format = get_download_dst_format(ctx, src_format, format, type, &swizzle_clamp);
+   if (dst_format == PIPE_FORMAT_NONE)
+      return false;
+
+   /* check with the driver to see if memcpy is likely to be faster */
+   if (!st->force_compute_based_texture_transfer &&
+       !screen->is_compute_copy_faster(screen, src_format, dst_format, width, height, 1, true))
+      return false;
+
+   if (!can_download_compute(src, src_format, dst_format))
+      return false;
+
+   /* Flipping window-system buffers is the same as MESA_pack_invert. */
+   struct gl_pixelstore_attrib packing = *pack;
+   if (invert_y) {
+      y = rb->Height - y - height;
+      packing.Invert = !packing.Invert;
+   }
+
+   enum pipe_texture_target view_target = get_target_from_texture(src);
+   dst = download_texture_compute(st, &packing, x, y, 0, width, height, 1,
+                                  rb->surface->u.tex.level,
+                                  rb->surface->u.tex.first_layer,
+                                  format, type, src_format, view_target, src,
+                                  dst_format, swizzle_clamp);
+   if (!dst)
+      return false;
+
+   copy_converted_buffer(ctx, &packing, view_target, dst, dst_format, x, y, 0,
+                         width, height, 1, format, type, pixels);
+   pipe_resource_reference(&dst, NULL);
+   return true;
+}
+
 void
 st_pbo_compute_deinit(struct st_context *st)
 {
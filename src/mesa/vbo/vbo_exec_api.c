@@ -233,8 +233,10 @@ vbo_exec_copy_to_current(struct vbo_exec_context *exec)
          /* The format changed. We need to update gallium vertex elements.
           * Material attributes don't need this because they don't have formats.
           */
-         if (i <= VBO_ATTRIB_EDGEFLAG)
+         if (i <= VBO_ATTRIB_EDGEFLAG) {
             ctx->NewState |= _NEW_CURRENT_ATTRIB;
+            ctx->Array.NewVertexElements = true;
+         }
       }
    }
 
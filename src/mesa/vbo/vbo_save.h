@@ -146,6 +146,10 @@ void _vbo_loopback_vertex_list(struct gl_context *ctx,
 void
 vbo_save_playback_vertex_list(struct gl_context *ctx, void *data, bool copy_to_current);
 
+void
+vbo_save_playback_vertex_list_run(struct gl_context *ctx, void *data,
+                                  unsigned count);
+
 void
 vbo_save_playback_vertex_list_loopback(struct gl_context *ctx, void *data);
 
@@ -90,8 +90,10 @@ copy_vao(struct gl_context *ctx, const struct gl_vertex_array_object *vao,
           (size >> dmul_shift) != currval->Format.User.Size) {
          vbo_set_vertex_format(&currval->Format, size >> dmul_shift, type);
          /* The format changed. We need to update gallium vertex elements. */
-         if (state == _NEW_CURRENT_ATTRIB)
+         if (state == _NEW_CURRENT_ATTRIB) {
             ctx->NewState |= state;
+            ctx->Array.NewVertexElements = true;
+         }
       }
 
       *data += size;
@@ -189,21 +191,68 @@ vbo_save_playback_vertex_list_loopback(struct gl_context *ctx, void *data)
 enum vbo_save_status {
    DONE,
    USE_SLOW_PATH,
+   READY_TO_DRAW,
 };
 
-static enum vbo_save_status
-vbo_save_playback_vertex_list_gallium(struct gl_context *ctx,
-                                      const struct vbo_save_vertex_list *node,
-                                      bool copy_to_current)
+/**
+ * Get a reference to node->state[mode] that can be passed to the driver
+ * with take_vertex_state_ownership. Return false if the node doesn't belong
+ * to this context and the driver must take its own reference.
+ */
+static bool
+get_private_vertex_state_reference(struct gl_context *ctx,
+                                   const struct vbo_save_vertex_list *node,
+                                   gl_vertex_processing_mode mode)
 {
-   /* Don't use this if selection or feedback mode is enabled. st/mesa can't
-    * handle it.
+   if (node->ctx != ctx)
+      return false;
+
+   /* This mechanism allows passing references to the driver without
+    * using atomics to increase the reference count.
+    *
+    * This private refcount can be decremented without atomics but only
+    * one context (ctx above) can use this counter (so that it's only
+    * used by 1 thread).
+    *
+    * This number is atomically added to reference.count at
+    * initialization. If it's never used, the same number is atomically
+    * subtracted from reference.count before destruction. If this number
+    * is decremented, we can pass one reference to the driver without
+    * touching reference.count with atomics. At destruction we only
+    * subtract the number of references we have not returned. This can
+    * possibly turn a million atomic increments into 1 add and 1 subtract
+    * atomic op over the whole lifetime of an app.
     */
-   if (!ctx->Driver.DrawGalliumVertexState || ctx->RenderMode != GL_RENDER)
-      return USE_SLOW_PATH;
+   int16_t * const private_refcount = (int16_t*)&node->private_refcount[mode];
+   assert(*private_refcount >= 0);
 
-   const gl_vertex_processing_mode mode = ctx->VertexProgram._VPMode;
+   if (unlikely(*private_refcount == 0)) {
+      /* pipe_vertex_state can be reused through util_vertex_state_cache,
+       * and there can be many display lists over-incrementing this number,
+       * causing it to overflow.
+       *
+       * Guess that the same state can never be used by N=500000 display
+       * lists, so one display list can only increment it by
+       * INT_MAX / N.
+       */
+      const int16_t add_refs = INT_MAX / 500000;
+      p_atomic_add(&node->state[mode]->reference.count, add_refs);
+      *private_refcount = add_refs;
+   }
+
+   (*private_refcount)--;
+   return true;
+}
 
+/**
+ * Validate states for drawing the node with DrawGalliumVertexState.
+ * This must be preceded by the RenderMode and DrawGalliumVertexState checks.
+ */
+static enum vbo_save_status
+vbo_save_validate_vertex_list_gallium(struct gl_context *ctx,
+                                      const struct vbo_save_vertex_list *node,
+                                      gl_vertex_processing_mode mode)
+{
    /* This sets which vertex arrays are enabled, which determines
     * which attribs have stride = 0 and whether edge flags are enabled.
     */
@@ -233,49 +282,34 @@ vbo_save_playback_vertex_list_gallium(struct gl_context *ctx,
    if (vp->info.inputs_read & ~enabled || vp->DualSlotInputs)
       return USE_SLOW_PATH;
 
+   return READY_TO_DRAW;
+}
+
+static enum vbo_save_status
+vbo_save_playback_vertex_list_gallium(struct gl_context *ctx,
+                                      const struct vbo_save_vertex_list *node,
+                                      bool copy_to_current)
+{
+   /* Don't use this if selection or feedback mode is enabled. st/mesa can't
+    * handle it.
+    */
+   if (!ctx->Driver.DrawGalliumVertexState || ctx->RenderMode != GL_RENDER)
+      return USE_SLOW_PATH;
+
+   const gl_vertex_processing_mode mode = ctx->VertexProgram._VPMode;
+
+   enum vbo_save_status status =
+      vbo_save_validate_vertex_list_gallium(ctx, node, mode);
+   if (status != READY_TO_DRAW)
+      return status;
+
+   const GLbitfield enabled = node->enabled_attribs[mode];
    struct pipe_vertex_state *state = node->state[mode];
    struct pipe_draw_vertex_state_info info;
 
    info.mode = node->mode;
-   info.take_vertex_state_ownership = false;
-
-   if (node->ctx == ctx) {
-      /* This mechanism allows passing references to the driver without
-       * using atomics to increase the reference count.
-       *
-       * This private refcount can be decremented without atomics but only
-       * one context (ctx above) can use this counter (so that it's only
-       * used by 1 thread).
-       *
-       * This number is atomically added to reference.count at
-       * initialization. If it's never used, the same number is atomically
-       * subtracted from reference.count before destruction. If this number
-       * is decremented, we can pass one reference to the driver without
-       * touching reference.count with atomics. At destruction we only
-       * subtract the number of references we have not returned. This can
-       * possibly turn a million atomic increments into 1 add and 1 subtract
-       * atomic op over the whole lifetime of an app.
-       */
-      int16_t * const private_refcount = (int16_t*)&node->private_refcount[mode];
-      assert(*private_refcount >= 0);
-
-      if (unlikely(*private_refcount == 0)) {
-         /* pipe_vertex_state can be reused through util_vertex_state_cache,
-          * and there can be many display lists over-incrementing this number,
-          * causing it to overflow.
-          *
-          * Guess that the same state can never be used by N=500000 display
-          * lists, so one display list can only increment it by
-          * INT_MAX / N.
-          */
-         const int16_t add_refs = INT_MAX / 500000;
-         p_atomic_add(&state->reference.count, add_refs);
-         *private_refcount = add_refs;
-      }
-
-      (*private_refcount)--;
-      info.take_vertex_state_ownership = true;
-   }
+   info.take_vertex_state_ownership =
+      get_private_vertex_state_reference(ctx, node, mode);
 
    /* Set edge flags. */
    _mesa_update_edgeflag_state_explicit(ctx, enabled & VERT_BIT_EDGEFLAG);
@@ -370,3 +404,148 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data, bool copy_to_c
    if (copy_to_current)
       playback_copy_to_current(ctx, node);
 }
+
+/* Draws are accumulated in stack arrays, so bundles are limited in size. */
+#define MAX_BUNDLE_DRAWS 256
+
+/**
+ * Draws of consecutive display list nodes that use the same vertex state
+ * and enabled attribs, replayed with a single DrawGalliumVertexState call.
+ */
+struct vbo_save_draw_bundle {
+   struct pipe_vertex_state *state;
+   GLbitfield enabled;
+   bool take_vertex_state_ownership;
+   bool single_mode;
+   unsigned num_draws;
+   struct pipe_draw_start_count_bias draws[MAX_BUNDLE_DRAWS];
+   uint8_t modes[MAX_BUNDLE_DRAWS];
+};
+
+static void
+vbo_save_flush_draw_bundle(struct gl_context *ctx,
+                           struct vbo_save_draw_bundle *bundle)
+{
+   if (!bundle->num_draws)
+      return;
+
+   struct pipe_draw_vertex_state_info info;
+
+   info.mode = bundle->modes[0];
+   info.take_vertex_state_ownership = bundle->take_vertex_state_ownership;
+
+   ctx->Driver.DrawGalliumVertexState(ctx, bundle->state, info,
+                                      bundle->draws,
+                                      bundle->single_mode ? NULL : bundle->modes,
+                                      bundle->num_draws);
+   bundle->num_draws = 0;
+}
+
+static inline const struct vbo_save_vertex_list *
+next_vertex_list(const struct vbo_save_vertex_list *node)
+{
+   return (const struct vbo_save_vertex_list *)
+          (&node->header + node->header.InstSize);
+}
+
+/**
+ * Execute a run of consecutive vertex list nodes that have no other display
+ * list commands between them and don't copy to current, which is what static
+ * geometry compiled with many glBegin/glEnd pairs looks like.
+ *
+ * Nothing can change GL states between such nodes, so states are validated
+ * only once, edge flag states are restored only once at the end, and draws
+ * of nodes sharing the same vertex state (i.e. the same vertex store) are
+ * merged into one DrawGalliumVertexState call.
+ */
+void
+vbo_save_playback_vertex_list_run(struct gl_context *ctx, void *data,
+                                  unsigned count)
+{
+   const struct vbo_save_vertex_list *node =
+      (const struct vbo_save_vertex_list *) data;
+
+   FLUSH_FOR_DRAW(ctx);
+
+   /* Don't use this if selection or feedback mode is enabled, and let
+    * the regular path report errors inside glBegin/End.
+    */
+   if (!ctx->Driver.DrawGalliumVertexState || ctx->RenderMode != GL_RENDER ||
+       _mesa_inside_begin_end(ctx)) {
+      for (unsigned i = 0; i < count; i++, node = next_vertex_list(node))
+         vbo_save_playback_vertex_list(ctx, (void *)node, false);
+      return;
+   }
+
+   const gl_vertex_processing_mode mode = ctx->VertexProgram._VPMode;
+   struct vbo_save_draw_bundle bundle;
+   bool edgeflags_changed = false;
+
+   bundle.num_draws = 0;
+
+   for (unsigned i = 0; i < count; i++, node = next_vertex_list(node)) {
+      if (bundle.num_draws &&
+          (node->state[mode] != bundle.state ||
+           node->enabled_attribs[mode] != bundle.enabled ||
+           bundle.num_draws + node->num_draws > MAX_BUNDLE_DRAWS))
+         vbo_save_flush_draw_bundle(ctx, &bundle);
+
+      if (node->num_draws > MAX_BUNDLE_DRAWS) {
+         if (vbo_save_playback_vertex_list_gallium(ctx, node, false) ==
+             USE_SLOW_PATH)
+            vbo_save_playback_vertex_list(ctx, (void *)node, false);
+         edgeflags_changed = false;
+         continue;
+      }
+
+      if (!bundle.num_draws) {
+         /* Start a new bundle. */
+         enum vbo_save_status status =
+            vbo_save_validate_vertex_list_gallium(ctx, node, mode);
+
+         if (status == USE_SLOW_PATH) {
+            vbo_save_playback_vertex_list(ctx, (void *)node, false);
+            edgeflags_changed = false;
+         }
+         if (status != READY_TO_DRAW || !node->num_draws)
+            continue;
+
+         bundle.state = node->state[mode];
+         bundle.enabled = node->enabled_attribs[mode];
+         bundle.take_vertex_state_ownership =
+            get_private_vertex_state_reference(ctx, node, mode);
+         bundle.single_mode = true;
+
+         _mesa_update_edgeflag_state_explicit(ctx,
+                                              bundle.enabled & VERT_BIT_EDGEFLAG);
+         edgeflags_changed = true;
+      }
+
+      if (node->num_draws == 1 && !node->modes) {
+         bundle.draws[bundle.num_draws] = node->start_count;
+         bundle.modes[bundle.num_draws] = node->mode;
+      } else {
+         memcpy(&bundle.draws[bundle.num_draws], node->start_counts,
+                node->num_draws * sizeof(node->start_counts[0]));
+         if (node->modes) {
+            memcpy(&bundle.modes[bundle.num_draws], node->modes,
+                   node->num_draws);
+         } else {
+            memset(&bundle.modes[bundle.num_draws], node->mode,
+                   node->num_draws);
+         }
+      }
+
+      for (unsigned j = 0; j < node->num_draws; j++) {
+         bundle.single_mode &=
+            bundle.modes[bundle.num_draws + j] == bundle.modes[0];
+      }
+      bundle.num_draws += node->num_draws;
+   }
+
+   vbo_save_flush_draw_bundle(ctx, &bundle);
+
+   /* Restore edge flag state. */
+   if (edgeflags_changed)
+      _mesa_update_edgeflag_state_vao(ctx);
+}
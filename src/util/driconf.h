@@ -239,6 +239,12 @@
    DRI_CONF_OPT_B(glthread_nop_check_framebuffer_status, def, \
                   "glthread always returns GL_FRAMEBUFFER_COMPLETE to prevent synchronization.")
 
+#define DRI_CONF_GLTHREAD_BATCH_POLICY(def) \
+   DRI_CONF_OPT_E(glthread_batch_policy, def, 0, 1, \
+                  "How glthread decides when to submit a batch of GL calls", \
+                  DRI_CONF_ENUM(0, "Submit when the batch is full") \
+                  DRI_CONF_ENUM(1, "Adapt the batch size to how busy the glthread worker is"))
+
 #define DRI_CONF_FORCE_GL_VENDOR() \
    DRI_CONF_OPT_S_NODEF(force_gl_vendor, "Override GPU vendor string.")
 
@@ -274,6 +274,9 @@ struct util_queue_monitoring
    unsigned num_direct_items;
    unsigned num_syncs;
    unsigned num_batches;
+   unsigned num_elided_cmds;
+   unsigned batch_fill_percent_sum;
+   unsigned num_filled_batches;
 };
 
 #ifdef __cplusplus